@@ -0,0 +1,551 @@
+/**
+ * @file
+ * File contenente la funzione ::main dei benchmark.
+ * Genera circoli sintetici di dimensione crescente e misura i tempi delle operazioni
+ * principali sui dati; i risultati vengono stampati su stdout una misura per riga
+ * in formato JSON, così da poter confrontare versioni diverse del programma.
+ * Termina con errore se il ricambio di giocatori non restituisce la memoria allocata.
+ *
+ * Uso:
+ *	ACE_bench [-r ripetizioni] [-a albero|memoria|file] [livello ...]
+ *	ACE_bench genera nome giocatori campi ore giorni [file.abk]
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+#ifdef __GLIBC__
+	#include <malloc.h>
+#endif
+
+#include "genera.h"
+#include "accesso_dati.h"
+#include "file_IO.h"
+#include "archivio.h"
+#include "formato.h"
+#include "istantanea.h"
+#include "esecutore.h"
+#include "indice_giorni.h"
+#include "torneo.h"
+#include "allocazione.h"
+#include "occupazione.h"
+#include "struttura_dati.h"
+
+#ifdef DEBUG_MODE
+	unsigned char MASK = 0;
+#endif
+
+/* Inizio definizioni delle entità private del modulo */
+
+const char NOME_CIRCOLO[] = "bench";		/**< Nome dei circoli generati */
+const char PRIMA_DATA[] = "01-01-2030";		/**< Giorno della prima prenotazione generata */
+const char FILE_BACKUP[] = "bench.abk";		/**< Backup scritto dai benchmark */
+const guint32 SEME = 1234;			/**< Seme dei circoli generati */
+const int CONTROLLI = 100000;			/**< Controlli di disponibilità misurati */
+const int RIPETIZIONI = 5;			/**< Ripetizioni predefinite di ogni misura */
+const int GIOCATORI_TORNEO = 128;		/**< Giocatori del torneo pianificato */
+const int GIORNI_TORNEO = 14;			/**< Giorni a disposizione del torneo */
+const int RICHIESTE = 100;			/**< Richieste di prenotazione allocate in un giorno */
+const int GIORNI_STAGIONE = 365;		/**< Giorni del periodo di cui si calcola l'occupazione */
+const int RICAMBIO = 200;			/**< Giocatori aggiunti ed eliminati a ogni ciclo di ricambio */
+const long RESIDUI_AMMESSI = 4096;		/**< Byte che i cicli di ricambio possono lasciare allocati */
+
+/** Stato condiviso dalle misure di un livello.
+ */
+struct contesto_t {
+	const livello_t *livello;
+	parametri_circolo_t param;
+	guint primo_giorno;
+	circolo_t *circolo;
+	circolo_t *caricato;
+	torneo_t *torneo;
+	int ore;
+	int risultato;
+};
+
+/** Operazione misurata o preparata.
+ */
+typedef void (*operazione_t)(contesto_t *ctx);
+
+static int confronta_tempi(const void *a, const void *b)
+{
+	gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+	return (x > y) - (x < y);
+}
+
+/** Esegue l'operazione più volte e stampa una riga JSON con i tempi.
+ * prepara viene eseguita prima di ogni ripetizione e non viene misurata
+ * @param[in,out] ctx Contesto del livello
+ * @param[in] nome Nome della misura
+ * @param[in] n Elementi elaborati da un'esecuzione, usato per il tempo per elemento
+ * @param[in] ripetizioni Numero di esecuzioni
+ * @param[in] operazione Operazione da misurare
+ * @param[in] prepara Operazione da eseguire prima di ogni esecuzione, può essere 0
+ */
+static void misura(contesto_t *ctx, const char *nome, int n, int ripetizioni,
+			operazione_t operazione, operazione_t prepara = 0)
+{
+	gint64 *tempi = g_new(gint64, ripetizioni);
+
+	for (int i = 0; i < ripetizioni; i++){
+		if (prepara != 0)
+			prepara(ctx);
+
+		gint64 inizio = g_get_monotonic_time();
+		operazione(ctx);
+		tempi[i] = g_get_monotonic_time() - inizio;
+	}
+
+	qsort(tempi, ripetizioni, sizeof(gint64), confronta_tempi);
+	gint64 mediana = tempi[ripetizioni / 2];
+
+	printf("{\"livello\": \"%s\", \"archivio\": \"%s\", \"misura\": \"%s\", \"n\": %d, \"ripetizioni\": %d, "
+		"\"min_us\": %" G_GINT64_FORMAT ", \"mediana_us\": %" G_GINT64_FORMAT ", \"max_us\": %" G_GINT64_FORMAT
+		", \"ns_elemento\": %.1f}\n",
+		ctx->livello->nome, archivio()->nome, nome, n, ripetizioni, tempi[0], mediana, tempi[ripetizioni - 1],
+		n > 0 ? mediana * 1000.0 / n : 0.0);
+	fflush(stdout);
+
+	g_free(tempi);
+}
+
+static void libera_caricato(contesto_t *ctx)
+{
+	if (ctx->caricato != 0)
+		elimina_circolo(ctx->caricato);
+}
+
+static void ricarica(contesto_t *ctx)
+{
+	libera_caricato(ctx);
+	ctx->caricato = carica_circolo(NOME_CIRCOLO);
+}
+
+/** Rigenera le ore su un circolo senza prenotazioni.
+ */
+static void svuota_ore(contesto_t *ctx)
+{
+	if (ctx->circolo != 0)
+		elimina_circolo(ctx->circolo);
+	ctx->circolo = genera_circolo(ctx->param);
+
+	//l'indice viene costruito fuori dalla misura, come accade nell'interfaccia
+	ore_del_giorno(ctx->circolo, (campo_t *) g_ptr_array_index(ctx->circolo->campi, 0), ctx->primo_giorno);
+}
+
+static void inserisci_ore(contesto_t *ctx)
+{
+	ctx->ore = genera_ore(ctx->circolo, ctx->param, ctx->primo_giorno);
+}
+
+static void controlla_conflitti(contesto_t *ctx)
+{
+	GRand *rand = g_rand_new_with_seed(SEME);
+	const orari_t *orari = &ctx->circolo->orari;
+	int slot = (orari->chiusura - orari->apertura) / orari->passo;
+	int libere = 0;
+
+	for (int i = 0; i < CONTROLLI; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(ctx->circolo->campi, g_rand_int_range(rand, 0, ctx->circolo->campi->len));
+		guint giorno = ctx->primo_giorno + g_rand_int_range(rand, 0, ctx->param.giorni);
+		int orario = orari->apertura + g_rand_int_range(rand, 0, slot) * orari->passo;
+
+		libere += ora_libera(ctx->circolo, campo, giorno, orario, orari->passo);
+	}
+
+	ctx->risultato = libere;
+	g_rand_free(rand);
+}
+
+/** Crea il torneo a eliminazione diretta con i primi giocatori del circolo.
+ * @return Numero di incontri del tabellone
+ */
+static int crea_torneo_bench(contesto_t *ctx)
+{
+	giocatore_t *giocatori[GIOCATORI_TORNEO];
+	int n = 0;
+
+	for (guint i = 0; i < ctx->circolo->giocatori->len && n < GIOCATORI_TORNEO; i++)
+		giocatori[n++] = (giocatore_t *) g_ptr_array_index(ctx->circolo->giocatori, i);
+
+	ctx->torneo = crea_torneo(ELIMINAZIONE, giocatori, n, giocatori[0], ctx->circolo);
+
+	return ctx->torneo->incontri->len;
+}
+
+/** Pianifica il torneo tra le prenotazioni generate, senza scriverne di nuove.
+ */
+static void pianifica_torneo_bench(contesto_t *ctx)
+{
+	const orari_t *orari = &ctx->circolo->orari;
+	vincoli_torneo_t vincoli = { ctx->primo_giorno, ctx->primo_giorno + GIORNI_TORNEO - 1,
+					2 * orari->passo, orari->passo, 0, 1 << TERRA, 0, 0 };
+	int non_pianificato;
+
+	ctx->risultato = pianifica_torneo(ctx->torneo, &vincoli, ctx->primo_giorno, 0, non_pianificato);
+}
+
+/** Alloca le richieste serali di un giorno tra le prenotazioni generate.
+ * Le richieste chiedono uno o due slot nelle ultime ore di apertura,
+ * con un terreno preferito e la tolleranza di uno slot
+ */
+static void alloca_richieste(contesto_t *ctx)
+{
+	GRand *rand = g_rand_new_with_seed(SEME);
+	const orari_t *orari = &ctx->circolo->orari;
+	richiesta_t *richieste = g_new(richiesta_t, RICHIESTE);
+
+	for (int i = 0; i < RICHIESTE; i++){
+		richiesta_t &r = richieste[i];
+		r.prenotante = (giocatore_t *) g_ptr_array_index(ctx->circolo->giocatori, 0);
+		r.durata = orari->passo * g_rand_int_range(rand, 1, 3);
+		r.orario = MAX(orari->apertura, orari->chiusura - orari->passo * g_rand_int_range(rand, 2, 7));
+		r.tolleranza = orari->passo;
+		r.terreni = 1 << g_rand_int_range(rand, ERBA, CEMENTO + 1);
+		r.coperture = 0;
+		r.vincolante = false;
+	}
+
+	ctx->risultato = risolvi_allocazione(richieste, RICHIESTE, ctx->primo_giorno, ctx->circolo);
+
+	g_free(richieste);
+	g_rand_free(rand);
+}
+
+/** Calcola l'occupazione di tutti i campi in una stagione che comprende le ore generate.
+ */
+static void calcola_stagione(contesto_t *ctx)
+{
+	occupazione_t *occupazione = calcola_occupazione(ctx->circolo, ctx->primo_giorno, ctx->primo_giorno + GIORNI_STAGIONE - 1);
+
+	ctx->risultato = occupazione->campi[0].totale_prenotati;
+	elimina_occupazione(occupazione);
+}
+
+/** Aggiunge un campo e dei giocatori con una prenotazione ciascuno, poi li elimina.
+ * Il campo viene eliminato per primo insieme alle sue ore, così i giocatori
+ * non hanno più prenotazioni e il circolo torna com'era senza toccare i file
+ */
+static void ricambio(contesto_t *ctx)
+{
+	circolo_t *circolo = ctx->circolo;
+	int numero = ((campo_t *) g_ptr_array_index(circolo->campi, 0))->numero + 1;
+	campo_t *campo = aggiungi_campo(numero, INDOOR, TERRA, "ricambio", NULL, circolo);
+	giocatore_t *giocatori[RICAMBIO];
+
+	for (int i = 0; i < RICAMBIO; i++){
+		giocatori[i] = aggiungi_giocatore("Nome", "Ricambio", "01/01/2000", "0", "0", "ricambio@bench", "NC",
+						NOME_CIRCOLO, NULL, circolo);
+		char *data = data_da_giorno(ctx->primo_giorno + i);
+		aggiungi_ora(circolo->orari.apertura, data, circolo->orari.passo, giocatori[i], campo);
+		g_free(data);
+	}
+
+	elimina_campo(campo, circolo);
+	for (int i = RICAMBIO - 1; i >= 0; i--)
+		elimina_giocatore(giocatori[i], circolo);
+}
+
+/** Stampa una riga JSON con la memoria rimasta allocata dopo i cicli di ricambio.
+ * Un primo ciclo fuori dalla misura porta vettori e tabelle alla loro dimensione,
+ * dopo il quale ogni ciclo deve restituire tutta la memoria che alloca.
+ * La memoria viene letta a esecutore fermo, così le eliminazioni dei file
+ * accodate da elimina_giocatore() non vengono contate
+ * @return FALSE se dopo i cicli restano allocati più di ::RESIDUI_AMMESSI byte
+ */
+static bool misura_ricambio(contesto_t *ctx, int ripetizioni)
+{
+	ricambio(ctx);
+
+#ifdef __GLIBC__
+	attendi_esecutore();
+	size_t prima = mallinfo2().uordblks;
+#endif
+
+	misura(ctx, "ricambio", RICAMBIO, ripetizioni, ricambio);
+
+#ifdef __GLIBC__
+	attendi_esecutore();
+	long residui = (long) mallinfo2().uordblks - (long) prima;
+	bool stato = residui <= RESIDUI_AMMESSI;
+
+	printf("{\"livello\": \"%s\", \"misura\": \"ricambio_memoria\", \"ripetizioni\": %d, \"byte_residui\": %ld, "
+		"\"esito\": \"%s\"}\n", ctx->livello->nome, ripetizioni, residui, stato ? "ok" : "perdita");
+	fflush(stdout);
+
+	if (!stato)
+		cerr<<"Il ricambio non restituisce la memoria: "<<residui<<" byte residui"<<endl;
+
+	return stato;
+#else
+	return true;
+#endif
+}
+
+static void salva_anagrafica(contesto_t *ctx)
+{
+	salva_circolo(ctx->circolo);
+	for (guint i = 0; i < ctx->circolo->giocatori->len; i++)
+		salva_giocatore( (giocatore_t *) g_ptr_array_index(ctx->circolo->giocatori, i), ctx->circolo );
+}
+
+static void salva_campi(contesto_t *ctx)
+{
+	for (guint i = 0; i < ctx->circolo->campi->len; i++)
+		salva_campo( (campo_t *) g_ptr_array_index(ctx->circolo->campi, i), ctx->circolo );
+}
+
+static void salva_ore(contesto_t *ctx)
+{
+	for (guint c = 0; c < ctx->circolo->campi->len; c++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(ctx->circolo->campi, c);
+		for (guint o = 0; o < campo->ore->len; o++)
+			salva_ora( (ora_t *) g_ptr_array_index(campo->ore, o), campo, ctx->circolo );
+	}
+}
+
+static void salva_ore_async(contesto_t *ctx)
+{
+	for (guint c = 0; c < ctx->circolo->campi->len; c++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(ctx->circolo->campi, c);
+		for (guint o = 0; o < campo->ore->len; o++)
+			salva_ora_async( (ora_t *) g_ptr_array_index(campo->ore, o), campo, ctx->circolo, 0, 0 );
+	}
+
+	attendi_esecutore();
+}
+
+/** Scrive e rilegge in un formato il record di ogni giocatore.
+ */
+static void converti(contesto_t *ctx, formato_t formato)
+{
+	GString *testo = g_string_sized_new(256);
+	int letti = 0;
+
+	for (guint i = 0; i < ctx->circolo->giocatori->len; i++){
+		g_string_truncate(testo, 0);
+		scrivi_record(testo, formato, TRACCIATO_GIOCATORE, g_ptr_array_index(ctx->circolo->giocatori, i));
+
+		char *cursore = testo->str;
+		ist_giocatore_t copia;
+		if ( leggi_record(cursore, testo->str + testo->len, formato, TRACCIATO_GIOCATORE, &copia) )
+			letti++;
+	}
+
+	g_string_free(testo, TRUE);
+	ctx->risultato = letti;
+}
+
+static void converti_testo(contesto_t *ctx)
+{
+	converti(ctx, FORMATO_TESTO);
+}
+
+static void converti_binario(contesto_t *ctx)
+{
+	converti(ctx, FORMATO_BINARIO);
+}
+
+static void converti_csv(contesto_t *ctx)
+{
+	converti(ctx, FORMATO_CSV);
+}
+
+static void esegui_backup(contesto_t *ctx)
+{
+	backup(FILE_BACKUP, ctx->circolo);
+}
+
+static void esegui_ripristino(contesto_t *ctx)
+{
+	ripristina(FILE_BACKUP);
+}
+
+static void esegui_caricamento(contesto_t *ctx)
+{
+	ctx->caricato = carica_circolo(NOME_CIRCOLO);
+}
+
+/** Prima richiesta all'indice dei giorni di un circolo appena caricato.
+ */
+static void costruisci_indice(contesto_t *ctx)
+{
+	ore_del_giorno(ctx->caricato, (campo_t *) g_ptr_array_index(ctx->caricato->campi, 0), ctx->primo_giorno);
+}
+
+/** Legge le ore di ogni campo per ogni giorno, come la tabella giornaliera.
+ */
+static void costruisci_tabelle(contesto_t *ctx)
+{
+	guint celle = 0;
+
+	for (int g = 0; g < ctx->param.giorni; g++)
+		for (guint c = 0; c < ctx->circolo->campi->len; c++){
+			const GPtrArray *ore = ore_del_giorno(ctx->circolo, (campo_t *) g_ptr_array_index(ctx->circolo->campi, c),
+								ctx->primo_giorno + g);
+			if (ore != 0)
+				celle += ore->len;
+		}
+
+	ctx->risultato = celle;
+}
+
+/** Esegue tutte le misure di un livello nella directory corrente.
+ * @return FALSE se un controllo delle misure è fallito
+ */
+static bool esegui_livello(const livello_t *livello, int ripetizioni)
+{
+	cerr<<"Livello "<<livello->nome<<"..."<<endl;
+
+	contesto_t ctx;
+	ctx.livello = livello;
+	ctx.param = parametri_livello(livello, NOME_CIRCOLO, SEME);
+	ctx.primo_giorno = giorno_da_data(PRIMA_DATA);
+	ctx.circolo = 0;
+	ctx.caricato = 0;
+	ctx.torneo = 0;
+	ctx.ore = 0;
+	ctx.risultato = 0;
+
+	misura(&ctx, "inserimento_ore", livello->ore, ripetizioni, inserisci_ore, svuota_ore);
+
+	misura(&ctx, "controllo_conflitti", CONTROLLI, ripetizioni, controlla_conflitti);
+	misura(&ctx, "tabella_giorno", livello->giorni * livello->campi, ripetizioni, costruisci_tabelle);
+
+	int incontri = crea_torneo_bench(&ctx);
+	misura(&ctx, "pianifica_torneo", incontri, ripetizioni, pianifica_torneo_bench);
+	elimina_torneo(ctx.torneo);
+
+	misura(&ctx, "allocazione_richieste", RICHIESTE, ripetizioni, alloca_richieste);
+
+	//gli aggregati vengono costruiti fuori dalla misura, come l'indice dei giorni
+	calcola_stagione(&ctx);
+	misura(&ctx, "occupazione_stagione", GIORNI_STAGIONE * livello->campi, ripetizioni, calcola_stagione);
+
+	bool stato = misura_ricambio(&ctx, ripetizioni);
+
+	misura(&ctx, "salva_giocatori", livello->giocatori + 1, ripetizioni, salva_anagrafica);
+	misura(&ctx, "salva_campi", livello->campi, ripetizioni, salva_campi);
+	misura(&ctx, "salva_ore", ctx.ore, ripetizioni, salva_ore);
+	misura(&ctx, "salva_ore_async", ctx.ore, ripetizioni, salva_ore_async);
+
+	misura(&ctx, "formato_testo", livello->giocatori, ripetizioni, converti_testo);
+	misura(&ctx, "formato_binario", livello->giocatori, ripetizioni, converti_binario);
+	misura(&ctx, "formato_csv", livello->giocatori, ripetizioni, converti_csv);
+
+	int elementi = livello->giocatori + livello->campi + ctx.ore;
+	misura(&ctx, "backup", elementi, ripetizioni, esegui_backup);
+	misura(&ctx, "ripristina", elementi, ripetizioni, esegui_ripristino);
+	misura(&ctx, "carica_circolo", elementi, ripetizioni, esegui_caricamento, libera_caricato);
+	misura(&ctx, "indice_giorni", ctx.ore, ripetizioni, costruisci_indice, ricarica);
+
+	libera_caricato(&ctx);
+	elimina_circolo(ctx.circolo);
+
+	elimina_file_circolo(NOME_CIRCOLO);
+	g_remove(FILE_BACKUP);
+
+	return stato;
+}
+
+/** Genera un circolo e lo scrive nei dati del programma o in un backup.
+ */
+static int genera(int argc, char *argv[])
+{
+	if (argc < 7){
+		cerr<<"Uso: "<<argv[0]<<" genera nome giocatori campi ore giorni [file.abk]"<<endl;
+		return 1;
+	}
+
+	parametri_circolo_t param;
+	param.nome = argv[2];
+	param.giocatori = atoi(argv[3]);
+	param.campi = atoi(argv[4]);
+	param.ore = atoi(argv[5]);
+	param.giorni = atoi(argv[6]);
+	param.seme = SEME;
+
+	circolo_t *circolo = genera_circolo(param);
+	int ore = genera_ore(circolo, param, giorno_da_data(PRIMA_DATA));
+
+	bool stato = (argc > 7) ? backup(argv[7], circolo) : scrivi_circolo_generato(circolo);
+
+	cerr<<"Generati "<<param.giocatori<<" giocatori, "<<param.campi<<" campi, "<<ore<<" ore"<<endl;
+
+	elimina_circolo(circolo);
+
+	return stato ? 0 : 1;
+}
+
+/* Fine definizioni private */
+
+/** Funzione principale dei benchmark.
+ * Senza argomenti esegue tutti i livelli in una directory temporanea
+ */
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "genera") == 0)
+		return genera(argc, argv);
+
+	int ripetizioni = RIPETIZIONI;
+	const archivio_t *scelto_archivio = archivio();
+	int primo = 1;
+	while (primo + 1 < argc){
+		if (strcmp(argv[primo], "-r") == 0)
+			ripetizioni = MAX(atoi(argv[primo + 1]), 1);
+		else if (strcmp(argv[primo], "-a") == 0)
+			scelto_archivio = cerca_archivio(argv[primo + 1]);
+		else
+			break;
+		primo += 2;
+	}
+
+	if (scelto_archivio == 0){
+		cerr<<"Archivio sconosciuto"<<endl;
+		return 1;
+	}
+
+	//i dati vengono scritti in una directory temporanea per non toccare quelli reali
+	char *dir = g_dir_make_tmp("ACE_bench_XXXXXX", NULL);
+	if (dir == 0 || g_chdir(dir) != 0){
+		cerr<<"Impossibile creare la directory temporanea"<<endl;
+		return 1;
+	}
+
+	//l'archivio su file unico viene creato nella directory temporanea
+	if ( !imposta_archivio(scelto_archivio) ){
+		cerr<<"Impossibile aprire l'archivio"<<endl;
+		return 1;
+	}
+
+	//ogni archivio conserva i file di testo dei record, quindi i tempi includono sempre composizione e lettura
+	printf("{\"archivio\": \"%s\", \"nota\": \"i record vengono composti e letti come testo con ogni archivio, "
+		"le differenze tra archivi misurano solo la conservazione dei file\"}\n", scelto_archivio->nome);
+
+	bool stato = true;
+	for (int l = 0; l < N_LIVELLI; l++){
+		bool scelto = (primo >= argc);
+		for (int i = primo; i < argc; i++)
+			scelto = scelto || strcmp(argv[i], LIVELLI[l].nome) == 0;
+
+		if (scelto)
+			stato = esegui_livello(&LIVELLI[l], ripetizioni) && stato;
+	}
+
+	attendi_esecutore();
+	imposta_archivio(&ARCHIVIO_ALBERO);
+	g_remove(FILE_ARCHIVIO);
+
+	g_rmdir(DATA_PATH);
+	g_chdir("..");
+	g_rmdir(dir);
+	g_free(dir);
+
+	return stato ? 0 : 1;
+}
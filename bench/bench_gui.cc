@@ -0,0 +1,526 @@
+/**
+ * @file
+ * File contenente la funzione ::main del benchmark dell'interfaccia.
+ * Carica l'interfaccia reale, apre un circolo sintetico e richiama gli handler
+ * come farebbe l'utente (cambio giorno, prenotazione, eliminazione, elenchi).
+ * Per ogni handler misura il tempo di esecuzione e la latenza fino al disegno
+ * del frame successivo; i percentili vengono stampati su stdout una riga JSON per handler.
+ * Richiede un display, senza schermo va eseguito sotto Xvfb (make bench_gui).
+ *
+ * Uso:
+ *	ACE_bench_gui [-r ripetizioni] [livello ...]
+ */
+
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+#include "genera.h"
+#include "handler.h"
+#include "accesso_dati.h"
+#include "file_IO.h"
+#include "esecutore.h"
+#include "indice_giorni.h"
+#include "struttura_dati.h"
+
+#ifdef DEBUG_MODE
+	unsigned char MASK = 0;
+#endif
+
+GtkBuilder *build;
+
+extern circolo_t *circolo;
+extern const char DATA_PATH[];
+
+/* Inizio definizioni delle entità private del modulo */
+
+const char INTERFACCIA[] = "interfaccia/interfaccia.glade";
+const guint PRIMO_MESE = 0;			/**< Mese (da 0) della prima prenotazione generata */
+const int PRIMO_ANNO = 2030;			/**< Anno della prima prenotazione generata */
+const char PRIMA_DATA[] = "01-01-2030";		/**< Giorno della prima prenotazione generata */
+const guint32 SEME = 1234;			/**< Seme dei circoli generati */
+const int RIPETIZIONI = 50;			/**< Ripetizioni predefinite di ogni handler */
+const guint ATTESA_FRAME = 1000;		/**< Millisecondi massimi di attesa di un frame */
+const gint64 ATTESA_CARICAMENTO = 600 * G_USEC_PER_SEC;	/**< Attesa massima del caricamento */
+
+const char *RICERCHE[] = {"ros", "mario bianchi", "giulia", "0000", "esempio.it"};
+const int N_RICERCHE = G_N_ELEMENTS(RICERCHE);
+
+/** Tempi raccolti per un handler, in microsecondi.
+ */
+struct campioni_t {
+	const char *nome;
+	GArray *durate;
+	GArray *frame;
+	int frame_persi;
+};
+
+/** Stato condiviso dalle azioni di un livello.
+ */
+struct stato_t {
+	GtkCalendar *calendario;
+	GtkWidget *principale;
+	int i;
+	campo_t *campo;
+	int orario;
+	int durata;
+	guint giorno;
+	char *data;
+	ora_t *ora;
+};
+
+/** Azione sull'interfaccia.
+ */
+typedef void (*azione_t)(stato_t *stato);
+
+/** Attesa di un frame.
+ */
+struct attesa_t {
+	bool dipinto;
+	bool scaduta;
+};
+
+static int errori = 0;	/**< Finestre di errore mostrate durante il benchmark */
+
+static void inizializza_campioni(campioni_t &c, const char *nome)
+{
+	c.nome = nome;
+	c.durate = g_array_new(FALSE, FALSE, sizeof(gint64));
+	c.frame = g_array_new(FALSE, FALSE, sizeof(gint64));
+	c.frame_persi = 0;
+}
+
+static int confronta_tempi(const void *a, const void *b)
+{
+	gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+	return (x > y) - (x < y);
+}
+
+/** Ritorna il percentile in millisecondi di un array di tempi ordinato.
+ */
+static double percentile(GArray *tempi, double p)
+{
+	if (tempi->len == 0)
+		return 0;
+
+	guint i = MIN( (guint) (p * tempi->len), tempi->len - 1 );
+	return g_array_index(tempi, gint64, i) / 1000.0;
+}
+
+/** Stampa la riga JSON di un handler e libera i campioni.
+ */
+static void stampa_campioni(const livello_t *livello, campioni_t &c)
+{
+	g_array_sort(c.durate, confronta_tempi);
+	g_array_sort(c.frame, confronta_tempi);
+
+	printf("{\"livello\": \"%s\", \"handler\": \"%s\", \"n\": %u, "
+		"\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, "
+		"\"frame_p50_ms\": %.3f, \"frame_p90_ms\": %.3f, \"frame_p99_ms\": %.3f, \"frame_max_ms\": %.3f, "
+		"\"frame_persi\": %d}\n",
+		livello->nome, c.nome, c.durate->len,
+		percentile(c.durate, 0.5), percentile(c.durate, 0.9), percentile(c.durate, 0.99), percentile(c.durate, 1),
+		percentile(c.frame, 0.5), percentile(c.frame, 0.9), percentile(c.frame, 0.99), percentile(c.frame, 1),
+		c.frame_persi);
+	fflush(stdout);
+
+	g_array_free(c.durate, TRUE);
+	g_array_free(c.frame, TRUE);
+}
+
+/** Esegue gli eventi in attesa, come farebbe il main loop tra due azioni dell'utente.
+ */
+static void attendi_eventi()
+{
+	while ( gtk_events_pending() )
+		gtk_main_iteration();
+}
+
+static void dopo_disegno(GdkFrameClock *clock, gpointer attesa)
+{
+	((attesa_t *) attesa)->dipinto = true;
+}
+
+static gboolean frame_scaduto(gpointer attesa)
+{
+	((attesa_t *) attesa)->scaduta = true;
+	return FALSE;
+}
+
+/** Attende il disegno del prossimo frame della finestra.
+ * Il frame contiene tutto ciò che l'azione appena eseguita ha invalidato
+ * @param[in] finestra Finestra da attendere
+ * @return TRUE se il frame è stato disegnato entro ATTESA_FRAME
+ */
+static bool attendi_frame(GtkWidget *finestra)
+{
+	GdkFrameClock *clock = gtk_widget_get_frame_clock(finestra);
+	if (clock == 0)
+		return false;
+
+	attesa_t attesa = {false, false};
+	gulong id = g_signal_connect(clock, "after-paint", G_CALLBACK(dopo_disegno), &attesa);
+	guint guardia = g_timeout_add(ATTESA_FRAME, frame_scaduto, &attesa);
+
+	gdk_frame_clock_request_phase(clock, GDK_FRAME_CLOCK_PHASE_PAINT);
+	while (!attesa.dipinto && !attesa.scaduta)
+		g_main_context_iteration(NULL, TRUE);
+
+	if (!attesa.scaduta)
+		g_source_remove(guardia);
+	g_signal_handler_disconnect(clock, id);
+
+	return attesa.dipinto;
+}
+
+/** Esegue un'azione e ne registra durata e latenza del frame.
+ * @param[in,out] c Campioni dell'handler
+ * @param[in,out] stato Stato del livello
+ * @param[in] azione Azione da eseguire
+ * @param[in] finestra Finestra in cui l'azione mostra il risultato
+ */
+static void misura(campioni_t &c, stato_t *stato, azione_t azione, GtkWidget *finestra)
+{
+	attendi_eventi();
+
+	gint64 inizio = g_get_monotonic_time();
+	azione(stato);
+	gint64 durata = g_get_monotonic_time() - inizio;
+
+	g_array_append_val(c.durate, durata);
+
+	if ( attendi_frame(finestra) ){
+		gint64 frame = g_get_monotonic_time() - inizio;
+		g_array_append_val(c.frame, frame);
+	}
+	else
+		c.frame_persi++;
+}
+
+static gboolean rispondi_si(gpointer dialogo)
+{
+	gtk_dialog_response( GTK_DIALOG(dialogo), GTK_RESPONSE_YES );
+	return FALSE;
+}
+
+/** Conferma le richieste di alert() appena vengono mostrate.
+ */
+static void conferma_alert(GtkWidget *dialogo, gpointer user_data)
+{
+	g_idle_add(rispondi_si, dialogo);
+}
+
+static gboolean nascondi(gpointer finestra)
+{
+	gtk_widget_hide( GTK_WIDGET(finestra) );
+	return FALSE;
+}
+
+/** Conta e chiude le finestre di errore.
+ */
+static void conta_errore(GtkWidget *finestra, gpointer user_data)
+{
+	GtkLabel *messaggio = GTK_LABEL( gtk_builder_get_object(build, "errore_m") );
+	cerr<<"Errore: "<<gtk_label_get_text(messaggio)<<endl;
+
+	errori++;
+	g_idle_add(nascondi, finestra);
+}
+
+/** Aggiorna giorno e data dello stato con il giorno selezionato nel calendario.
+ */
+static void leggi_giorno(stato_t *stato)
+{
+	guint giorno, mese, anno;
+	gtk_calendar_get_date(stato->calendario, &anno, &mese, &giorno);
+
+	g_free(stato->data);
+	stato->data = g_strdup_printf("%02u-%02u-%04u", giorno, mese + 1, anno);
+	stato->giorno = giorno_da_data(stato->data);
+}
+
+/** Cerca uno slot libero nel giorno selezionato.
+ * @return TRUE se è stato trovato, campo e orario vengono scritti nello stato
+ */
+static bool cerca_slot_libero(stato_t *stato)
+{
+	for (guint i = 0; i < circolo->campi->len; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+		const orari_t *orari = get_orari_campo(campo);
+		//durata proposta da handler_mostra_ora
+		int durata = MAX(60 / orari->passo, 1) * orari->passo;
+
+		for (int orario = orari->apertura; orario + durata <= orari->chiusura; orario += orari->passo)
+			if ( ora_libera(circolo, campo, stato->giorno, orario, durata) ){
+				stato->campo = campo;
+				stato->orario = orario;
+				stato->durata = durata;
+				return true;
+			}
+	}
+
+	return false;
+}
+
+static void cambia_giorno(stato_t *stato)
+{
+	gtk_calendar_select_day(stato->calendario, stato->i % 28 + 1);
+}
+
+static void ridisegna_tabella(stato_t *stato)
+{
+	disegna_tabella_ore();
+}
+
+static void cambia_giorni(stato_t *stato)
+{
+	gtk_spin_button_set_value( GTK_SPIN_BUTTON( gtk_builder_get_object(build, "giorni_tabella") ),
+				(stato->i % 2) ? 7 : 1 );
+}
+
+static void apri_slot(stato_t *stato)
+{
+	handler_mostra_ora(stato->campo, stato->data, stato->orario, 0, NULL);
+}
+
+static void prenota(stato_t *stato)
+{
+	handler_prenota_ora(NULL, NULL);
+}
+
+static void apri_ora(stato_t *stato)
+{
+	handler_mostra_ora(stato->campo, stato->data, stato->orario, stato->ora, NULL);
+}
+
+static void elimina(stato_t *stato)
+{
+	handler_elimina_ora(NULL, NULL);
+}
+
+static void apri_giocatori(stato_t *stato)
+{
+	handler_elenco_giocatori(NULL, NULL);
+}
+
+static void apri_soci(stato_t *stato)
+{
+	handler_elenco_soci(NULL, NULL);
+}
+
+static void cerca(stato_t *stato)
+{
+	gtk_entry_set_text( GTK_ENTRY( gtk_builder_get_object(build, "cerca_g") ), RICERCHE[stato->i % N_RICERCHE] );
+}
+
+static void apri_campi(stato_t *stato)
+{
+	handler_elenco_campi(NULL, NULL);
+}
+
+/** Cerca l'ora appena prenotata nello slot dello stato.
+ */
+static ora_t *ora_prenotata(stato_t *stato)
+{
+	const GPtrArray *ore = ore_del_giorno(circolo, stato->campo, stato->giorno);
+
+	for (guint i = 0; ore != 0 && i < ore->len; i++){
+		ora_t *ora = (ora_t *) g_ptr_array_index(ore, i);
+		if (ora->orario == stato->orario)
+			return ora;
+	}
+
+	return 0;
+}
+
+/** Genera il circolo del livello, lo apre nell'interfaccia e misura gli handler.
+ * @return FALSE se il circolo non è stato caricato
+ */
+static bool esegui_livello(const livello_t *livello, int ripetizioni)
+{
+	cerr<<"Livello "<<livello->nome<<"..."<<endl;
+
+	char *nome = g_strconcat("bench_", livello->nome, NULL);
+	parametri_circolo_t param = parametri_livello(livello, nome, SEME);
+
+	circolo_t *generato = genera_circolo(param);
+	genera_ore(generato, param, giorno_da_data(PRIMA_DATA));
+	scrivi_circolo_generato(generato);
+	elimina_circolo(generato);
+
+	stato_t stato;
+	stato.calendario = GTK_CALENDAR( gtk_builder_get_object(build, "calendario") );
+	stato.principale = GTK_WIDGET( gtk_builder_get_object(build, "principale") );
+	stato.data = 0;
+	stato.ora = 0;
+
+	GtkWidget *elenco_g = GTK_WIDGET( gtk_builder_get_object(build, "elenco_g") );
+	GtkWidget *elenco_c = GTK_WIDGET( gtk_builder_get_object(build, "elenco_c") );
+
+	gtk_calendar_select_month(stato.calendario, PRIMO_MESE, PRIMO_ANNO);
+	gtk_calendar_select_day(stato.calendario, 1);
+	attendi_eventi();
+
+	//caricamento attraverso l'handler, fino all'abilitazione del calendario
+	int errori_prima = errori;
+	gint64 inizio = g_get_monotonic_time();
+	handler_carica_circolo(NULL, nome);
+	while ( !gtk_widget_get_sensitive( GTK_WIDGET(stato.calendario) ) && errori == errori_prima
+		&& g_get_monotonic_time() - inizio < ATTESA_CARICAMENTO )
+		if ( !g_main_context_iteration(NULL, FALSE) )
+			g_usleep(100);
+
+	if ( !gtk_widget_get_sensitive( GTK_WIDGET(stato.calendario) ) ){
+		cerr<<"Impossibile caricare il circolo "<<nome<<endl;
+		g_free(nome);
+		return false;
+	}
+
+	campioni_t caricamento;
+	inizializza_campioni(caricamento, "handler_carica_circolo");
+	gint64 durata = g_get_monotonic_time() - inizio;
+	g_array_append_val(caricamento.durate, durata);
+	if ( attendi_frame(stato.principale) ){
+		gint64 frame = g_get_monotonic_time() - inizio;
+		g_array_append_val(caricamento.frame, frame);
+	}
+	stampa_campioni(livello, caricamento);
+
+	campioni_t giorno, disegna, giorni, mostra, prenotazione, mostra_esistente, eliminazione,
+		giocatori, soci, ricerca, campi;
+	inizializza_campioni(giorno, "aggiorna_tabella_ore");
+	inizializza_campioni(disegna, "disegna_tabella_ore");
+	inizializza_campioni(giorni, "handler_giorni_tabella");
+	inizializza_campioni(mostra, "handler_mostra_ora");
+	inizializza_campioni(prenotazione, "handler_prenota_ora");
+	inizializza_campioni(mostra_esistente, "handler_mostra_ora_esistente");
+	inizializza_campioni(eliminazione, "handler_elimina_ora");
+	inizializza_campioni(giocatori, "handler_elenco_giocatori");
+	inizializza_campioni(soci, "handler_elenco_soci");
+	inizializza_campioni(ricerca, "handler_cerca_giocatori");
+	inizializza_campioni(campi, "handler_elenco_campi");
+
+	for (stato.i = 0; stato.i < ripetizioni; stato.i++){
+		misura(giorno, &stato, cambia_giorno, stato.principale);
+		misura(disegna, &stato, ridisegna_tabella, stato.principale);
+		misura(giorni, &stato, cambia_giorni, stato.principale);
+
+		leggi_giorno(&stato);
+		if ( cerca_slot_libero(&stato) ){
+			misura(mostra, &stato, apri_slot, stato.principale);
+
+			gtk_combo_box_set_active( GTK_COMBO_BOX( gtk_builder_get_object(build, "nome_ora_n") ), 0 );
+			misura(prenotazione, &stato, prenota, stato.principale);
+
+			stato.ora = ora_prenotata(&stato);
+			if (stato.ora != 0){
+				misura(mostra_esistente, &stato, apri_ora, stato.principale);
+				misura(eliminazione, &stato, elimina, stato.principale);
+			}
+		}
+
+		misura(giocatori, &stato, apri_giocatori, elenco_g);
+		misura(ricerca, &stato, cerca, elenco_g);
+		gtk_entry_set_text( GTK_ENTRY( gtk_builder_get_object(build, "cerca_g") ), "" );
+		gtk_widget_hide(elenco_g);
+
+		misura(soci, &stato, apri_soci, elenco_g);
+		gtk_widget_hide(elenco_g);
+
+		misura(campi, &stato, apri_campi, elenco_c);
+		gtk_widget_hide(elenco_c);
+	}
+
+	stampa_campioni(livello, giorno);
+	stampa_campioni(livello, disegna);
+	stampa_campioni(livello, giorni);
+	stampa_campioni(livello, mostra);
+	stampa_campioni(livello, prenotazione);
+	stampa_campioni(livello, mostra_esistente);
+	stampa_campioni(livello, eliminazione);
+	stampa_campioni(livello, giocatori);
+	stampa_campioni(livello, ricerca);
+	stampa_campioni(livello, soci);
+	stampa_campioni(livello, campi);
+
+	g_free(stato.data);
+	g_free(nome);
+
+	return true;
+}
+
+/* Fine definizioni private */
+
+/** Funzione principale del benchmark dell'interfaccia.
+ * Senza argomenti esegue tutti i livelli in una directory temporanea
+ */
+int main(int argc, char *argv[])
+{
+	gtk_init(&argc, &argv);
+
+	//l'interfaccia va cercata prima di spostarsi nella directory temporanea
+	char *corrente = g_get_current_dir();
+	char *interfaccia = g_build_filename(corrente, INTERFACCIA, NULL);
+	g_free(corrente);
+
+	build = gtk_builder_new();
+	if ( !gtk_builder_add_from_file(build, interfaccia, NULL) ){
+		cerr<<"Impossibile caricare "<<interfaccia<<endl;
+		return 1;
+	}
+	g_free(interfaccia);
+
+	gtk_builder_connect_signals(build, NULL);
+	g_signal_connect( gtk_builder_get_object(build, "alert"), "map", G_CALLBACK(conferma_alert), NULL );
+	g_signal_connect( gtk_builder_get_object(build, "errore"), "map", G_CALLBACK(conta_errore), NULL );
+
+	int ripetizioni = RIPETIZIONI;
+	int primo = 1;
+	if (argc > 2 && strcmp(argv[1], "-r") == 0){
+		ripetizioni = MAX(atoi(argv[2]), 1);
+		primo = 3;
+	}
+
+	char *dir = g_dir_make_tmp("ACE_bench_gui_XXXXXX", NULL);
+	if (dir == 0 || g_chdir(dir) != 0){
+		cerr<<"Impossibile creare la directory temporanea"<<endl;
+		return 1;
+	}
+
+	GPtrArray *nomi = g_ptr_array_new_with_free_func(g_free);
+	bool stato = true;
+
+	for (int l = 0; l < N_LIVELLI; l++){
+		bool scelto = (primo >= argc);
+		for (int i = primo; i < argc; i++)
+			scelto = scelto || strcmp(argv[i], LIVELLI[l].nome) == 0;
+
+		if (!scelto)
+			continue;
+
+		g_ptr_array_add(nomi, g_strconcat("bench_", LIVELLI[l].nome, NULL));
+		stato = esegui_livello(&LIVELLI[l], ripetizioni) && stato;
+	}
+
+	attendi_esecutore();
+
+	for (guint i = 0; i < nomi->len; i++)
+		elimina_file_circolo( (const char *) g_ptr_array_index(nomi, i) );
+	g_ptr_array_free(nomi, TRUE);
+
+	g_rmdir(DATA_PATH);
+	g_chdir("..");
+	g_rmdir(dir);
+	g_free(dir);
+
+	if (errori > 0)
+		cerr<<errori<<" errori durante il benchmark"<<endl;
+
+	return (stato && errori == 0) ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file
+ * File contenente il modulo genera.
+ * Genera circoli sintetici di dimensione arbitraria per i benchmark
+ */
+
+#include <glib.h>
+
+#include "genera.h"
+#include "accesso_dati.h"
+#include "file_IO.h"
+#include "indice_giorni.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+extern const livello_t LIVELLI[] = {
+	{"piccolo", 100, 4, 1000, 30},
+	{"medio", 1000, 8, 10000, 90},
+	{"grande", 5000, 16, 50000, 365},
+};
+
+extern const int N_LIVELLI = G_N_ELEMENTS(LIVELLI);
+
+/* Inizio definizioni delle entità private del modulo */
+
+const char *NOMI[] = {"Mario", "Luca", "Giulia", "Anna", "Marco", "Sara", "Paolo", "Elena", "Davide", "Chiara"};
+const char *COGNOMI[] = {"Rossi", "Bianchi", "Ferrari", "Esposito", "Romano", "Colombo", "Ricci", "Marino", "Greco", "Bruno"};
+const char *CLASSIFICHE[] = {"NC", "4.6", "4.3", "4.1", "3.5", "3.1", "2.8"};
+
+const int N_NOMI = G_N_ELEMENTS(NOMI);
+const int N_COGNOMI = G_N_ELEMENTS(COGNOMI);
+const int N_CLASSIFICHE = G_N_ELEMENTS(CLASSIFICHE);
+
+const int TENTATIVI = 8;	/**< Tentativi per ora prima di considerare i campi pieni */
+
+/** Aggiunge un giocatore sintetico.
+ * Nome e cognome si ripetono, tessera ed email sono uniche
+ */
+static giocatore_t *genera_giocatore(int i, GRand *rand, circolo_t *circolo)
+{
+	const char *nome = NOMI[ g_rand_int_range(rand, 0, N_NOMI) ];
+	const char *cognome = COGNOMI[ g_rand_int_range(rand, 0, N_COGNOMI) ];
+	const char *classifica = CLASSIFICHE[ g_rand_int_range(rand, 0, N_CLASSIFICHE) ];
+
+	char *nascita = g_strdup_printf("%02d/%02d/%04d", g_rand_int_range(rand, 1, 29),
+					g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 1940, 2015));
+	char *tessera = g_strdup_printf("%08d", i);
+	char *telefono = g_strdup_printf("3%09d", g_rand_int_range(rand, 0, 1000000000));
+	char *email = g_strdup_printf("%s.%s%d@esempio.it", nome, cognome, i);
+
+	giocatore_t *giocatore;
+	if (i % 3 == 0)
+		giocatore = aggiungi_socio(nome, cognome, nascita, tessera, telefono, email, classifica,
+					g_rand_boolean(rand), 0, circolo);
+	else
+		giocatore = aggiungi_giocatore(nome, cognome, nascita, tessera, telefono, email, classifica,
+					"Altro circolo", 0, circolo);
+
+	g_free(nascita);
+	g_free(tessera);
+	g_free(telefono);
+	g_free(email);
+
+	return giocatore;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+parametri_circolo_t parametri_livello(const livello_t *livello, const char nome[], guint32 seme)
+{
+	parametri_circolo_t param;
+	param.nome = nome;
+	param.giocatori = livello->giocatori;
+	param.campi = livello->campi;
+	param.ore = livello->ore;
+	param.giorni = livello->giorni;
+	param.seme = seme;
+
+	return param;
+}
+
+circolo_t *genera_circolo(const parametri_circolo_t &param)
+{
+	D1(cout<<"Generazione circolo "<<param.nome<<endl)
+
+	circolo_t *circolo = inizializza_circolo(param.nome, "Via dei Campi 1", "info@esempio.it", "059000000");
+	GRand *rand = g_rand_new_with_seed(param.seme);
+
+	for (int i = 0; i < param.giocatori; i++)
+		genera_giocatore(i, rand, circolo);
+
+	for (int i = 1; i <= param.campi; i++)
+		aggiungi_campo(i, (copertura_t) (i % 2), (terreno_t) (i % 5), "", 0, circolo);
+
+	g_rand_free(rand);
+
+	return circolo;
+}
+
+int genera_ore(circolo_t *circolo, const parametri_circolo_t &param, guint primo_giorno)
+{
+	if (circolo == 0 || circolo->campi->len == 0 || circolo->giocatori->len == 0 || param.giorni <= 0)
+		return 0;
+
+	GRand *rand = g_rand_new_with_seed(param.seme + 1);
+
+	//campi e giocatori estratti a caso
+	GPtrArray *campi = circolo->campi;
+	GPtrArray *giocatori = circolo->giocatori;
+
+	//le date vengono convertite una volta sola per giorno
+	char **date = g_new(char *, param.giorni + 1);
+	for (int i = 0; i < param.giorni; i++)
+		date[i] = data_da_giorno(primo_giorno + i);
+	date[param.giorni] = 0;
+
+	int inserite = 0;
+	for (int tentativi = param.ore * TENTATIVI; inserite < param.ore && tentativi > 0; tentativi--){
+		campo_t *campo = (campo_t *) g_ptr_array_index(campi, g_rand_int_range(rand, 0, campi->len));
+		const orari_t *orari = get_orari_campo(campo);
+
+		int slot = (orari->chiusura - orari->apertura) / orari->passo;
+		if (slot <= 0)
+			continue;
+
+		int inizio = g_rand_int_range(rand, 0, slot);
+		int durata = MIN( g_rand_int_range(rand, 1, 3), slot - inizio ) * orari->passo;
+		int orario = orari->apertura + inizio * orari->passo;
+		int giorno = g_rand_int_range(rand, 0, param.giorni);
+
+		if ( !ora_libera(circolo, campo, primo_giorno + giorno, orario, durata) )
+			continue;
+
+		giocatore_t *prenotante = (giocatore_t *) g_ptr_array_index(giocatori, g_rand_int_range(rand, 0, giocatori->len));
+		if ( aggiungi_ora(orario, date[giorno], durata, prenotante, campo) != 0 )
+			inserite++;
+	}
+
+	g_strfreev(date);
+	g_rand_free(rand);
+
+	D2(cout<<"Ore inserite: "<<inserite<<endl)
+
+	return inserite;
+}
+
+bool scrivi_circolo_generato(const circolo_t *circolo)
+{
+	if ( !salva_circolo(circolo) )
+		return false;
+
+	for (guint i = 0; i < circolo->giocatori->len; i++)
+		if ( !salva_giocatore( (giocatore_t *) g_ptr_array_index(circolo->giocatori, i), circolo ) )
+			return false;
+
+	for (guint c = 0; c < circolo->campi->len; c++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, c);
+		if ( !salva_campo(campo, circolo) )
+			return false;
+
+		for (guint o = 0; o < campo->ore->len; o++)
+			if ( !salva_ora( (ora_t *) g_ptr_array_index(campo->ore, o), campo, circolo ) )
+				return false;
+	}
+
+	return true;
+}
+
+/* Fine definizioni pubbliche */
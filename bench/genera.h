@@ -0,0 +1,75 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo genera.cc
+ */
+
+#ifndef GENERA
+#define GENERA
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo genera */
+
+/** Parametri di un circolo sintetico.
+ * Le ore vengono distribuite a caso sui campi e sui giorni a partire da primo_giorno,
+ * lo stesso seme genera sempre lo stesso circolo
+ */
+struct parametri_circolo_t {
+	const char *nome;
+	int giocatori;
+	int campi;
+	int ore;
+	int giorni;
+	guint32 seme;
+};
+
+/** Dimensione di un circolo sintetico usata dai benchmark.
+ */
+struct livello_t {
+	const char *nome;
+	int giocatori;
+	int campi;
+	int ore;
+	int giorni;
+};
+
+extern const livello_t LIVELLI[];	/**< Livelli predefiniti in ordine di dimensione */
+extern const int N_LIVELLI;		/**< Numero di livelli predefiniti */
+
+/** Ritorna i parametri di un circolo della dimensione del livello.
+ * @param[in] livello Livello
+ * @param[in] nome Nome del circolo
+ * @param[in] seme Seme del generatore
+ * @return Parametri del circolo
+ */
+parametri_circolo_t parametri_livello(const livello_t *livello, const char nome[], guint32 seme);
+
+/** Genera un circolo con giocatori e campi.
+ * Un giocatore su tre è socio; il circolo usa gli orari predefiniti
+ * @param[in] param Parametri del circolo
+ * @return Circolo generato, da deallocare con elimina_circolo()
+ */
+circolo_t *genera_circolo(const parametri_circolo_t &param);
+
+/** Aggiunge al circolo le prenotazioni casuali.
+ * Ogni ora viene controllata con ora_libera() e inserita con aggiungi_ora()
+ * come fa l'interfaccia, quindi il tempo impiegato misura l'inserimento delle prenotazioni;
+ * se i campi sono pieni si ferma prima di aver inserito tutte le ore
+ * @param[in,out] circolo Circolo generato con genera_circolo()
+ * @param[in] param Parametri del circolo
+ * @param[in] primo_giorno Giorno giuliano della prima prenotazione
+ * @return Numero di ore inserite
+ */
+int genera_ore(circolo_t *circolo, const parametri_circolo_t &param, guint primo_giorno);
+
+/** Scrive il circolo nell'albero di directory dei dati.
+ * @param[in] circolo Circolo da scrivere
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool scrivi_circolo_generato(const circolo_t *circolo);
+
+/* Fine interfaccia del modulo genera */
+
+#endif
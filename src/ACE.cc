@@ -31,6 +31,7 @@
 using namespace std;
 
 #include "struttura_dati.h"
+#include "archivio.h"
 
 #ifdef DEBUG_MODE
 	unsigned char MASK = 1|2;
@@ -39,6 +40,7 @@ using namespace std;
 /* Definizioni costanti del modulo */
 
 const char INTERFACCIA[] = "interfaccia/interfaccia.glade";
+const char VARIABILE_ARCHIVIO[] = "ACE_ARCHIVIO";	/**< Variabile d'ambiente con il nome dell'archivio da usare */
 
 /* Fine definizioni costanti */
 
@@ -51,6 +53,11 @@ int main(int argc, char *argv[])
 {
 	gtk_init(&argc, &argv);
 
+	//senza la variabile i dati restano nell'albero di directory
+	const char *nome_archivio = g_getenv(VARIABILE_ARCHIVIO);
+	if ( nome_archivio != 0 && !imposta_archivio( cerca_archivio(nome_archivio) ) )
+		cerr<<"Archivio non disponibile: "<<nome_archivio<<endl;
+
 	build = gtk_builder_new();
 
 	g_assert(build);
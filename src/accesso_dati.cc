@@ -5,22 +5,102 @@
  */
 
 #include <glib.h>
+#include <cstring>
 #include "accesso_dati.h"
 #include "struttura_dati.h"
 #include "file_IO.h"
+#include "selezione.h"
 #include "debug.h"
 
 /* Inizio definizioni delle entità private del modulo */
 
+/** Registrazione di un osservatore.
+ * Coppia funzione-dati agganciata alla lista osservatori del circolo
+ */
+struct registrazione_t {
+	osservatore_t funzione;
+	gpointer dati;
+};
+
+const orari_t ORARI_PREDEFINITI = { 8*60, 23*60, 60 };	/**< Orari dei circoli che non li hanno impostati */
+
 
 /** Funzione usata per deallocare le ore.
- * Utile anche per la deallocazione della lista ore quando si elimina un campo
- * utilizzando la funzione g_list_free_full()
  */
 static inline void dealloca_ora(gpointer ora_)
 {
 	ora_t *ora = (ora_t *) ora_;
-	delete ora;
+	g_string_free(ora->data, TRUE);
+	g_free(ora);
+}
+
+/** Funzione usata per deallocare le prenotazioni ricorrenti.
+ */
+static void dealloca_regola(gpointer regola_)
+{
+	regola_t *regola = (regola_t *) regola_;
+	g_array_free(regola->eccezioni, TRUE);
+	g_free(regola);
+}
+
+/** Funzione usata per deallocare i corsi.
+ * Le regole del corso appartengono ai campi e vanno eliminate a parte
+ */
+static void dealloca_corso(gpointer corso_)
+{
+	corso_t *corso = (corso_t *) corso_;
+	g_string_free(corso->nome, true);
+	g_list_free(corso->iscritti);
+	g_free(corso);
+}
+
+/** Funzione usata per deallocare i giocatori.
+ */
+static void dealloca_giocatore(giocatore_t *giocatore)
+{
+	g_free(giocatore->testi);
+	g_free(giocatore);
+}
+
+/** Funzione usata per deallocare i campi con le loro ore e prenotazioni ricorrenti.
+ */
+static void dealloca_campo(campo_t *campo)
+{
+	g_string_free(campo->note, TRUE);
+	for (guint i = 0; i < campo->ore->len; i++)
+		dealloca_ora(g_ptr_array_index(campo->ore, i));
+	g_ptr_array_free(campo->ore, TRUE);
+	g_list_free_full(campo->regole, dealloca_regola);
+	g_free(campo);
+}
+
+/** Ritorna la settimana del giorno giuliano, le settimane iniziano il lunedì.
+ */
+static inline guint settimana(guint giorno)
+{
+	return (giorno - 1) / 7;
+}
+
+/** Cerca un giorno tra le eccezioni della regola.
+ * @param[in] regola Regola
+ * @param[in] giorno Giorno giuliano
+ * @param[out] posizione Posizione del giorno o nella quale inserirlo
+ * @return TRUE se il giorno è un'eccezione
+ */
+static bool cerca_eccezione(const regola_t *regola, guint giorno, guint &posizione)
+{
+	guint inizio = 0, fine = regola->eccezioni->len;
+	while (inizio < fine){
+		guint medio = (inizio + fine) / 2;
+		if (g_array_index(regola->eccezioni, guint, medio) < giorno)
+			inizio = medio + 1;
+		else
+			fine = medio;
+	}
+
+	posizione = inizio;
+
+	return inizio < regola->eccezioni->len && g_array_index(regola->eccezioni, guint, inizio) == giorno;
 }
 
 /** Funzione di comparazione per l'inserimento in ordine dei campi.
@@ -63,7 +143,7 @@ static int confronta_data(const char *a, const char *b)
 
 	for (int i = 0; i < 2; i++)
 		if ( a[i] != b[i] )
-			return ( a[6+i] - b[6+i] );
+			return ( a[i] - b[i] );
 	return 0;
 }
 
@@ -92,6 +172,101 @@ static int inserisci_in_ordine_ora(gconstpointer a, gconstpointer b)
 	return 1;
 }
 
+/** Ritorna la prima posizione del vettore ordinato in cui l'elemento può essere inserito.
+ * L'elemento va prima di tutti quelli che non lo precedono, come in g_list_insert_sorted()
+ * @param[in] vettore Vettore ordinato secondo confronta
+ * @param[in] elemento Elemento da cercare
+ * @param[in] confronta Funzione di comparazione del vettore
+ * @return Posizione
+ */
+static guint cerca_in_ordine(const GPtrArray *vettore, gconstpointer elemento, GCompareFunc confronta)
+{
+	guint inizio = 0, fine = vettore->len;
+	while (inizio < fine){
+		guint medio = (inizio + fine) / 2;
+		if ( confronta(elemento, g_ptr_array_index(vettore, medio)) > 0 )
+			inizio = medio + 1;
+		else
+			fine = medio;
+	}
+
+	return inizio;
+}
+
+/** Inserisce l'elemento nel vettore mantenendone l'ordine.
+ */
+static void inserisci_in_ordine(GPtrArray *vettore, gpointer elemento, GCompareFunc confronta)
+{
+	g_ptr_array_insert(vettore, cerca_in_ordine(vettore, elemento, confronta), elemento);
+}
+
+/** Toglie l'elemento dal vettore ordinato mantenendone l'ordine.
+ * L'elemento viene cercato tra quelli equivalenti secondo confronta
+ * @return TRUE se l'elemento era nel vettore
+ */
+static bool togli_in_ordine(GPtrArray *vettore, gconstpointer elemento, GCompareFunc confronta)
+{
+	for (guint i = cerca_in_ordine(vettore, elemento, confronta); i < vettore->len; i++)
+		if (g_ptr_array_index(vettore, i) == elemento){
+			g_ptr_array_remove_index(vettore, i);
+			return true;
+		}
+
+	//confronta potrebbe non essere coerente con l'ordine del vettore
+	return g_ptr_array_remove(vettore, (gpointer) elemento);
+}
+
+/** Toglie l'elemento dal vettore mantenendone l'ordine.
+ * La ricerca parte dal fondo, così svuotare il vettore dall'ultimo elemento costa un passo per elemento
+ * @return TRUE se l'elemento era nel vettore
+ */
+static bool togli_da_vettore(GPtrArray *vettore, gconstpointer elemento)
+{
+	for (guint i = vettore->len; i > 0; i--)
+		if (g_ptr_array_index(vettore, i - 1) == elemento){
+			g_ptr_array_remove_index(vettore, i - 1);
+			return true;
+		}
+
+	return false;
+}
+
+/** Copia i dati di testo di un giocatore in un unico blocco.
+ * I dati nulli vengono memorizzati come stringhe vuote
+ * @param[in] dati Dati di testo nell'ordine di dato_giocatore_t
+ * @param[out] inizio Posizione di ciascun dato nel blocco
+ * @return Blocco da deallocare con g_free, 0 se non c'è memoria o i dati sono troppo lunghi
+ */
+static char *componi_testi(const char *dati[], guint16 inizio[])
+{
+	gsize lunghezze[N_DATI_GIOCATORE];
+	gsize totale = 0;
+
+	for (int i = 0; i < N_DATI_GIOCATORE; i++){
+		lunghezze[i] = (dati[i] != 0) ? strlen(dati[i]) : 0;
+		totale += lunghezze[i] + 1;
+	}
+
+	//l'ultimo dato deve iniziare entro la posizione massima di inizio
+	if (totale - lunghezze[N_DATI_GIOCATORE - 1] - 1 > G_MAXUINT16){
+		D1(cout<<"Dati del giocatore troppo lunghi"<<endl)
+		return 0;
+	}
+
+	char *testi = (char *) g_try_malloc(totale);
+	if (testi == 0) return 0;
+
+	gsize pos = 0;
+	for (int i = 0; i < N_DATI_GIOCATORE; i++){
+		inizio[i] = pos;
+		memcpy(testi + pos, (dati[i] != 0) ? dati[i] : "", lunghezze[i]);
+		testi[pos + lunghezze[i]] = '\0';
+		pos += lunghezze[i] + 1;
+	}
+
+	return testi;
+}
+
 /* Fine definizioni private */
 
 /* Inizio definizioni delle funzioni pubbliche del modulo */
@@ -108,9 +283,16 @@ circolo_t *inizializza_circolo(const char nome[], const char indirizzo[], const
 	circolo->telefono = g_string_new(telefono);
 	circolo->n_campi = 0;
 	circolo->n_soci = 0;
-	circolo->giocatori = 0;
-	circolo->campi = 0;
+	circolo->giocatori = g_ptr_array_new();
+	circolo->campi = g_ptr_array_new();
+	circolo->corsi = 0;
 	circolo->pros_id = 0;
+	circolo->osservatori = 0;
+	circolo->istantanee = 0;
+	circolo->ricerca = 0;
+	circolo->giorni = 0;
+	circolo->occupazione = 0;
+	circolo->orari = ORARI_PREDEFINITI;
 
 	return circolo;
 }
@@ -125,44 +307,40 @@ giocatore_t *aggiungi_giocatore(const char nome[], const char cognome[], const c
 	//Creazione giocatore
 	giocatore_t *giocatore = 0;
 	
+	const char *dati[N_DATI_GIOCATORE] = { nome, cognome, nascita, tessera, telefono, email, classifica, circolo_g };
+	guint16 inizio[N_DATI_GIOCATORE];
+	char *testi = componi_testi(dati, inizio);
+	if (testi == 0) return 0;
+
 	if (vecchio == NULL){
 		giocatore = g_try_new(giocatore_t, 1);
-		if (giocatore == 0) return 0;	
+		if (giocatore == 0){
+			g_free(testi);
+			return 0;
+		}
 		giocatore->ID = ++(circolo->pros_id);
 		D1(cout<<"Memoria per giocatore allocata correttamente"<<endl)
 	} else {
 		//rimozione vecchie informazioni
 		giocatore = vecchio;
-
-		g_string_free(giocatore->nome, TRUE);
-		g_string_free(giocatore->cognome, TRUE);
-		g_string_free(giocatore->email, TRUE);
-		g_string_free(giocatore->nascita, TRUE);
-		g_string_free(giocatore->tessera, TRUE);
-		g_string_free(giocatore->telefono, TRUE);
-		g_string_free(giocatore->classifica, TRUE);
-		g_string_free(giocatore->circolo, TRUE);
+		g_free(giocatore->testi);
 	}
 	
 	//Inserimento informazioni
-	giocatore->nome = g_string_new(nome);
-	giocatore->cognome = g_string_new(cognome);
-	giocatore->email = g_string_new(email);
-	giocatore->nascita = g_string_new(nascita);
-	giocatore->tessera = g_string_new(tessera);
-	giocatore->telefono = g_string_new(telefono);
-	giocatore->classifica = g_string_new(classifica);
-	giocatore->circolo = g_string_new(circolo_g);
+	memcpy(giocatore->inizio, inizio, sizeof(inizio));
+	giocatore->testi = testi;
 	giocatore->socio = false;
 	giocatore->retta = false;
 	D1(cout<<"Informazioni giocatore create"<<endl)
 
 	if (vecchio == NULL){
 		//Aggancio al Circolo
-		circolo->giocatori = g_list_append(circolo->giocatori, giocatore);
+		g_ptr_array_add(circolo->giocatori, giocatore);
 		D1(cout<<"giocatore agganciato"<<endl)
 	}
 
+	notifica_modifica(circolo, (vecchio == NULL) ? INSERIMENTO : AGGIORNAMENTO, ELEM_GIOCATORE, giocatore, circolo);
+
 	return giocatore;
 }
 
@@ -179,6 +357,8 @@ giocatore_t *aggiungi_socio	(const char nome[], const char cognome[], const char
 	socio->retta = retta;
 
 	circolo->n_soci++;
+
+	notifica_modifica(circolo, AGGIORNAMENTO, ELEM_GIOCATORE, socio, circolo);
 	
 	return socio;
 }
@@ -194,7 +374,10 @@ campo_t *aggiungi_campo(int numero, copertura_t copertura, terreno_t terreno, co
 		//Creazione campo
 		campo = g_try_new(campo_t, 1);
 		if (campo == 0) return 0;
-		campo->ore = 0;
+		campo->ore = g_ptr_array_new();
+		campo->regole = 0;
+		campo->circolo = circolo;
+		campo->orari.apertura = campo->orari.chiusura = campo->orari.passo = 0;
 		D1(cout<<"Memoria per campo allocata correttamente"<<endl)
 	} else {
 		//rimozione vecchie informazioni
@@ -213,15 +396,19 @@ campo_t *aggiungi_campo(int numero, copertura_t copertura, terreno_t terreno, co
 	if (vecchio == NULL){
 		//Aggancio al Circolo
 		circolo->n_campi++;
-		circolo->campi = g_list_insert_sorted(circolo->campi, campo, inserisci_in_ordine_campo);
+		inserisci_in_ordine(circolo->campi, campo, inserisci_in_ordine_campo);
 		D1(cout<<"Campo agganciato"<<endl)
 	}
 
+	notifica_modifica(circolo, (vecchio == NULL) ? INSERIMENTO : AGGIORNAMENTO, ELEM_CAMPO, campo, circolo);
+
 	return campo;
 }
 
 ora_t *aggiungi_ora(int orario, const char data[], int durata, giocatore_t *prenotante, campo_t *campo)
 {
+	TEMPO("accesso_dati: aggiungi_ora")
+
 	//Controllo validità campo
 	if (campo == 0) return 0;
 
@@ -235,21 +422,279 @@ ora_t *aggiungi_ora(int orario, const char data[], int durata, giocatore_t *pren
 	ora->data = g_string_new(data);
 	ora->durata = durata;
 	ora->prenotante = prenotante;
+	ora->regola = 0;
+	ora->corso = 0;
 	D1(cout<<"Informazioni inserite"<<endl)
 
 	//Aggancio al campo
-	campo->ore = g_list_insert_sorted(campo->ore, ora, inserisci_in_ordine_ora);
+	inserisci_in_ordine(campo->ore, ora, inserisci_in_ordine_ora);
 	D1(cout<<"Ora agganciata"<<endl)
 
+	notifica_modifica(campo->circolo, INSERIMENTO, ELEM_ORA, ora, campo);
+
 	return ora;
 }
 
+regola_t *aggiungi_regola(int ID, int orario, int durata, guint inizio, guint fine, int giorni, int settimane,
+			giocatore_t *prenotante, corso_t *corso, campo_t *campo)
+{
+	if (campo == 0 || prenotante == 0) return 0;
+	if (durata <= 0 || inizio == 0 || inizio > fine || settimane <= 0) return 0;
+	if ( (giorni & 0x7f) == 0 || (giorni & ~0x7f) != 0 ) return 0;
+
+	//nuovo ID: il successivo al massimo tra le regole del campo
+	if (ID <= 0){
+		ID = 0;
+		for (GList *tmp = campo->regole; tmp != NULL; tmp = g_list_next(tmp))
+			ID = MAX(ID, ((regola_t *) tmp->data)->ID);
+		ID++;
+	}
+
+	regola_t *regola = g_try_new(regola_t, 1);
+	if (regola == 0) return 0;
+
+	regola->ID = ID;
+	regola->orario = orario;
+	regola->durata = durata;
+	regola->inizio = inizio;
+	regola->fine = fine;
+	regola->giorni = giorni;
+	regola->settimane = settimane;
+	regola->eccezioni = g_array_new(FALSE, FALSE, sizeof(guint));
+	regola->prenotante = prenotante;
+	regola->corso = corso;
+
+	campo->regole = g_list_append(campo->regole, regola);
+
+	notifica_modifica(campo->circolo, INSERIMENTO, ELEM_REGOLA, regola, campo);
+
+	return regola;
+}
+
+bool aggiungi_eccezione(regola_t *regola, guint giorno, campo_t *campo)
+{
+	if (regola == 0 || campo == 0) return false;
+	if ( !regola_nel_giorno(regola, giorno) ) return false;
+
+	guint posizione;
+	cerca_eccezione(regola, giorno, posizione);
+	g_array_insert_val(regola->eccezioni, posizione, giorno);
+
+	notifica_modifica(campo->circolo, AGGIORNAMENTO, ELEM_REGOLA, regola, campo);
+
+	return true;
+}
+
+bool sposta_regola(regola_t *regola, int orario, int giorni, campo_t *campo)
+{
+	if (regola == 0 || campo == 0) return false;
+	if ( (int) regola->inizio + giorni <= 0 ) return false;
+	if (regola->settimane != 1 && giorni % 7 != 0) return false;
+
+	//la maschera dei giorni ruota di giorni posizioni sui sette giorni
+	int rotazione = ((giorni % 7) + 7) % 7;
+	regola->giorni = ( (regola->giorni << rotazione) | (regola->giorni >> (7 - rotazione)) ) & 0x7f;
+
+	regola->orario = orario;
+	regola->inizio += giorni;
+	regola->fine += giorni;
+	for (guint i = 0; i < regola->eccezioni->len; i++)
+		g_array_index(regola->eccezioni, guint, i) += giorni;
+
+	notifica_modifica(campo->circolo, AGGIORNAMENTO, ELEM_REGOLA, regola, campo);
+
+	return true;
+}
+
+bool regola_nel_giorno(const regola_t *regola, guint giorno)
+{
+	if (giorno < regola->inizio || giorno > regola->fine)
+		return false;
+
+	if ( (regola->giorni & (1 << ((giorno - 1) % 7))) == 0 )
+		return false;
+
+	if ( (settimana(giorno) - settimana(regola->inizio)) % regola->settimane != 0 )
+		return false;
+
+	guint posizione;
+	return !cerca_eccezione(regola, giorno, posizione);
+}
+
+guint prossima_occorrenza(const regola_t *regola, guint giorno)
+{
+	giorno = MAX(giorno, regola->inizio);
+
+	while (giorno <= regola->fine){
+		guint salto = (settimana(giorno) - settimana(regola->inizio)) % regola->settimane;
+
+		//settimana senza occorrenze: si passa al lunedì della prossima valida
+		if (salto != 0){
+			giorno = (settimana(giorno) + regola->settimane - salto) * 7 + 1;
+			continue;
+		}
+
+		if ( regola_nel_giorno(regola, giorno) )
+			return giorno;
+
+		giorno++;
+	}
+
+	return 0;
+}
+
+bool orari_validi(int apertura, int chiusura, int passo)
+{
+	if (passo <= 0 || apertura < 0 || chiusura > 24*60 || apertura >= chiusura)
+		return false;
+
+	return (chiusura - apertura) % passo == 0;
+}
+
+bool imposta_orari_circolo(circolo_t *circolo, int apertura, int chiusura, int passo)
+{
+	if (circolo == 0) return false;
+	if ( !orari_validi(apertura, chiusura, passo) ) return false;
+
+	circolo->orari.apertura = apertura;
+	circolo->orari.chiusura = chiusura;
+	circolo->orari.passo = passo;
+
+	notifica_modifica(circolo, AGGIORNAMENTO, ELEM_CIRCOLO, circolo, circolo);
+
+	return true;
+}
+
+bool imposta_orari_campo(campo_t *campo, int apertura, int chiusura, int passo)
+{
+	if (campo == 0) return false;
+
+	if (passo == 0)
+		apertura = chiusura = 0;
+	else if ( !orari_validi(apertura, chiusura, passo) )
+		return false;
+
+	campo->orari.apertura = apertura;
+	campo->orari.chiusura = chiusura;
+	campo->orari.passo = passo;
+
+	notifica_modifica(campo->circolo, AGGIORNAMENTO, ELEM_CAMPO, campo, campo->circolo);
+
+	return true;
+}
+
+const orari_t *get_orari_campo(const campo_t *campo)
+{
+	if (campo->orari.passo != 0)
+		return &campo->orari;
+
+	return &campo->circolo->orari;
+}
+
+bool orario_valido(const campo_t *campo, int orario, int durata)
+{
+	if (campo == 0) return false;
+
+	const orari_t *orari = get_orari_campo(campo);
+
+	if (orario < orari->apertura || durata <= 0 || orario + durata > orari->chiusura)
+		return false;
+
+	return (orario - orari->apertura) % orari->passo == 0 && durata % orari->passo == 0;
+}
+
+const char *dato_giocatore(const giocatore_t *giocatore, dato_giocatore_t dato)
+{
+	return giocatore->testi + giocatore->inizio[dato];
+}
+
 const char *get_nome_ora(ora_t *ora)
 {
 	if (ora == NULL)
 		return 0;
 
-	return ora->prenotante->cognome->str;
+	if (ora->corso != 0)
+		return ora->corso->nome->str;
+
+	return dato_giocatore(ora->prenotante, DATO_COGNOME);
+}
+
+corso_t *aggiungi_corso(int ID, const char nome[], giocatore_t *istruttore, circolo_t *circolo)
+{
+	if (circolo == 0 || istruttore == 0) return 0;
+	if (nome == 0 || nome[0] == '\0') return 0;
+
+	//nuovo ID: il successivo al massimo tra i corsi del circolo
+	if (ID <= 0){
+		ID = 0;
+		for (GList *tmp = circolo->corsi; tmp != NULL; tmp = g_list_next(tmp))
+			ID = MAX(ID, ((corso_t *) tmp->data)->ID);
+		ID++;
+	}
+
+	corso_t *corso = g_try_new(corso_t, 1);
+	if (corso == 0) return 0;
+
+	corso->ID = ID;
+	corso->nome = g_string_new(nome);
+	corso->istruttore = istruttore;
+	corso->iscritti = 0;
+
+	circolo->corsi = g_list_append(circolo->corsi, corso);
+
+	notifica_modifica(circolo, INSERIMENTO, ELEM_CORSO, corso, circolo);
+
+	return corso;
+}
+
+bool iscrivi_corso(corso_t *corso, giocatore_t *giocatore, circolo_t *circolo)
+{
+	if (corso == 0 || giocatore == 0) return false;
+	if ( g_list_find(corso->iscritti, giocatore) != NULL ) return false;
+
+	corso->iscritti = g_list_append(corso->iscritti, giocatore);
+
+	notifica_modifica(circolo, AGGIORNAMENTO, ELEM_CORSO, corso, circolo);
+
+	return true;
+}
+
+bool ritira_corso(corso_t *corso, giocatore_t *giocatore, circolo_t *circolo)
+{
+	if (corso == 0 || giocatore == 0) return false;
+	if ( g_list_find(corso->iscritti, giocatore) == NULL ) return false;
+
+	corso->iscritti = g_list_remove(corso->iscritti, giocatore);
+
+	notifica_modifica(circolo, AGGIORNAMENTO, ELEM_CORSO, corso, circolo);
+
+	return true;
+}
+
+bool elimina_corso(corso_t *corso, circolo_t *circolo)
+{
+	if (circolo == 0) return false;
+	if (corso == 0) return false;
+
+	//prima le lezioni, così gli osservatori non vedono regole di un corso rimosso
+	for (guint i = 0; i < circolo->campi->len; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+		GList *tmp_r = campo->regole;
+		while(tmp_r != NULL){
+			regola_t *regola = (regola_t *) tmp_r->data;
+			tmp_r = g_list_next(tmp_r);
+
+			if (regola->corso == corso)
+				elimina_regola(regola, campo);
+		}
+	}
+
+	notifica_modifica(circolo, RIMOZIONE, ELEM_CORSO, corso, circolo);
+
+	circolo->corsi = g_list_remove(circolo->corsi, corso);
+	dealloca_corso(corso);
+
+	return true;
 }
 
 bool elimina_socio(giocatore_t *socio, circolo_t *circolo)
@@ -261,6 +706,8 @@ bool elimina_socio(giocatore_t *socio, circolo_t *circolo)
 	socio->socio = false;
 	circolo->n_soci--;	
 
+	notifica_modifica(circolo, AGGIORNAMENTO, ELEM_GIOCATORE, socio, circolo);
+
 	return true;
 	
 }
@@ -272,37 +719,55 @@ bool elimina_giocatore(giocatore_t *giocatore, circolo_t *circolo)
 	if (circolo == 0) return false;
 	if (giocatore == 0) return false;
 
-	//elimino ora associate al giocatore
-	GList *tmp = circolo->campi;
+	//elimino i corsi di cui è istruttore e lo ritiro dagli altri
+	GList *tmp = circolo->corsi;
 	while(tmp != NULL){
-		campo_t *campo = (campo_t *) tmp->data;
-		GList *list = cerca_lista_int(campo->ore, prenotante, (int) giocatore, ora_t);
-		GList *tmp_ = list;
-		while(tmp_ != NULL){
-			ora_t *ora = (ora_t *) tmp_->data;
-			elimina_file_ora(ora, campo, circolo);
-			elimina_ora(ora, campo);
+		corso_t *corso = (corso_t *) tmp->data;
+		tmp = g_list_next(tmp);
 
-			tmp_ = g_list_next(tmp_);	
+		if (corso->istruttore == giocatore){
+			elimina_file_corso_async(corso, circolo, NULL, NULL);
+			elimina_corso(corso, circolo);
 		}
-		g_list_free(list);
+		else if ( ritira_corso(corso, giocatore, circolo) )
+			salva_corso_async(corso, circolo, NULL, NULL);
+	}
 
-		tmp = g_list_next(tmp);	
+	//elimino ora associate al giocatore
+	for (guint i = 0; i < circolo->campi->len; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+		condizione_t prenotate = ora_di_prenotante(giocatore);
+		cursore_t ore = scorri_ore(campo, prenotate);
+		for (ora_t *ora = prossima_ora(ore); ora != 0; ora = prossima_ora(ore)){
+			elimina_file_ora_async(ora, campo, circolo, NULL, NULL);
+			elimina_ora(ora, campo);
+		}
+
+		//e le prenotazioni ricorrenti
+		GList *tmp_r = campo->regole;
+		while(tmp_r != NULL){
+			regola_t *regola = (regola_t *) tmp_r->data;
+			tmp_r = g_list_next(tmp_r);
+
+			if (regola->prenotante != giocatore)
+				continue;
+
+			elimina_file_regola_async(regola, campo, circolo, NULL, NULL);
+			elimina_regola(regola, campo);
+		}
 	}
 
 	D1(cout<<"Ore associate eliminate"<<endl)
-	
-	g_string_free(giocatore->nome, true);
-	g_string_free(giocatore->cognome, true);
-	g_string_free(giocatore->email, true);
 
-	delete giocatore;
+	notifica_modifica(circolo, RIMOZIONE, ELEM_GIOCATORE, giocatore, circolo);
 
-	D1(cout<<"giocatore deallocato"<<endl)
-
-	circolo->giocatori = g_list_remove(circolo->giocatori, giocatore);
+	togli_da_vettore(circolo->giocatori, giocatore);
 
 	D1(cout<<"giocatore eliminato dalla lista"<<endl)
+	
+	dealloca_giocatore(giocatore);
+
+	D1(cout<<"giocatore deallocato"<<endl)
 
 	return true;	
 }
@@ -314,12 +779,11 @@ bool elimina_campo(campo_t *campo, circolo_t *circolo)
 	if (circolo == 0) return false;
 	if (campo == 0) return false;
 
-	g_string_free(campo->note, true);
-	g_list_free_full(campo->ore, dealloca_ora);
+	notifica_modifica(circolo, RIMOZIONE, ELEM_CAMPO, campo, circolo);
 
-	delete campo;
+	togli_da_vettore(circolo->campi, campo);
+	dealloca_campo(campo);
 
-	circolo->campi = g_list_remove(circolo->campi, campo);
 	circolo->n_campi--;
 	
 	return true;
@@ -332,30 +796,99 @@ bool elimina_ora(ora_t *ora, campo_t *campo)
 	if (campo == 0) return false;
 	if (ora == 0) return false;
 
+	notifica_modifica(campo->circolo, RIMOZIONE, ELEM_ORA, ora, campo);
+
+	togli_in_ordine(campo->ore, ora, inserisci_in_ordine_ora);
 	dealloca_ora(ora);
-	campo->ore = g_list_remove(campo->ore, ora);
 
 	return true;
 	
 }
 
+bool elimina_regola(regola_t *regola, campo_t *campo)
+{
+	if (campo == 0) return false;
+	if (regola == 0) return false;
+
+	notifica_modifica(campo->circolo, RIMOZIONE, ELEM_REGOLA, regola, campo);
+
+	campo->regole = g_list_remove(campo->regole, regola);
+	dealloca_regola(regola);
+
+	return true;
+}
+
 bool elimina_circolo(circolo_t *&circolo)
 {
 	if (circolo == 0) return false;
 
+	//Gli osservatori vengono avvisati una sola volta per l'intero circolo
+	notifica_modifica(circolo, RIMOZIONE, ELEM_CIRCOLO, circolo, circolo);
+	g_list_free_full(circolo->osservatori, g_free);
+	circolo->osservatori = 0;
+
 	g_string_free(circolo->nome, true);
 	g_string_free(circolo->indirizzo, true);
 	g_string_free(circolo->email, true);
 	g_string_free(circolo->telefono, true);
-	g_list_foreach(circolo->campi, (GFunc) elimina_campo, circolo);
-	g_list_foreach(circolo->giocatori, (GFunc) elimina_giocatore, circolo);
-	g_list_free(circolo->campi);
-	g_list_free(circolo->giocatori);
-
-	delete circolo;
+	//i vettori vengono svuotati dal fondo, così ogni eliminazione trova subito l'elemento
+	while (circolo->campi->len > 0)
+		elimina_campo( (campo_t *) g_ptr_array_index(circolo->campi, circolo->campi->len - 1), circolo );
+	//i corsi vanno deallocati prima dei giocatori, senza toccare i loro file
+	g_list_free_full(circolo->corsi, dealloca_corso);
+	circolo->corsi = 0;
+	while (circolo->giocatori->len > 0)
+		elimina_giocatore( (giocatore_t *) g_ptr_array_index(circolo->giocatori, circolo->giocatori->len - 1), circolo );
+	g_ptr_array_free(circolo->campi, TRUE);
+	g_ptr_array_free(circolo->giocatori, TRUE);
+
+	g_free(circolo);
 	circolo = 0;
 
 	return true;	
 }
 
+void aggiungi_osservatore(circolo_t *circolo, osservatore_t funzione, gpointer dati)
+{
+	if (circolo == 0) return;
+
+	registrazione_t *reg = g_new(registrazione_t, 1);
+	reg->funzione = funzione;
+	reg->dati = dati;
+
+	circolo->osservatori = g_list_append(circolo->osservatori, reg);
+}
+
+void rimuovi_osservatore(circolo_t *circolo, osservatore_t funzione, gpointer dati)
+{
+	if (circolo == 0) return;
+
+	GList *tmp = circolo->osservatori;
+	while(tmp != NULL){
+		registrazione_t *reg = (registrazione_t *) tmp->data;
+		if (reg->funzione == funzione && reg->dati == dati){
+			circolo->osservatori = g_list_delete_link(circolo->osservatori, tmp);
+			g_free(reg);
+			return;
+		}
+
+		tmp = g_list_next(tmp);
+	}
+}
+
+void notifica_modifica(circolo_t *circolo, modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore)
+{
+	if (circolo == 0) return;
+
+	GList *tmp = circolo->osservatori;
+	while(tmp != NULL){
+		//l'osservatore può rimuoversi durante la notifica
+		GList *succ = g_list_next(tmp);
+		registrazione_t *reg = (registrazione_t *) tmp->data;
+		reg->funzione(modifica, tipo, elemento, contenitore, reg->dati);
+
+		tmp = succ;
+	}
+}
+
 /* Fine definizione pubbliche */
@@ -10,6 +10,25 @@
 
 /* Inizio interfaccia del modulo accesso_dati */
 
+/** Tipo di modifica notificata agli osservatori.
+ * L'inserimento e l'aggiornamento vengono notificati a modifica avvenuta,
+ * la rimozione prima che l'elemento venga staccato e deallocato
+ */
+enum modifica_t {INSERIMENTO = 0, AGGIORNAMENTO, RIMOZIONE};
+
+/** Tipo dell'elemento a cui si riferisce la modifica.
+ */
+enum elemento_t {ELEM_CIRCOLO = 0, ELEM_GIOCATORE, ELEM_CAMPO, ELEM_ORA, ELEM_REGOLA, ELEM_CORSO};
+
+/** Funzione chiamata a ogni modifica dei dati del circolo.
+ * @param[in] modifica Tipo di modifica
+ * @param[in] tipo Tipo dell'elemento modificato
+ * @param[in] elemento Puntatore all'elemento modificato
+ * @param[in] contenitore Campo per le ore e le regole, circolo per gli altri elementi, compresi i corsi
+ * @param[in] dati Dati passati alla registrazione dell'osservatore
+ */
+typedef void (*osservatore_t)(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati);
+
 /** Inizializza il Circolo con i dati della società.
  * Crea una struttura di tipo circolo_t con i dati passati come parametri e 
  * la ritorna
@@ -23,7 +42,9 @@ circolo_t *inizializza_circolo(const char nome[], const char indirizzo[], const
 
 /** Aggiunge o modifica un giocatore al Circolo.
  * Crea un nuovo socio con i dati passati e lo aggancia alla lista soci del circolo
- * se gli si passa un vecchio giocatore giocatore modifica i dati di quest'ultimo
+ * se gli si passa un vecchio giocatore giocatore modifica i dati di quest'ultimo.
+ * I dati di testo vengono copiati in un unico blocco: la modifica rialloca solo il blocco
+ * e se fallisce il vecchio giocatore resta invariato
  * @param[in] nome Nome del giocatore
  * @param[in] cognome Cognome del giocatore
  * @param[in] nascita Data di nascita del giocatore nel formato (gg/mm/aaaa)
@@ -81,8 +102,103 @@ campo_t *aggiungi_campo(int numero, copertura_t copertura, terreno_t terreno, co
  */
 ora_t *aggiungi_ora(int orario, const char data[], int durata, giocatore_t *prenotante, campo_t *campo);
 
+/** Aggiunge una prenotazione ricorrente al campo.
+ * La regola viene memorizzata una sola volta, le sue occorrenze non vengono create
+ * @param[in] ID ID della regola, 0 per assegnarne uno nuovo
+ * @param[in] orario Orario delle occorrenze in minuti
+ * @param[in] durata Durata delle occorrenze in minuti
+ * @param[in] inizio Giorno giuliano della prima occorrenza possibile
+ * @param[in] fine Giorno giuliano dell'ultima occorrenza possibile
+ * @param[in] giorni Giorni della settimana, bit 0 il lunedì e bit 6 la domenica
+ * @param[in] settimane Ripete la regola una settimana ogni settimane
+ * @param[in] prenotante Prenotante delle occorrenze
+ * @param[in] corso Corso di cui la regola programma le lezioni, 0 se non è di un corso
+ * @param[in,out] campo Campo al quale aggiungere la regola
+ * @return Puntatore alla regola appena creata, 0 se i dati non sono validi
+ */
+regola_t *aggiungi_regola(int ID, int orario, int durata, guint inizio, guint fine, int giorni, int settimane,
+			giocatore_t *prenotante, corso_t *corso, campo_t *campo);
+
+/** Annulla una occorrenza della regola.
+ * @param[in,out] regola Regola
+ * @param[in] giorno Giorno giuliano dell'occorrenza
+ * @param[in,out] campo Campo della regola
+ * @return successo (TRUE) o fallimento (FALSE) se la regola non si ripete nel giorno
+ */
+bool aggiungi_eccezione(regola_t *regola, guint giorno, campo_t *campo);
+
+/** Controlla se la regola ha un'occorrenza nel giorno.
+ * @param[in] regola Regola
+ * @param[in] giorno Giorno giuliano
+ * @return TRUE se la regola si ripete nel giorno e non è annullata
+ */
+bool regola_nel_giorno(const regola_t *regola, guint giorno);
+
+/** Ritorna la prima occorrenza della regola a partire da un giorno.
+ * Salta le settimane in cui la regola non si ripete, permette di scorrere
+ * le occorrenze senza crearle
+ * @param[in] regola Regola
+ * @param[in] giorno Primo giorno giuliano da considerare
+ * @return Giorno giuliano dell'occorrenza, 0 se non ce ne sono altre
+ */
+guint prossima_occorrenza(const regola_t *regola, guint giorno);
+
+/** Controlla gli orari di prenotazione.
+ * L'intervallo di apertura deve stare nella giornata e contenere un numero intero di slot
+ * @param[in] apertura Orario di apertura in minuti
+ * @param[in] chiusura Orario di chiusura in minuti
+ * @param[in] passo Durata di uno slot in minuti
+ * @return TRUE se gli orari sono validi
+ */
+bool orari_validi(int apertura, int chiusura, int passo);
+
+/** Imposta gli orari di prenotazione del circolo.
+ * Valgono per tutti i campi che non hanno orari propri
+ * @param[in,out] circolo Circolo
+ * @param[in] apertura Orario di apertura in minuti
+ * @param[in] chiusura Orario di chiusura in minuti
+ * @param[in] passo Durata di uno slot in minuti
+ * @return successo (TRUE) o fallimento (FALSE) se gli orari non sono validi
+ */
+bool imposta_orari_circolo(circolo_t *circolo, int apertura, int chiusura, int passo);
+
+/** Imposta gli orari di prenotazione propri del campo.
+ * @param[in,out] campo Campo
+ * @param[in] apertura Orario di apertura in minuti
+ * @param[in] chiusura Orario di chiusura in minuti
+ * @param[in] passo Durata di uno slot in minuti, 0 per usare gli orari del circolo
+ * @return successo (TRUE) o fallimento (FALSE) se gli orari non sono validi
+ */
+bool imposta_orari_campo(campo_t *campo, int apertura, int chiusura, int passo);
+
+/** Restituisce gli orari di prenotazione in vigore per il campo.
+ * @param[in] campo Campo
+ * @return Orari propri del campo se impostati, altrimenti quelli del circolo
+ */
+const orari_t *get_orari_campo(const campo_t *campo);
+
+/** Controlla che un'ora rispetti gli orari del campo.
+ * L'ora deve cadere tra apertura e chiusura, iniziare all'inizio di uno slot
+ * e durare un numero intero di slot
+ * @param[in] campo Campo
+ * @param[in] orario Orario in minuti
+ * @param[in] durata Durata in minuti
+ * @return TRUE se l'ora rispetta gli orari
+ */
+bool orario_valido(const campo_t *campo, int orario, int durata);
+
+/** Restituisce un dato di testo del giocatore.
+ * Il testo punta nel blocco del giocatore e resta valido finché il giocatore
+ * non viene modificato o eliminato
+ * @param[in] giocatore Giocatore
+ * @param[in] dato Dato da leggere
+ * @return Testo del dato, stringa vuota se non impostato
+ */
+const char *dato_giocatore(const giocatore_t *giocatore, dato_giocatore_t dato);
+
 /** Restituisce il nome associato all'ora.
- * Il nome varia a seconda di che tipo è il prenotante
+ * Il nome varia a seconda di che tipo è il prenotante:
+ * il nome del corso per le sue lezioni, il cognome del giocatore per le altre ore
  * @param[in] ora Puntatore all'ora
  * @return Nome dell'ora
  */
@@ -98,7 +214,8 @@ const char *get_nome_ora(ora_t *ora);
 bool elimina_socio(giocatore_t *socio, circolo_t *circolo);
 
 /** Elimina il giocatore dal Circolo
- * Elimina i giocatore passato come parametro dal circolo
+ * Elimina i giocatore passato come parametro dal circolo;
+ * i corsi di cui è istruttore vengono eliminati e dagli altri viene ritirato
  * @param[in,out] giocatore Giocatore da eliminare
  * @param[in,out] circolo Circolo dal quale eliminare il giocatore
  */
@@ -120,6 +237,59 @@ bool elimina_campo(campo_t *campo, circolo_t *circolo);
  */
 bool elimina_ora(ora_t *ora, campo_t *campo);
 
+/** Elimina la prenotazione ricorrente dal campo.
+ * @param[in,out] regola Regola da eliminare
+ * @param[in,out] campo Campo dal quale eliminare la regola
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool elimina_regola(regola_t *regola, campo_t *campo);
+
+/** Sposta nel tempo tutte le occorrenze di una prenotazione ricorrente.
+ * Il periodo, i giorni della settimana e le eccezioni vengono spostati di giorni,
+ * l'orario diventa quello indicato; non controlla i conflitti con le altre prenotazioni.
+ * Una regola che non si ripete ogni settimana può essere spostata solo di settimane intere
+ * @param[in,out] regola Regola da spostare
+ * @param[in] orario Nuovo orario delle occorrenze
+ * @param[in] giorni Giorni di cui spostare le occorrenze, anche negativo
+ * @param[in,out] campo Campo della regola
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool sposta_regola(regola_t *regola, int orario, int giorni, campo_t *campo);
+
+/** Aggiunge un corso al circolo.
+ * Le lezioni del corso si programmano come prenotazioni ricorrenti dei campi
+ * @param[in] ID ID del corso, 0 per assegnarne uno nuovo
+ * @param[in] nome Nome del corso, mostrato nella tabella delle ore
+ * @param[in] istruttore Istruttore del corso, prenotante delle sue lezioni
+ * @param[in,out] circolo Circolo al quale aggiungere il corso
+ * @return Puntatore al corso appena creato, 0 se i dati non sono validi
+ */
+corso_t *aggiungi_corso(int ID, const char nome[], giocatore_t *istruttore, circolo_t *circolo);
+
+/** Iscrive un giocatore al corso.
+ * @param[in,out] corso Corso
+ * @param[in] giocatore Giocatore da iscrivere
+ * @param[in,out] circolo Circolo del corso
+ * @return successo (TRUE) o fallimento (FALSE) se il giocatore è già iscritto
+ */
+bool iscrivi_corso(corso_t *corso, giocatore_t *giocatore, circolo_t *circolo);
+
+/** Ritira un giocatore dal corso.
+ * @param[in,out] corso Corso
+ * @param[in] giocatore Giocatore da ritirare
+ * @param[in,out] circolo Circolo del corso
+ * @return successo (TRUE) o fallimento (FALSE) se il giocatore non è iscritto
+ */
+bool ritira_corso(corso_t *corso, giocatore_t *giocatore, circolo_t *circolo);
+
+/** Elimina il corso dal circolo.
+ * Elimina anche le regole con le lezioni del corso da tutti i campi
+ * @param[in,out] corso Corso da eliminare
+ * @param[in,out] circolo Circolo dal quale eliminare il corso
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool elimina_corso(corso_t *corso, circolo_t *circolo);
+
 /** Elimina il circolo dalla memoria.
  * Elimina dalla memoria i tutto il circolo
  * @param[in,out] circolo Circolo da eliminare
@@ -127,26 +297,30 @@ bool elimina_ora(ora_t *ora, campo_t *campo);
  */
 bool elimina_circolo(circolo_t *&circolo);
 
-/** Cerca all'interno della lista gli elementi corrispondeti ai dati passati, il confronto è tra interi.
- * Restituisce una lista con gli elementi corrispondenti alla ricerca
- * @param[in] lista Lista in cui cercare
- * @param[in] campo Campo della struttuara in cui cercare
- * @param[in] dati Dato di confronto
- * @param[in] tipo Tipo della struttura
- * @return Lista con gli elementi trovati
- */
-#define cerca_lista_int(lista, campo, dati, tipo) 		\
-({								\
-	GList *res = 0;						\
-	GList *tmp = lista;					\
-	while(tmp){						\
-		tipo *elemento = (tipo *) tmp->data;		\
-		if ( ((int) elemento->campo) == dati )			\
-			res = g_list_append(res, elemento);	\
-		tmp = g_list_next(tmp);				\
-	}							\
-	res;							\
-})
+/** Registra un osservatore sul circolo.
+ * La funzione verrà chiamata a ogni modifica dei dati del circolo
+ * @param[in,out] circolo Circolo da osservare
+ * @param[in] funzione Funzione da chiamare
+ * @param[in] dati Dati passati alla funzione
+ */
+void aggiungi_osservatore(circolo_t *circolo, osservatore_t funzione, gpointer dati);
+
+/** Rimuove un osservatore dal circolo.
+ * @param[in,out] circolo Circolo osservato
+ * @param[in] funzione Funzione registrata
+ * @param[in] dati Dati usati nella registrazione
+ */
+void rimuovi_osservatore(circolo_t *circolo, osservatore_t funzione, gpointer dati);
+
+/** Notifica una modifica a tutti gli osservatori del circolo.
+ * Utile quando un modulo esterno modifica direttamente i campi di un elemento
+ * @param[in] circolo Circolo modificato
+ * @param[in] modifica Tipo di modifica
+ * @param[in] tipo Tipo dell'elemento modificato
+ * @param[in] elemento Elemento modificato
+ * @param[in] contenitore Campo per le ore e le regole, circolo per gli altri elementi
+ */
+void notifica_modifica(circolo_t *circolo, modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore);
 
 /* Fine interfaccia del modulo accesso_dati */
 
@@ -0,0 +1,374 @@
+/**
+ * @file
+ * File contenente il modulo allocazione.
+ * Ogni campo viene diviso negli slot dei suoi orari; ogni richiesta può occupare
+ * una serie di slot consecutivi in uno dei campi, entro la sua tolleranza.
+ * Le richieste vengono assegnate una alla volta cercando un cammino aumentante come
+ * nell'algoritmo di Kuhn per gli abbinamenti: se il posto migliore è occupato da una sola
+ * richiesta, questa viene spostata altrove, anche a catena. Con richieste tutte di uno slot
+ * il risultato è un abbinamento massimo, con durate diverse resta un'ottima approssimazione.
+ * Un ultimo passaggio sposta le richieste assegnate nei posti liberi più vicini alle preferenze
+ */
+
+#include <glib.h>
+
+#include <cstdlib>
+
+#include "allocazione.h"
+#include "accesso_dati.h"
+#include "indice_giorni.h"
+#include "file_IO.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const int PENALITA_TERRENO = 60;	/**< Costo di un terreno non preferito, in minuti di spostamento */
+const int PENALITA_COPERTURA = 60;	/**< Costo di una copertura non preferita, in minuti di spostamento */
+const int BONUS_ADIACENZA = 5;		/**< Sconto per ogni lato attaccato a una prenotazione o agli orari del campo */
+const int SLOT_PRENOTATO = -2;		/**< Slot occupato da una prenotazione esistente */
+const int SLOT_LIBERO = -1;		/**< Slot libero, gli altri valori sono indici di richieste */
+const int PASSAGGI_MIGLIORAMENTO = 3;	/**< Passaggi massimi di avvicinamento alle preferenze */
+
+/** Slot di un campo nel giorno.
+ */
+struct griglia_t {
+	campo_t *campo;
+	const orari_t *orari;
+	int n_slot;
+	int *slot;
+};
+
+/** Posto possibile per una richiesta: n slot a partire da primo nella griglia.
+ */
+struct opzione_t {
+	int griglia;
+	int primo;
+	int n;
+	int costo;
+};
+
+/** Stato dell'allocazione.
+ * opzioni contiene per ogni richiesta i suoi posti in ordine di costo,
+ * scelta l'indice del posto assegnato o -1
+ */
+struct allocazione_t {
+	GArray *griglie;
+	GArray **opzioni;
+	int *scelta;
+	bool *visitata;
+	int n;
+};
+
+/** Prepara gli slot dei campi segnando quelli occupati dalle prenotazioni del giorno.
+ */
+static GArray *prepara_griglie(circolo_t *circolo, guint giorno)
+{
+	GArray *griglie = g_array_new(FALSE, FALSE, sizeof(griglia_t));
+
+	for (guint i = 0; i < circolo->campi->len; i++){
+		griglia_t griglia;
+		griglia.campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+		griglia.orari = get_orari_campo(griglia.campo);
+		griglia.n_slot = (griglia.orari->chiusura - griglia.orari->apertura) / griglia.orari->passo;
+		griglia.slot = g_new(int, griglia.n_slot);
+
+		for (int s = 0; s < griglia.n_slot; s++)
+			griglia.slot[s] = SLOT_LIBERO;
+
+		const GPtrArray *ore = ore_del_giorno(circolo, griglia.campo, giorno);
+		for (guint i = 0; ore != 0 && i < ore->len; i++){
+			ora_t *ora = (ora_t *) g_ptr_array_index(ore, i);
+			int primo = (ora->orario - griglia.orari->apertura) / griglia.orari->passo;
+			int ultimo = (ora->orario + ora->durata - griglia.orari->apertura - 1) / griglia.orari->passo;
+
+			for (int s = MAX(primo, 0); s <= ultimo && s < griglia.n_slot; s++)
+				griglia.slot[s] = SLOT_PRENOTATO;
+		}
+
+		g_array_append_val(griglie, griglia);
+	}
+
+	return griglie;
+}
+
+static gint confronta_opzioni(gconstpointer a, gconstpointer b)
+{
+	return ( (const opzione_t *) a )->costo - ( (const opzione_t *) b )->costo;
+}
+
+/** Elenca i posti possibili di una richiesta in ordine di costo.
+ */
+static GArray *prepara_opzioni(const richiesta_t &richiesta, GArray *griglie)
+{
+	GArray *opzioni = g_array_new(FALSE, FALSE, sizeof(opzione_t));
+
+	for (guint g = 0; g < griglie->len; g++){
+		const griglia_t &griglia = g_array_index(griglie, griglia_t, g);
+		const orari_t *orari = griglia.orari;
+		int bit_terreno = 1 << griglia.campo->terreno;
+		int bit_copertura = 1 << griglia.campo->copertura;
+
+		bool terreno = richiesta.terreni == 0 || (richiesta.terreni & bit_terreno) != 0;
+		bool copertura = richiesta.coperture == 0 || (richiesta.coperture & bit_copertura) != 0;
+
+		if (richiesta.vincolante && !(terreno && copertura))
+			continue;
+		if (richiesta.durata <= 0 || richiesta.durata % orari->passo != 0)
+			continue;
+
+		int n = richiesta.durata / orari->passo;
+		int da = richiesta.orario - richiesta.tolleranza - orari->apertura;
+		int primo = (da <= 0) ? 0 : (da + orari->passo - 1) / orari->passo;
+
+		for (; primo + n <= griglia.n_slot; primo++){
+			int inizio = orari->apertura + primo * orari->passo;
+			if (inizio > richiesta.orario + richiesta.tolleranza)
+				break;
+
+			bool libero = true;
+			for (int s = primo; s < primo + n && libero; s++)
+				libero = griglia.slot[s] != SLOT_PRENOTATO;
+			if (!libero)
+				continue;
+
+			opzione_t opzione = { (int) g, primo, n, abs(inizio - richiesta.orario) };
+			if (!terreno)
+				opzione.costo += PENALITA_TERRENO;
+			if (!copertura)
+				opzione.costo += PENALITA_COPERTURA;
+			if (primo == 0 || griglia.slot[primo - 1] == SLOT_PRENOTATO)
+				opzione.costo -= BONUS_ADIACENZA;
+			if (primo + n == griglia.n_slot || griglia.slot[primo + n] == SLOT_PRENOTATO)
+				opzione.costo -= BONUS_ADIACENZA;
+
+			g_array_append_val(opzioni, opzione);
+		}
+	}
+
+	//l'ordinamento stabile lascia i campi nel loro ordine a parità di costo
+	g_array_sort(opzioni, confronta_opzioni);
+
+	return opzioni;
+}
+
+static const opzione_t &opzione(const allocazione_t *a, int richiesta, int indice)
+{
+	return g_array_index(a->opzioni[richiesta], opzione_t, indice);
+}
+
+/** Segna gli slot di un posto con la richiesta che lo occupa, o li libera.
+ */
+static void segna(allocazione_t *a, const opzione_t &o, int valore)
+{
+	int *slot = g_array_index(a->griglie, griglia_t, o.griglia).slot;
+
+	for (int s = o.primo; s < o.primo + o.n; s++)
+		slot[s] = valore;
+}
+
+static void assegna(allocazione_t *a, int richiesta, int indice)
+{
+	a->scelta[richiesta] = indice;
+	segna(a, opzione(a, richiesta, indice), richiesta);
+}
+
+static void togli(allocazione_t *a, int richiesta)
+{
+	segna(a, opzione(a, richiesta, a->scelta[richiesta]), SLOT_LIBERO);
+	a->scelta[richiesta] = -1;
+}
+
+/** Ritorna chi occupa un posto, senza contare la richiesta ignorata.
+ * @return SLOT_LIBERO se il posto è libero, l'indice della richiesta se è una sola,
+ * SLOT_PRENOTATO se sono più di una
+ */
+static int occupante(const allocazione_t *a, const opzione_t &o, int ignorata)
+{
+	const int *slot = g_array_index(a->griglie, griglia_t, o.griglia).slot;
+	int trovata = SLOT_LIBERO;
+
+	for (int s = o.primo; s < o.primo + o.n; s++){
+		if (slot[s] == SLOT_LIBERO || slot[s] == ignorata || slot[s] == trovata)
+			continue;
+		if (trovata != SLOT_LIBERO)
+			return SLOT_PRENOTATO;
+		trovata = slot[s];
+	}
+
+	return trovata;
+}
+
+/** Cerca un posto per la richiesta spostando a catena le richieste che lo occupano.
+ * Le richieste già spostate in questa ricerca sono segnate in visitata
+ * @return TRUE se la richiesta è stata assegnata
+ */
+static bool cammino_aumentante(allocazione_t *a, int richiesta)
+{
+	for (guint i = 0; i < a->opzioni[richiesta]->len; i++){
+		int altra = occupante(a, opzione(a, richiesta, i), -1);
+
+		if (altra == SLOT_LIBERO){
+			assegna(a, richiesta, i);
+			return true;
+		}
+
+		if (altra == SLOT_PRENOTATO || a->visitata[altra])
+			continue;
+
+		a->visitata[altra] = true;
+		int vecchia = a->scelta[altra];
+		togli(a, altra);
+		assegna(a, richiesta, i);
+
+		if ( cammino_aumentante(a, altra) )
+			return true;
+
+		togli(a, richiesta);
+		assegna(a, altra, vecchia);
+	}
+
+	return false;
+}
+
+/** Sposta le richieste assegnate nei posti liberi più economici.
+ * Il numero di richieste soddisfatte non cambia
+ */
+static void migliora(allocazione_t *a)
+{
+	bool cambiato = true;
+
+	for (int p = 0; p < PASSAGGI_MIGLIORAMENTO && cambiato; p++){
+		cambiato = false;
+
+		for (int r = 0; r < a->n; r++){
+			//le opzioni sono in ordine di costo, basta guardare quelle prima della scelta
+			for (int i = 0; i < a->scelta[r]; i++){
+				if ( occupante(a, opzione(a, r, i), r) != SLOT_LIBERO )
+					continue;
+
+				togli(a, r);
+				assegna(a, r, i);
+				cambiato = true;
+				break;
+			}
+		}
+	}
+}
+
+/** Ordine in cui assegnare le richieste.
+ * Prima le più lunghe, che occupano più minuti, poi le meno flessibili
+ */
+static gint confronta_richieste(gconstpointer a_, gconstpointer b_, gpointer dati)
+{
+	const richiesta_t *richieste = (const richiesta_t *) ( (gpointer *) dati )[0];
+	const allocazione_t *a = (const allocazione_t *) ( (gpointer *) dati )[1];
+	int x = *(const int *) a_, y = *(const int *) b_;
+
+	if (richieste[x].durata != richieste[y].durata)
+		return richieste[y].durata - richieste[x].durata;
+
+	return (int) a->opzioni[x]->len - (int) a->opzioni[y]->len;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+int risolvi_allocazione(richiesta_t richieste[], int n, guint giorno, circolo_t *circolo)
+{
+	TEMPO("allocazione: risolvi_allocazione")
+
+	if (circolo == 0 || richieste == 0 || n <= 0) return 0;
+
+	allocazione_t a;
+	a.n = n;
+	a.griglie = prepara_griglie(circolo, giorno);
+	a.opzioni = g_new(GArray *, n);
+	a.scelta = g_new(int, n);
+	a.visitata = g_new(bool, n);
+
+	int *ordine = g_new(int, n);
+	for (int r = 0; r < n; r++){
+		a.opzioni[r] = prepara_opzioni(richieste[r], a.griglie);
+		a.scelta[r] = -1;
+		ordine[r] = r;
+	}
+
+	gpointer dati[2] = { richieste, &a };
+	g_qsort_with_data(ordine, n, sizeof(int), confronta_richieste, dati);
+
+	int soddisfatte = 0;
+	for (int i = 0; i < n; i++){
+		for (int r = 0; r < n; r++)
+			a.visitata[r] = false;
+		a.visitata[ ordine[i] ] = true;
+
+		if ( cammino_aumentante(&a, ordine[i]) )
+			soddisfatte++;
+	}
+
+	migliora(&a);
+
+	for (int r = 0; r < n; r++){
+		richieste[r].campo = 0;
+		richieste[r].inizio = 0;
+
+		if (a.scelta[r] < 0)
+			continue;
+
+		const opzione_t &o = opzione(&a, r, a.scelta[r]);
+		const griglia_t &griglia = g_array_index(a.griglie, griglia_t, o.griglia);
+		richieste[r].campo = griglia.campo;
+		richieste[r].inizio = griglia.orari->apertura + o.primo * griglia.orari->passo;
+	}
+
+	for (int r = 0; r < n; r++)
+		g_array_free(a.opzioni[r], TRUE);
+	for (guint g = 0; g < a.griglie->len; g++)
+		g_free( g_array_index(a.griglie, griglia_t, g).slot );
+	g_array_free(a.griglie, TRUE);
+	g_free(a.opzioni);
+	g_free(a.scelta);
+	g_free(a.visitata);
+	g_free(ordine);
+
+	D1(cout<<"Allocate "<<soddisfatte<<" richieste su "<<n<<endl)
+
+	return soddisfatte;
+}
+
+int prenota_allocazione(const richiesta_t richieste[], int n, guint giorno, circolo_t *circolo,
+			completamento_t completamento, gpointer dati)
+{
+	TEMPO("allocazione: prenota_allocazione")
+
+	if (circolo == 0 || richieste == 0) return -1;
+
+	//tutto o niente: nel frattempo qualcuno potrebbe aver prenotato uno degli orari
+	for (int r = 0; r < n; r++)
+		if (richieste[r].campo != 0 &&
+				!ora_libera(circolo, richieste[r].campo, giorno, richieste[r].inizio, richieste[r].durata) )
+			return -1;
+
+	char *data = data_da_giorno(giorno);
+	int prenotate = 0;
+
+	for (int r = 0; r < n; r++){
+		if (richieste[r].campo == 0)
+			continue;
+
+		ora_t *ora = aggiungi_ora(richieste[r].inizio, data, richieste[r].durata, richieste[r].prenotante, richieste[r].campo);
+		if (ora == 0)
+			continue;
+
+		salva_ora_async(ora, richieste[r].campo, circolo, completamento, dati);
+		prenotate++;
+	}
+
+	g_free(data);
+
+	return prenotate;
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,63 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo allocazione.cc
+ */
+
+#ifndef ALLOCAZIONE
+#define ALLOCAZIONE
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+#include "esecutore.h"
+
+/* Inizio interfaccia del modulo allocazione */
+
+/** Richiesta di prenotazione flessibile.
+ * Il prenotante vuole giocare per durata minuti iniziando tra orario - tolleranza e orario + tolleranza;
+ * terreni e coperture sono maschere con un bit per ogni terreno_t e copertura_t preferiti, 0 se indifferenti.
+ * Se vincolante è TRUE i campi che non rispettano le preferenze non vengono proposti.
+ * campo e inizio contengono il risultato dell'allocazione, campo è 0 se la richiesta non è soddisfatta
+ */
+struct richiesta_t {
+	giocatore_t *prenotante;
+	int orario;
+	int tolleranza;
+	int durata;
+	int terreni;
+	int coperture;
+	bool vincolante;
+	campo_t *campo;
+	int inizio;
+};
+
+/** Assegna un campo e un orario a un gruppo di richieste dello stesso giorno.
+ * Massimizza prima il numero di richieste soddisfatte, poi i minuti prenotati,
+ * infine rispetta il più possibile orari e preferenze;
+ * a parità preferisce gli orari attaccati alle prenotazioni esistenti, per non frammentare i campi.
+ * Le prenotazioni non vengono create, vanno scritte con prenota_allocazione()
+ * @param[in,out] richieste Richieste, ricevono campo e inizio assegnati
+ * @param[in] n Numero di richieste
+ * @param[in] giorno Giorno giuliano delle richieste
+ * @param[in,out] circolo Circolo
+ * @return Numero di richieste soddisfatte
+ */
+int risolvi_allocazione(richiesta_t richieste[], int n, guint giorno, circolo_t *circolo);
+
+/** Prenota tutte le richieste soddisfatte da risolvi_allocazione().
+ * Prima controlla che tutti gli orari assegnati siano ancora liberi:
+ * se uno non lo è non viene creata nessuna prenotazione
+ * @param[in] richieste Richieste allocate
+ * @param[in] n Numero di richieste
+ * @param[in] giorno Giorno giuliano delle richieste
+ * @param[in,out] circolo Circolo
+ * @param[in] completamento Funzione chiamata al termine di ogni scrittura, può essere 0
+ * @param[in] dati Dati passati a completamento
+ * @return Numero di prenotazioni create, -1 se un orario assegnato non è più libero
+ */
+int prenota_allocazione(const richiesta_t richieste[], int n, guint giorno, circolo_t *circolo,
+			completamento_t completamento, gpointer dati);
+
+/* Fine interfaccia del modulo allocazione */
+
+#endif
@@ -0,0 +1,1260 @@
+/**
+ * @file
+ * File contenente il modulo archivio.
+ * Conserva i file dei circoli in uno degli archivi disponibili:
+ * l'albero di directory, la memoria oppure un unico file che registra le modifiche
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "archivio.h"
+#include "file_IO.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+extern const char DATA_PATH[] = "data";
+extern const char GIOCATORI_DIR[] = "giocatori";
+extern const char CAMPI_DIR[] = "campi";
+extern const char ORE_DIR[] = "ore";
+extern const char REGOLE_DIR[] = "regole";
+extern const char CORSI_DIR[] = "corsi";
+
+extern const char FILE_ARCHIVIO[] = "data.arc";
+const char INTESTAZIONE_ARCHIVIO[] = "ACE ARCHIVIO 1\n";	/**< Inizio del file dell'archivio */
+const char ESTENSIONE_TEMPORANEO[] = ".tmp";		/**< Estensione del file scritto durante la compattazione */
+
+const guint BLOCCO_LETTURA = 4096;			/**< Byte chiesti a ogni lettura di un file */
+const guint MIN_COMPATTAZIONE = 1024;			/**< Registrazioni sotto le quali il file non viene compattato */
+
+static const archivio_t *in_uso = &ARCHIVIO_ALBERO;	/**< Archivio in uso */
+
+/** Scrive tutto il testo nel file, ripetendo le scritture parziali.
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool scrivi_tutto(int fd, const char *testo, gsize lunghezza)
+{
+	while (lunghezza > 0){
+		ssize_t scritti = write(fd, testo, lunghezza);
+		if (scritti < 0 && errno == EINTR)
+			continue;
+
+		if (scritti <= 0)
+			return false;
+
+		testo += scritti;
+		lunghezza -= scritti;
+	}
+
+	return true;
+}
+
+/** Ritorna il percorso della cartella.
+ * @param[in] nome_cir Nome del circolo
+ * @param[in] cartella Cartella
+ * @param[in] campo Numero del campo per le cartelle di un campo
+ * @return Percorso della cartella
+ */
+static char *percorso_cartella(const char *nome_cir, cartella_t cartella, int campo)
+{
+	char numero[16];
+	g_snprintf(numero, sizeof(numero), "%d", campo);
+
+	switch (cartella){
+		case CARTELLA_CIRCOLO:
+			return g_build_filename(DATA_PATH, nome_cir, NULL);
+		case CARTELLA_GIOCATORI:
+			return g_build_filename(DATA_PATH, nome_cir, GIOCATORI_DIR, NULL);
+		case CARTELLA_CAMPI:
+			return g_build_filename(DATA_PATH, nome_cir, CAMPI_DIR, NULL);
+		case CARTELLA_CORSI:
+			return g_build_filename(DATA_PATH, nome_cir, CORSI_DIR, NULL);
+		case CARTELLA_CAMPO:
+			return g_build_filename(DATA_PATH, nome_cir, CAMPI_DIR, numero, NULL);
+		case CARTELLA_ORE:
+			return g_build_filename(DATA_PATH, nome_cir, CAMPI_DIR, numero, ORE_DIR, NULL);
+		case CARTELLA_REGOLE:
+			return g_build_filename(DATA_PATH, nome_cir, CAMPI_DIR, numero, REGOLE_DIR, NULL);
+	}
+
+	return 0;
+}
+
+/* Archivio ad albero di directory */
+
+/** Descrittori delle cartelle di un circolo, -1 per quelle non ancora aperte.
+ * campi associa al numero di ogni campo l'array dei descrittori delle sue cartelle
+ */
+struct cartelle_circolo_t {
+	int fd[CARTELLE_CIRCOLO];
+	GHashTable *campi;
+};
+
+/** Cartelle aperte di ogni circolo, per nome del circolo.
+ * Una cartella viene creata e aperta al primo file scritto al suo interno, poi i file
+ * vengono aperti ed eliminati relativamente al suo descrittore senza ricostruire
+ * né ricontrollare il percorso. La usano anche i thread dell'esecutore,
+ * quindi si accede solo con mutex_cartelle bloccato
+ */
+static GHashTable *cartelle = 0;
+static GMutex mutex_cartelle;		/**< Protegge le cartelle aperte */
+
+static void chiudi_cartelle(int fd[], int n)
+{
+	for (int i = 0; i < n; i++)
+		if (fd[i] >= 0)
+			close(fd[i]);
+}
+
+static void libera_cartelle_campo(gpointer fd)
+{
+	chiudi_cartelle( (int *) fd, CARTELLE_CAMPO );
+	g_free(fd);
+}
+
+static void libera_cartelle_circolo(gpointer cartelle_)
+{
+	cartelle_circolo_t *c = (cartelle_circolo_t *) cartelle_;
+
+	chiudi_cartelle(c->fd, CARTELLE_CIRCOLO);
+	g_hash_table_destroy(c->campi);
+	g_free(c);
+}
+
+/** Ritorna il posto del descrittore della cartella, aggiungendo il circolo o il campo se mancano.
+ * Va chiamata con mutex_cartelle bloccato
+ */
+static int *posto_cartella(const char *nome_cir, cartella_t cartella, int campo)
+{
+	if (cartelle == 0)
+		cartelle = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, libera_cartelle_circolo);
+
+	cartelle_circolo_t *c = (cartelle_circolo_t *) g_hash_table_lookup(cartelle, nome_cir);
+	if (c == 0){
+		c = g_new(cartelle_circolo_t, 1);
+		for (int i = 0; i < CARTELLE_CIRCOLO; i++)
+			c->fd[i] = -1;
+		c->campi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_cartelle_campo);
+		g_hash_table_insert(cartelle, g_strdup(nome_cir), c);
+	}
+
+	if (cartella < CARTELLA_CAMPO)
+		return &c->fd[cartella];
+
+	int *fd = (int *) g_hash_table_lookup(c->campi, GINT_TO_POINTER(campo));
+	if (fd == 0){
+		fd = g_new(int, CARTELLE_CAMPO);
+		for (int i = 0; i < CARTELLE_CAMPO; i++)
+			fd[i] = -1;
+		g_hash_table_insert(c->campi, GINT_TO_POINTER(campo), fd);
+	}
+
+	return &fd[cartella - CARTELLA_CAMPO];
+}
+
+/** Apre la sottocartella, creandola se richiesto.
+ * @return Descrittore della sottocartella, -1 in caso di errore
+ */
+static int apri_sottocartella(int padre, const char nome[], bool crea)
+{
+	//un altro processo potrebbe averla creata nel frattempo
+	if (crea && mkdirat(padre, nome, S_IRWXU) != 0 && errno != EEXIST){
+		D1(cout<<"Impossibile creare cartella"<<endl)
+		D2(cout<<"Cartella: "<<nome<<endl)
+		return -1;
+	}
+
+	return openat(padre, nome, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+/** Ritorna il descrittore della cartella, aprendola la prima volta che serve.
+ * Va chiamata con mutex_cartelle bloccato
+ * @param[in] nome_cir Nome del circolo
+ * @param[in] cartella Cartella
+ * @param[in] campo Numero del campo per le cartelle di un campo
+ * @param[in] crea TRUE per creare la cartella, e quelle che la contengono, se non esiste
+ * @return Descrittore della cartella, -1 se non esiste e non va creata o non è stato possibile aprirla
+ */
+static int descrittore_cartella(const char *nome_cir, cartella_t cartella, int campo, bool crea)
+{
+	int *fd = posto_cartella(nome_cir, cartella, campo);
+	if (*fd >= 0)
+		return *fd;
+
+	int padre = -1;
+	const char *nome = 0;
+	char numero[16];
+
+	switch (cartella){
+		case CARTELLA_CIRCOLO:
+			//la cartella dei dati è relativa alla directory corrente, quindi non viene tenuta aperta
+			if (crea && g_mkdir(DATA_PATH, S_IRWXU) != 0 && errno != EEXIST)
+				return -1;
+			padre = open(DATA_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			nome = nome_cir;
+			break;
+		case CARTELLA_GIOCATORI:
+			padre = descrittore_cartella(nome_cir, CARTELLA_CIRCOLO, 0, crea);
+			nome = GIOCATORI_DIR;
+			break;
+		case CARTELLA_CAMPI:
+			padre = descrittore_cartella(nome_cir, CARTELLA_CIRCOLO, 0, crea);
+			nome = CAMPI_DIR;
+			break;
+		case CARTELLA_CORSI:
+			padre = descrittore_cartella(nome_cir, CARTELLA_CIRCOLO, 0, crea);
+			nome = CORSI_DIR;
+			break;
+		case CARTELLA_CAMPO:
+			padre = descrittore_cartella(nome_cir, CARTELLA_CAMPI, 0, crea);
+			g_snprintf(numero, sizeof(numero), "%d", campo);
+			nome = numero;
+			break;
+		case CARTELLA_ORE:
+			padre = descrittore_cartella(nome_cir, CARTELLA_CAMPO, campo, crea);
+			nome = ORE_DIR;
+			break;
+		case CARTELLA_REGOLE:
+			padre = descrittore_cartella(nome_cir, CARTELLA_CAMPO, campo, crea);
+			nome = REGOLE_DIR;
+			break;
+	}
+
+	if (padre < 0)
+		return -1;
+
+	*fd = apri_sottocartella(padre, nome, crea);
+
+	if (cartella == CARTELLA_CIRCOLO)
+		close(padre);
+
+	return *fd;
+}
+
+/** Chiude le cartelle aperte del circolo, da chiamare quando vengono eliminate.
+ */
+static void dimentica_circolo(const char *nome_cir)
+{
+	g_mutex_lock(&mutex_cartelle);
+	if (cartelle != 0)
+		g_hash_table_remove(cartelle, nome_cir);
+	g_mutex_unlock(&mutex_cartelle);
+}
+
+/** Chiude le cartelle aperte del campo, da chiamare quando vengono eliminate.
+ */
+static void dimentica_campo(const char *nome_cir, int campo)
+{
+	g_mutex_lock(&mutex_cartelle);
+	cartelle_circolo_t *c = (cartelle != 0) ? (cartelle_circolo_t *) g_hash_table_lookup(cartelle, nome_cir) : 0;
+	if (c != 0)
+		g_hash_table_remove(c->campi, GINT_TO_POINTER(campo));
+	g_mutex_unlock(&mutex_cartelle);
+}
+
+/** Ritorna una copia del descrittore della cartella, da chiudere con close().
+ * La copia resta valida anche se nel frattempo un altro thread chiude le cartelle del circolo,
+ * quindi il file può essere aperto senza tenere bloccato mutex_cartelle
+ * @return Descrittore della cartella, -1 in caso di errore
+ */
+static int copia_cartella(const posizione_t &pos, bool crea)
+{
+	g_mutex_lock(&mutex_cartelle);
+
+	int dir = descrittore_cartella(pos.circolo, pos.cartella, pos.campo, crea);
+	if (dir >= 0)
+		dir = fcntl(dir, F_DUPFD_CLOEXEC, 0);
+
+	int errore = errno;
+
+	g_mutex_unlock(&mutex_cartelle);
+
+	errno = errore;
+
+	return dir;
+}
+
+/** Ritorna TRUE se la cartella è stata eliminata dopo essere stata aperta.
+ */
+static bool cartella_eliminata(int dir)
+{
+	struct stat info;
+
+	return fstat(dir, &info) == 0 && info.st_nlink == 0;
+}
+
+/** Apre un file nella sua cartella.
+ * Se la cartella aperta è stata eliminata dall'esterno le cartelle del circolo
+ * vengono riaperte e l'apertura ritentata una volta; un file che semplicemente
+ * non esiste non tocca le cartelle aperte
+ * @param[in] pos Posizione del file
+ * @param[in] modo Modo di apertura del file
+ * @param[in] crea TRUE per creare la cartella se non esiste
+ * @return Descrittore del file, -1 in caso di errore
+ */
+static int apri_file(const posizione_t &pos, int modo, bool crea)
+{
+	int fd = -1;
+
+	for (int tentativo = 0; tentativo < 2; tentativo++){
+		int dir = copia_cartella(pos, crea);
+		if (dir < 0)
+			break;
+
+		fd = openat(dir, pos.nome, modo | O_CLOEXEC, 0666);
+		int errore = errno;
+		bool eliminata = fd < 0 && errore == ENOENT && cartella_eliminata(dir);
+		close(dir);
+		errno = errore;
+
+		if (!eliminata)
+			break;
+		dimentica_circolo(pos.circolo);
+	}
+
+	return fd;
+}
+
+/** Elimina ricorsivamente le sottodirectory della directory passata.
+ * @param[in] dir_ Directory alla quale eliminare le sotto directory
+ */
+static void elimina_sub_directory(const char *dir_)
+{
+	GDir *dir = g_dir_open(dir_, 0, NULL);
+	const char *file = 0;
+	char *file_ = 0;
+
+	if (dir == NULL)
+		return;
+
+	while( (file = g_dir_read_name(dir)) ){
+		file_ = g_build_filename(dir_, file, NULL);
+
+		if ( g_file_test(file_, G_FILE_TEST_IS_DIR) )
+			elimina_sub_directory(file_);
+		if ( g_file_test(file_, G_FILE_TEST_IS_REGULAR) )
+			g_remove(file_);
+
+		g_free(file_);
+	}
+
+	g_dir_close(dir);
+	g_rmdir(dir_);
+
+}
+
+static bool albero_apri()
+{
+	return true;
+}
+
+static void albero_chiudi()
+{
+	g_mutex_lock(&mutex_cartelle);
+	if (cartelle != 0)
+		g_hash_table_destroy(cartelle);
+	cartelle = 0;
+	g_mutex_unlock(&mutex_cartelle);
+}
+
+/** Elimina un file dalla sua cartella, senza creare cartelle.
+ */
+static bool albero_elimina(const posizione_t &pos)
+{
+	int dir = copia_cartella(pos, false);
+	if (dir < 0)
+		return false;
+
+	int res = unlinkat(dir, pos.nome, 0);
+	int errore = errno;
+
+	close(dir);
+
+	errno = errore;
+
+	return res == 0;
+}
+
+/** Scrive il testo nel file, creando se serve la cartella.
+ * In caso di errore in scrittura il file viene rimosso
+ */
+static bool albero_scrivi(const posizione_t &pos, const char testo[], gsize lunghezza)
+{
+	int fd = apri_file(pos, O_WRONLY | O_CREAT | O_TRUNC, true);
+
+	if (fd < 0){
+		D1(cout<<"Errore nell'apertura del file"<<endl)
+		D2(cout<<"File: "<<pos.nome<<endl)
+		return false;
+	}
+
+	bool stato = scrivi_tutto(fd, testo, lunghezza);
+	stato = (close(fd) == 0) && stato;
+
+	if (!stato){
+		D1(cout<<"Errore in scrittura"<<endl)
+		albero_elimina(pos);
+	}
+
+	return stato;
+}
+
+static bool albero_leggi(const posizione_t &pos, GByteArray *testo)
+{
+	int fd = apri_file(pos, O_RDONLY, false);
+	if (fd < 0)
+		return false;
+
+	g_byte_array_set_size(testo, 0);
+
+	ssize_t letti;
+	do {
+		guint usati = testo->len;
+		g_byte_array_set_size(testo, usati + BLOCCO_LETTURA);
+		letti = read(fd, testo->data + usati, BLOCCO_LETTURA);
+		g_byte_array_set_size(testo, usati + MAX(letti, 0));
+	} while ( letti > 0 || (letti < 0 && errno == EINTR) );
+
+	close(fd);
+
+	return letti == 0;
+}
+
+/** Elimina ricorsivamente la cartella e chiude i suoi descrittori e quelli delle sue sottocartelle.
+ */
+static bool albero_elimina_cartella(const posizione_t &pos)
+{
+	char *dir = percorso(pos);
+
+	elimina_sub_directory(dir);
+
+	if (pos.cartella >= CARTELLA_CAMPO)
+		dimentica_campo(pos.circolo, pos.campo);
+	else
+		dimentica_circolo(pos.circolo);
+
+	bool stato = !g_file_test(dir, G_FILE_TEST_EXISTS);
+	g_free(dir);
+
+	return stato;
+}
+
+static bool albero_esiste(const posizione_t &pos)
+{
+	//le cartelle vengono cercate dal percorso, potrebbero essere state eliminate dall'esterno
+	if (pos.nome[0] == '\0'){
+		char *dir = percorso(pos);
+		bool stato = g_file_test(dir, G_FILE_TEST_IS_DIR);
+		g_free(dir);
+
+		return stato;
+	}
+
+	int dir = copia_cartella(pos, false);
+	if (dir < 0)
+		return false;
+
+	bool stato = faccessat(dir, pos.nome, F_OK, 0) == 0;
+
+	close(dir);
+
+	return stato;
+}
+
+/** Elenca i file o, se cartelle è TRUE, le sottocartelle non nascoste della directory.
+ * @return Nomi trovati, 0 se la directory non esiste
+ */
+static GPtrArray *elenca_directory(const char dir[], bool cartelle)
+{
+	GDir *d = g_dir_open(dir, 0, NULL);
+	if (d == NULL)
+		return 0;
+
+	GPtrArray *nomi = g_ptr_array_new_with_free_func(g_free);
+	const char *nome = 0;
+
+	while( (nome = g_dir_read_name(d)) ){
+		if ( file_nascosto(nome) )
+			continue;
+
+		char *file = g_build_filename(dir, nome, NULL);
+		bool scelto = g_file_test(file, cartelle ? G_FILE_TEST_IS_DIR : G_FILE_TEST_IS_REGULAR);
+		g_free(file);
+
+		if (scelto)
+			g_ptr_array_add(nomi, g_strdup(nome));
+	}
+
+	g_dir_close(d);
+
+	return nomi;
+}
+
+static GPtrArray *albero_elenca(const posizione_t &pos)
+{
+	char *dir = percorso(pos);
+	GPtrArray *nomi = elenca_directory(dir, pos.cartella == CARTELLA_CAMPI);
+	g_free(dir);
+
+	return nomi;
+}
+
+static GPtrArray *albero_elenca_circoli()
+{
+	GPtrArray *nomi = elenca_directory(DATA_PATH, true);
+
+	return (nomi != 0) ? nomi : g_ptr_array_new_with_free_func(g_free);
+}
+
+/* Archivio in memoria */
+
+/** File di un circolo tenuti in memoria.
+ * Ogni cartella è una tabella dal nome di ogni file al suo contenuto in un GByteArray,
+ * 0 finché non vi viene scritto un file; campi associa al numero di ogni campo
+ * l'array delle sue cartelle. Il posto di CARTELLA_CAMPI resta vuoto
+ */
+struct circolo_memoria_t {
+	GHashTable *cartelle[CARTELLE_CIRCOLO];
+	GHashTable *campi;
+};
+
+/** File in memoria di ogni circolo, per nome del circolo; 0 se l'archivio non è aperto.
+ * È condivisa dall'archivio in memoria e da quello su file unico, che non sono mai aperti insieme,
+ * e si accede solo con mutex_memoria bloccato
+ */
+static GHashTable *memoria = 0;
+static GMutex mutex_memoria;		/**< Protegge i file in memoria e il file dell'archivio */
+static guint file_in_memoria = 0;	/**< Numero di file in memoria */
+
+static void libera_contenuto(gpointer contenuto)
+{
+	g_byte_array_free( (GByteArray *) contenuto, TRUE );
+}
+
+/** Dealloca le cartelle con i loro file.
+ */
+static void libera_cartelle_memoria(GHashTable *cartelle_[], int n)
+{
+	for (int i = 0; i < n; i++)
+		if (cartelle_[i] != 0){
+			file_in_memoria -= g_hash_table_size(cartelle_[i]);
+			g_hash_table_destroy(cartelle_[i]);
+			cartelle_[i] = 0;
+		}
+}
+
+static void libera_campo_memoria(gpointer campo)
+{
+	libera_cartelle_memoria( (GHashTable **) campo, CARTELLE_CAMPO );
+	g_free(campo);
+}
+
+static void libera_circolo_memoria(gpointer circolo_)
+{
+	circolo_memoria_t *c = (circolo_memoria_t *) circolo_;
+
+	libera_cartelle_memoria(c->cartelle, CARTELLE_CIRCOLO);
+	g_hash_table_destroy(c->campi);
+	g_free(c);
+}
+
+/** Ritorna il posto della cartella in memoria, aggiungendo il circolo o il campo se richiesto.
+ * Va chiamata con mutex_memoria bloccato
+ * @return Posto della cartella, 0 se il circolo o il campo non esistono e non vanno aggiunti
+ */
+static GHashTable **posto_memoria(const posizione_t &pos, bool crea)
+{
+	circolo_memoria_t *c = (circolo_memoria_t *) g_hash_table_lookup(memoria, pos.circolo);
+	if (c == 0){
+		if (!crea)
+			return 0;
+		c = g_new0(circolo_memoria_t, 1);
+		c->campi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_campo_memoria);
+		g_hash_table_insert(memoria, g_strdup(pos.circolo), c);
+	}
+
+	if (pos.cartella < CARTELLA_CAMPO)
+		return &c->cartelle[pos.cartella];
+
+	GHashTable **campo = (GHashTable **) g_hash_table_lookup(c->campi, GINT_TO_POINTER(pos.campo));
+	if (campo == 0){
+		if (!crea)
+			return 0;
+		campo = g_new0(GHashTable *, CARTELLE_CAMPO);
+		g_hash_table_insert(c->campi, GINT_TO_POINTER(pos.campo), campo);
+	}
+
+	return &campo[pos.cartella - CARTELLA_CAMPO];
+}
+
+/** Ritorna il contenuto del file in memoria, 0 se non esiste.
+ * Va chiamata con mutex_memoria bloccato
+ */
+static GByteArray *cerca_file(const posizione_t &pos)
+{
+	GHashTable **cartella = posto_memoria(pos, false);
+
+	if (cartella == 0 || *cartella == 0)
+		return 0;
+
+	return (GByteArray *) g_hash_table_lookup(*cartella, pos.nome);
+}
+
+/** Sostituisce il contenuto del file in memoria, creandolo se non esiste.
+ * Va chiamata con mutex_memoria bloccato
+ */
+static void aggiorna_file(const posizione_t &pos, const char testo[], gsize lunghezza)
+{
+	GHashTable **cartella = posto_memoria(pos, true);
+
+	if (*cartella == 0)
+		*cartella = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, libera_contenuto);
+
+	GByteArray *contenuto = (GByteArray *) g_hash_table_lookup(*cartella, pos.nome);
+	if (contenuto == 0){
+		contenuto = g_byte_array_sized_new(lunghezza);
+		g_hash_table_insert(*cartella, g_strdup(pos.nome), contenuto);
+		file_in_memoria++;
+	}
+
+	g_byte_array_set_size(contenuto, 0);
+	g_byte_array_append(contenuto, (const guint8 *) testo, lunghezza);
+}
+
+/** Rimuove il file dalla memoria.
+ * Va chiamata con mutex_memoria bloccato
+ * @return TRUE se il file esisteva
+ */
+static bool rimuovi_file(const posizione_t &pos)
+{
+	GHashTable **cartella = posto_memoria(pos, false);
+
+	if ( cartella == 0 || *cartella == 0 || !g_hash_table_remove(*cartella, pos.nome) )
+		return false;
+
+	file_in_memoria--;
+
+	return true;
+}
+
+/** Rimuove dalla memoria la cartella con tutto il suo contenuto.
+ * Va chiamata con mutex_memoria bloccato
+ */
+static void rimuovi_cartella(const posizione_t &pos)
+{
+	circolo_memoria_t *c = (circolo_memoria_t *) g_hash_table_lookup(memoria, pos.circolo);
+
+	if (c == 0)
+		return;
+
+	switch (pos.cartella){
+		case CARTELLA_CIRCOLO:
+			g_hash_table_remove(memoria, pos.circolo);
+			break;
+		case CARTELLA_CAMPI:
+			g_hash_table_remove_all(c->campi);
+			break;
+		case CARTELLA_CAMPO:
+			g_hash_table_remove(c->campi, GINT_TO_POINTER(pos.campo));
+			break;
+		default:
+			GHashTable **cartella = posto_memoria(pos, false);
+			if (cartella != 0)
+				libera_cartelle_memoria(cartella, 1);
+			break;
+	}
+}
+
+/** Controlla se la cartella esiste in memoria.
+ * Va chiamata con mutex_memoria bloccato
+ */
+static bool cartella_in_memoria(const posizione_t &pos)
+{
+	circolo_memoria_t *c = (circolo_memoria_t *) g_hash_table_lookup(memoria, pos.circolo);
+
+	if (c == 0)
+		return false;
+
+	switch (pos.cartella){
+		case CARTELLA_CIRCOLO:
+			return true;
+		case CARTELLA_CAMPI:
+			return g_hash_table_size(c->campi) > 0;
+		case CARTELLA_CAMPO:
+			return g_hash_table_contains(c->campi, GINT_TO_POINTER(pos.campo));
+		default:
+			GHashTable **cartella = posto_memoria(pos, false);
+			return cartella != 0 && *cartella != 0;
+	}
+}
+
+static bool memoria_apri()
+{
+	g_mutex_lock(&mutex_memoria);
+	if (memoria == 0)
+		memoria = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, libera_circolo_memoria);
+	g_mutex_unlock(&mutex_memoria);
+
+	return true;
+}
+
+static void memoria_chiudi()
+{
+	g_mutex_lock(&mutex_memoria);
+	if (memoria != 0)
+		g_hash_table_destroy(memoria);
+	memoria = 0;
+	g_mutex_unlock(&mutex_memoria);
+}
+
+static bool memoria_scrivi(const posizione_t &pos, const char testo[], gsize lunghezza)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	bool stato = memoria != 0;
+	if (stato)
+		aggiorna_file(pos, testo, lunghezza);
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return stato;
+}
+
+static bool memoria_leggi(const posizione_t &pos, GByteArray *testo)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	GByteArray *contenuto = (memoria != 0) ? cerca_file(pos) : 0;
+	if (contenuto != 0){
+		g_byte_array_set_size(testo, 0);
+		g_byte_array_append(testo, contenuto->data, contenuto->len);
+	}
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return contenuto != 0;
+}
+
+static bool memoria_elimina(const posizione_t &pos)
+{
+	g_mutex_lock(&mutex_memoria);
+	bool stato = (memoria != 0) && rimuovi_file(pos);
+	g_mutex_unlock(&mutex_memoria);
+
+	if (!stato)
+		errno = ENOENT;
+
+	return stato;
+}
+
+static bool memoria_elimina_cartella(const posizione_t &pos)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	bool stato = memoria != 0;
+	if (stato)
+		rimuovi_cartella(pos);
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return stato;
+}
+
+static bool memoria_esiste(const posizione_t &pos)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	bool stato = false;
+	if (memoria != 0)
+		stato = (pos.nome[0] == '\0') ? cartella_in_memoria(pos) : cerca_file(pos) != 0;
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return stato;
+}
+
+static GPtrArray *memoria_elenca(const posizione_t &pos)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	GPtrArray *nomi = 0;
+	GHashTableIter iter;
+	gpointer chiave;
+
+	if ( memoria != 0 && cartella_in_memoria(pos) ){
+		nomi = g_ptr_array_new_with_free_func(g_free);
+
+		if (pos.cartella == CARTELLA_CAMPI){
+			circolo_memoria_t *c = (circolo_memoria_t *) g_hash_table_lookup(memoria, pos.circolo);
+			g_hash_table_iter_init(&iter, c->campi);
+			while ( g_hash_table_iter_next(&iter, &chiave, NULL) )
+				g_ptr_array_add(nomi, g_strdup_printf("%d", GPOINTER_TO_INT(chiave)));
+		}
+		//il circolo o il campo esistono anche se nella loro cartella non è mai stato scritto un file
+		else if (*posto_memoria(pos, false) != 0){
+			GHashTable *cartella = *posto_memoria(pos, false);
+			g_hash_table_iter_init(&iter, cartella);
+			while ( g_hash_table_iter_next(&iter, &chiave, NULL) )
+				g_ptr_array_add(nomi, g_strdup( (const char *) chiave ));
+		}
+	}
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return nomi;
+}
+
+static GPtrArray *memoria_elenca_circoli()
+{
+	GPtrArray *nomi = g_ptr_array_new_with_free_func(g_free);
+
+	g_mutex_lock(&mutex_memoria);
+
+	if (memoria != 0){
+		GHashTableIter iter;
+		gpointer chiave;
+		g_hash_table_iter_init(&iter, memoria);
+		while ( g_hash_table_iter_next(&iter, &chiave, NULL) )
+			g_ptr_array_add(nomi, g_strdup( (const char *) chiave ));
+	}
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return nomi;
+}
+
+/* Archivio su file unico */
+
+/** Operazioni registrate nel file dell'archivio.
+ */
+enum operazione_t {OP_SCRITTURA = 'S', OP_ELIMINAZIONE = 'E', OP_CARTELLA = 'C'};
+
+/* Il file dell'archivio inizia con INTESTAZIONE_ARCHIVIO ed è seguito dalle registrazioni in ordine.
+ * Ogni registrazione contiene l'operazione su un byte, il nome del circolo, la cartella, il numero
+ * del campo, il nome del file e, per le scritture, il contenuto; gli interi sono su 4 byte little endian
+ * e i testi sono preceduti dalla loro lunghezza. Le operazioni vengono ripetute in memoria all'apertura */
+
+static int fd_registro = -1;			/**< File dell'archivio aperto in aggiunta, -1 se chiuso */
+static off_t fine_registro = 0;			/**< Lunghezza della parte valida del file */
+static guint registrazioni = 0;			/**< Registrazioni contenute nel file */
+static GByteArray *registrazione = 0;		/**< Buffer riusato per comporre le registrazioni */
+
+static void aggiungi_32(GByteArray *testo, guint32 valore)
+{
+	guint8 byte[4] = { (guint8) valore, (guint8) (valore >> 8), (guint8) (valore >> 16), (guint8) (valore >> 24) };
+	g_byte_array_append(testo, byte, 4);
+}
+
+static void aggiungi_testo(GByteArray *testo, const char *dati, gsize lunghezza)
+{
+	aggiungi_32(testo, lunghezza);
+	g_byte_array_append(testo, (const guint8 *) dati, lunghezza);
+}
+
+/** Aggiunge al testo la registrazione di un'operazione.
+ * @param[in,out] testo Testo a cui aggiungere la registrazione
+ * @param[in] operazione Operazione
+ * @param[in] pos Posizione del file o della cartella
+ * @param[in] contenuto Contenuto del file per le scritture, altrimenti 0
+ * @param[in] lunghezza Lunghezza del contenuto
+ */
+static void componi_registrazione(GByteArray *testo, operazione_t operazione, const posizione_t &pos,
+				const char *contenuto, gsize lunghezza)
+{
+	guint8 op = operazione;
+	g_byte_array_append(testo, &op, 1);
+	aggiungi_testo(testo, pos.circolo, strlen(pos.circolo));
+	aggiungi_32(testo, pos.cartella);
+	aggiungi_32(testo, pos.campo);
+	aggiungi_testo(testo, pos.nome, strlen(pos.nome));
+
+	if (operazione == OP_SCRITTURA)
+		aggiungi_testo(testo, contenuto, lunghezza);
+}
+
+static bool leggi_32(const char *&cursore, const char *fine, guint32 &valore)
+{
+	if (fine - cursore < 4)
+		return false;
+
+	const guint8 *byte = (const guint8 *) cursore;
+	valore = byte[0] | (byte[1] << 8) | (byte[2] << 16) | ((guint32) byte[3] << 24);
+	cursore += 4;
+
+	return true;
+}
+
+static bool leggi_testo(const char *&cursore, const char *fine, const char *&testo, guint32 &lunghezza)
+{
+	if ( !leggi_32(cursore, fine, lunghezza) || (guint32) (fine - cursore) < lunghezza )
+		return false;
+
+	testo = cursore;
+	cursore += lunghezza;
+
+	return true;
+}
+
+/** Ripete in memoria le operazioni registrate nel file.
+ * Una registrazione incompleta o non valida, lasciata da una scrittura interrotta,
+ * termina la lettura: lei e quelle successive vengono scartate.
+ * Va chiamata con mutex_memoria bloccato
+ * @param[in] testo Contenuto del file, dopo l'intestazione
+ * @param[in] fine Fine del contenuto
+ * @return Fine della parte valida del contenuto
+ */
+static const char *ripeti_registro(const char *testo, const char *fine)
+{
+	GString *circolo = g_string_new(NULL);
+
+	while (testo < fine){
+		const char *cursore = testo + 1;
+		const char *nome_cir, *nome, *contenuto = 0;
+		guint32 l_circolo, cartella, campo, l_nome, l_contenuto = 0;
+		operazione_t operazione = (operazione_t) *testo;
+
+		if ( !leggi_testo(cursore, fine, nome_cir, l_circolo) || !leggi_32(cursore, fine, cartella) ||
+				!leggi_32(cursore, fine, campo) || !leggi_testo(cursore, fine, nome, l_nome) ||
+				cartella > CARTELLA_REGOLE || l_nome >= (guint32) LUNGHEZZA_NOME )
+			break;
+
+		if ( operazione == OP_SCRITTURA && !leggi_testo(cursore, fine, contenuto, l_contenuto) )
+			break;
+
+		g_string_assign(circolo, "");
+		g_string_append_len(circolo, nome_cir, l_circolo);
+
+		posizione_t pos = posizione(circolo->str, (cartella_t) cartella, campo, "");
+		memcpy(pos.nome, nome, l_nome);
+		pos.nome[l_nome] = '\0';
+
+		if (operazione == OP_SCRITTURA)
+			aggiorna_file(pos, contenuto, l_contenuto);
+		else if (operazione == OP_ELIMINAZIONE)
+			rimuovi_file(pos);
+		else if (operazione == OP_CARTELLA)
+			rimuovi_cartella(pos);
+		else
+			break;
+
+		registrazioni++;
+		testo = cursore;
+	}
+
+	g_string_free(circolo, TRUE);
+
+	return testo;
+}
+
+/** Aggiunge al testo una registrazione di scrittura per ogni file della cartella.
+ * @return Numero di registrazioni aggiunte
+ */
+static guint registra_cartella(GByteArray *testo, const posizione_t &cartella, GHashTable *file)
+{
+	if (file == 0)
+		return 0;
+
+	GHashTableIter iter;
+	gpointer nome, contenuto;
+	posizione_t pos = cartella;
+
+	g_hash_table_iter_init(&iter, file);
+	while ( g_hash_table_iter_next(&iter, &nome, &contenuto) ){
+		g_strlcpy(pos.nome, (const char *) nome, sizeof(pos.nome));
+		componi_registrazione(testo, OP_SCRITTURA, pos, (const char *) ((GByteArray *) contenuto)->data,
+				((GByteArray *) contenuto)->len);
+	}
+
+	return g_hash_table_size(file);
+}
+
+/** Riscrive il file dell'archivio con una sola scrittura per ogni file in memoria.
+ * Il nuovo file viene scritto a parte e sostituisce il vecchio solo se completo,
+ * quindi un'interruzione non perde dati. Va chiamata con mutex_memoria bloccato
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool compatta_registro()
+{
+	TEMPO("archivio: compatta_registro")
+
+	GByteArray *testo = g_byte_array_sized_new(BLOCCO_LETTURA);
+	g_byte_array_append(testo, (const guint8 *) INTESTAZIONE_ARCHIVIO, strlen(INTESTAZIONE_ARCHIVIO));
+	guint n = 0;
+
+	GHashTableIter iter, iter_campi;
+	gpointer nome_cir, circolo_, numero, campo;
+
+	g_hash_table_iter_init(&iter, memoria);
+	while ( g_hash_table_iter_next(&iter, &nome_cir, &circolo_) ){
+		circolo_memoria_t *c = (circolo_memoria_t *) circolo_;
+
+		for (int i = 0; i < CARTELLE_CIRCOLO; i++)
+			n += registra_cartella(testo, posizione( (const char *) nome_cir, (cartella_t) i, 0, "" ), c->cartelle[i]);
+
+		g_hash_table_iter_init(&iter_campi, c->campi);
+		while ( g_hash_table_iter_next(&iter_campi, &numero, &campo) )
+			for (int i = 0; i < CARTELLE_CAMPO; i++)
+				n += registra_cartella(testo, posizione( (const char *) nome_cir, (cartella_t) (CARTELLA_CAMPO + i),
+							GPOINTER_TO_INT(numero), "" ), ((GHashTable **) campo)[i]);
+	}
+
+	char *temporaneo = g_strconcat(FILE_ARCHIVIO, ESTENSIONE_TEMPORANEO, NULL);
+	int fd = open(temporaneo, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	bool stato = fd >= 0 && scrivi_tutto(fd, (const char *) testo->data, testo->len) && fsync(fd) == 0;
+
+	if (fd >= 0)
+		stato = (close(fd) == 0) && stato;
+
+	stato = stato && g_rename(temporaneo, FILE_ARCHIVIO) == 0;
+
+	if (!stato){
+		D1(cout<<"Impossibile compattare l'archivio"<<endl)
+		g_remove(temporaneo);
+	}
+	else {
+		if (fd_registro >= 0)
+			close(fd_registro);
+		fd_registro = open(FILE_ARCHIVIO, O_WRONLY | O_APPEND | O_CLOEXEC);
+		fine_registro = testo->len;
+		registrazioni = n;
+		stato = fd_registro >= 0;
+	}
+
+	g_free(temporaneo);
+	g_byte_array_free(testo, TRUE);
+
+	return stato;
+}
+
+/** Registra un'operazione in coda al file dell'archivio.
+ * Se la scrittura fallisce il file viene riportato alla lunghezza precedente,
+ * così le registrazioni successive restano leggibili. Va chiamata con mutex_memoria bloccato
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool registra(operazione_t operazione, const posizione_t &pos, const char *contenuto, gsize lunghezza)
+{
+	if (fd_registro < 0)
+		return false;
+
+	if (registrazione == 0)
+		registrazione = g_byte_array_sized_new(BLOCCO_LETTURA);
+
+	g_byte_array_set_size(registrazione, 0);
+	componi_registrazione(registrazione, operazione, pos, contenuto, lunghezza);
+
+	if ( !scrivi_tutto(fd_registro, (const char *) registrazione->data, registrazione->len) ){
+		D1(cout<<"Errore in scrittura dell'archivio"<<endl)
+		if (ftruncate(fd_registro, fine_registro) != 0)
+			D1(cout<<"Impossibile ripristinare l'archivio"<<endl)
+		return false;
+	}
+
+	fine_registro += registrazione->len;
+	registrazioni++;
+
+	//le registrazioni superate vengono eliminate quando sono la maggior parte del file
+	if (registrazioni > MIN_COMPATTAZIONE && registrazioni > 2 * file_in_memoria)
+		compatta_registro();
+
+	return true;
+}
+
+static void registro_chiudi()
+{
+	g_mutex_lock(&mutex_memoria);
+
+	if (fd_registro >= 0)
+		close(fd_registro);
+	fd_registro = -1;
+
+	if (memoria != 0)
+		g_hash_table_destroy(memoria);
+	memoria = 0;
+
+	if (registrazione != 0)
+		g_byte_array_free(registrazione, TRUE);
+	registrazione = 0;
+
+	g_mutex_unlock(&mutex_memoria);
+}
+
+/** Apre il file dell'archivio e ne carica in memoria i file.
+ * Se il file non esiste viene creato vuoto; un file che non è un archivio non viene toccato
+ */
+static bool registro_apri()
+{
+	TEMPO("archivio: apri_registro")
+
+	g_mutex_lock(&mutex_memoria);
+
+	if (memoria != 0)
+		g_hash_table_destroy(memoria);
+	memoria = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, libera_circolo_memoria);
+	registrazioni = 0;
+
+	char *testo = 0;
+	gsize lunghezza = 0;
+	bool stato = true;
+
+	if ( !g_file_get_contents(FILE_ARCHIVIO, &testo, &lunghezza, NULL) ){
+		//archivio nuovo
+		stato = !g_file_test(FILE_ARCHIVIO, G_FILE_TEST_EXISTS) && compatta_registro();
+	}
+	else if ( lunghezza < strlen(INTESTAZIONE_ARCHIVIO) ||
+			strncmp(testo, INTESTAZIONE_ARCHIVIO, strlen(INTESTAZIONE_ARCHIVIO)) != 0 ){
+		D1(cout<<"Il file non è un archivio"<<endl)
+		D2(cout<<"File: "<<FILE_ARCHIVIO<<endl)
+		stato = false;
+	}
+	else {
+		const char *valido = ripeti_registro(testo + strlen(INTESTAZIONE_ARCHIVIO), testo + lunghezza);
+		fine_registro = valido - testo;
+
+		fd_registro = open(FILE_ARCHIVIO, O_WRONLY | O_APPEND | O_CLOEXEC);
+		stato = fd_registro >= 0;
+
+		//la coda non valida viene tolta, altrimenti nasconderebbe le registrazioni successive
+		if ( stato && fine_registro < (off_t) lunghezza && ftruncate(fd_registro, fine_registro) != 0 )
+			stato = false;
+
+		if (stato && registrazioni > MIN_COMPATTAZIONE && registrazioni > 2 * file_in_memoria)
+			stato = compatta_registro();
+	}
+
+	g_free(testo);
+	g_mutex_unlock(&mutex_memoria);
+
+	if (!stato)
+		registro_chiudi();
+
+	return stato;
+}
+
+static bool registro_scrivi(const posizione_t &pos, const char testo[], gsize lunghezza)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	//la memoria viene aggiornata solo se la modifica è stata registrata
+	bool stato = registra(OP_SCRITTURA, pos, testo, lunghezza);
+	if (stato)
+		aggiorna_file(pos, testo, lunghezza);
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return stato;
+}
+
+static bool registro_elimina(const posizione_t &pos)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	bool esiste = (memoria != 0) && cerca_file(pos) != 0;
+	bool stato = esiste && registra(OP_ELIMINAZIONE, pos, 0, 0);
+	if (stato)
+		rimuovi_file(pos);
+
+	g_mutex_unlock(&mutex_memoria);
+
+	if (!esiste)
+		errno = ENOENT;
+
+	return stato;
+}
+
+static bool registro_elimina_cartella(const posizione_t &pos)
+{
+	g_mutex_lock(&mutex_memoria);
+
+	bool stato = registra(OP_CARTELLA, pos, 0, 0);
+	if (stato)
+		rimuovi_cartella(pos);
+
+	g_mutex_unlock(&mutex_memoria);
+
+	return stato;
+}
+
+/** Archivi che si possono scegliere per nome.
+ */
+static const archivio_t *const ARCHIVI[] = { &ARCHIVIO_ALBERO, &ARCHIVIO_MEMORIA, &ARCHIVIO_FILE };
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+extern const archivio_t ARCHIVIO_ALBERO = { "albero", albero_apri, albero_chiudi, albero_scrivi, albero_leggi,
+		albero_elimina, albero_elimina_cartella, albero_esiste, albero_elenca, albero_elenca_circoli };
+
+extern const archivio_t ARCHIVIO_MEMORIA = { "memoria", memoria_apri, memoria_chiudi, memoria_scrivi, memoria_leggi,
+		memoria_elimina, memoria_elimina_cartella, memoria_esiste, memoria_elenca, memoria_elenca_circoli };
+
+//le letture sono quelle della memoria, le modifiche vengono prima registrate nel file
+extern const archivio_t ARCHIVIO_FILE = { "file", registro_apri, registro_chiudi, registro_scrivi, memoria_leggi,
+		registro_elimina, registro_elimina_cartella, memoria_esiste, memoria_elenca, memoria_elenca_circoli };
+
+const archivio_t *archivio()
+{
+	return in_uso;
+}
+
+bool imposta_archivio(const archivio_t *nuovo)
+{
+	if (nuovo == 0) return false;
+	if (nuovo == in_uso) return true;
+
+	//l'archivio in memoria e quello su file condividono i file in memoria, quindi il vecchio va chiuso prima
+	in_uso->chiudi();
+
+	if ( !nuovo->apri() ){
+		D1(cout<<"Impossibile aprire l'archivio"<<endl)
+		D2(cout<<"Archivio: "<<nuovo->nome<<endl)
+		in_uso->apri();
+		return false;
+	}
+
+	in_uso = nuovo;
+
+	return true;
+}
+
+const archivio_t *cerca_archivio(const char nome[])
+{
+	for (guint i = 0; i < G_N_ELEMENTS(ARCHIVI); i++)
+		if (g_strcmp0(ARCHIVI[i]->nome, nome) == 0)
+			return ARCHIVI[i];
+
+	return 0;
+}
+
+posizione_t posizione(const char *nome_cir, cartella_t cartella, int campo, const char nome[])
+{
+	posizione_t pos;
+	pos.circolo = nome_cir;
+	pos.cartella = cartella;
+	pos.campo = campo;
+	g_strlcpy(pos.nome, nome, sizeof(pos.nome));
+
+	return pos;
+}
+
+char *percorso(const posizione_t &pos)
+{
+	char *dir = percorso_cartella(pos.circolo, pos.cartella, pos.campo);
+	if (pos.nome[0] == '\0')
+		return dir;
+
+	char *file = g_build_filename(dir, pos.nome, NULL);
+	g_free(dir);
+
+	return file;
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,120 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo archivio.cc
+ */
+
+#ifndef ARCHIVIO
+#define ARCHIVIO
+
+#include <glib.h>
+
+/* Inizio interfaccia del modulo archivio */
+
+extern const char DATA_PATH[];		/**< Directory dove l'archivio ad albero memorizza i dati */
+extern const char GIOCATORI_DIR[];	/**< Cartella dei giocatori */
+extern const char CAMPI_DIR[];		/**< Cartella dei campi */
+extern const char ORE_DIR[];		/**< Cartella delle ore */
+extern const char REGOLE_DIR[];		/**< Cartella delle prenotazioni ricorrenti */
+extern const char CORSI_DIR[];		/**< Cartella dei corsi */
+extern const char FILE_ARCHIVIO[];	/**< File in cui l'archivio su file unico memorizza i dati */
+
+/** Cartelle dei dati di un circolo.
+ * Le prime sono cartelle del circolo, da CARTELLA_CAMPO in poi cartelle di un campo
+ */
+enum cartella_t {CARTELLA_CIRCOLO, CARTELLA_GIOCATORI, CARTELLA_CAMPI, CARTELLA_CORSI,
+		CARTELLA_CAMPO, CARTELLA_ORE, CARTELLA_REGOLE};
+
+const int CARTELLE_CIRCOLO = CARTELLA_CAMPO;				/**< Cartelle proprie del circolo */
+const int CARTELLE_CAMPO = CARTELLA_REGOLE - CARTELLA_CAMPO + 1;	/**< Cartelle proprie di un campo */
+
+const int LUNGHEZZA_NOME = 64;		/**< Lunghezza massima del nome di un file in una cartella */
+
+/** Posizione di un file del circolo: la cartella che lo contiene e il nome nella cartella.
+ * campo è il numero del campo per le cartelle di un campo; con il nome vuoto indica la cartella stessa
+ */
+struct posizione_t {
+	const char *circolo;
+	cartella_t cartella;
+	int campo;
+	char nome[LUNGHEZZA_NOME];
+};
+
+/** Archivio dei dati dei circoli.
+ * Ogni archivio conserva i file dei circoli organizzati nelle stesse cartelle,
+ * file_IO ne compone e interpreta il contenuto. Gli archivi lavorano sui file e non sulle entità:
+ * il testo dei record resta l'unico formato dei dati, quindi backup, ripristino e caricamento
+ * a blocchi sono scritti una volta sola per tutti gli archivi e un circolo si sposta da un archivio
+ * all'altro senza conversioni. Le operazioni vengono chiamate
+ * anche dai thread dell'esecutore, quindi ogni archivio deve proteggere i propri dati.
+ * apri viene chiamata quando l'archivio viene scelto, chiudi quando viene sostituito;
+ * elenca ritorna i nomi dei file di una cartella di giocatori, corsi, ore o regole,
+ * per CARTELLA_CAMPI i numeri dei campi,
+ * e 0 se la cartella non esiste; elenca_circoli ritorna i nomi dei circoli.
+ * Gli elenchi vanno deallocati con g_ptr_array_free().
+ * leggi sovrascrive il testo con il contenuto del file; elimina in caso di fallimento
+ * lascia in errno il motivo, ENOENT se il file non esiste
+ */
+struct archivio_t {
+	const char *nome;
+	bool (*apri)();
+	void (*chiudi)();
+	bool (*scrivi)(const posizione_t &pos, const char testo[], gsize lunghezza);
+	bool (*leggi)(const posizione_t &pos, GByteArray *testo);
+	bool (*elimina)(const posizione_t &pos);
+	bool (*elimina_cartella)(const posizione_t &pos);
+	bool (*esiste)(const posizione_t &pos);
+	GPtrArray *(*elenca)(const posizione_t &pos);
+	GPtrArray *(*elenca_circoli)();
+};
+
+//@{
+/** Archivi disponibili.
+ * ARCHIVIO_ALBERO è l'albero di directory in DATA_PATH, quello predefinito;
+ * ARCHIVIO_MEMORIA tiene i file in memoria e li perde all'uscita o quando viene sostituito, per le prove e i benchmark:
+ * elimina l'accesso al disco ma non la composizione e la lettura dei record;
+ * ARCHIVIO_FILE tiene i file in memoria e registra ogni modifica in coda a un unico file,
+ * riletto all'apertura e compattato quando le modifiche superate diventano la maggior parte
+ */
+extern const archivio_t ARCHIVIO_ALBERO;
+extern const archivio_t ARCHIVIO_MEMORIA;
+extern const archivio_t ARCHIVIO_FILE;	//@}
+
+/** Ritorna l'archivio in uso.
+ * @return Archivio in uso, ARCHIVIO_ALBERO se non ne è stato scelto un altro
+ */
+const archivio_t *archivio();
+
+/** Sceglie l'archivio in cui leggere e scrivere i dati.
+ * Va chiamata quando non ci sono lavori in corso sui file. L'archivio precedente viene
+ * chiuso prima di aprire il nuovo e, se l'apertura fallisce, riaperto e lasciato in uso
+ * @param[in] nuovo Archivio da usare
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool imposta_archivio(const archivio_t *nuovo);
+
+/** Cerca un archivio per nome.
+ * @param[in] nome Nome dell'archivio: albero, memoria o file
+ * @return Archivio, 0 se non esiste
+ */
+const archivio_t *cerca_archivio(const char nome[]);
+
+/** Crea la posizione di un file o, se nome è vuoto, della cartella stessa.
+ * Il nome del circolo viene puntato, non copiato
+ * @param[in] nome_cir Nome del circolo
+ * @param[in] cartella Cartella
+ * @param[in] campo Numero del campo per le cartelle di un campo
+ * @param[in] nome Nome del file nella cartella
+ * @return Posizione
+ */
+posizione_t posizione(const char *nome_cir, cartella_t cartella, int campo, const char nome[]);
+
+/** Ritorna il percorso del file nell'albero di directory.
+ * È anche la chiave dei lavori in background sul file
+ * @param[in] pos Posizione del file, se il nome è vuoto della cartella
+ * @return Percorso, da deallocare con g_free()
+ */
+char *percorso(const posizione_t &pos);
+
+/* Fine interfaccia del modulo archivio */
+
+#endif
@@ -0,0 +1,238 @@
+/**
+ * @file
+ * File contenente il modulo corsi.
+ * Fornisce le operazioni su tutte le lezioni di un corso: ogni operazione
+ * controlla prima l'intero gruppo di lezioni, modifica le regole dei campi
+ * e salva il corso con una sola scrittura
+ */
+
+#include <glib.h>
+
+#include "corsi.h"
+#include "accesso_dati.h"
+#include "indice_giorni.h"
+#include "file_IO.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+/** Lezione di un corso: la regola e il campo a cui appartiene.
+ */
+struct lezione_t {
+	regola_t *regola;
+	campo_t *campo;
+};
+
+/** Raccoglie le regole del corso di tutti i campi.
+ * @return Array di lezione_t, da deallocare con g_array_free()
+ */
+static GArray *lezioni_corso(const corso_t *corso, const circolo_t *circolo)
+{
+	GArray *lezioni = g_array_new(FALSE, FALSE, sizeof(lezione_t));
+
+	for (guint i = 0; i < circolo->campi->len; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+
+		for (GList *tmp_r = campo->regole; tmp_r != NULL; tmp_r = g_list_next(tmp_r)){
+			regola_t *regola = (regola_t *) tmp_r->data;
+			if (regola->corso != corso)
+				continue;
+
+			lezione_t lezione = { regola, campo };
+			g_array_append_val(lezioni, lezione);
+		}
+	}
+
+	return lezioni;
+}
+
+/** Toglie le lezioni aggiunte da una programmazione non riuscita.
+ */
+static void togli_lezioni(GArray *lezioni)
+{
+	for (guint i = 0; i < lezioni->len; i++){
+		lezione_t *lezione = &g_array_index(lezioni, lezione_t, i);
+		elimina_regola(lezione->regola, lezione->campo);
+	}
+}
+
+/** Riporta le prime n lezioni dove erano prima dello spostamento.
+ */
+static void ripristina_lezioni(GArray *lezioni, guint n, int minuti, int giorni)
+{
+	for (guint i = 0; i < n; i++){
+		lezione_t *lezione = &g_array_index(lezioni, lezione_t, i);
+		sposta_regola(lezione->regola, lezione->regola->orario - minuti, -giorni, lezione->campo);
+	}
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+bool programma_corso(corso_t *corso, const blocco_corso_t blocchi[], int n_blocchi, guint inizio, guint fine,
+			guint &conflitto, circolo_t *circolo, completamento_t completamento, gpointer dati)
+{
+	TEMPO("corsi: programma_corso")
+
+	conflitto = 0;
+
+	if (corso == 0 || circolo == 0) return false;
+	if (n_blocchi <= 0 || inizio == 0 || inizio > fine) return false;
+
+	//i blocchi con lo stesso campo, orario e durata diventano una regola con più giorni
+	GArray *regole = g_array_new(FALSE, FALSE, sizeof(blocco_corso_t));
+	for (int i = 0; i < n_blocchi; i++){
+		const blocco_corso_t &blocco = blocchi[i];
+
+		if (blocco.giorno < 0 || blocco.giorno > 6 || !orario_valido(blocco.campo, blocco.orario, blocco.durata) ){
+			D1(cout<<"Blocco del corso non valido"<<endl)
+			g_array_free(regole, TRUE);
+			return false;
+		}
+
+		guint j = 0;
+		for (; j < regole->len; j++){
+			blocco_corso_t &regola = g_array_index(regole, blocco_corso_t, j);
+			if (regola.campo == blocco.campo && regola.orario == blocco.orario && regola.durata == blocco.durata){
+				regola.giorno |= 1 << blocco.giorno;
+				break;
+			}
+		}
+
+		if (j == regole->len){
+			blocco_corso_t regola = blocco;
+			regola.giorno = 1 << blocco.giorno;
+			g_array_append_val(regole, regola);
+		}
+	}
+
+	//le regole vengono aggiunte una alla volta, così si controllano anche tra di loro
+	GArray *aggiunte = g_array_new(FALSE, FALSE, sizeof(lezione_t));
+	regola_t prova = {0, 0, 0, inizio, fine, 0, 1, g_array_new(FALSE, FALSE, sizeof(guint)), corso->istruttore, corso};
+	bool stato = true;
+
+	for (guint i = 0; i < regole->len && stato; i++){
+		const blocco_corso_t &regola = g_array_index(regole, blocco_corso_t, i);
+		prova.orario = regola.orario;
+		prova.durata = regola.durata;
+		prova.giorni = regola.giorno;
+
+		conflitto = conflitto_regola(circolo, regola.campo, &prova, 0);
+		if (conflitto != 0){
+			stato = false;
+			break;
+		}
+
+		lezione_t lezione = { aggiungi_regola(0, regola.orario, regola.durata, inizio, fine, regola.giorno, 1,
+							corso->istruttore, corso, regola.campo), regola.campo };
+		if (lezione.regola == 0){
+			stato = false;
+			break;
+		}
+		g_array_append_val(aggiunte, lezione);
+	}
+
+	if (stato)
+		salva_corso_async(corso, circolo, completamento, dati);
+	else
+		togli_lezioni(aggiunte);
+
+	g_array_free(prova.eccezioni, TRUE);
+	g_array_free(aggiunte, TRUE);
+	g_array_free(regole, TRUE);
+
+	return stato;
+}
+
+bool sposta_corso(corso_t *corso, int minuti, int giorni, guint &conflitto, circolo_t *circolo,
+			completamento_t completamento, gpointer dati)
+{
+	TEMPO("corsi: sposta_corso")
+
+	conflitto = 0;
+
+	if (corso == 0 || circolo == 0) return false;
+
+	GArray *lezioni = lezioni_corso(corso, circolo);
+
+	//prima si controllano gli orari, che non richiedono di spostare nulla
+	for (guint i = 0; i < lezioni->len; i++){
+		lezione_t *lezione = &g_array_index(lezioni, lezione_t, i);
+		if ( !orario_valido(lezione->campo, lezione->regola->orario + minuti, lezione->regola->durata) ){
+			g_array_free(lezioni, TRUE);
+			return false;
+		}
+	}
+
+	guint spostate = 0;
+	for (; spostate < lezioni->len; spostate++){
+		lezione_t *lezione = &g_array_index(lezioni, lezione_t, spostate);
+		if ( !sposta_regola(lezione->regola, lezione->regola->orario + minuti, giorni, lezione->campo) )
+			break;
+	}
+
+	//le lezioni del corso si spostano insieme, quindi non si confrontano tra di loro
+	for (guint i = 0; i < spostate && conflitto == 0; i++){
+		lezione_t *lezione = &g_array_index(lezioni, lezione_t, i);
+		conflitto = conflitto_regola(circolo, lezione->campo, lezione->regola, corso);
+	}
+
+	bool stato = spostate == lezioni->len && conflitto == 0;
+
+	if (stato)
+		salva_corso_async(corso, circolo, completamento, dati);
+	else
+		ripristina_lezioni(lezioni, spostate, minuti, giorni);
+
+	g_array_free(lezioni, TRUE);
+
+	return stato;
+}
+
+bool annulla_lezione(regola_t *regola, campo_t *campo, guint giorno, circolo_t *circolo,
+			completamento_t completamento, gpointer dati)
+{
+	if (regola == 0 || regola->corso == 0) return false;
+
+	if ( !aggiungi_eccezione(regola, giorno, campo) )
+		return false;
+
+	salva_corso_async(regola->corso, circolo, completamento, dati);
+
+	return true;
+}
+
+int conta_lezioni(const corso_t *corso, const circolo_t *circolo)
+{
+	GArray *lezioni = lezioni_corso(corso, circolo);
+	int n = 0;
+
+	for (guint i = 0; i < lezioni->len; i++){
+		const regola_t *regola = g_array_index(lezioni, lezione_t, i).regola;
+
+		for (guint g = prossima_occorrenza(regola, regola->inizio); g != 0; g = prossima_occorrenza(regola, g + 1))
+			n++;
+	}
+
+	g_array_free(lezioni, TRUE);
+
+	return n;
+}
+
+GList *corsi_del_campo(const campo_t *campo)
+{
+	GList *corsi = 0;
+
+	for (GList *tmp = campo->regole; tmp != NULL; tmp = g_list_next(tmp)){
+		corso_t *corso = ((regola_t *) tmp->data)->corso;
+
+		if (corso != 0 && g_list_find(corsi, corso) == NULL)
+			corsi = g_list_prepend(corsi, corso);
+	}
+
+	return corsi;
+}
+
+/* Fine definizioni pubbliche */
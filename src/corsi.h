@@ -0,0 +1,90 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo corsi.cc
+ */
+
+#ifndef CORSI
+#define CORSI
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+#include "esecutore.h"
+
+/* Inizio interfaccia del modulo corsi */
+
+/** Lezioni settimanali di un corso su un campo.
+ * giorno è il giorno della settimana, 0 il lunedì e 6 la domenica;
+ * orario e durata sono in minuti
+ */
+struct blocco_corso_t {
+	campo_t *campo;
+	int giorno;
+	int orario;
+	int durata;
+};
+
+/** Programma le lezioni di un corso per un periodo.
+ * Ogni blocco diventa una lezione settimanale tra inizio e fine; i blocchi con lo stesso
+ * campo, orario e durata vengono uniti in un'unica regola.
+ * Vengono programmate tutte le lezioni o nessuna: se una si sovrappone ad altre prenotazioni
+ * quelle già aggiunte vengono tolte. Il corso viene salvato una sola volta alla fine
+ * @param[in,out] corso Corso
+ * @param[in] blocchi Blocchi da programmare
+ * @param[in] n_blocchi Numero di blocchi
+ * @param[in] inizio Giorno giuliano di inizio del periodo
+ * @param[in] fine Giorno giuliano di fine del periodo
+ * @param[out] conflitto Giorno giuliano della prima sovrapposizione, 0 se non ce ne sono
+ * @param[in,out] circolo Circolo del corso
+ * @param[in] completamento Funzione chiamata al termine del salvataggio, può essere 0
+ * @param[in] dati Dati passati a completamento
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool programma_corso(corso_t *corso, const blocco_corso_t blocchi[], int n_blocchi, guint inizio, guint fine,
+			guint &conflitto, circolo_t *circolo, completamento_t completamento, gpointer dati);
+
+/** Sposta tutte le lezioni di un corso.
+ * Le lezioni vengono spostate di minuti e di giorni; se una di esse esce dagli orari del suo campo
+ * o si sovrappone ad altre prenotazioni tutte tornano dove erano.
+ * Il corso viene salvato una sola volta alla fine
+ * @param[in,out] corso Corso
+ * @param[in] minuti Minuti di cui spostare le lezioni, anche negativo
+ * @param[in] giorni Giorni di cui spostare le lezioni, anche negativo
+ * @param[out] conflitto Giorno giuliano della prima sovrapposizione, 0 se non ce ne sono
+ * @param[in,out] circolo Circolo del corso
+ * @param[in] completamento Funzione chiamata al termine del salvataggio, può essere 0
+ * @param[in] dati Dati passati a completamento
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool sposta_corso(corso_t *corso, int minuti, int giorni, guint &conflitto, circolo_t *circolo,
+			completamento_t completamento, gpointer dati);
+
+/** Annulla una sola lezione di un corso.
+ * @param[in,out] regola Regola della lezione
+ * @param[in,out] campo Campo della regola
+ * @param[in] giorno Giorno giuliano della lezione
+ * @param[in,out] circolo Circolo del corso
+ * @param[in] completamento Funzione chiamata al termine del salvataggio, può essere 0
+ * @param[in] dati Dati passati a completamento
+ * @return successo (TRUE) o fallimento (FALSE) se quel giorno non c'è lezione
+ */
+bool annulla_lezione(regola_t *regola, campo_t *campo, guint giorno, circolo_t *circolo,
+			completamento_t completamento, gpointer dati);
+
+/** Conta le lezioni programmate di un corso, escluse quelle annullate.
+ * @param[in] corso Corso
+ * @param[in] circolo Circolo del corso
+ * @return Numero di lezioni
+ */
+int conta_lezioni(const corso_t *corso, const circolo_t *circolo);
+
+/** Ritorna i corsi che hanno lezioni sul campo.
+ * Serve a salvare i corsi dopo l'eliminazione del campo, che porta via le loro lezioni
+ * @param[in] campo Campo
+ * @return Lista dei corsi, da deallocare con g_list_free()
+ */
+GList *corsi_del_campo(const campo_t *campo);
+
+/* Fine interfaccia del modulo corsi */
+
+#endif
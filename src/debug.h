@@ -1,7 +1,8 @@
 /**
  * @file
  * File contente le istruzioni per il debug.
- * Ha effetto solo se è definito DEBUG_MODE
+ * D1 e D2 hanno effetto solo se è definito DEBUG_MODE,
+ * TEMPO, CONTA, ISTOGRAMMA e TRACCIA solo se è definito PRESTAZIONI
  */
 
 #ifndef DEBUG
@@ -19,4 +20,30 @@
 #define D1(A) DBG(1, A) /**< Mostra i vari passaggi fondamentali */
 #define D2(A) DBG(2, A) /**< Mostra stato variabili ed errori veri e propri */
 
+#ifdef PRESTAZIONI
+	#include "prestazioni.h"
+	#define PRS_CONCAT_(A, B) A##B
+	#define PRS_CONCAT(A, B) PRS_CONCAT_(A, B)
+	/** Misura il tempo fino alla fine del blocco. */
+	#define TEMPO(NOME) \
+		static statistica_t *PRS_CONCAT(prs_stat_, __LINE__) = registra_statistica(NOME, STAT_TEMPO); \
+		tempo_blocco_t PRS_CONCAT(prs_tempo_, __LINE__)(PRS_CONCAT(prs_stat_, __LINE__));
+	/** Conta un evento. */
+	#define CONTA(NOME) \
+		{ static statistica_t *prs_stat = registra_statistica(NOME, STAT_CONTATORE); aggiungi_valore(prs_stat, 1); }
+	/** Aggiunge un valore all'istogramma. */
+	#define ISTOGRAMMA(NOME, VALORE) \
+		{ static statistica_t *prs_stat = registra_statistica(NOME, STAT_ISTOGRAMMA); aggiungi_valore(prs_stat, (VALORE)); }
+	/** Registra nella traccia un evento lungo quanto il blocco. */
+	#define TRACCIA(NOME, CATEGORIA, FILE) traccia_blocco_t prs_traccia(NOME, CATEGORIA, FILE);
+	/** Aggiunge un conteggio all'evento del blocco. */
+	#define TRACCIA_ARG(NOME, VALORE) prs_traccia.argomento(NOME, (VALORE));
+#else
+	#define TEMPO(NOME)			/**< PRESTAZIONI non definito. Non esegue nulla. */
+	#define CONTA(NOME)			/**< PRESTAZIONI non definito. Non esegue nulla. */
+	#define ISTOGRAMMA(NOME, VALORE)	/**< PRESTAZIONI non definito. Non esegue nulla. */
+	#define TRACCIA(NOME, CATEGORIA, FILE)	/**< PRESTAZIONI non definito. Non esegue nulla. */
+	#define TRACCIA_ARG(NOME, VALORE)	/**< PRESTAZIONI non definito. Non esegue nulla. */
+#endif
+
 #endif
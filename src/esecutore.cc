@@ -0,0 +1,217 @@
+/**
+ * @file
+ * File contenente il modulo esecutore.
+ * Esegue in background le operazioni lente (scritture su disco, backup)
+ * e riporta il loro esito nel main loop di GTK
+ */
+
+#include <glib.h>
+#include <cstring>
+
+#include "esecutore.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const int N_THREAD = 4;		/**< Thread usati dall'esecutore */
+
+/** Lavoro accodato.
+ */
+struct voce_lavoro_t {
+	char *chiave;
+	lavoro_t lavoro;
+	gpointer dati;
+	GDestroyNotify libera;
+	completamento_t fine;
+	gpointer dati_fine;
+	bool esito;
+};
+
+static GMutex mutex;			/**< Protegge le code dell'esecutore */
+static GThreadPool *pool = 0;		/**< Thread che eseguono i lavori */
+static GQueue in_attesa = { 0, 0, 0 };	/**< Lavori non ancora partiti, in ordine di arrivo */
+static GList *in_corso = 0;		/**< Lavori in esecuzione */
+static int da_completare = 0;		/**< Lavori il cui completamento non è ancora stato eseguito */
+
+/** Funzione da chiamare quando non restano lavori da completare.
+ */
+struct attesa_t {
+	completamento_t fine;
+	gpointer dati;
+};
+
+static GSList *attese = 0;		/**< Attese della fine dei lavori, in ordine inverso di arrivo */
+
+/** Controlla se due chiavi sono in conflitto.
+ * @return TRUE se le chiavi sono uguali o una è un percorso contenuto nell'altra
+ */
+static bool chiavi_in_conflitto(const char *a, const char *b)
+{
+	size_t la = strlen(a);
+	size_t lb = strlen(b);
+
+	if (la > lb){
+		const char *tmp = a;
+		a = b;
+		b = tmp;
+		size_t l = la;
+		la = lb;
+		lb = l;
+	}
+
+	if ( strncmp(a, b, la) != 0 )
+		return false;
+
+	return (la == lb) || (b[la] == '/');
+}
+
+/** Controlla se la chiave è in conflitto con uno dei lavori della lista.
+ * Scorre la lista fino al nodo fine escluso
+ */
+static bool conflitto_lista(const char *chiave, GList *lista, GList *fine)
+{
+	for (GList *tmp = lista; tmp != fine; tmp = g_list_next(tmp))
+		if ( chiavi_in_conflitto(chiave, ((voce_lavoro_t *) tmp->data)->chiave) )
+			return true;
+
+	return false;
+}
+
+/** Fa partire i lavori in attesa che non hanno conflitti.
+ * Un lavoro parte solo se nessun lavoro in corso e nessun lavoro accodato prima di lui
+ * è in conflitto, così l'ordine per chiave viene mantenuto.
+ * Va chiamata con il mutex acquisito
+ */
+static void avvia_lavori()
+{
+	GList *tmp = in_attesa.head;
+	while(tmp != NULL){
+		GList *succ = g_list_next(tmp);
+		voce_lavoro_t *voce = (voce_lavoro_t *) tmp->data;
+
+		if ( !conflitto_lista(voce->chiave, in_corso, NULL) &&
+				!conflitto_lista(voce->chiave, in_attesa.head, tmp) ){
+			g_queue_delete_link(&in_attesa, tmp);
+			in_corso = g_list_prepend(in_corso, voce);
+			g_thread_pool_push(pool, voce, NULL);
+		}
+
+		tmp = succ;
+	}
+}
+
+/** Esegue nel main loop il completamento del lavoro e ne libera i dati.
+ */
+static gboolean completa_lavoro(gpointer voce_)
+{
+	voce_lavoro_t *voce = (voce_lavoro_t *) voce_;
+
+	if (voce->fine != 0)
+		voce->fine(voce->esito, voce->dati_fine);
+
+	if (voce->libera != 0)
+		voce->libera(voce->dati);
+	g_free(voce->chiave);
+	g_free(voce);
+
+	g_mutex_lock(&mutex);
+	da_completare--;
+	GSList *pronte = 0;
+	if (da_completare == 0){
+		pronte = g_slist_reverse(attese);
+		attese = 0;
+	}
+	g_mutex_unlock(&mutex);
+
+	//le attese possono accodare altri lavori, quindi vengono chiamate senza il mutex
+	for (GSList *tmp = pronte; tmp != NULL; tmp = g_slist_next(tmp)){
+		attesa_t *attesa = (attesa_t *) tmp->data;
+		attesa->fine(true, attesa->dati);
+	}
+	g_slist_free_full(pronte, g_free);
+
+	return G_SOURCE_REMOVE;
+}
+
+/** Funzione eseguita dai thread del pool.
+ */
+static void esegui_lavoro(gpointer voce_, gpointer user_data)
+{
+	voce_lavoro_t *voce = (voce_lavoro_t *) voce_;
+
+	D2(cout<<"Esecuzione lavoro: "<<voce->chiave<<endl)
+	{
+		TEMPO("esecutore: lavoro")
+		voce->esito = voce->lavoro(voce->dati);
+	}
+
+	g_mutex_lock(&mutex);
+	in_corso = g_list_remove(in_corso, voce);
+	avvia_lavori();
+	g_mutex_unlock(&mutex);
+
+	g_idle_add_full(G_PRIORITY_DEFAULT, completa_lavoro, voce, NULL);
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+void accoda_lavoro(const char *chiave, lavoro_t lavoro, gpointer dati, GDestroyNotify libera,
+			completamento_t fine, gpointer dati_fine)
+{
+	voce_lavoro_t *voce = g_new(voce_lavoro_t, 1);
+	voce->chiave = g_strdup(chiave);
+	voce->lavoro = lavoro;
+	voce->dati = dati;
+	voce->libera = libera;
+	voce->fine = fine;
+	voce->dati_fine = dati_fine;
+	voce->esito = false;
+
+	g_mutex_lock(&mutex);
+
+	if (pool == 0)
+		pool = g_thread_pool_new(esegui_lavoro, NULL, N_THREAD, FALSE, NULL);
+
+	da_completare++;
+	g_queue_push_tail(&in_attesa, voce);
+	avvia_lavori();
+	ISTOGRAMMA("esecutore: lavori in attesa", in_attesa.length)
+
+	g_mutex_unlock(&mutex);
+}
+
+void attendi_esecutore()
+{
+	D1(cout<<"Attesa esecutore"<<endl)
+
+	g_mutex_lock(&mutex);
+	while (da_completare > 0){
+		//i completamenti vengono eseguiti dal main loop, quindi va fatto girare
+		g_mutex_unlock(&mutex);
+		g_main_context_iteration(NULL, TRUE);
+		g_mutex_lock(&mutex);
+	}
+	g_mutex_unlock(&mutex);
+}
+
+void al_termine_esecutore(completamento_t fine, gpointer dati)
+{
+	g_mutex_lock(&mutex);
+
+	bool libero = da_completare == 0;
+	if (!libero){
+		attesa_t *attesa = g_new(attesa_t, 1);
+		attesa->fine = fine;
+		attesa->dati = dati;
+		attese = g_slist_prepend(attese, attesa);
+	}
+
+	g_mutex_unlock(&mutex);
+
+	if (libero)
+		fine(true, dati);
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo esecutore.cc
+ */
+
+#ifndef ESECUTORE
+#define ESECUTORE
+
+#include <glib.h>
+
+/* Inizio interfaccia del modulo esecutore */
+
+/** Lavoro da eseguire in background.
+ * Viene eseguito su un thread dell'esecutore, non deve accedere all'interfaccia
+ * né ai dati del circolo vivo
+ * @param[in,out] dati Dati del lavoro
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+typedef bool (*lavoro_t)(gpointer dati);
+
+/** Funzione chiamata al termine di un lavoro.
+ * Viene sempre eseguita nel main loop di GTK
+ * @param[in] esito Valore ritornato dal lavoro
+ * @param[in] dati Dati passati con il completamento
+ */
+typedef void (*completamento_t)(bool esito, gpointer dati);
+
+/** Accoda un lavoro all'esecutore.
+ * I lavori sono ordinati per chiave: un lavoro non parte finché non sono terminati
+ * tutti i lavori accodati prima di lui con una chiave in conflitto.
+ * Due chiavi sono in conflitto se sono uguali o se una è un prefisso dell'altra
+ * seguito da '/', quindi usando come chiave il percorso dell'entità
+ * le operazioni su una cartella attendono quelle sui file che contiene e viceversa
+ * @param[in] chiave Chiave dell'entità interessata
+ * @param[in] lavoro Lavoro da eseguire
+ * @param[in] dati Dati del lavoro
+ * @param[in] libera Funzione per deallocare i dati del lavoro, può essere 0
+ * @param[in] fine Funzione da chiamare nel main loop al termine, può essere 0
+ * @param[in] dati_fine Dati passati a fine
+ */
+void accoda_lavoro(const char *chiave, lavoro_t lavoro, gpointer dati, GDestroyNotify libera,
+			completamento_t fine, gpointer dati_fine);
+
+/** Attende la fine di tutti i lavori accodati.
+ * Da usare prima di leggere dal disco dati che potrebbero essere in scrittura
+ * e all'uscita del programma
+ */
+void attendi_esecutore();
+
+/** Chiama la funzione quando tutti i lavori accodati sono stati completati.
+ * Diversamente da attendi_esecutore() non fa girare il main loop: la funzione viene chiamata
+ * nel main loop dopo l'ultimo completamento, o subito se non ci sono lavori
+ * @param[in] fine Funzione da chiamare, con esito sempre TRUE
+ * @param[in] dati Dati passati a fine
+ */
+void al_termine_esecutore(completamento_t fine, gpointer dati);
+
+/* Fine interfaccia del modulo esecutore */
+
+#endif
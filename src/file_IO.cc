@@ -7,296 +7,1481 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <string>
 using namespace std;
 
 #include "file_IO.h"
+#include "archivio.h"
 #include "accesso_dati.h"
+#include "istantanea.h"
+#include "formato.h"
+#include "esecutore.h"
+#include "indice_giorni.h"
+#include "selezione.h"
 #include "struttura_dati.h"
 #include "debug.h"
 
 
 /* Inizio definizioni delle entità private del modulo */
 
-extern const char DATA_PATH[] = "data";			/**< Directory dove il programma memorizza i dati */
 const char DATI_CIRCOLO[] = "circolo.txt";		/**< File contenente i dati del circolo */
 const char DATI_CAMPO[] = "campo.txt";			/**< File contenente i dati del campo */
-const char GIOCATORI_DIR[] = "giocatori";		/**< Cartella dei giocatori */
-const char CAMPI_DIR[] = "campi";			/**< Cartella dei campi */
+const char ORARI_CAMPO[] = "orari.txt";			/**< File contenente gli orari propri del campo */
 const char ARCHIVIO_DIR[] = "archivio";			/**< Cartella delle ore archiviate */
-const char ORE_DIR[] = "ore";				/**< Cartella delle ore */
 const char FILE_EXT[] = ".txt";				/**< Estensione dei file */
 
 const char ETX = 3;					/**< End of text */
 
-/** Controlla l'esistenza della directory e se non esiste la crea.
- * Se la directory esiste ritorna subito TRUE altrimenti ricostruisce
- * l'albero delle directory per crearla	
- * @param[in] path Indirizzo della directory
- * @return TRUE se la directory esiste o è stata creata, FALSE se non è stato possibile crearla
+const int LUNGHEZZA_RECORD = 128;			/**< Spazio riservato per il testo di un record */
+
+const unsigned int RIGHE_REGOLA = 9;			/**< Righe del file di una prenotazione ricorrente */
+const unsigned int RIGHE_CORSO = 4;			/**< Righe del file di un corso prima delle sue lezioni */
+const int VALORI_LEZIONE = 8;				/**< Valori di una lezione prima delle sue eccezioni */
+
+//@{
+/** Ritornano la posizione del file di un'entità, senza allocare memoria.
  */
-static bool controlla_directory(const char path[])
+static posizione_t posizione_giocatore(const char *nome_cir, int ID)
 {
-	if ( g_file_test(path, G_FILE_TEST_IS_DIR) ) return true;
+	posizione_t pos = posizione(nome_cir, CARTELLA_GIOCATORI, 0, "");
+	g_snprintf(pos.nome, sizeof(pos.nome), "%d%s", ID, FILE_EXT);
 
-	D1(cout<<"Cartella non presente"<<endl);
-	//Se non esiste la crea
-	char *file = 0;
-	char *file_ = 0;
-	char **cartelle = g_strsplit(path, "/", 0);
-	int len = g_strv_length(cartelle);
-	D2(cout<<"len: "<<len<<endl)
-	
-	file = g_build_filename(cartelle[0], NULL);
-	for (int i = 0; i < len; i++){
-		if ( !g_file_test(file, G_FILE_TEST_IS_DIR) ){
-
-			D2(cout<<"Creazione cartella: "<<file<<endl)
-			if ( g_mkdir(file, S_IRWXU) != 0 ){
-				D1(cout<<"Impossibile creare cartella"<<endl)
-				return false;
-			}
+	return pos;
+}
+
+static posizione_t posizione_ora(const char *nome_cir, int campo, const ora_t *ora)
+{
+	posizione_t pos = posizione(nome_cir, CARTELLA_ORE, campo, "");
+	g_snprintf(pos.nome, sizeof(pos.nome), "%s_%d%s", ora->data->str, ora->orario, FILE_EXT);
+
+	return pos;
+}
+
+static posizione_t posizione_regola(const char *nome_cir, int campo, const regola_t *regola)
+{
+	posizione_t pos = posizione(nome_cir, CARTELLA_REGOLE, campo, "");
+	g_snprintf(pos.nome, sizeof(pos.nome), "%d%s", regola->ID, FILE_EXT);
+
+	return pos;
+}
+
+static posizione_t posizione_corso(const char *nome_cir, const corso_t *corso)
+{
+	posizione_t pos = posizione(nome_cir, CARTELLA_CORSI, 0, "");
+	g_snprintf(pos.nome, sizeof(pos.nome), "%d%s", corso->ID, FILE_EXT);
+
+	return pos;
+}	//@}
+
+/** Ritorna il prossimo valore di una riga separato da spazi, terminandolo sul posto.
+ * @param[in,out] cursore Posizione nella riga, avanza oltre il valore
+ * @return Valore, 0 se la riga è finita
+ */
+static char *prossimo_valore(char *&cursore)
+{
+	while (*cursore == ' ')
+		cursore++;
+	if (*cursore == '\0')
+		return 0;
+
+	char *valore = cursore;
+	while (*cursore != ' ' && *cursore != '\0')
+		cursore++;
+	if (*cursore == ' ')
+		*cursore++ = '\0';
+
+	return valore;
+}
+
+/** Scrive nello stream l'intestazione di una cartella del backup.
+ * @param[in,out] f1 Stream del backup
+ * @param[in] cartella Percorso della cartella
+ */
+static void backup_cartella(ostream &f1, const char cartella[])
+{
+	f1<<"<cartella "<<cartella<<">"<<endl;
+}
+
+/** Scrive nello stream l'intestazione di un file del backup.
+ * Il contenuto va scritto subito dopo e chiuso con fine_backup_file()
+ * @param[in,out] f1 Stream del backup
+ * @param[in] file Percorso del file
+ */
+static void backup_file(ostream &f1, const char file[])
+{
+	f1<<"<file "<<file<<">"<<endl;
+}
+
+/** Indica la fine del file corrente nel backup.
+ * @param[in,out] f1 Stream del backup
+ */
+static void fine_backup_file(ostream &f1)
+{
+	f1<<ETX<<endl;
+}
+
+/** Ricava la posizione di un file del backup dal suo percorso nell'albero di directory.
+ * Il nome del circolo viene copiato in circolo, a cui punta la posizione
+ * @param[in] file Percorso del file nel backup
+ * @param[out] pos Posizione del file
+ * @param[out] circolo Nome del circolo
+ * @return TRUE se il percorso è quello di un file dei dati
+ */
+static bool posizione_backup(const char file[], posizione_t &pos, GString *circolo)
+{
+	char **parti = g_strsplit(file, "/", 0);
+	guint n = g_strv_length(parti);
+	int campo = 0;
+	bool stato = n >= 3 && g_strcmp0(parti[0], DATA_PATH) == 0;
+
+	if (stato){
+		g_string_assign(circolo, parti[1]);
+		const char *nome = parti[n - 1];
+
+		if (n == 3)
+			pos = posizione(circolo->str, CARTELLA_CIRCOLO, 0, nome);
+		else if (n == 4 && g_strcmp0(parti[2], GIOCATORI_DIR) == 0)
+			pos = posizione(circolo->str, CARTELLA_GIOCATORI, 0, nome);
+		else if (n == 4 && g_strcmp0(parti[2], CORSI_DIR) == 0)
+			pos = posizione(circolo->str, CARTELLA_CORSI, 0, nome);
+		else if ( n >= 5 && g_strcmp0(parti[2], CAMPI_DIR) == 0 && leggi_intero(parti[3], campo) ){
+			if (n == 5)
+				pos = posizione(circolo->str, CARTELLA_CAMPO, campo, nome);
+			else if (n == 6 && g_strcmp0(parti[4], ORE_DIR) == 0)
+				pos = posizione(circolo->str, CARTELLA_ORE, campo, nome);
+			else if (n == 6 && g_strcmp0(parti[4], REGOLE_DIR) == 0)
+				pos = posizione(circolo->str, CARTELLA_REGOLE, campo, nome);
+			else
+				stato = false;
 		}
-	
-		file_ = g_build_filename(file, cartelle[i+1], NULL);
-		g_free(file);
-		file = file_;
+		else
+			stato = false;
 	}
-	
-	g_free(file_);
-	g_strfreev(cartelle);
 
-	return true;
+	g_strfreev(parti);
+
+	return stato;
 }
 
-/** Copia il file nello stream.
- * Copia il contenuto del file nello stream
- * @param[in,out] f1 Stream in cui copiare il file
- * @param[in] file File da copiare
- * @return Successo (TRUE) o fallimento (FALSE)
+/** Scrive nel backup il record di una copia piatta nel formato dei file.
+ * @param[in,out] f1 Stream del backup
+ * @param[in] tracciato Tracciato della copia
+ * @param[in] copia Copia piatta
  */
-static bool backup_file(ofstream &f1, const char file[])
+static void backup_record(ostream &f1, const tracciato_t &tracciato, gconstpointer copia)
 {
-	if (!f1){
-		D1(cout<<"Lo stream passato non è valido"<<endl)
-		return false;
+	GString *testo = g_string_sized_new(LUNGHEZZA_RECORD);
+	scrivi_copia(testo, FORMATO_TESTO, tracciato, copia);
+
+	f1.write(testo->str, testo->len);
+	g_string_free(testo, TRUE);
+}
+
+/** Dati passati alle funzioni di visita dell'istantanea durante il backup.
+ */
+struct dati_backup_t {
+	ostream *f1;
+	const char *nome_cir;
+};
+
+/** Scrive nel backup il file di un giocatore dell'istantanea.
+ */
+static void backup_giocatore(const ist_giocatore_t *giocatore, void *dati_)
+{
+	dati_backup_t *dati = (dati_backup_t *) dati_;
+	ostream &f1 = *dati->f1;
+	ostringstream file;
+	file<<DATA_PATH<<"/"<<dati->nome_cir<<"/"<<GIOCATORI_DIR<<"/"<<giocatore->ID<<FILE_EXT;
+
+	backup_file(f1, file.str().c_str());
+	backup_record(f1, TRACCIATO_GIOCATORE, giocatore);
+	fine_backup_file(f1);
+}
+
+/** Dati per il backup delle ore e delle regole di un campo. */
+struct dati_backup_ore_t {
+	ostream *f1;
+	const char *dir;
+};
+
+/** Scrive nel backup il file di un'ora dell'istantanea.
+ */
+static void backup_ora(const ist_ora_t *ora, void *dati_)
+{
+	dati_backup_ore_t *dati = (dati_backup_ore_t *) dati_;
+	ostream &f1 = *dati->f1;
+	ostringstream file;
+	file<<dati->dir<<"/"<<ora->data<<"_"<<ora->orario<<FILE_EXT;
+
+	backup_file(f1, file.str().c_str());
+	backup_record(f1, TRACCIATO_ORA, ora);
+	fine_backup_file(f1);
+}
+
+static void scrivi_dati_regola(ostream &f1, int ID, int orario, int durata, guint inizio, guint fine,
+			int giorni, int settimane, int prenotante, const guint *eccezioni, guint n_eccezioni);
+static void scrivi_lezione(ostream &f1, int campo, int ID, int orario, int durata, guint inizio, guint fine,
+			int giorni, int settimane, const guint *eccezioni, guint n_eccezioni);
+
+/** Scrive nel backup il file di una prenotazione ricorrente dell'istantanea.
+ * Le lezioni dei corsi vengono scritte nel file del loro corso
+ */
+static void backup_regola(const ist_regola_t *regola, void *dati_)
+{
+	if (regola->corso != 0)
+		return;
+
+	dati_backup_ore_t *dati = (dati_backup_ore_t *) dati_;
+	ostream &f1 = *dati->f1;
+	ostringstream file;
+	file<<dati->dir<<"/"<<regola->ID<<FILE_EXT;
+
+	backup_file(f1, file.str().c_str());
+	scrivi_dati_regola(f1, regola->ID, regola->orario, regola->durata, regola->inizio, regola->fine,
+			regola->giorni, regola->settimane, regola->prenotante, regola->eccezioni, regola->n_eccezioni);
+	fine_backup_file(f1);
+}
+
+/** Dati per il backup delle lezioni di un corso. */
+struct dati_backup_lezioni_t {
+	ostream *f1;
+	int corso;
+	int campo;
+};
+
+static void backup_lezione(const ist_regola_t *regola, void *dati_)
+{
+	dati_backup_lezioni_t *dati = (dati_backup_lezioni_t *) dati_;
+
+	if (regola->corso == dati->corso)
+		scrivi_lezione(*dati->f1, dati->campo, regola->ID, regola->orario, regola->durata, regola->inizio,
+				regola->fine, regola->giorni, regola->settimane, regola->eccezioni, regola->n_eccezioni);
+}
+
+static void backup_lezioni_campo(const ist_campo_t *campo, void *dati_)
+{
+	dati_backup_lezioni_t *dati = (dati_backup_lezioni_t *) dati_;
+	dati->campo = campo->numero;
+
+	ist_foreach_regola(campo, backup_lezione, dati);
+}
+
+/** Dati per il backup dei corsi. */
+struct dati_backup_corsi_t {
+	ostream *f1;
+	const char *dir;
+	const istantanea_t *ist;
+};
+
+/** Scrive nel backup il file di un corso dell'istantanea con tutte le sue lezioni.
+ */
+static void backup_corso(const ist_corso_t *corso, void *dati_)
+{
+	dati_backup_corsi_t *dati = (dati_backup_corsi_t *) dati_;
+	ostream &f1 = *dati->f1;
+	ostringstream file;
+	file<<dati->dir<<"/"<<corso->ID<<FILE_EXT;
+
+	backup_file(f1, file.str().c_str());
+	f1<<corso->ID<<endl;
+	f1<<corso->nome<<endl;
+	f1<<corso->istruttore<<endl;
+	for (guint i = 0; i < corso->n_iscritti; i++)
+		f1<<(i > 0 ? " " : "")<<corso->iscritti[i];
+	f1<<endl;
+
+	dati_backup_lezioni_t lezioni = { dati->f1, corso->ID, 0 };
+	ist_foreach_campo(dati->ist, backup_lezioni_campo, &lezioni);
+	fine_backup_file(f1);
+}
+
+/** Scrive nel backup le cartelle e i file di un campo dell'istantanea.
+ */
+static void backup_campo(const ist_campo_t *campo, void *dati_)
+{
+	dati_backup_t *dati = (dati_backup_t *) dati_;
+	ostream &f1 = *dati->f1;
+	ostringstream dir;
+	dir<<DATA_PATH<<"/"<<dati->nome_cir<<"/"<<CAMPI_DIR<<"/"<<campo->numero;
+	string dir_ore = dir.str() + "/" + ORE_DIR;
+	string file = dir.str() + "/" + DATI_CAMPO;
+
+	backup_cartella(f1, dir.str().c_str());
+	backup_file(f1, file.c_str());
+	backup_record(f1, TRACCIATO_CAMPO, campo);
+	fine_backup_file(f1);
+
+	if (campo->orari.passo != 0){
+		string orari = dir.str() + "/" + ORARI_CAMPO;
+		backup_file(f1, orari.c_str());
+		backup_record(f1, TRACCIATO_ORARI, &campo->orari);
+		fine_backup_file(f1);
 	}
-	
-	streambuf *buf = f1.rdbuf();
-	ifstream f2(file);
-	if (!f2){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		D2(cout<<"File: "<<file<<endl)
-		return false;
+
+	backup_cartella(f1, dir_ore.c_str());
+	dati_backup_ore_t dati_ore = { dati->f1, dir_ore.c_str() };
+	ist_foreach_ora(campo, backup_ora, &dati_ore);
+
+	string dir_regole = dir.str() + "/" + REGOLE_DIR;
+	backup_cartella(f1, dir_regole.c_str());
+	dati_backup_ore_t dati_regole = { dati->f1, dir_regole.c_str() };
+	ist_foreach_regola(campo, backup_regola, &dati_regole);
+}
+
+/** Scrive i dati di una prenotazione ricorrente nello stream nel formato dei file.
+ * Le date sono nel formato gg-mm-aaaa, le eccezioni tutte sull'ultima riga separate da spazi
+ */
+static void scrivi_dati_regola(ostream &f1, int ID, int orario, int durata, guint inizio, guint fine,
+			int giorni, int settimane, int prenotante, const guint *eccezioni, guint n_eccezioni)
+{
+	char *data_inizio = data_da_giorno(inizio);
+	char *data_fine = data_da_giorno(fine);
+
+	f1<<ID<<endl;
+	f1<<orario<<endl;
+	f1<<durata<<endl;
+	f1<<data_inizio<<endl;
+	f1<<data_fine<<endl;
+	f1<<giorni<<endl;
+	f1<<settimane<<endl;
+	f1<<prenotante<<endl;
+
+	for (guint i = 0; i < n_eccezioni; i++){
+		char *data = data_da_giorno(eccezioni[i]);
+		f1<<(i > 0 ? " " : "")<<data;
+		g_free(data);
 	}
-	
-	//Scrittura markup
-	f1<<"<file "<<file<<">"<<endl;
-	
-	//Scrittura contenuto file
-	while( !f2.eof() ){
-		f2>>noskipws>>buf;
-		f1.flush();
+	f1<<endl;
+
+	g_free(data_fine);
+	g_free(data_inizio);
+}
+
+/** Scrive i dati della regola nello stream nel formato dei file.
+ */
+static void scrivi_regola(ostream &f1, const regola_t *regola)
+{
+	scrivi_dati_regola(f1, regola->ID, regola->orario, regola->durata, regola->inizio, regola->fine,
+			regola->giorni, regola->settimane, regola->prenotante->ID,
+			(const guint *) regola->eccezioni->data, regola->eccezioni->len);
+}
+
+/** Scrive una lezione di un corso su una sola riga.
+ * La riga contiene campo, ID, orario, durata, date di inizio e fine, giorni, settimane
+ * ed eventuali eccezioni, separati da spazi
+ */
+static void scrivi_lezione(ostream &f1, int campo, int ID, int orario, int durata, guint inizio, guint fine,
+			int giorni, int settimane, const guint *eccezioni, guint n_eccezioni)
+{
+	char *data_inizio = data_da_giorno(inizio);
+	char *data_fine = data_da_giorno(fine);
+
+	f1<<campo<<" "<<ID<<" "<<orario<<" "<<durata<<" "<<data_inizio<<" "<<data_fine<<" "
+	  <<giorni<<" "<<settimane;
+
+	for (guint i = 0; i < n_eccezioni; i++){
+		char *data = data_da_giorno(eccezioni[i]);
+		f1<<" "<<data;
+		g_free(data);
 	}
+	f1<<endl;
 
-	//Indico la fine del markup e quindi del file scritto
-	f1<<ETX<<endl;
+	g_free(data_fine);
+	g_free(data_inizio);
+}
+
+/** Scrive il corso nello stream nel formato dei file.
+ * Dopo nome, istruttore e iscritti segue una riga per ogni regola con le lezioni del corso,
+ * così qualunque modifica al corso e alle sue lezioni si salva con una sola scrittura
+ */
+static void scrivi_corso(ostream &f1, const corso_t *corso, const circolo_t *circolo)
+{
+	f1<<corso->ID<<endl;
+	f1<<corso->nome->str<<endl;
+	f1<<corso->istruttore->ID<<endl;
+	for (GList *tmp = corso->iscritti; tmp != NULL; tmp = g_list_next(tmp))
+		f1<<(tmp != corso->iscritti ? " " : "")<<((giocatore_t *) tmp->data)->ID;
+	f1<<endl;
+
+	for (guint i = 0; i < circolo->campi->len; i++){
+		const campo_t *campo = (const campo_t *) g_ptr_array_index(circolo->campi, i);
+
+		for (GList *tmp_r = campo->regole; tmp_r != NULL; tmp_r = g_list_next(tmp_r)){
+			const regola_t *regola = (const regola_t *) tmp_r->data;
+			if (regola->corso != corso)
+				continue;
 
-	f2.close();
+			scrivi_lezione(f1, campo->numero, regola->ID, regola->orario, regola->durata, regola->inizio,
+					regola->fine, regola->giorni, regola->settimane,
+					(const guint *) regola->eccezioni->data, regola->eccezioni->len);
+		}
+	}
+}
 
-	return true;
+/** Scrive il testo nel file dell'archivio in uso.
+ * In caso di errore in scrittura il file viene rimosso
+ * @param[in] pos Posizione del file
+ * @param[in] testo Contenuto del file
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool scrivi_file(const posizione_t &pos, const char testo[])
+{
+	CONTA("file_IO: file scritti")
+	TRACCIA("scrivi_file", "salvataggio", pos.nome)
+
+	return archivio()->scrivi(pos, testo, strlen(testo));
 }
 
-/** Copia la cartella nello stream.
- * Copia il contenuto della cartella compresi i file nello stream
- * @param[in,out] f1 Stream nel quale copiare la cartella
- * @param[in] cartella Cartella da copiare
+/** Elimina un file dalla sua cartella.
+ * In caso di fallimento errno indica il motivo, ENOENT se il file o la cartella non esistono
+ * @param[in] pos Posizione del file
  * @return successo (TRUE) o fallimento (FALSE)
  */
-static bool backup_dir(ofstream &f1, const char cartella[])
+static bool elimina_file(const posizione_t &pos)
 {
-	if (!f1){
-		D1(cout<<"Lo stream passato non è valido"<<endl)
+	return archivio()->elimina(pos);
+}
+
+/** Elimina gli orari propri di un campo che torna a usare quelli del circolo.
+ * Un file rimasto prevarrebbe sugli orari del circolo al caricamento successivo
+ * @return TRUE se il file non c'è più, anche se non esisteva
+ */
+static bool elimina_orari(const posizione_t &pos)
+{
+	return elimina_file(pos) || errno == ENOENT;
+}
+
+/** Dati di un lavoro in background su un file o una cartella.
+ * La posizione punta al nome del circolo copiato nel lavoro,
+ * percorso è il percorso del file o della cartella ed è la chiave del lavoro
+ */
+struct lavoro_file_t {
+	char *circolo;
+	posizione_t pos;
+	char *percorso;
+	char *testo;
+};
+
+static void libera_lavoro_file(gpointer lavoro_)
+{
+	lavoro_file_t *lavoro = (lavoro_file_t *) lavoro_;
+
+	g_free(lavoro->circolo);
+	g_free(lavoro->percorso);
+	g_free(lavoro->testo);
+	g_free(lavoro);
+}
+
+/** Crea i dati di un lavoro, prendendo possesso del testo passato.
+ */
+static lavoro_file_t *nuovo_lavoro_file(const posizione_t &pos, char *testo)
+{
+	lavoro_file_t *lavoro = g_new(lavoro_file_t, 1);
+	lavoro->circolo = g_strdup(pos.circolo);
+	lavoro->pos = pos;
+	lavoro->pos.circolo = lavoro->circolo;
+	lavoro->percorso = percorso(pos);
+	lavoro->testo = testo;
+
+	return lavoro;
+}
+
+static bool lavoro_scrivi_file(gpointer lavoro_)
+{
+	lavoro_file_t *lavoro = (lavoro_file_t *) lavoro_;
+	return scrivi_file(lavoro->pos, lavoro->testo);
+}
+
+static bool lavoro_elimina_file(gpointer lavoro_)
+{
+	lavoro_file_t *lavoro = (lavoro_file_t *) lavoro_;
+	return elimina_file(lavoro->pos);
+}
+
+static bool lavoro_elimina_directory(gpointer lavoro_)
+{
+	lavoro_file_t *lavoro = (lavoro_file_t *) lavoro_;
+
+	return archivio()->elimina_cartella(lavoro->pos);
+}
+
+/** Accoda un lavoro sul file o sulla cartella; la chiave dell'esecutore è il suo percorso.
+ */
+static void accoda_lavoro_file(const posizione_t &pos, lavoro_t lavoro, char *testo, completamento_t fine, gpointer dati)
+{
+	lavoro_file_t *lavoro_file = nuovo_lavoro_file(pos, testo);
+	accoda_lavoro(lavoro_file->percorso, lavoro, lavoro_file, libera_lavoro_file, fine, dati);
+}
+
+/** Accoda la scrittura del file.
+ */
+static void accoda_scrittura(const posizione_t &pos, const ostringstream &testo, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(pos, lavoro_scrivi_file, g_strdup(testo.str().c_str()), fine, dati);
+}
+
+/** Scrive nel file il record di un elemento del circolo nel formato dei file.
+ * @param[in] pos Posizione del file
+ * @param[in] tracciato Tracciato dell'elemento
+ * @param[in] elemento Elemento del circolo
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool scrivi_file_record(const posizione_t &pos, const tracciato_t &tracciato, gconstpointer elemento)
+{
+	GString *testo = g_string_sized_new(LUNGHEZZA_RECORD);
+	scrivi_record(testo, FORMATO_TESTO, tracciato, elemento);
+
+	bool stato = scrivi_file(pos, testo->str);
+	g_string_free(testo, TRUE);
+
+	return stato;
+}
+
+/** Accoda la scrittura nel file del record di un elemento del circolo.
+ * Il record viene composto subito, quindi l'elemento può cambiare prima della scrittura
+ */
+static void accoda_record(const posizione_t &pos, const tracciato_t &tracciato, gconstpointer elemento,
+				completamento_t fine, gpointer dati)
+{
+	GString *testo = g_string_sized_new(LUNGHEZZA_RECORD);
+	scrivi_record(testo, FORMATO_TESTO, tracciato, elemento);
+
+	accoda_lavoro_file(pos, lavoro_scrivi_file, g_string_free(testo, FALSE), fine, dati);
+}
+
+/** Dati del salvataggio in background di un campo.
+ * Il file del campo e quello dei suoi orari vengono scritti dallo stesso lavoro,
+ * così il completamento viene chiamato una sola volta;
+ * orari è il record degli orari, 0 se il campo usa quelli del circolo
+ */
+struct lavoro_campo_t {
+	lavoro_file_t *campo;
+	char *orari;
+};
+
+static void libera_lavoro_campo(gpointer lavoro_)
+{
+	lavoro_campo_t *lavoro = (lavoro_campo_t *) lavoro_;
+
+	libera_lavoro_file(lavoro->campo);
+	g_free(lavoro->orari);
+	g_free(lavoro);
+}
+
+static bool lavoro_salva_campo(gpointer lavoro_)
+{
+	lavoro_campo_t *lavoro = (lavoro_campo_t *) lavoro_;
+	posizione_t pos_orari = lavoro->campo->pos;
+	g_strlcpy(pos_orari.nome, ORARI_CAMPO, sizeof(pos_orari.nome));
+
+	bool stato = scrivi_file(lavoro->campo->pos, lavoro->campo->testo);
+
+	if (lavoro->orari != 0)
+		stato = scrivi_file(pos_orari, lavoro->orari) && stato;
+	else
+		stato = elimina_orari(pos_orari) && stato;
+
+	return stato;
+}
+
+/** Dati del backup in background.
+ */
+struct lavoro_backup_t {
+	char *file;
+	istantanea_t *ist;
+};
+
+static bool lavoro_backup(gpointer lavoro_)
+{
+	lavoro_backup_t *lavoro = (lavoro_backup_t *) lavoro_;
+	return backup_istantanea(lavoro->file, lavoro->ist);
+}
+
+static void libera_lavoro_backup(gpointer lavoro_)
+{
+	lavoro_backup_t *lavoro = (lavoro_backup_t *) lavoro_;
+
+	rilascia_istantanea(lavoro->ist);
+	g_free(lavoro->file);
+	g_free(lavoro);
+}
+
+static bool lavoro_ripristina(gpointer file)
+{
+	return ripristina( (const char *) file );
+}
+
+/** Dati della lettura in background del nome del circolo di un backup.
+ * nome appartiene al chiamante e viene letto nella funzione di completamento
+ */
+struct lavoro_nome_backup_t {
+	char *file;
+	char **nome;
+};
+
+static bool lavoro_nome_backup(gpointer lavoro_)
+{
+	lavoro_nome_backup_t *lavoro = (lavoro_nome_backup_t *) lavoro_;
+
+	*lavoro->nome = get_nome_backup(lavoro->file);
+
+	return *lavoro->nome != 0;
+}
+
+static void libera_lavoro_nome_backup(gpointer lavoro_)
+{
+	lavoro_nome_backup_t *lavoro = (lavoro_nome_backup_t *) lavoro_;
+
+	g_free(lavoro->file);
+	g_free(lavoro);
+}
+
+static bool lavoro_circolo_esistente(gpointer nome_cir)
+{
+	return circolo_esistente( (const char *) nome_cir );
+}
+
+static bool lavoro_elenca_circoli(gpointer circoli_)
+{
+	GPtrArray **circoli = (GPtrArray **) circoli_;
+
+	*circoli = elenca_circoli();
+
+	return *circoli != 0;
+}
+
+/** Dati letti dal file di un'ora.
+ * Il campo è indicato dal numero
+ */
+struct dati_ora_t {
+	int campo;
+	ist_ora_t ora;
+};
+
+/** File di un'ora ancora da leggere.
+ */
+struct file_ora_t {
+	int campo;
+	char *nome;
+};
+
+/** Dati letti dal file di una prenotazione ricorrente.
+ * Il campo e il prenotante sono indicati dal numero e dall'ID,
+ * le eccezioni vanno deallocate con g_array_free()
+ */
+struct dati_regola_t {
+	int campo;
+	int ID;
+	int orario;
+	int durata;
+	guint inizio;
+	guint fine;
+	int giorni;
+	int settimane;
+	int prenotante;
+	GArray *eccezioni;
+};
+
+const guint BLOCCO_LETTURA = 4096;	/**< Byte chiesti a ogni lettura di un file */
+
+/** Buffer di lettura dei file dei dati.
+ * Ogni thread ne ha uno, riusato da un file all'altro: il file viene letto in testo
+ * e diviso sul posto sostituendo gli a capo con terminatori, righe punta all'inizio di ogni riga.
+ * Dopo i primi file il buffer non viene più riallocato
+ */
+struct lettore_t {
+	GByteArray *testo;
+	GPtrArray *righe;
+};
+
+static void libera_lettore(gpointer lettore_)
+{
+	lettore_t *lettore = (lettore_t *) lettore_;
+
+	g_byte_array_free(lettore->testo, TRUE);
+	g_ptr_array_free(lettore->righe, TRUE);
+	g_free(lettore);
+}
+
+static GPrivate lettore_thread = G_PRIVATE_INIT(libera_lettore);	/**< Lettore di ogni thread */
+
+/** Ritorna il lettore del thread chiamante, creandolo alla prima lettura.
+ */
+static lettore_t *lettore_corrente()
+{
+	lettore_t *lettore = (lettore_t *) g_private_get(&lettore_thread);
+
+	if (lettore == 0){
+		lettore = g_new(lettore_t, 1);
+		lettore->testo = g_byte_array_sized_new(BLOCCO_LETTURA);
+		lettore->righe = g_ptr_array_new();
+		g_private_set(&lettore_thread, lettore);
+	}
+
+	return lettore;
+}
+
+/** Legge tutto il file dall'archivio in uso nel buffer, seguito da un terminatore.
+ * @param[in] pos Posizione del file
+ * @param[out] testo Buffer, il contenuto precedente viene sovrascritto
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool leggi_file(const posizione_t &pos, GByteArray *testo)
+{
+	if ( !archivio()->leggi(pos, testo) )
 		return false;
+
+	const guint8 terminatore = '\0';
+	g_byte_array_append(testo, &terminatore, 1);
+
+	return true;
+}
+
+/** Legge il file nel buffer del thread.
+ * @param[in] pos Posizione del file
+ * @param[out] lunghezza Lunghezza del testo
+ * @return Testo del file seguito da un terminatore, valido fino alla lettura successiva
+ * dello stesso thread, 0 in caso di errore
+ */
+static char *leggi_testo(const posizione_t &pos, gsize &lunghezza)
+{
+	CONTA("file_IO: file letti")
+
+	lettore_t *lettore = lettore_corrente();
+
+	if ( !leggi_file(pos, lettore->testo) ){
+		D1(cout<<"Errore apertura file"<<endl)
+		D2(cout<<"File: "<<pos.nome<<endl)
+		return 0;
 	}
 
-	GDir *dir = g_dir_open(cartella, 0, NULL);
-	const char *file = 0;
-	char *file_ = 0;
-	
-	f1<<"<cartella "<<cartella<<">"<<endl;	
+	lunghezza = lettore->testo->len - 1;
+
+	return (char *) lettore->testo->data;
+}
+
+/** Legge il file nel buffer del thread e lo divide in righe sul posto.
+ * Il testo dopo l'ultimo a capo è l'ultima riga, anche se vuoto
+ * @param[in] pos Posizione del file
+ * @param[in] min_righe Numero minimo di righe che il file deve contenere
+ * @param[out] n_righe Numero di righe lette
+ * @return Righe del file, valide fino alla lettura successiva dello stesso thread, 0 in caso di errore
+ */
+static char **leggi_righe(const posizione_t &pos, guint min_righe, guint &n_righe)
+{
+	gsize lunghezza;
+	char *riga = leggi_testo(pos, lunghezza);
+
+	if (riga == 0)
+		return 0;
+
+	char *fine = riga + lunghezza;
+	GPtrArray *righe = lettore_corrente()->righe;
+
+	g_ptr_array_set_size(righe, 0);
+	for (;;){
+		g_ptr_array_add(righe, riga);
+
+		char *a_capo = (char *) memchr(riga, '\n', fine - riga);
+		if (a_capo == 0)
+			break;
+
+		*a_capo = '\0';
+		riga = a_capo + 1;
+	}
 
-	while( (file = g_dir_read_name(dir)) ){
-		file_ = g_build_filename(cartella, file, NULL);
+	n_righe = righe->len;
 
-		if ( g_file_test(file_, G_FILE_TEST_IS_DIR) )
-			backup_dir(f1, file_);
-		if ( g_file_test(file_, G_FILE_TEST_IS_REGULAR) )
-			backup_file(f1, file_);
+	if (n_righe < min_righe){
+		D1(cout<<"File incompleto"<<endl)
+		D2(cout<<"File: "<<pos.nome<<endl)
+		return 0;
+	}
+
+	return (char **) righe->pdata;
+}
+
+/** Legge dal file un record nel formato dei file.
+ * @param[in] pos Posizione del file
+ * @param[in] tracciato Tracciato del record
+ * @param[out] copia Copia piatta letta
+ * @param[in,out] testi Se diverso da 0 il testo del file viene copiato qui prima di essere letto,
+ * altrimenti i testi della copia restano validi fino alla lettura successiva dello stesso thread
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+static bool leggi_file_record(const posizione_t &pos, const tracciato_t &tracciato, gpointer copia, GStringChunk *testi = 0)
+{
+	gsize lunghezza;
+	char *testo = leggi_testo(pos, lunghezza);
 
-		g_free(file_);
+	if (testo == 0)
+		return false;
+
+	if (testi != 0)
+		testo = g_string_chunk_insert_len(testi, testo, lunghezza);
+
+	if ( !leggi_record(testo, testo + lunghezza, FORMATO_TESTO, tracciato, copia) ){
+		D1(cout<<"File errato"<<endl)
+		D2(cout<<"File: "<<pos.nome<<endl)
+		return false;
 	}
-		
 
 	return true;
 }
 
-/** Operatore per la lettura del tipo copertura_t.
- * Utilizza un intero temporaneo e lo converte
+/** Legge il file di un campo e quello dei suoi orari.
+ * @param[in] nome_cir Nome del circolo
+ * @param[in] numero Numero del campo
+ * @param[out] campo Dati letti, orari ha passo 0 se il campo usa quelli del circolo
+ * @param[in,out] testi Testi in cui copiare le note, vedi leggi_file_record()
+ * @return successo (TRUE) o fallimento (FALSE)
  */
-static istream &operator>>(istream &is, copertura_t &c)
+static bool leggi_campo(const char *nome_cir, int numero, ist_campo_t &campo, GStringChunk *testi = 0)
 {
-	int tmp;
-	is>>tmp;
-	c = static_cast<copertura_t>(tmp);
+	posizione_t pos = posizione(nome_cir, CARTELLA_CAMPO, numero, ORARI_CAMPO);
+	TRACCIA("leggi_campo", "caricamento", nome_cir)
+
+	//gli orari vanno letti per primi, la lettura del campo riusa il buffer
+	orari_t &orari = campo.orari;
 
-	return is;
+	if ( !archivio()->esiste(pos) || !leggi_file_record(pos, TRACCIATO_ORARI, &orari) ||
+			!orari_validi(orari.apertura, orari.chiusura, orari.passo) )
+		orari.apertura = orari.chiusura = orari.passo = 0;
+
+	g_strlcpy(pos.nome, DATI_CAMPO, sizeof(pos.nome));
+
+	return leggi_file_record(pos, TRACCIATO_CAMPO, &campo, testi);
 }
 
-/** Operatore per la lettura del tipo terreno_t.
- * Utilizza un intero temporaneo e lo converte
+/** Legge il file di un'ora.
+ * @param[in] pos Posizione del file dell'ora
+ * @param[out] ora Dati letti
+ * @return successo (TRUE) o fallimento (FALSE)
  */
-static istream &operator>>(istream &is, terreno_t &t)
+static bool leggi_ora(const posizione_t &pos, dati_ora_t &ora)
 {
-	int tmp;
-	is>>tmp;
-	t = static_cast<terreno_t>(tmp);
+	TRACCIA("leggi_ora", "caricamento", pos.nome)
 
-	return is;
+	return leggi_file_record(pos, TRACCIATO_ORA, &ora.ora);
 }
 
-/** Ritorna il file del circolo.
- * @param[in] nome_cir Nome del circolo
- * @return Percorso del file
+/** Legge il file di una prenotazione ricorrente.
+ * @param[in] pos Posizione del file della regola
+ * @param[out] regola Dati letti
+ * @return successo (TRUE) o fallimento (FALSE)
  */
-static char *get_file_circolo(const char *nome_cir)
+static bool leggi_regola(const posizione_t &pos, dati_regola_t &regola)
 {
-	char *dir = get_dir_circolo(nome_cir);
-	char *file = g_build_filename(dir, DATI_CIRCOLO, NULL);
+	TRACCIA("leggi_regola", "caricamento", pos.nome)
 
-	g_free(dir);
+	guint n_righe;
+	char **righe = leggi_righe(pos, RIGHE_REGOLA, n_righe);
+
+	if ( righe == 0 || !leggi_intero(righe[0], regola.ID) || !leggi_intero(righe[1], regola.orario) ||
+			!leggi_intero(righe[2], regola.durata) || !leggi_intero(righe[5], regola.giorni) ||
+			!leggi_intero(righe[6], regola.settimane) || !leggi_intero(righe[7], regola.prenotante) ){
+		D1(cout<<"File della regola errato"<<endl)
+		return false;
+	}
+
+	regola.inizio = giorno_da_data(righe[3]);
+	regola.fine = giorno_da_data(righe[4]);
+
+	if (regola.inizio == 0 || regola.fine == 0){
+		D1(cout<<"Date della regola errate"<<endl)
+		return false;
+	}
+
+	regola.eccezioni = g_array_new(FALSE, FALSE, sizeof(guint));
+	char *cursore = righe[8];
+	for (char *data = prossimo_valore(cursore); data != 0; data = prossimo_valore(cursore)){
+		guint giorno = giorno_da_data(data);
+		if (giorno != 0)
+			g_array_append_val(regola.eccezioni, giorno);
+	}
 
-	return file;
+	return true;
 }
 
-/** Ritorna la directory dell'ora.
- * @param[in] nome_cir Nome del Circolo
- * @param[in] campo Numero del campo
- * @return Percorso della directory
+/** Crea la regola a partire dai dati letti e la aggancia al campo.
+ * @param[in] dati Dati letti da leggi_regola()
+ * @param[in] prenotante Prenotante della regola
+ * @param[in,out] campo Campo al quale agganciare la regola
+ * @return Regola creata, 0 se i dati non sono validi
  */
-static char *get_dir_ora(const char *nome_cir, int campo)
+static regola_t *crea_regola(const dati_regola_t &dati, giocatore_t *prenotante, campo_t *campo)
 {
-	ostringstream numero;
-	numero<<campo;
+	regola_t *regola = aggiungi_regola(dati.ID, dati.orario, dati.durata, dati.inizio, dati.fine,
+					dati.giorni, dati.settimane, prenotante, 0, campo);
+
+	for (guint i = 0; regola != 0 && i < dati.eccezioni->len; i++)
+		aggiungi_eccezione(regola, g_array_index(dati.eccezioni, guint, i), campo);
 
-	return g_build_filename(DATA_PATH, nome_cir, CAMPI_DIR, numero.str().c_str(), ORE_DIR, NULL);
+	return regola;
 }
 
-/** Ritorna il file dell'ora.
+static void libera_dati_regola(gpointer regola)
+{
+	g_array_free( ((dati_regola_t *) regola)->eccezioni, TRUE );
+}
+
+/** Legge le regole di un campo e le aggiunge all'array.
  * @param[in] nome_cir Nome del circolo
  * @param[in] campo Numero del campo
- * @param[in] ora Ora
- * @return Percorso al file dell'ora
+ * @param[in,out] regole Array di dati_regola_t
  */
-static char *get_file_ora(const char *nome_cir, int campo, const ora_t *ora)
+static void leggi_regole(const char *nome_cir, int campo, GArray *regole)
 {
-	D1(cout<<"get_file_ora"<<endl)
-	ostringstream file;
-	file<<ora->data->str<<"_"<<ora->orario<<FILE_EXT;
+	TRACCIA("scansione regole", "directory", nome_cir)
+
+	posizione_t pos = posizione(nome_cir, CARTELLA_REGOLE, campo, "");
+	GPtrArray *file = archivio()->elenca(pos);
+	if (file == 0)
+		return;
+
+	for (guint i = 0; i < file->len; i++){
+		g_strlcpy(pos.nome, (const char *) g_ptr_array_index(file, i), sizeof(pos.nome));
+		dati_regola_t regola;
+		regola.campo = campo;
+		if ( leggi_regola(pos, regola) )
+			g_array_append_val(regole, regola);
+	}
 
-	D2(cout<<file<<endl);
-	
-	char *dir = get_dir_ora(nome_cir, campo);
+	g_ptr_array_free(file, TRUE);
+}
 
-	char *percorso = g_build_filename(dir, file.str().c_str(), NULL);
+/** Crea il corso a partire dalle righe del suo file e lo aggancia al circolo.
+ * Le righe dopo le prime RIGHE_CORSO sono le lezioni, agganciate come regole ai loro campi;
+ * le lezioni su campi non più presenti vengono scartate. I valori delle righe vengono separati sul posto
+ * @param[in,out] righe Righe del file del corso
+ * @param[in] n_righe Numero di righe, almeno RIGHE_CORSO
+ * @param[in,out] circolo Circolo
+ * @param[in] giocatori Tabella da ID a giocatore
+ * @param[in] campi Tabella da numero a campo
+ * @return Corso creato, 0 se l'istruttore non esiste o il file non è valido
+ */
+static corso_t *crea_corso(char **righe, guint n_righe, circolo_t *circolo, GHashTable *giocatori, GHashTable *campi)
+{
+	int ID, id_istruttore;
 
-	g_free(dir);
+	if ( !leggi_intero(righe[0], ID) || !leggi_intero(righe[2], id_istruttore) ){
+		D1(cout<<"File del corso errato"<<endl)
+		return 0;
+	}
+
+	giocatore_t *istruttore = (giocatore_t *) g_hash_table_lookup(giocatori, GINT_TO_POINTER(id_istruttore));
+	corso_t *corso = aggiungi_corso(ID, righe[1], istruttore, circolo);
+
+	if (corso == 0){
+		D1(cout<<"Corso senza istruttore"<<endl)
+		return 0;
+	}
+
+	char *cursore = righe[3];
+	for (char *valore = prossimo_valore(cursore); valore != 0; valore = prossimo_valore(cursore)){
+		int id;
+		giocatore_t *iscritto = leggi_intero(valore, id) ?
+				(giocatore_t *) g_hash_table_lookup(giocatori, GINT_TO_POINTER(id)) : 0;
+		if (iscritto != 0)
+			iscrivi_corso(corso, iscritto, circolo);
+	}
+
+	for (guint i = RIGHE_CORSO; i < n_righe; i++){
+		char *valori[VALORI_LEZIONE];
+		int n_valori = 0;
+
+		cursore = righe[i];
+		while ( n_valori < VALORI_LEZIONE && (valori[n_valori] = prossimo_valore(cursore)) != 0 )
+			n_valori++;
+
+		int numero, ID_lezione, orario, durata, giorni, settimane;
+
+		if ( n_valori < VALORI_LEZIONE || !leggi_intero(valori[0], numero) || !leggi_intero(valori[1], ID_lezione) ||
+				!leggi_intero(valori[2], orario) || !leggi_intero(valori[3], durata) ||
+				!leggi_intero(valori[6], giorni) || !leggi_intero(valori[7], settimane) )
+			continue;
+
+		campo_t *campo = (campo_t *) g_hash_table_lookup(campi, GINT_TO_POINTER(numero));
+		regola_t *regola = 0;
+
+		if (campo != 0)
+			regola = aggiungi_regola(ID_lezione, orario, durata, giorno_da_data(valori[4]),
+					giorno_da_data(valori[5]), giorni, settimane, istruttore, corso, campo);
+
+		//i valori dopo i primi VALORI_LEZIONE sono le eccezioni
+		for (char *data = prossimo_valore(cursore); regola != 0 && data != 0; data = prossimo_valore(cursore))
+			aggiungi_eccezione(regola, giorno_da_data(data), campo);
+	}
 
-	return percorso;
+	return corso;
 }
 
-/** Ritorna la directory del giocatore.
- * @param[in] nome_cir Nome del circolo
- * @return Percorso della directory
+/** Carica i corsi del circolo dalla loro cartella.
+ * I campi e i giocatori devono essere già stati caricati
  */
-static char *get_dir_giocatore(const char *nome_cir)
+static void carica_corsi(circolo_t *circolo)
 {
-	return g_build_filename(DATA_PATH, nome_cir, GIOCATORI_DIR, NULL);
+	posizione_t pos = posizione(circolo->nome->str, CARTELLA_CORSI, 0, "");
+	TRACCIA("scansione corsi", "directory", pos.circolo)
+	GPtrArray *file = archivio()->elenca(pos);
+
+	if (file == 0)
+		return;
+
+	GHashTable *giocatori = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GHashTable *campi = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (guint i = 0; i < circolo->giocatori->len; i++){
+		giocatore_t *giocatore = (giocatore_t *) g_ptr_array_index(circolo->giocatori, i);
+		g_hash_table_insert(giocatori, GINT_TO_POINTER(giocatore->ID), giocatore);
+	}
+	for (guint i = 0; i < circolo->campi->len; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+		g_hash_table_insert(campi, GINT_TO_POINTER(campo->numero), campo);
+	}
+
+	for (guint i = 0; i < file->len; i++){
+		g_strlcpy(pos.nome, (const char *) g_ptr_array_index(file, i), sizeof(pos.nome));
+		guint n_righe;
+		char **righe = leggi_righe(pos, RIGHE_CORSO, n_righe);
+
+		if (righe != 0)
+			crea_corso(righe, n_righe, circolo, giocatori, campi);
+	}
+
+	g_hash_table_destroy(campi);
+	g_hash_table_destroy(giocatori);
+	g_ptr_array_free(file, TRUE);
 }
 
-/** Ritorna il file del giocatore.
- * @param[in] nome_cir Nome del circolo
- * @param[in] ID Id del giocatore
- * @return Percorso del file
+/** Crea il giocatore a partire dai dati del suo file e lo aggancia al circolo.
+ * @param[in] dati Dati letti dal file
+ * @param[in,out] circolo Circolo al quale agganciare il giocatore
+ * @return Giocatore creato, 0 in caso di errore
  */
-static char *get_file_giocatore(const char *nome_cir, int ID)
+static giocatore_t *crea_giocatore(const ist_giocatore_t &dati, circolo_t *circolo)
 {
-	ostringstream file;
-	file<<ID<<FILE_EXT;
+	giocatore_t *giocatore = aggiungi_giocatore(dati.nome, dati.cognome, dati.nascita, dati.tessera, dati.telefono,
+							dati.email, dati.classifica, dati.circolo, NULL, circolo);
+	if (giocatore == 0)
+		return 0;
 
-	char *dir = get_dir_giocatore(nome_cir);
+	//Ripristino id e socio
+	giocatore->ID = dati.ID;
+	giocatore->socio = dati.socio;
+	giocatore->retta = dati.retta;
 
-	char *percorso = g_build_filename(dir, file.str().c_str(), NULL);
+	if (giocatore->socio) 
+		circolo->n_soci++;
+
+	//i nuovi giocatori non devono riusare l'ID di un giocatore caricato
+	if (giocatore->ID > circolo->pros_id)
+		circolo->pros_id = giocatore->ID;
 
-	g_free(dir);	
+	notifica_modifica(circolo, AGGIORNAMENTO, ELEM_GIOCATORE, giocatore, circolo);
 
-	return percorso;
+	return giocatore;
 }
 
-/** Ritorna la directory del campo.
+/** Legge il file del circolo.
+ * I file dei circoli creati prima degli orari configurabili non li contengono,
+ * in quel caso gli orari restano a 0
  * @param[in] nome_cir Nome del circolo
- * @param[in] n Numero del campo
- * @return Percorso della directory
+ * @param[out] circolo Dati letti
+ * @param[in,out] testi Testi in cui copiare i dati, vedi leggi_file_record()
+ * @return successo (TRUE) o fallimento (FALSE)
  */
-static char *get_dir_campo(const char *nome_cir, int n)
+static bool leggi_circolo(const char *nome_cir, dati_circolo_t &circolo, GStringChunk *testi = 0)
 {
-	ostringstream numero;
-	numero<<n;
+	circolo.orari.apertura = circolo.orari.chiusura = circolo.orari.passo = 0;
 
-	char *percorso = g_build_filename(DATA_PATH, nome_cir, CAMPI_DIR, numero.str().c_str(), NULL);
-	return percorso;
+	return leggi_file_record(posizione(nome_cir, CARTELLA_CIRCOLO, 0, DATI_CIRCOLO), TRACCIATO_CIRCOLO, &circolo, testi);
 }
 
-/** Ritorna il file del campo.
- * @param[in] nome_cir Nome Circolo
- * @param[in] n Numero campo
- * @return Percorso del file
+/** Crea il circolo a partire dai dati del suo file.
+ * Se il file non contiene orari validi restano quelli predefiniti
+ * @param[in] dati Dati letti da leggi_circolo()
+ * @return Circolo creato
  */
-static char *get_file_campo(const char *nome_cir, int n)
+static circolo_t *crea_circolo(const dati_circolo_t &dati)
 {
-	char *dir = get_dir_campo(nome_cir, n);
+	circolo_t *circolo = inizializza_circolo(dati.nome, dati.indirizzo, dati.email, dati.telefono);
+	const orari_t &orari = dati.orari;
 
-	char *file = g_build_filename(dir, DATI_CAMPO, NULL);	
-	
-	g_free(dir);
+	if ( circolo != 0 && orari_validi(orari.apertura, orari.chiusura, orari.passo) )
+		imposta_orari_circolo(circolo, orari.apertura, orari.chiusura, orari.passo);
+
+	return circolo;
+}
+
+const int DIM_BLOCCO = 256;	/**< File letti prima di passare un blocco al main loop */
+
+/** Caricamento in background di un circolo.
+ * Le tabelle campi e giocatori servono a risolvere numeri e ID
+ * dei blocchi e sono usate solo dal main loop
+ */
+struct caricamento_t {
+	char *nome;
+	char *giorno;
+	progresso_t progresso;
+	gpointer dati;
+	volatile gint annullato;
+	circolo_t *circolo;
+	GHashTable *campi;
+	GHashTable *giocatori;
+};
+
+/** Blocco di dati letto dal thread di caricamento.
+ * Viene agganciato al circolo nel main loop da applica_blocco().
+ * I testi del circolo, dei campi, dei giocatori e dei corsi sono copiati in testi,
+ * che viene deallocato insieme al blocco
+ */
+struct blocco_caricamento_t {
+	caricamento_t *caricamento;
+	fase_caricamento_t fase;
+	double frazione;
+	GStringChunk *testi;
+	dati_circolo_t *circolo;
+	GArray *campi;
+	GArray *giocatori;
+	GArray *ore;
+	GArray *regole;
+	GPtrArray *corsi;
+};
+
+static void libera_file_ora(gpointer ora)
+{
+	g_free( ((file_ora_t *) ora)->nome );
+}
+
+static blocco_caricamento_t *nuovo_blocco(caricamento_t *car)
+{
+	blocco_caricamento_t *blocco = g_new0(blocco_caricamento_t, 1);
+	blocco->caricamento = car;
+	blocco->testi = g_string_chunk_new(BLOCCO_LETTURA);
+	blocco->campi = g_array_new(FALSE, FALSE, sizeof(ist_campo_t));
+	blocco->giocatori = g_array_new(FALSE, FALSE, sizeof(ist_giocatore_t));
+	blocco->ore = g_array_new(FALSE, FALSE, sizeof(dati_ora_t));
+	blocco->regole = g_array_new(FALSE, FALSE, sizeof(dati_regola_t));
+	g_array_set_clear_func(blocco->regole, libera_dati_regola);
+	blocco->corsi = g_ptr_array_new_with_free_func( (GDestroyNotify) g_ptr_array_unref );
+
+	return blocco;
+}
 
-	return file;
+static void libera_blocco(blocco_caricamento_t *blocco)
+{
+	g_free(blocco->circolo);
+	g_array_free(blocco->campi, TRUE);
+	g_array_free(blocco->giocatori, TRUE);
+	g_array_free(blocco->ore, TRUE);
+	g_array_free(blocco->regole, TRUE);
+	g_ptr_array_free(blocco->corsi, TRUE);
+	g_string_chunk_free(blocco->testi);
+	g_free(blocco);
+}
+
+static void libera_caricamento(caricamento_t *car)
+{
+	g_free(car->nome);
+	g_free(car->giorno);
+	g_hash_table_destroy(car->campi);
+	g_hash_table_destroy(car->giocatori);
+	g_free(car);
 }
 
-/** Elimina ricorsivamente le sottodirectory della directory passata.
- * @param[in] dir_ Directory alla quale eliminare le sotto directory
+/** Aggancia al circolo i dati letti dal thread di caricamento.
+ * Viene eseguita nel main loop; se il caricamento è stato annullato
+ * i dati vengono scartati. L'ultimo blocco dealloca il caricamento
  */
-static void elimina_sub_directory(const char *dir_)
+static gboolean applica_blocco(gpointer blocco_)
 {
-	GDir *dir = g_dir_open(dir_, 0, NULL);
-	const char *file = 0;
-	char *file_ = 0;
+	blocco_caricamento_t *blocco = (blocco_caricamento_t *) blocco_;
+	caricamento_t *car = blocco->caricamento;
+	TRACCIA("applica_blocco", "caricamento", car->nome)
+	TRACCIA_ARG("record", blocco->campi->len + blocco->giocatori->len + blocco->ore->len + blocco->regole->len +
+				blocco->corsi->len)
+
+	if ( !g_atomic_int_get(&car->annullato) ){
+
+		//il blocco di un caricamento fallito non contiene dati validi del circolo
+		if (blocco->circolo != 0 && blocco->fase != CARICAMENTO_FALLITO)
+			car->circolo = crea_circolo(*blocco->circolo);
+
+		if (car->circolo != 0){
+			for (guint i = 0; i < blocco->campi->len; i++){
+				ist_campo_t *dati = &g_array_index(blocco->campi, ist_campo_t, i);
+				campo_t *campo = aggiungi_campo(dati->numero, dati->copertura, dati->terreno, dati->note,
+								NULL, car->circolo);
+				if (dati->orari.passo != 0)
+					imposta_orari_campo(campo, dati->orari.apertura, dati->orari.chiusura, dati->orari.passo);
+				g_hash_table_insert(car->campi, GINT_TO_POINTER(campo->numero), campo);
+			}
+
+			for (guint i = 0; i < blocco->giocatori->len; i++){
+				giocatore_t *giocatore = crea_giocatore(g_array_index(blocco->giocatori, ist_giocatore_t, i),
+									car->circolo);
+				if (giocatore != 0)
+					g_hash_table_insert(car->giocatori, GINT_TO_POINTER(giocatore->ID), giocatore);
+			}
+
+			for (guint i = 0; i < blocco->ore->len; i++){
+				dati_ora_t *dati = &g_array_index(blocco->ore, dati_ora_t, i);
+				campo_t *campo = (campo_t *) g_hash_table_lookup(car->campi, GINT_TO_POINTER(dati->campo));
+				giocatore_t *prenotante = (giocatore_t *)
+					g_hash_table_lookup(car->giocatori, GINT_TO_POINTER(dati->ora.prenotante));
+
+				//ore di giocatori non più presenti
+				if (campo == 0 || prenotante == 0){
+					D1(cout<<"Ora senza campo o prenotante"<<endl)
+					continue;
+				}
+
+				aggiungi_ora(dati->ora.orario, dati->ora.data, dati->ora.durata, prenotante, campo);
+			}
+
+			for (guint i = 0; i < blocco->regole->len; i++){
+				dati_regola_t *dati = &g_array_index(blocco->regole, dati_regola_t, i);
+				campo_t *campo = (campo_t *) g_hash_table_lookup(car->campi, GINT_TO_POINTER(dati->campo));
+				giocatore_t *prenotante = (giocatore_t *)
+					g_hash_table_lookup(car->giocatori, GINT_TO_POINTER(dati->prenotante));
+
+				if (campo == 0 || prenotante == 0){
+					D1(cout<<"Regola senza campo o prenotante"<<endl)
+					continue;
+				}
 
-	while( (file = g_dir_read_name(dir)) ){
-		file_ = g_build_filename(dir_, file, NULL);
+				crea_regola(*dati, prenotante, campo);
+			}
 
-		if ( g_file_test(file_, G_FILE_TEST_IS_DIR) )
-			elimina_sub_directory(file_);
-		if ( g_file_test(file_, G_FILE_TEST_IS_REGULAR) )
-			g_remove(file_);
+			for (guint i = 0; i < blocco->corsi->len; i++){
+				GPtrArray *righe = (GPtrArray *) g_ptr_array_index(blocco->corsi, i);
+				crea_corso( (char **) righe->pdata, righe->len, car->circolo, car->giocatori, car->campi );
+			}
+		}
 
-		g_free(file_);
+		if (car->progresso != 0)
+			car->progresso(car->circolo, blocco->fase, blocco->frazione, car->dati);
 	}
 
-	g_rmdir(dir_);
-	
+	if (blocco->fase == CARICAMENTO_FINITO || blocco->fase == CARICAMENTO_FALLITO)
+		libera_caricamento(car);
+
+	libera_blocco(blocco);
+
+	return G_SOURCE_REMOVE;
+}
+
+/** Passa il blocco al main loop e ne prepara uno nuovo.
+ * La priorità è quella idle perché i blocchi non ritardino il ridisegno della finestra
+ */
+static void invia_blocco(blocco_caricamento_t *&blocco, fase_caricamento_t fase, double frazione)
+{
+	blocco->fase = fase;
+	blocco->frazione = frazione;
+	g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, applica_blocco, blocco, NULL);
+
+	blocco = nuovo_blocco(blocco->caricamento);
+}
+
+/** Copia nel blocco le righe lette.
+ * Nel buffer del lettore le righe sono consecutive, quindi vengono copiate tutte insieme
+ * @return Righe copiate
+ */
+static GPtrArray *copia_righe(blocco_caricamento_t *blocco, char **righe, guint n_righe)
+{
+	const char *ultima = righe[n_righe - 1];
+	char *copia = g_string_chunk_insert_len(blocco->testi, righe[0], ultima + strlen(ultima) - righe[0]);
+	GPtrArray *copiate = g_ptr_array_sized_new(n_righe);
+
+	for (guint i = 0; i < n_righe; i++)
+		g_ptr_array_add(copiate, copia + (righe[i] - righe[0]));
+
+	return copiate;
+}
+
+/** Legge il giocatore e lo aggiunge al blocco.
+ */
+static void leggi_giocatore(const posizione_t &pos, blocco_caricamento_t *blocco)
+{
+	TRACCIA("leggi_giocatore", "caricamento", pos.nome)
+
+	ist_giocatore_t dati;
+
+	if ( leggi_file_record(pos, TRACCIATO_GIOCATORE, &dati, blocco->testi) )
+		g_array_append_val(blocco->giocatori, dati);
+}
+
+/** Legge i campi del circolo.
+ * Le ore del giorno e le prenotazioni ricorrenti vengono lette subito e aggiunte al blocco,
+ * i file delle ore degli altri giorni vengono aggiunti allo storico
+ */
+static void leggi_campi(caricamento_t *car, blocco_caricamento_t *blocco, GArray *storico)
+{
+	char *prefisso = g_strconcat(car->giorno, "_", NULL);
+	TRACCIA("scansione campi", "directory", car->nome)
+	GPtrArray *campi = archivio()->elenca( posizione(car->nome, CARTELLA_CAMPI, 0, "") );
+
+	if (campi == 0){
+		g_free(prefisso);
+		return;
+	}
+
+	for (guint c = 0; c < campi->len; c++){
+		int numero;
+		ist_campo_t dati_campo;
+
+		if ( !leggi_intero( (const char *) g_ptr_array_index(campi, c), numero ) ||
+				!leggi_campo(car->nome, numero, dati_campo, blocco->testi) )
+			continue;
+
+		g_array_append_val(blocco->campi, dati_campo);
+
+		leggi_regole(car->nome, numero, blocco->regole);
+
+		posizione_t pos = posizione(car->nome, CARTELLA_ORE, numero, "");
+		GPtrArray *ore = archivio()->elenca(pos);
+		if (ore == 0)
+			continue;
+
+		for (guint i = 0; i < ore->len; i++){
+			const char *file_o = (const char *) g_ptr_array_index(ore, i);
+
+			if ( !g_str_has_prefix(file_o, prefisso) ){
+				file_ora_t ora = { dati_campo.numero, g_strdup(file_o) };
+				g_array_append_val(storico, ora);
+				continue;
+			}
+
+			g_strlcpy(pos.nome, file_o, sizeof(pos.nome));
+			dati_ora_t dati_ora;
+			dati_ora.campo = dati_campo.numero;
+			if ( leggi_ora(pos, dati_ora) )
+				g_array_append_val(blocco->ore, dati_ora);
+		}
+
+		g_ptr_array_free(ore, TRUE);
+	}
+
+	g_ptr_array_free(campi, TRUE);
+	g_free(prefisso);
+
+	TRACCIA_ARG("ore", blocco->ore->len + storico->len)
+}
+
+/** Lavoro che legge il circolo a blocchi.
+ * Il primo blocco contiene i dati del circolo, i campi, le ore del giorno richiesto,
+ * le prenotazioni ricorrenti e i loro prenotanti, così la tabella del giorno può essere disegnata subito;
+ * seguono a blocchi gli altri giocatori, con l'ultimo dei quali arrivano i corsi, e poi lo storico delle ore
+ */
+static bool lavoro_carica_circolo(gpointer car_)
+{
+	TEMPO("file_IO: carica_circolo_async")
+
+	caricamento_t *car = (caricamento_t *) car_;
+	TRACCIA("carica_circolo_async", "caricamento", car->nome)
+	blocco_caricamento_t *blocco = nuovo_blocco(car);
+
+	//il blocco riceve i dati solo se il file è stato letto per intero
+	dati_circolo_t dati_circolo;
+
+	if ( !leggi_circolo(car->nome, dati_circolo, blocco->testi) ){
+		invia_blocco(blocco, CARICAMENTO_FALLITO, 0);
+		libera_blocco(blocco);
+		return false;
+	}
+
+	blocco->circolo = g_new(dati_circolo_t, 1);
+	*blocco->circolo = dati_circolo;
+
+	//Campi e ore del giorno
+	GArray *storico = g_array_new(FALSE, FALSE, sizeof(file_ora_t));
+	g_array_set_clear_func(storico, libera_file_ora);
+	leggi_campi(car, blocco, storico);
+
+	//Prenotanti delle ore del giorno e delle regole
+	GHashTable *letti = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (guint i = 0; i < blocco->ore->len + blocco->regole->len; i++){
+		int id = (i < blocco->ore->len) ? g_array_index(blocco->ore, dati_ora_t, i).ora.prenotante
+				: g_array_index(blocco->regole, dati_regola_t, i - blocco->ore->len).prenotante;
+
+		if ( g_hash_table_contains(letti, GINT_TO_POINTER(id)) )
+			continue;
+
+		posizione_t pos = posizione(car->nome, CARTELLA_GIOCATORI, 0, "");
+		g_snprintf(pos.nome, sizeof(pos.nome), "%d%s", id, FILE_EXT);
+		leggi_giocatore(pos, blocco);
+		g_hash_table_add(letti, GINT_TO_POINTER(id));
+	}
+
+	//Elenco dei giocatori rimanenti
+	posizione_t pos_g = posizione(car->nome, CARTELLA_GIOCATORI, 0, "");
+	GPtrArray *giocatori = archivio()->elenca(pos_g);
+	if (giocatori == 0)
+		giocatori = g_ptr_array_new_with_free_func(g_free);
+	else {
+		TRACCIA("scansione giocatori", "directory", car->nome)
+		for (guint i = giocatori->len; i > 0; i--)
+			if ( g_hash_table_contains(letti, GINT_TO_POINTER( atoi( (char *) g_ptr_array_index(giocatori, i - 1) ) )) )
+				g_ptr_array_remove_index_fast(giocatori, i - 1);
+		TRACCIA_ARG("giocatori", giocatori->len)
+	}
+	g_hash_table_destroy(letti);
+
+	invia_blocco(blocco, CARICAMENTO_GIORNO, 0);
+
+	double totale = MAX(giocatori->len + storico->len, 1);
+	int letti_tot = 0;
+
+	for (guint i = 0; i < giocatori->len && !g_atomic_int_get(&car->annullato); i++){
+		g_strlcpy(pos_g.nome, (char *) g_ptr_array_index(giocatori, i), sizeof(pos_g.nome));
+		leggi_giocatore(pos_g, blocco);
+
+		if (++letti_tot % DIM_BLOCCO == 0)
+			invia_blocco(blocco, CARICAMENTO_GIOCATORI, letti_tot / totale);
+	}
+
+	//i corsi richiedono tutti i giocatori, quindi vanno nell'ultimo blocco dei giocatori
+	posizione_t pos_c = posizione(car->nome, CARTELLA_CORSI, 0, "");
+	GPtrArray *corsi = archivio()->elenca(pos_c);
+	for (guint i = 0; corsi != 0 && i < corsi->len; i++){
+		g_strlcpy(pos_c.nome, (char *) g_ptr_array_index(corsi, i), sizeof(pos_c.nome));
+		guint n_righe;
+		char **righe = leggi_righe(pos_c, RIGHE_CORSO, n_righe);
+		if (righe != 0)
+			g_ptr_array_add(blocco->corsi, copia_righe(blocco, righe, n_righe));
+	}
+	if (corsi != 0)
+		g_ptr_array_free(corsi, TRUE);
+
+	invia_blocco(blocco, CARICAMENTO_GIOCATORI, letti_tot / totale);
+
+	for (guint i = 0; i < storico->len && !g_atomic_int_get(&car->annullato); i++){
+		file_ora_t *file = &g_array_index(storico, file_ora_t, i);
+		posizione_t pos = posizione(car->nome, CARTELLA_ORE, file->campo, file->nome);
+		dati_ora_t dati_ora;
+		dati_ora.campo = file->campo;
+
+		if ( leggi_ora(pos, dati_ora) )
+			g_array_append_val(blocco->ore, dati_ora);
+
+		if (++letti_tot % DIM_BLOCCO == 0)
+			invia_blocco(blocco, CARICAMENTO_STORICO, letti_tot / totale);
+	}
+
+	TRACCIA_ARG("file", letti_tot)
+
+	g_ptr_array_free(giocatori, TRUE);
+	g_array_free(storico, TRUE);
+
+	invia_blocco(blocco, CARICAMENTO_FINITO, 1);
+	libera_blocco(blocco);
+
+	return true;
 }
 
 /* Fine definizioni private */
@@ -323,446 +1508,348 @@ char *get_dir_circolo(const char *nome_cir)
 
 bool salva_circolo(const circolo_t *circolo)
 {
-	char *file = get_file_circolo(circolo->nome->str);
-	char *dir = get_dir_circolo(circolo->nome->str);
-
 	if (circolo == 0) return false;
 
-	//Controllo esistenza cartella del circolo, se non esiste la crea
-	if ( !controlla_directory(dir) ) return false;
-
-	//Apertura file per la scrittura
-	ofstream f1(file);
-
-	g_free(dir);
-
-	if(!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		D2(cout<<"File: "<<file<<endl)
-		g_free(file);
-		return false;
-	}
-
-	
-
-	//Scrittura file
-	f1<<circolo->nome->str<<endl;
-	f1<<circolo->indirizzo->str<<endl;
-	f1<<circolo->email->str<<endl;
-	f1<<circolo->telefono->str<<endl;
+	TRACCIA("salva_circolo", "salvataggio", circolo->nome->str)
 
-	if(!f1){
-		D1(cout<<"Errore in scrittura"<<endl)
-		f1.close();
-		g_remove(file);
-		g_free(file);
-		return false;
-	}
+	return scrivi_file_record(posizione(circolo->nome->str, CARTELLA_CIRCOLO, 0, DATI_CIRCOLO), TRACCIATO_CIRCOLO, circolo);
+}
 
-	f1.close();
-	g_free(file);
+void salva_circolo_async(const circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	TRACCIA("salva_circolo_async", "salvataggio", circolo->nome->str)
 
-	return true;
+	accoda_record(posizione(circolo->nome->str, CARTELLA_CIRCOLO, 0, DATI_CIRCOLO), TRACCIATO_CIRCOLO, circolo, fine, dati);
 }
 
 circolo_t *carica_circolo(const char nome[])
 {
-	//Caricamento dati Circolo
-	circolo_t *circolo = 0;
-	char *testo = 0;
-	char **campi_c = 0;
-	int size = 0;
-	char *file_c = get_file_circolo(nome);
-	
-	ifstream f1(file_c);
-	if (!f1){
-		D1(cout<<"Errore apertura file"<<endl)
-		D2(cout<<"File: "<<file_c<<endl)
-		return 0;
-	}
-
-	//Lunghezza file
-	f1.seekg(0, f1.end);
-	size = f1.tellg();
-	f1.seekg(0, f1.beg);
+	TEMPO("file_IO: carica_circolo")
+	TRACCIA("carica_circolo", "caricamento", nome)
 
-	//Creazione buffer
-	testo = new char[size+1];
-	
-	//Recupero informazioni
-	f1.getline(testo, size, EOF);
-	campi_c = g_strsplit(testo, "\n", 0);
+	//Caricamento dati Circolo
+	dati_circolo_t dati_circolo;
 
-	//Chiusura file
-	f1.close();
+	if ( !leggi_circolo(nome, dati_circolo) )
+		return 0;
 
 	//Creazione circolo
-	circolo = inizializza_circolo(campi_c[0], campi_c[1], campi_c[2], campi_c[3]);
-
-	//Deallocazione memoria utilizzata
-	g_strfreev(campi_c);
-	g_free(file_c);
-	delete[] testo;
-
+	circolo_t *circolo = crea_circolo(dati_circolo);
 
 	//Caricamento giocatori del circolo
-	const char *file_g = 0;
-	char *n_dir_g = get_dir_giocatore(nome);
-	GDir *dir_g = g_dir_open(n_dir_g, 0, NULL);
+	GPtrArray *file = archivio()->elenca( posizione(nome, CARTELLA_GIOCATORI, 0, "") );
 
-	if (dir_g != NULL){
+	if (file != 0){
+		TRACCIA("scansione giocatori", "directory", nome)
 
-		while( (file_g = g_dir_read_name(dir_g)) ){
-			if ( file_nascosto(file_g) )
-				continue;
-			
-			char *giocatore = g_build_filename(n_dir_g, file_g, NULL);
-	
-			carica_giocatore(giocatore, circolo);
+		for (guint i = 0; i < file->len; i++){
+			carica_giocatore( (const char *) g_ptr_array_index(file, i), circolo );
 
 			D1(cout<<"Giocatore caricato"<<endl)
-			D2(cout<<giocatore<<endl)
-
-			g_free(giocatore);
+			D2(cout<<(const char *) g_ptr_array_index(file, i)<<endl)
 		}
-	
-		g_dir_close(dir_g);
+
+		g_ptr_array_free(file, TRUE);
+		TRACCIA_ARG("giocatori", circolo->giocatori->len)
 	}
 
-	g_free(n_dir_g);
+	//Caricamento campi del circolo
+	GPtrArray *campi = archivio()->elenca( posizione(nome, CARTELLA_CAMPI, 0, "") );
 
+	if (campi != 0){
+		TRACCIA("scansione campi", "directory", nome)
 
-	//Caricamento campi del circolo
-	const char *file = 0;
-	campo_t *campo_caricato = 0;	
-	char *ora = 0;
-	char *dati = 0;
-	char *campo = 0;
-	char *campi = g_build_filename(DATA_PATH, nome, CAMPI_DIR, NULL);
-	GDir *dir = g_dir_open(campi, 0, NULL);
-	
-	if (dir != NULL){
+		for (guint c = 0; c < campi->len; c++){
+			int numero;
 
-		while( (file = g_dir_read_name(dir)) ){
-			if ( file_nascosto(file) )
-				continue;
-	
-			campo = g_build_filename(campi, file, NULL);
-	
-			if ( !g_file_test(campo, G_FILE_TEST_IS_DIR) ){
-				g_free(campo);
+			if ( !leggi_intero( (const char *) g_ptr_array_index(campi, c), numero ) )
 				continue;
-			}
-	
-			dati = g_build_filename(campo, DATI_CAMPO, NULL);
-	
-			campo_caricato = carica_campo(dati, circolo);
+
+			campo_t *campo_caricato = carica_campo(numero, circolo);
 
 			D1(cout<<"Campo caricato"<<endl)
-			D2(cout<<dati<<endl)
-	
-			g_free(dati);
-	
-			dati = g_build_filename(campo, ORE_DIR, NULL); 
+			D2(cout<<numero<<endl)
 
-			g_free(campo);
+			if (campo_caricato == 0)
+				continue;
 
-			GDir *dir_ore = g_dir_open(dati, 0, NULL);
-	
-			if (dir_ore == NULL){
-				g_free(dati);
+			file = archivio()->elenca( posizione(nome, CARTELLA_REGOLE, numero, "") );
+
+			for (guint i = 0; file != 0 && i < file->len; i++)
+				carica_regola( (const char *) g_ptr_array_index(file, i), campo_caricato, circolo );
+
+			if (file != 0)
+				g_ptr_array_free(file, TRUE);
+
+			file = archivio()->elenca( posizione(nome, CARTELLA_ORE, numero, "") );
+
+			if (file == 0)
 				continue;
-			}
-			
-			while( (file = g_dir_read_name(dir_ore)) ){
-				if ( file_nascosto(file) )
-					continue;
-	
-				ora = g_build_filename(dati, file, NULL);
-				
-				carica_ora(ora, campo_caricato, circolo);
+
+			for (guint i = 0; i < file->len; i++){
+				carica_ora( (const char *) g_ptr_array_index(file, i), campo_caricato, circolo );
 
 				D1(cout<<"Ora caricata"<<endl)
-				D2(cout<<ora<<endl)
-		
-				g_free(ora);
+				D2(cout<<(const char *) g_ptr_array_index(file, i)<<endl)
 			}
-	
-			g_dir_close(dir_ore);
-			g_free(dati);
-	
+
+			g_ptr_array_free(file, TRUE);
 		}
-	
-		g_dir_close(dir);
 
-	} // if (dir != NULL)
+		g_ptr_array_free(campi, TRUE);
+		TRACCIA_ARG("campi", circolo->campi->len)
+	}
 
-	g_free(campi);
+	carica_corsi(circolo);
 
 	return circolo;
 }
 
+caricamento_t *carica_circolo_async(const char nome[], const char giorno[], progresso_t progresso, gpointer dati)
+{
+	caricamento_t *car = g_new0(caricamento_t, 1);
+	car->nome = g_strdup(nome);
+	car->giorno = g_strdup(giorno);
+	car->progresso = progresso;
+	car->dati = dati;
+	car->campi = g_hash_table_new(g_direct_hash, g_direct_equal);
+	car->giocatori = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	//la chiave della cartella fa attendere le scritture in corso sul circolo
+	char *dir = get_dir_circolo(nome);
+	accoda_lavoro(dir, lavoro_carica_circolo, car, NULL, NULL, NULL);
+	g_free(dir);
+
+	return car;
+}
+
+void annulla_caricamento(caricamento_t *caricamento)
+{
+	g_atomic_int_set(&caricamento->annullato, 1);
+}
+
 bool salva_giocatore(const giocatore_t *giocatore, const circolo_t *circolo)
 {
-	char *dir = get_dir_giocatore(circolo->nome->str);
-	char *file = get_file_giocatore(circolo->nome->str, giocatore->ID);
-	
 	if (giocatore == 0) return false;
 	if (circolo == 0) return false;
 
-	if ( !controlla_directory(dir) ) return false;
+	posizione_t pos = posizione_giocatore(circolo->nome->str, giocatore->ID);
+	TRACCIA("salva_giocatore", "salvataggio", pos.nome)
 
-	g_free(dir);
+	return scrivi_file_record(pos, TRACCIATO_GIOCATORE, giocatore);
+}
 
-	ofstream f1(file);
+void salva_giocatore_async(const giocatore_t *giocatore, const circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	TRACCIA("salva_giocatore_async", "salvataggio", circolo->nome->str)
 
-	if (!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		D2(cout<<"File: "<<file<<endl)		
-		g_free(file);		
-		return false;
-	}
+	accoda_record(posizione_giocatore(circolo->nome->str, giocatore->ID), TRACCIATO_GIOCATORE, giocatore, fine, dati);
+}
 
-	//Scrittura file
-	f1<<giocatore->ID<<endl;
-	f1<<giocatore->nome->str<<endl;
-	f1<<giocatore->cognome->str<<endl;
-	f1<<giocatore->nascita->str<<endl;
-	f1<<giocatore->tessera->str<<endl;
-	f1<<giocatore->telefono->str<<endl;
-	f1<<giocatore->email->str<<endl;
-	f1<<giocatore->classifica->str<<endl;
-	f1<<giocatore->circolo->str<<endl;
-	f1<<giocatore->socio<<endl;
-	f1<<giocatore->retta<<endl;
+giocatore_t *carica_giocatore(const char nome[], circolo_t *circolo)
+{
+	TRACCIA("carica_giocatore", "caricamento", nome)
 
-	if (!f1){
-		D1(cout<<"Errore in scrittura"<<endl)
-		f1.close();
-		g_remove(file);
-		g_free(file);
-		return false;		
-	}
+	ist_giocatore_t dati;
 
-	f1.close();
-	g_free(file);
+	if ( !leggi_file_record(posizione(circolo->nome->str, CARTELLA_GIOCATORI, 0, nome), TRACCIATO_GIOCATORE, &dati) )
+		return 0;
 
-	return true;	
+	return crea_giocatore(dati, circolo);
 }
 
-giocatore_t *carica_giocatore(const char file[], circolo_t *circolo)
+bool salva_campo(const campo_t *campo, const circolo_t *circolo)
 {
-	giocatore_t *giocatore = 0;
-	char *testo = 0;
-	char **campi = 0;
-	int size = 0;
+	if (campo == 0) return false;
+	if (circolo == 0) return false;
 
-	ifstream f1(file);
-	if (!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		return 0;
-	}
+	posizione_t pos = posizione(circolo->nome->str, CARTELLA_CAMPO, campo->numero, DATI_CAMPO);
+	TRACCIA("salva_campo", "salvataggio", pos.nome)
 
-	//Lunghezza file
-	f1.seekg(0, f1.end);
-	size = f1.tellg();
-	f1.seekg(0, f1.beg);
+	bool stato = scrivi_file_record(pos, TRACCIATO_CAMPO, campo);
 
-	//Creazione buffer
-	testo = new char[size+1];
-	
-	//Recupero informazioni
-	f1.getline(testo, size, EOF);
-	campi = g_strsplit(testo, "\n", 0);
+	posizione_t pos_orari = posizione(circolo->nome->str, CARTELLA_CAMPO, campo->numero, ORARI_CAMPO);
 
-	//Chiusura file
-	f1.close();
+	if (campo->orari.passo != 0)
+		stato = scrivi_file_record(pos_orari, TRACCIATO_ORARI, &campo->orari) && stato;
+	else
+		stato = elimina_orari(pos_orari) && stato;
 
-	//Creazione circolo
-	giocatore = aggiungi_giocatore(campi[1], campi[2], campi[3], campi[4], campi[5], campi[6], campi[7], campi[8], NULL, circolo);
+	return stato;	
+}
 
-	//Ripristino id e socio
-	giocatore->ID = atoi(campi[0]);
-	giocatore->socio = atoi(campi[9]);
-	giocatore->retta = atoi(campi[10]);
+void salva_campo_async(const campo_t *campo, const circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	TRACCIA("salva_campo_async", "salvataggio", circolo->nome->str)
 
-	if (giocatore->socio) 
-		circolo->n_soci++;
+	GString *testo = g_string_sized_new(LUNGHEZZA_RECORD);
+	scrivi_record(testo, FORMATO_TESTO, TRACCIATO_CAMPO, campo);
 
-	//Deallocazione memoria utilizzata
-	g_strfreev(campi);
-	delete[] testo;
+	lavoro_campo_t *lavoro = g_new(lavoro_campo_t, 1);
+	lavoro->campo = nuovo_lavoro_file(posizione(circolo->nome->str, CARTELLA_CAMPO, campo->numero, DATI_CAMPO),
+					g_string_free(testo, FALSE));
+	lavoro->orari = 0;
 
-	return giocatore;
+	//senza orari propri il campo usa quelli del circolo e il loro file viene eliminato
+	if (campo->orari.passo != 0){
+		testo = g_string_sized_new(LUNGHEZZA_RECORD);
+		scrivi_record(testo, FORMATO_TESTO, TRACCIATO_ORARI, &campo->orari);
+		lavoro->orari = g_string_free(testo, FALSE);
+	}
+
+	accoda_lavoro(lavoro->campo->percorso, lavoro_salva_campo, lavoro, libera_lavoro_campo, fine, dati);
 }
 
-bool salva_campo(const campo_t *campo, const circolo_t *circolo)
+campo_t *carica_campo(int numero, circolo_t *circolo)
 {
-	char *dir = get_dir_campo(circolo->nome->str, campo->numero);
-	char *file = get_file_campo(circolo->nome->str, campo->numero);
+	TRACCIA("carica_campo", "caricamento", circolo->nome->str)
 
-	if (campo == 0) return false;
-	if (circolo == 0) return false;
+	ist_campo_t dati;
 
-	if ( !controlla_directory(dir) ) return false;
+	if ( !leggi_campo(circolo->nome->str, numero, dati) )
+		return 0;
 
-	g_free(dir);
+	campo_t *campo = aggiungi_campo(dati.numero, dati.copertura, dati.terreno, dati.note, NULL, circolo);
 
-	ofstream f1(file);
+	if (campo != 0 && dati.orari.passo != 0)
+		imposta_orari_campo(campo, dati.orari.apertura, dati.orari.chiusura, dati.orari.passo);
 
-	if (!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		D2(cout<<"File: "<<file<<endl)		
-		g_free(file);		
-		return false;
-	}
+	return campo;
+}
 
-	//Scrittura file
-	f1<<campo->numero<<endl;
-	f1<<campo->copertura<<endl;
-	f1<<campo->terreno<<endl;
-	f1<<campo->note->str<<endl;
+bool salva_ora(const ora_t *ora, const campo_t *campo, const circolo_t *circolo)
+{
+	if (ora == 0) return false;
+	if (campo == 0) return false;
 
-	if (!f1){
-		D1(cout<<"Errore in scrittura"<<endl)
-		f1.close();
-		g_remove(file);
-		g_free(file);
-		return false;		
-	}
+	posizione_t pos = posizione_ora(circolo->nome->str, campo->numero, ora);
+	TRACCIA("salva_ora", "salvataggio", pos.nome)
+
+	return scrivi_file_record(pos, TRACCIATO_ORA, ora);
+}
 
-	f1.close();
-	g_free(file);
+void salva_ora_async(const ora_t *ora, const campo_t *campo, const circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	TRACCIA("salva_ora_async", "salvataggio", circolo->nome->str)
 
-	return true;	
+	accoda_record(posizione_ora(circolo->nome->str, campo->numero, ora), TRACCIATO_ORA, ora, fine, dati);
 }
 
-campo_t *carica_campo(const char file[], circolo_t *circolo)
+ora_t *carica_ora(const char nome[], campo_t *campo, circolo_t *circolo)
 {
-	campo_t *campo = 0;
-	int numero;
-	terreno_t terreno;
-	copertura_t copertura;
-	char *note = 0;
+	D1(cout<<"Carica ora"<<endl)
+	TRACCIA("carica_ora", "caricamento", nome)
 
-	ifstream f1(file);
-	if (!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
+	dati_ora_t dati;
+
+	if ( !leggi_ora(posizione(circolo->nome->str, CARTELLA_ORE, campo->numero, nome), dati) )
 		return 0;
-	}
 
-	f1>>numero;
-	f1>>copertura;
-	f1>>terreno;
+	giocatore_t *prenotante = primo_giocatore(circolo, giocatore_con_id(dati.ora.prenotante));
 
-	//Lunghezza file
-	f1.ignore();
-	int pos = f1.tellg();
-	f1.seekg(0, f1.end);
-	int size = f1.tellg();
-	f1.seekg(pos, f1.beg);
-	
-	note = new char[size-pos+1];	
-	
-	//Recupero informazioni
-	f1.getline(note, size-pos, EOF);
+	//il prenotante potrebbe essere stato eliminato
+	if (prenotante == 0)
+		return 0;
+
+	return aggiungi_ora(dati.ora.orario, dati.ora.data, dati.ora.durata, prenotante, campo);
+}
+
+regola_t *carica_regola(const char nome[], campo_t *campo, circolo_t *circolo)
+{
+	TRACCIA("carica_regola", "caricamento", nome)
 
-	//Chiusura file
-	f1.close();
+	dati_regola_t dati;
 
-	//Creazione circolo
-	campo = aggiungi_campo(numero, copertura, terreno, note, NULL, circolo);
+	if ( !leggi_regola(posizione(circolo->nome->str, CARTELLA_REGOLE, campo->numero, nome), dati) )
+		return 0;
 
-	//Deallocazione memoria utilizzata
-	delete[] note;
+	giocatore_t *prenotante = primo_giocatore(circolo, giocatore_con_id(dati.prenotante));
+	regola_t *regola = 0;
 
-	return campo;
+	//il prenotante potrebbe essere stato eliminato
+	if (prenotante != 0)
+		regola = crea_regola(dati, prenotante, campo);
+	g_array_free(dati.eccezioni, TRUE);
+
+	return regola;
 }
 
-bool salva_ora(const ora_t *ora, const campo_t *campo, const circolo_t *circolo)
+bool salva_regola(const regola_t *regola, const campo_t *campo, const circolo_t *circolo)
 {
-	int prenotante;
-	char *dir = get_dir_ora(circolo->nome->str, campo->numero);
-	char *file = get_file_ora(circolo->nome->str, campo->numero, ora);
-	
-	if (ora == 0) return false;
+	if (regola == 0) return false;
 	if (campo == 0) return false;
 
-	if ( !controlla_directory(dir) ) return false;
+	posizione_t pos = posizione_regola(circolo->nome->str, campo->numero, regola);
+	TRACCIA("salva_regola", "salvataggio", pos.nome)
 
-	prenotante = ora->prenotante->ID;
+	ostringstream testo;
+	scrivi_regola(testo, regola);
 
-	ofstream f1(file);
+	return scrivi_file(pos, testo.str().c_str());
+}
 
-	g_free(dir);
+void salva_regola_async(const regola_t *regola, const campo_t *campo, const circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	TRACCIA("salva_regola_async", "salvataggio", circolo->nome->str)
 
-	if (!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		D2(cout<<"File: "<<file<<endl)		
-		g_free(file);		
-		return false;
-	}
+	ostringstream testo;
+	scrivi_regola(testo, regola);
 
-	//Scrittura file
-	f1<<ora->orario<<endl;
-	f1<<ora->data->str<<endl;
-	f1<<ora->durata<<endl;
-	f1<<prenotante<<endl;
+	accoda_scrittura(posizione_regola(circolo->nome->str, campo->numero, regola), testo, fine, dati);
+}
 
-	if (!f1){
-		D1(cout<<"Errore in scrittura"<<endl)
-		f1.close();
-		g_remove(file);
-		g_free(file);
-		return false;		
-	}
+bool salva_corso(const corso_t *corso, const circolo_t *circolo)
+{
+	if (corso == 0) return false;
+
+	posizione_t pos = posizione_corso(circolo->nome->str, corso);
+	TRACCIA("salva_corso", "salvataggio", pos.nome)
 
-	f1.close();
-	g_free(file);
+	ostringstream testo;
+	scrivi_corso(testo, corso, circolo);
 
-	return true;	
+	return scrivi_file(pos, testo.str().c_str());
 }
 
-ora_t *carica_ora(char file[], campo_t *campo, circolo_t *circolo)
+void salva_corso_async(const corso_t *corso, const circolo_t *circolo, completamento_t fine, gpointer dati)
 {
-	D1(cout<<"Carica ora"<<endl)
+	TRACCIA("salva_corso_async", "salvataggio", circolo->nome->str)
 
-	ora_t *ora;
-	char data[11];
-	int orario, durata, id;
-	giocatore_t *prenotante;
+	ostringstream testo;
+	scrivi_corso(testo, corso, circolo);
 
-	ifstream f1(file);
-	if (!f1){
-		D1(cout<<"Errore nell'apertura del file"<<endl)
-		return 0;
-	}
+	accoda_scrittura(posizione_corso(circolo->nome->str, corso), testo, fine, dati);
+}
 
-	f1>>orario;
-	f1>>data;
-	f1>>durata;
-	f1>>id;
+bool backup(const char file[], circolo_t *circolo)
+{
+	if (circolo == 0)
+		return false;
 
-	GList *list = 0;
-	list = cerca_lista_int(circolo->giocatori, ID, id, giocatore_t);
-	prenotante = (giocatore_t *) list->data;
-	g_list_free(list);
+	istantanea_t *ist = crea_istantanea(circolo);
+	bool stato = backup_istantanea(file, ist);
+	rilascia_istantanea(ist);
 
-	//Chiusura file
-	f1.close();
+	return stato;
+}
 
-	//Creazione circolo
-	ora = aggiungi_ora(orario, data, durata, prenotante, campo);
+void backup_async(const char file[], circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	lavoro_backup_t *lavoro = g_new(lavoro_backup_t, 1);
+	lavoro->file = g_strdup(file);
+	lavoro->ist = crea_istantanea(circolo);
 
-	return ora;
+	accoda_lavoro(file, lavoro_backup, lavoro, libera_lavoro_backup, fine, dati);
 }
 
-bool backup(const char file[], circolo_t *circolo)
+bool backup_istantanea(const char file[], const istantanea_t *ist)
 {
-	if (circolo == 0)
+	TEMPO("file_IO: backup")
+	TRACCIA("backup", "salvataggio", file)
+
+	if (ist == 0)
 		return false;
 
-	bool stato;
 	ofstream fout(file);
 	if (!fout){
 		D1(cout<<"Errore nella creazione del file"<<endl)
@@ -770,90 +1857,139 @@ bool backup(const char file[], circolo_t *circolo)
 		return false;
 	}
 
-	char *cartella = g_build_filename(DATA_PATH, circolo->nome->str, NULL);
+	const char *nome_cir = ist_nome_circolo(ist);
+	dati_circolo_t dati_circolo;
+	dati_circolo.nome = nome_cir;
+	dati_circolo.orari = *ist_orari_circolo(ist);
+	ist_dati_circolo(ist, &dati_circolo.indirizzo, &dati_circolo.email, &dati_circolo.telefono);
 
-	fout<<"<ACE BACKUP circolo="<<circolo->nome->str<<">"<<endl;
-	
-	stato = backup_dir(fout, cartella);
+	string dir = string(DATA_PATH) + "/" + nome_cir;
+	string dir_giocatori = dir + "/" + GIOCATORI_DIR;
+	string dir_campi = dir + "/" + CAMPI_DIR;
+	string file_circolo = dir + "/" + DATI_CIRCOLO;
+
+	fout<<"<ACE BACKUP circolo="<<nome_cir<<">"<<endl;
+
+	backup_cartella(fout, dir.c_str());
+	backup_file(fout, file_circolo.c_str());
+	backup_record(fout, TRACCIATO_CIRCOLO, &dati_circolo);
+	fine_backup_file(fout);
+
+	dati_backup_t dati = { &fout, nome_cir };
 
-	g_free(cartella);
+	backup_cartella(fout, dir_giocatori.c_str());
+	ist_foreach_giocatore(ist, backup_giocatore, &dati);
+
+	backup_cartella(fout, dir_campi.c_str());
+	ist_foreach_campo(ist, backup_campo, &dati);
+
+	string dir_corsi = dir + "/" + CORSI_DIR;
+	dati_backup_corsi_t dati_corsi = { &fout, dir_corsi.c_str(), ist };
+	backup_cartella(fout, dir_corsi.c_str());
+	ist_foreach_corso(ist, backup_corso, &dati_corsi);
+
+	bool stato = fout.good();
 	fout.close();
 
+	if (!stato){
+		D1(cout<<"Errore in scrittura"<<endl)
+		g_remove(file);
+	}
+
 	return stato;
-	
 }
 
 bool ripristina(const char file[])
 {
-	ifstream f1(file);
-	if (!f1){
+	TEMPO("file_IO: ripristina")
+	TRACCIA("ripristina", "salvataggio", file)
+
+	char *testo = 0;
+	gsize lunghezza = 0;
+
+	if ( !g_file_get_contents(file, &testo, &lunghezza, NULL) ){
 		D1(cout<<"Errore nell'apertura del file"<<endl)
 		D2(cout<<"File: "<<file<<endl)
 		return false;
 	}
 
 	//salto la prima riga del file (contiene intestazione)
-	char c;
-	f1>>noskipws;
-	while( (f1>>c) && (c != '\n') )
-		; 
-	
-	char markup[10];
-	char *file_n = 0;
-	int inizio, fine;
-	ofstream fout;
-	
-	while( f1.peek() != EOF ){
-		f1.getline(markup, 10, ' ');
-	
-		inizio = f1.tellg();
-		while ( (f1>>c) && (c != '>') )
-			;
-		fine = f1.tellg();
-		f1.seekg(inizio, f1.beg);
-		file_n = new char[fine-inizio];
-		f1.get(file_n, fine-inizio);
-		file_n[fine-inizio-1] = '\0';
-	
+	const char *fine = testo + lunghezza;
+	const char *cursore = (const char *) memchr(testo, '\n', lunghezza);
+	cursore = (cursore != 0) ? cursore + 1 : fine;
+
+	GString *circolo = g_string_new(NULL);
+	bool stato = true;
+
+	while (stato && cursore < fine){
+		//ogni voce è "<file percorso>" o "<cartella percorso>" su una riga
+		const char *chiusura = (const char *) memchr(cursore, '>', fine - cursore);
+		const char *spazio = (const char *) memchr(cursore, ' ', fine - cursore);
+
+		if (chiusura == 0 || spazio == 0 || spazio > chiusura){
+			D1(cout<<"file corrotto"<<endl)
+			D2(cout<<"file: "<<file<<endl)
+			stato = false;
+			break;
+		}
+
+		string markup(cursore, spazio - cursore);
+		string file_n(spazio + 1, chiusura - spazio - 1);
+		cursore = chiusura + 1;
+
 		D1(cout<<"markup: "<<markup<<endl)
-		
-		//controllo markup (può essere o "<file" o "<cartella")
-		if ( g_strcmp0(markup, "<file") == 0 ){
-			fout.open(file_n);
-			if (!fout){
-				D1(cout<<"Impossibile scrivere il file"<<endl)
-				D2(cout<<"file: "<<file_n<<endl)
-				return false;
-			}
-			f1.ignore(); //ignoro il carattere >
-			f1.ignore(); //ignoro il carattere \n
-			
-			while ( (f1>>c) && (c != ETX) )
-				fout<<c;
-			
-			fout.close();
-		} 
-		else if ( g_strcmp0(markup, "<cartella") == 0){
-			if ( !controlla_directory(file_n) ){
-				D1(cout<<"impossibile creare la cartella"<<endl)
-				D2(cout<<"cartella: "<<file_n<<endl);
-				return false;
-			}
-			f1.ignore(); //ignoro il carattere >
+
+		//le cartelle vengono create dall'archivio insieme ai loro file
+		if (markup == "<cartella"){
+			cursore++; //ignoro il carattere \n alla fine della riga
+			continue;
 		}
-		else {
+
+		posizione_t pos;
+		const char *contenuto = cursore + 1; //ignoro il carattere \n dopo >
+		const char *etx = (contenuto <= fine) ? (const char *) memchr(contenuto, ETX, fine - contenuto) : 0;
+
+		if ( markup != "<file" || etx == 0 || !posizione_backup(file_n.c_str(), pos, circolo) ){
 			D1(cout<<"file corrotto"<<endl)
 			D2(cout<<"file: "<<file<<endl)
-			return false;
+			stato = false;
+			break;
 		}
-		
-		f1.ignore(); //ignore il carattere \n alla fine della riga
-		delete[] file_n;
+
+		if ( !archivio()->scrivi(pos, contenuto, etx - contenuto) ){
+			D1(cout<<"Impossibile scrivere il file"<<endl)
+			D2(cout<<"file: "<<file_n<<endl)
+			stato = false;
+			break;
+		}
+
+		cursore = MIN(etx + 2, fine); //ignoro ETX e il carattere \n alla fine della riga
 	}
-	
-	f1.close();
-	
-	return true;	
+
+	g_string_free(circolo, TRUE);
+	g_free(testo);
+
+	return stato;
+}
+
+void get_nome_backup_async(const char file[], char **nome_cir, completamento_t fine, gpointer dati)
+{
+	lavoro_nome_backup_t *lavoro = g_new(lavoro_nome_backup_t, 1);
+	lavoro->file = g_strdup(file);
+	lavoro->nome = nome_cir;
+	*nome_cir = 0;
+
+	accoda_lavoro(file, lavoro_nome_backup, lavoro, libera_lavoro_nome_backup, fine, dati);
+}
+
+void ripristina_async(const char file[], const char *nome_cir, completamento_t fine, gpointer dati)
+{
+	//la chiave è la directory del circolo: il ripristino attende le operazioni sui suoi file
+	char *dir = get_dir_circolo(nome_cir);
+
+	accoda_lavoro(dir, lavoro_ripristina, g_strdup(file), g_free, fine, dati);
+
+	g_free(dir);
 }
 
 char *get_nome_backup(const char file[])
@@ -888,7 +2024,7 @@ char *get_nome_backup(const char file[])
 		return 0;
 	}
 
-	char *nome = new char[fine-inizio+1];
+	char *nome = g_new(char, fine-inizio+1);
 
 	f1.seekg(inizio, f1.beg);
 	for (int i = 0; i<(fine-inizio); i++)
@@ -904,72 +2040,96 @@ bool elimina_file_giocatore(giocatore_t *giocatore, circolo_t *circolo)
 {
 	D1(cout<<"Elimina file giocatore"<<endl);
 
-	int res;
-	char *file = get_file_giocatore(circolo->nome->str, giocatore->ID);
-	
-	res = g_remove(file);
-
-	g_free(file);
-
-	if (res == -1)
-		return false;
+	return elimina_file( posizione_giocatore(circolo->nome->str, giocatore->ID) );
+}
 
-	return true;
+void elimina_file_giocatore_async(giocatore_t *giocatore, circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(posizione_giocatore(circolo->nome->str, giocatore->ID), lavoro_elimina_file, 0, fine, dati);
 }
 
 void elimina_file_campo(campo_t *campo, circolo_t *circolo)
 {
-	char *file = get_dir_campo(circolo->nome->str, campo->numero);
-	
-	elimina_sub_directory(file);
-	g_rmdir(file);
+	archivio()->elimina_cartella( posizione(circolo->nome->str, CARTELLA_CAMPO, campo->numero, "") );
+}
 
-	g_free(file);
+void elimina_file_campo_async(campo_t *campo, circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(posizione(circolo->nome->str, CARTELLA_CAMPO, campo->numero, ""), lavoro_elimina_directory, 0, fine, dati);
 }
 
 bool elimina_file_ora(ora_t *ora, campo_t *campo, circolo_t *circolo)
 {
 	D1(cout<<"Elimina file ora"<<endl)
-	
-	int res;
 
-	char *file = get_file_ora(circolo->nome->str, campo->numero, ora);
+	return elimina_file( posizione_ora(circolo->nome->str, campo->numero, ora) );
+}
 
-	D2(cout<<file<<endl);
-	
-	res = g_remove(file);
+void elimina_file_ora_async(ora_t *ora, campo_t *campo, circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(posizione_ora(circolo->nome->str, campo->numero, ora), lavoro_elimina_file, 0, fine, dati);
+}
 
-	g_free(file);
+bool elimina_file_regola(regola_t *regola, campo_t *campo, circolo_t *circolo)
+{
+	return elimina_file( posizione_regola(circolo->nome->str, campo->numero, regola) );
+}
 
-	if (res == -1)
-		return false;
-	
-	return true;
+void elimina_file_regola_async(regola_t *regola, campo_t *campo, circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(posizione_regola(circolo->nome->str, campo->numero, regola), lavoro_elimina_file, 0, fine, dati);
+}
+
+bool elimina_file_corso(corso_t *corso, circolo_t *circolo)
+{
+	return elimina_file( posizione_corso(circolo->nome->str, corso) );
+}
+
+void elimina_file_corso_async(corso_t *corso, circolo_t *circolo, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(posizione_corso(circolo->nome->str, corso), lavoro_elimina_file, 0, fine, dati);
 }
 
 void elimina_file_circolo(const char *nome_cir)
 {
 	D1(cout<<"Elimina file circolo"<<endl)
 	
-	char *dir = get_dir_circolo(nome_cir);
-	
-	D2(cout<<"dir: "<<dir<<endl)
+	D2(cout<<"circolo: "<<nome_cir<<endl)
 
-	elimina_sub_directory(dir);
-	g_rmdir(dir);
+	archivio()->elimina_cartella( posizione(nome_cir, CARTELLA_CIRCOLO, 0, "") );
+}
 
-	g_free(dir);
+void elimina_file_circolo_async(const char *nome_cir, completamento_t fine, gpointer dati)
+{
+	accoda_lavoro_file(posizione(nome_cir, CARTELLA_CIRCOLO, 0, ""), lavoro_elimina_directory, 0, fine, dati);
 }
 
 bool circolo_esistente(const char *nome_cir)
 {
+	return archivio()->esiste( posizione(nome_cir, CARTELLA_CIRCOLO, 0, "") );
+}
+
+void circolo_esistente_async(const char *nome_cir, completamento_t fine, gpointer dati)
+{
+	//la chiave è la directory del circolo: il controllo vede le operazioni accodate prima
 	char *dir = get_dir_circolo(nome_cir);
 
-	bool stato = g_file_test(dir, G_FILE_TEST_IS_DIR);
+	accoda_lavoro(dir, lavoro_circolo_esistente, g_strdup(nome_cir), g_free, fine, dati);
 
 	g_free(dir);
-	
-	return stato;
-}	
+}
+
+GPtrArray *elenca_circoli()
+{
+	return archivio()->elenca_circoli();
+}
+
+void elenca_circoli_async(GPtrArray **circoli, completamento_t fine, gpointer dati)
+{
+	*circoli = 0;
+
+	//la chiave è la cartella dei dati, in conflitto con quella di ogni circolo
+	accoda_lavoro(DATA_PATH, lavoro_elenca_circoli, circoli, NULL, fine, dati);
+}
 
 /* Fine definizioni pubbliche */
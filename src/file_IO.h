@@ -7,9 +7,16 @@
 #define FILE_IO
 
 #include "struttura_dati.h"
+#include "esecutore.h"
+
+struct istantanea_t;
 
 /* Inizio interfaccia del modulo file_IO */
 
+/* Le funzioni con suffisso _async preparano i dati nel thread chiamante e
+ * accodano l'operazione sul disco all'esecutore; fine viene chiamata nel main loop
+ * con l'esito dell'operazione e può essere 0 */
+
 
 /** Controlla se un file è nascosto.
  * Esamina il nome del file e stabilisce se è nascosto;
@@ -27,6 +34,13 @@ bool file_nascosto(const char file[]);
  */
 bool salva_circolo(const circolo_t *circolo);
 
+/** Salva su file i dati del circolo in background.
+ * @param[in] circolo Circolo da salvare
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void salva_circolo_async(const circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Carica da file i dati del circolo
  * Carica dalla directory del programma i dati del circolo
  * @param[in] nome Nome del circolo da caricare
@@ -34,14 +48,53 @@ bool salva_circolo(const circolo_t *circolo);
  */
 circolo_t *carica_circolo(const char nome[]);
 
+/** Fasi del caricamento in background di un circolo.
+ */
+enum fase_caricamento_t {CARICAMENTO_GIORNO = 0, CARICAMENTO_GIOCATORI, CARICAMENTO_STORICO,
+			CARICAMENTO_FINITO, CARICAMENTO_FALLITO};
+
+/** Funzione chiamata nel main loop durante il caricamento di un circolo.
+ * Con CARICAMENTO_GIORNO il circolo contiene i campi, le ore del giorno richiesto e i loro prenotanti
+ * e da quel momento appartiene al chiamante; le chiamate successive segnalano
+ * l'aggiunta di altri giocatori e delle ore degli altri giorni.
+ * Con CARICAMENTO_FALLITO il circolo è 0
+ * @param[in] circolo Circolo in caricamento
+ * @param[in] fase Fase del caricamento
+ * @param[in] frazione Frazione dei file già letti
+ * @param[in] dati Dati passati a carica_circolo_async()
+ */
+typedef void (*progresso_t)(circolo_t *circolo, fase_caricamento_t fase, double frazione, gpointer dati);
+
+/** Caricamento in background di un circolo. */
+struct caricamento_t;
+
+/** Carica da file i dati del circolo in background.
+ * I file vengono letti da un thread dell'esecutore, dopo le scritture già accodate
+ * sul circolo, e agganciati al circolo nel main loop a blocchi:
+ * prima le ore del giorno richiesto, poi gli altri giocatori e infine lo storico
+ * @param[in] nome Nome del circolo da caricare
+ * @param[in] giorno Giorno da caricare per primo, nel formato gg-mm-aaaa
+ * @param[in] progresso Funzione chiamata dopo ogni blocco
+ * @param[in] dati Dati passati a progresso
+ * @return Caricamento, valido fino alla chiamata con CARICAMENTO_FINITO o CARICAMENTO_FALLITO
+ */
+caricamento_t *carica_circolo_async(const char nome[], const char giorno[], progresso_t progresso, gpointer dati);
+
+/** Annulla un caricamento in corso.
+ * I blocchi non ancora agganciati vengono scartati e progresso non viene più chiamata;
+ * il circolo eventualmente già ricevuto resta del chiamante
+ * @param[in,out] caricamento Caricamento da annullare, non va più usato
+ */
+void annulla_caricamento(caricamento_t *caricamento);
+
 /** Carica un giocatore da file
  * Carica i dati del giocatore dal file e aggancia il giocatore
  * al circolo
- * @param[in] file File del giocatore
+ * @param[in] nome Nome del file del giocatore nella cartella dei giocatori
  * @param[in,out] circolo Circolo al quale agganciare il giocatore
  * @return Puntatore al giocatore appena creato
  */
-giocatore_t *carica_giocatore(const char file[], circolo_t *circolo);
+giocatore_t *carica_giocatore(const char nome[], circolo_t *circolo);
 
 /** Salva il giocatore su file.
  * Salva il giocatore su un file nella directory del circolo
@@ -51,30 +104,47 @@ giocatore_t *carica_giocatore(const char file[], circolo_t *circolo);
  */
 bool salva_giocatore(const giocatore_t *giocatore, const circolo_t *circolo);
 
+/** Salva il giocatore su file in background.
+ * @param[in] giocatore Giocatore da salvare
+ * @param[in] circolo Circolo del giocatore
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void salva_giocatore_async(const giocatore_t *giocatore, const circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Salva il campo su file
- * Salva il campo su un file nella directory del circolo
+ * Salva il campo su un file nella directory del circolo; gli orari propri
+ * del campo vanno in orari.txt, che viene rimosso se il campo usa quelli del circolo
  * @param[in] campo Campo da salvare
  * @param[in] circolo Circolo del campo
  * @return successo (TRUE) o fallimento (FALSE)
  */
 bool salva_campo(const campo_t *campo, const circolo_t *circolo);
 
+/** Salva il campo su file in background.
+ * @param[in] campo Campo da salvare
+ * @param[in] circolo Circolo del campo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void salva_campo_async(const campo_t *campo, const circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Carica il campo da file.
  * Carica il campo dal file e lo aggancia al circolo
- * @param[in] file File del campo
+ * @param[in] numero Numero del campo
  * @param[in,out] circolo Circolo al quale agganciare il campo
  * @return Puntatore al campo appena creato
  */
-campo_t *carica_campo(const char file[], circolo_t *circolo);
+campo_t *carica_campo(int numero, circolo_t *circolo);
 
 /** Carica l'ora dal file.
  * Carica l'ora dal file selezionato e la aggancia al campo
- * @param[in] file File dell'ora
+ * @param[in] nome Nome del file dell'ora nella cartella delle ore del campo
  * @param[in,out] campo Campo al quale agganciare
  * @param[in] circolo Circolo del campo
  * @return Puntatore all'ora creata
  */
-ora_t *carica_ora(char file[], campo_t *campo, circolo_t *circolo);
+ora_t *carica_ora(const char nome[], campo_t *campo, circolo_t *circolo);
 
 /** Salva l'ora su file.
  * Salva l'ora su file, se archivia è true allora l'ora viene
@@ -87,29 +157,113 @@ ora_t *carica_ora(char file[], campo_t *campo, circolo_t *circolo);
  */
 bool salva_ora(const ora_t *ora, const campo_t *campo, const circolo_t *circolo);
 
+/** Salva l'ora su file in background.
+ * @param[in] ora Ora da salvare
+ * @param[in] campo Campo dell'ora
+ * @param[in] circolo Circolo dell'ora
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void salva_ora_async(const ora_t *ora, const campo_t *campo, const circolo_t *circolo, completamento_t fine, gpointer dati);
+
+/** Carica la prenotazione ricorrente dal file.
+ * Carica la regola dal file e la aggancia al campo
+ * @param[in] nome Nome del file della regola nella cartella delle regole del campo
+ * @param[in,out] campo Campo al quale agganciare
+ * @param[in] circolo Circolo del campo
+ * @return Puntatore alla regola creata, 0 se il file non è valido o il prenotante non esiste
+ */
+regola_t *carica_regola(const char nome[], campo_t *campo, circolo_t *circolo);
+
+/** Salva la prenotazione ricorrente su file.
+ * Ogni regola occupa un solo file qualunque sia il numero delle sue occorrenze
+ * @param[in] regola Regola da salvare
+ * @param[in] campo Campo della regola
+ * @param[in] circolo Circolo del campo
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool salva_regola(const regola_t *regola, const campo_t *campo, const circolo_t *circolo);
+
+/** Salva la prenotazione ricorrente su file in background.
+ * @param[in] regola Regola da salvare
+ * @param[in] campo Campo della regola
+ * @param[in] circolo Circolo del campo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void salva_regola_async(const regola_t *regola, const campo_t *campo, const circolo_t *circolo, completamento_t fine, gpointer dati);
+
+/** Salva il corso su file.
+ * Il file contiene anche tutte le lezioni del corso, quindi un'operazione
+ * su tutte le lezioni richiede una sola scrittura
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool salva_corso(const corso_t *corso, const circolo_t *circolo);
+
+/** Salva il corso su file in background.
+ */
+void salva_corso_async(const corso_t *corso, const circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Crea un backup del circolo.
- * Crea un backup del circolo e lo salva sul file
+ * Crea un backup del circolo e lo salva sul file;
+ * i dati vengono presi da un'istantanea del circolo
  * @param[in] file File nel quale salvare il backup
  * @param[in] circolo Circolo da salvare
  * @return successo (TRUE) o fallimento (FALSE)
  */
 bool backup(const char file[], circolo_t *circolo);
 
+/** Crea un backup del circolo in background.
+ * L'istantanea viene presa subito, la scrittura del file avviene in background
+ * @param[in] file File nel quale salvare il backup
+ * @param[in] circolo Circolo da salvare
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void backup_async(const char file[], circolo_t *circolo, completamento_t fine, gpointer dati);
+
+/** Crea un backup a partire da un'istantanea del circolo.
+ * Non legge l'albero delle directory: il contenuto dei file viene generato dall'istantanea,
+ * quindi può essere eseguita da un altro thread mentre il circolo viene modificato
+ * @param[in] file File nel quale salvare il backup
+ * @param[in] ist Istantanea del circolo
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool backup_istantanea(const char file[], const istantanea_t *ist);
+
 /** Ripristina un backup.
- * Ripristina l'albero di directory rappresentante un circolo da
- * un file di backup
+ * Riscrive nell'archivio in uso i file del circolo contenuti
+ * in un file di backup
  * @param[in] file File di backup
  * @return successo (TRUE) o fallimento (FALSE)
  */
 bool ripristina(const char file[]);
 
+/** Ripristina un backup in background.
+ * Il ripristino attende le operazioni già accodate sui file del circolo
+ * @param[in] file File di backup
+ * @param[in] nome_cir Nome del circolo contenuto nel backup
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void ripristina_async(const char file[], const char *nome_cir, completamento_t fine, gpointer dati);
+
 /** Ritorna il nome del circolo ai cui fa riferimento
  * il file di backup
  * @param[in] file File di backup
- * @return Nome del circolo, 0 in caso di errori
+ * @return Nome del circolo da deallocare con g_free(), 0 in caso di errori
  */
 char *get_nome_backup(const char file[]);
 
+/** Legge in background il nome del circolo a cui fa riferimento il file di backup.
+ * @param[in] file File di backup
+ * @param[out] nome_cir Nome del circolo da deallocare con g_free(), 0 in caso di errori;
+ *	va mantenuto valido e letto solo dopo la chiamata di fine
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void get_nome_backup_async(const char file[], char **nome_cir, completamento_t fine, gpointer dati);
+
 /** Elimina il file del giocatore.
  * @param[in] circolo Circolo a cui è associato il giocatore
  * @param[in] giocatore Giocatore da eliminare
@@ -117,6 +271,14 @@ char *get_nome_backup(const char file[]);
  */
 bool elimina_file_giocatore(giocatore_t *giocatore, circolo_t *circolo);
 
+/** Elimina il file del giocatore in background.
+ * @param[in] giocatore Giocatore da eliminare
+ * @param[in] circolo Circolo a cui è associato il giocatore
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void elimina_file_giocatore_async(giocatore_t *giocatore, circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Elimina il file del campo.
  * @param[in] circolo Circolo a cui è associato il campo
  * @param[in] campo Campo da eliminare
@@ -124,6 +286,14 @@ bool elimina_file_giocatore(giocatore_t *giocatore, circolo_t *circolo);
  */
 void elimina_file_campo(campo_t *campo, circolo_t *circolo);
 
+/** Elimina in background la directory del campo con tutte le sue ore.
+ * @param[in] campo Campo da eliminare
+ * @param[in] circolo Circolo a cui è associato il campo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void elimina_file_campo_async(campo_t *campo, circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Elimina il file dell'ora
  * @param[in] circolo Circolo a cui è associato il campo
  * @param[in] campo Campo a cui è associata l'ora
@@ -132,17 +302,80 @@ void elimina_file_campo(campo_t *campo, circolo_t *circolo);
  */
 bool elimina_file_ora(ora_t *ora, campo_t *campo, circolo_t *circolo);
 
+/** Elimina il file dell'ora in background.
+ * @param[in] ora Ora da eliminare
+ * @param[in] campo Campo a cui è associata l'ora
+ * @param[in] circolo Circolo a cui è associato il campo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void elimina_file_ora_async(ora_t *ora, campo_t *campo, circolo_t *circolo, completamento_t fine, gpointer dati);
+
+/** Elimina il file della prenotazione ricorrente.
+ * @param[in] regola Regola da eliminare
+ * @param[in] campo Campo della regola
+ * @param[in] circolo Circolo del campo
+ * @return Successo (TRUE) o fallimento (FALSE)
+ */
+bool elimina_file_regola(regola_t *regola, campo_t *campo, circolo_t *circolo);
+
+/** Elimina il file della prenotazione ricorrente in background.
+ * @param[in] regola Regola da eliminare
+ * @param[in] campo Campo della regola
+ * @param[in] circolo Circolo del campo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void elimina_file_regola_async(regola_t *regola, campo_t *campo, circolo_t *circolo, completamento_t fine, gpointer dati);
+
+/** Elimina il file del corso con le sue lezioni.
+ * @return Successo (TRUE) o fallimento (FALSE)
+ */
+bool elimina_file_corso(corso_t *corso, circolo_t *circolo);
+
+/** Elimina il file del corso in background.
+ */
+void elimina_file_corso_async(corso_t *corso, circolo_t *circolo, completamento_t fine, gpointer dati);
+
 /** Elimina l'intera struttura delle directory rapprensentanti il circolo.
  * @param[in] nome_cir Nome del circolo
  */
 void elimina_file_circolo(const char *nome_cir);
 
+/** Elimina in background l'intera struttura delle directory del circolo.
+ * @param[in] nome_cir Nome del circolo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void elimina_file_circolo_async(const char *nome_cir, completamento_t fine, gpointer dati);
+
 /** Controlla se esiste un circolo con tale nome
  * @param[in] nome_cir Nome del circolo
  * @return esito
  */
 bool circolo_esistente(const char *nome_cir);
 
+/** Controlla in background se esiste un circolo con tale nome.
+ * fine riceve TRUE se il circolo esiste
+ * @param[in] nome_cir Nome del circolo
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void circolo_esistente_async(const char *nome_cir, completamento_t fine, gpointer dati);
+
+/** Elenca i circoli presenti nell'archivio in uso.
+ * @return Nomi dei circoli, da deallocare con g_ptr_array_free()
+ */
+GPtrArray *elenca_circoli();
+
+/** Elenca in background i circoli presenti nell'archivio in uso.
+ * @param[out] circoli Nomi dei circoli, da deallocare con g_ptr_array_free();
+ *	va mantenuto valido e letto solo dopo la chiamata di fine
+ * @param[in] fine Funzione chiamata al termine
+ * @param[in] dati Dati passati a fine
+ */
+void elenca_circoli_async(GPtrArray **circoli, completamento_t fine, gpointer dati);
+
 /** Ritorna la directory del circolo.
  * @param[in] nome_cir Nome del circolo
  * @return Percorso della directory
@@ -0,0 +1,541 @@
+/**
+ * @file
+ * File contenente il modulo formato.
+ * Descrive con un tracciato l'ordine e il tipo delle voci del circolo, dei giocatori,
+ * dei campi e delle ore, e scrive e legge i record in ogni formato a partire dal tracciato.
+ * Lo stesso tracciato serve sia per le strutture del circolo sia per le loro copie piatte,
+ * quindi l'ordine delle voci è scritto una sola volta per tutti i formati
+ */
+
+#include <glib.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "formato.h"
+#include "accesso_dati.h"
+#include "istantanea.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+static const voce_t VOCI_CIRCOLO[] = {
+	{ "nome", VOCE_TESTO, offsetof(circolo_t, nome), offsetof(dati_circolo_t, nome), 0, false },
+	{ "indirizzo", VOCE_TESTO, offsetof(circolo_t, indirizzo), offsetof(dati_circolo_t, indirizzo), 0, false },
+	{ "email", VOCE_TESTO, offsetof(circolo_t, email), offsetof(dati_circolo_t, email), 0, false },
+	{ "telefono", VOCE_TESTO, offsetof(circolo_t, telefono), offsetof(dati_circolo_t, telefono), 0, false },
+	//mancano nei circoli creati prima degli orari configurabili
+	{ "apertura", VOCE_INTERO, offsetof(circolo_t, orari.apertura), offsetof(dati_circolo_t, orari.apertura), 0, true },
+	{ "chiusura", VOCE_INTERO, offsetof(circolo_t, orari.chiusura), offsetof(dati_circolo_t, orari.chiusura), 0, true },
+	{ "passo", VOCE_INTERO, offsetof(circolo_t, orari.passo), offsetof(dati_circolo_t, orari.passo), 0, true }
+};
+
+static const voce_t VOCI_GIOCATORE[] = {
+	{ "ID", VOCE_INTERO, offsetof(giocatore_t, ID), offsetof(ist_giocatore_t, ID), 0, false },
+	{ "nome", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, nome), 0, false, DATO_NOME },
+	{ "cognome", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, cognome), 0, false, DATO_COGNOME },
+	{ "nascita", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, nascita), 0, false, DATO_NASCITA },
+	{ "tessera", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, tessera), 0, false, DATO_TESSERA },
+	{ "telefono", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, telefono), 0, false, DATO_TELEFONO },
+	{ "email", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, email), 0, false, DATO_EMAIL },
+	{ "classifica", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, classifica), 0, false, DATO_CLASSIFICA },
+	{ "circolo", VOCE_DATO_GIOCATORE, 0, offsetof(ist_giocatore_t, circolo), 0, false, DATO_CIRCOLO },
+	{ "socio", VOCE_BOOLEANO, offsetof(giocatore_t, socio), offsetof(ist_giocatore_t, socio), 0, false },
+	{ "retta", VOCE_BOOLEANO, offsetof(giocatore_t, retta), offsetof(ist_giocatore_t, retta), 0, false }
+};
+
+//gli enumerati sono letti e scritti come int
+static const voce_t VOCI_CAMPO[] = {
+	{ "numero", VOCE_INTERO, offsetof(campo_t, numero), offsetof(ist_campo_t, numero), 0, false },
+	{ "copertura", VOCE_INTERO, offsetof(campo_t, copertura), offsetof(ist_campo_t, copertura), OUTDOOR, false },
+	{ "terreno", VOCE_INTERO, offsetof(campo_t, terreno), offsetof(ist_campo_t, terreno), CEMENTO, false },
+	//ultima perché nel formato testo può occupare più righe
+	{ "note", VOCE_TESTO, offsetof(campo_t, note), offsetof(ist_campo_t, note), 0, false }
+};
+
+static const voce_t VOCI_ORA[] = {
+	{ "orario", VOCE_INTERO, offsetof(ora_t, orario), offsetof(ist_ora_t, orario), 0, false },
+	{ "data", VOCE_DATA, offsetof(ora_t, data), offsetof(ist_ora_t, data), sizeof(ist_ora_t::data), false },
+	{ "durata", VOCE_INTERO, offsetof(ora_t, durata), offsetof(ist_ora_t, durata), 0, false },
+	{ "prenotante", VOCE_PRENOTANTE, offsetof(ora_t, prenotante), offsetof(ist_ora_t, prenotante), 0, false }
+};
+
+static const voce_t VOCI_ORARI[] = {
+	{ "apertura", VOCE_INTERO, offsetof(orari_t, apertura), offsetof(orari_t, apertura), 0, false },
+	{ "chiusura", VOCE_INTERO, offsetof(orari_t, chiusura), offsetof(orari_t, chiusura), 0, false },
+	{ "passo", VOCE_INTERO, offsetof(orari_t, passo), offsetof(orari_t, passo), 0, false }
+};
+
+/** Ritorna TRUE se la voce viene scritta come un numero.
+ */
+static inline bool numerica(const voce_t &voce)
+{
+	return voce.tipo == VOCE_INTERO || voce.tipo == VOCE_BOOLEANO || voce.tipo == VOCE_PRENOTANTE;
+}
+
+/** Aggiunge al testo un intero su 4 byte little endian.
+ */
+static void aggiungi_32(GString *testo, guint32 valore)
+{
+	char byte[4] = { (char) valore, (char) (valore >> 8), (char) (valore >> 16), (char) (valore >> 24) };
+	g_string_append_len(testo, byte, 4);
+}
+
+/** Legge un intero su 4 byte little endian.
+ */
+static guint32 leggi_32(const char testo[])
+{
+	const guchar *byte = (const guchar *) testo;
+	return byte[0] | (byte[1] << 8) | (byte[2] << 16) | ((guint32) byte[3] << 24);
+}
+
+/** Aggiunge al testo un intero in cifre decimali.
+ */
+static void aggiungi_intero(GString *testo, int valore)
+{
+	char cifre[12];
+	char *inizio = cifre + sizeof(cifre);
+	guint assoluto = (valore < 0) ? 0u - (guint) valore : (guint) valore;
+
+	do {
+		*--inizio = '0' + assoluto % 10;
+		assoluto /= 10;
+	} while (assoluto != 0);
+
+	if (valore < 0)
+		*--inizio = '-';
+
+	g_string_append_len(testo, inizio, cifre + sizeof(cifre) - inizio);
+}
+
+/** Aggiunge al testo un valore CSV, tra virgolette se contiene separatori o virgolette.
+ */
+static void aggiungi_csv(GString *testo, const char valore[])
+{
+	if (strpbrk(valore, ",\"\r\n") == 0){
+		g_string_append(testo, valore);
+		return;
+	}
+
+	g_string_append_c(testo, '"');
+	for (const char *c = valore; *c != '\0'; c++){
+		if (*c == '"')
+			g_string_append_c(testo, '"');
+		g_string_append_c(testo, *c);
+	}
+	g_string_append_c(testo, '"');
+}
+
+/** Legge il valore di una voce da una struttura del circolo.
+ * @param[in] voce Voce
+ * @param[in] elemento Struttura
+ * @param[out] valore Testo, per le voci non numeriche
+ * @param[out] intero Intero, per le voci numeriche
+ */
+static void valore_memoria(const voce_t &voce, gconstpointer elemento, const char *&valore, int &intero)
+{
+	const char *posto = (const char *) elemento + voce.in_memoria;
+
+	switch (voce.tipo){
+		case VOCE_INTERO:
+			intero = *(const int *) posto;
+			break;
+		case VOCE_BOOLEANO:
+			intero = *(const bool *) posto;
+			break;
+		case VOCE_PRENOTANTE: {
+			const giocatore_t *giocatore = *(giocatore_t * const *) posto;
+			intero = (giocatore != 0) ? giocatore->ID : 0;
+			break;
+		}
+		case VOCE_TESTO:
+		case VOCE_DATA:
+			valore = (*(GString * const *) posto)->str;
+			break;
+		case VOCE_DATO_GIOCATORE:
+			valore = dato_giocatore( (const giocatore_t *) elemento, voce.dato );
+			break;
+	}
+}
+
+/** Legge il valore di una voce da una copia piatta.
+ * @param[in] voce Voce
+ * @param[in] copia Copia piatta
+ * @param[out] valore Testo, per le voci non numeriche
+ * @param[out] intero Intero, per le voci numeriche
+ */
+static void valore_copia(const voce_t &voce, gconstpointer copia, const char *&valore, int &intero)
+{
+	const char *posto = (const char *) copia + voce.in_copia;
+
+	switch (voce.tipo){
+		case VOCE_INTERO:
+		case VOCE_PRENOTANTE:
+			intero = *(const int *) posto;
+			break;
+		case VOCE_BOOLEANO:
+			intero = *(const bool *) posto;
+			break;
+		case VOCE_TESTO:
+		case VOCE_DATO_GIOCATORE:
+			valore = *(const char * const *) posto;
+			if (valore == 0)
+				valore = "";
+			break;
+		case VOCE_DATA:
+			valore = posto;
+			break;
+	}
+}
+
+/** Aggiunge al testo il valore di una voce.
+ * @param[in,out] testo Testo
+ * @param[in] formato Formato del record
+ * @param[in] voce Voce
+ * @param[in] valore Testo, per le voci non numeriche
+ * @param[in] intero Intero, per le voci numeriche
+ * @param[in] prima TRUE se è la prima voce del record
+ */
+static void scrivi_voce(GString *testo, formato_t formato, const voce_t &voce, const char valore[], int intero, bool prima)
+{
+	switch (formato){
+		case FORMATO_TESTO:
+			if ( numerica(voce) )
+				aggiungi_intero(testo, intero);
+			else
+				g_string_append(testo, valore);
+			g_string_append_c(testo, '\n');
+			break;
+
+		case FORMATO_CSV:
+			if (!prima)
+				g_string_append_c(testo, ',');
+			if ( numerica(voce) )
+				aggiungi_intero(testo, intero);
+			else
+				aggiungi_csv(testo, valore);
+			break;
+
+		case FORMATO_BINARIO:
+			if (voce.tipo == VOCE_BOOLEANO)
+				g_string_append_c(testo, intero != 0);
+			else if ( numerica(voce) )
+				aggiungi_32(testo, intero);
+			else {
+				gsize lunghezza = strlen(valore);
+				aggiungi_32(testo, lunghezza);
+				//il terminatore permette di leggere il testo sul posto
+				g_string_append_len(testo, valore, lunghezza + 1);
+			}
+			break;
+	}
+}
+
+/** Aggiunge al testo il record di una struttura o di una copia piatta.
+ */
+static void scrivi(GString *testo, formato_t formato, const tracciato_t &tracciato, gconstpointer dati, bool copia)
+{
+	gsize inizio = testo->len;
+
+	//la lunghezza viene completata alla fine del record
+	if (formato == FORMATO_BINARIO)
+		aggiungi_32(testo, 0);
+
+	for (int i = 0; i < tracciato.n_voci; i++){
+		const voce_t &voce = tracciato.voci[i];
+		const char *valore = 0;
+		int intero = 0;
+
+		if (copia)
+			valore_copia(voce, dati, valore, intero);
+		else
+			valore_memoria(voce, dati, valore, intero);
+
+		scrivi_voce(testo, formato, voce, valore, intero, i == 0);
+	}
+
+	if (formato == FORMATO_CSV)
+		g_string_append_c(testo, '\n');
+	else if (formato == FORMATO_BINARIO){
+		guint32 lunghezza = testo->len - inizio - 4;
+		for (int i = 0; i < 4; i++)
+			testo->str[inizio + i] = (char) (lunghezza >> (8 * i));
+	}
+}
+
+/** Stato della lettura di un record.
+ * fine è la fine del record, finito indica che non restano valori da leggere
+ */
+struct lettura_t {
+	char *cursore;
+	char *fine;
+	bool finito;
+};
+
+/** Ritorna il prossimo valore di un record nel formato testo.
+ * @param[in,out] l Stato della lettura
+ * @param[in] ultima TRUE se è l'ultima voce, che prende tutto il resto del record
+ * @return Valore terminato sul posto
+ */
+static char *valore_testo(lettura_t &l, bool ultima)
+{
+	char *valore = l.cursore;
+	char *a_capo = ultima ? 0 : (char *) memchr(valore, '\n', l.fine - valore);
+
+	if (a_capo == 0){
+		l.cursore = l.fine;
+		l.finito = true;
+	}
+	else {
+		*a_capo = '\0';
+		l.cursore = a_capo + 1;
+	}
+
+	return valore;
+}
+
+/** Ritorna il prossimo valore di un record CSV.
+ * Le virgolette vengono tolte sul posto
+ * @param[in,out] l Stato della lettura
+ * @return Valore terminato sul posto, 0 se il valore non è valido
+ */
+static char *valore_csv(lettura_t &l)
+{
+	char *valore = l.cursore;
+	char *scritto = l.cursore;
+	char *c = l.cursore;
+
+	if (*c == '"'){
+		for (c++; ; c++){
+			if (c >= l.fine)
+				return 0;
+			if (*c == '"'){
+				if (c + 1 < l.fine && c[1] == '"')
+					c++;
+				else {
+					c++;
+					break;
+				}
+			}
+			*scritto++ = *c;
+		}
+	}
+	else {
+		while (c < l.fine && *c != ',' && *c != '\n' && *c != '\r')
+			c++;
+		scritto = c;
+	}
+
+	if (c >= l.fine){
+		l.cursore = c;
+		l.finito = true;
+	}
+	else if (*c == ',')
+		l.cursore = c + 1;
+	else if (*c == '\n'){
+		l.cursore = c + 1;
+		l.finito = true;
+	}
+	else if (*c == '\r' && c + 1 < l.fine && c[1] == '\n'){
+		l.cursore = c + 2;
+		l.finito = true;
+	}
+	else
+		return 0;
+
+	*scritto = '\0';
+	return valore;
+}
+
+/** Legge il prossimo valore di un record binario.
+ * @param[in,out] l Stato della lettura
+ * @param[in] voce Voce da leggere
+ * @param[out] valore Testo, per le voci non numeriche
+ * @param[out] intero Intero, per le voci numeriche
+ * @return TRUE se il valore è valido
+ */
+static bool valore_binario(lettura_t &l, const voce_t &voce, char *&valore, int &intero)
+{
+	gsize resto = l.fine - l.cursore;
+
+	if (voce.tipo == VOCE_BOOLEANO){
+		intero = *l.cursore != 0;
+		l.cursore++;
+	}
+	else if ( numerica(voce) ){
+		if (resto < 4)
+			return false;
+		intero = (gint32) leggi_32(l.cursore);
+		l.cursore += 4;
+	}
+	else {
+		if (resto < 5)
+			return false;
+		guint32 lunghezza = leggi_32(l.cursore);
+		if (lunghezza > resto - 5 || l.cursore[4 + lunghezza] != '\0')
+			return false;
+		valore = l.cursore + 4;
+		l.cursore = valore + lunghezza + 1;
+	}
+
+	l.finito = (l.cursore == l.fine);
+	return true;
+}
+
+/** Converte il valore letto e lo scrive nella copia.
+ * Nei formati testuali anche i valori numerici sono in valore, nel formato binario sono già in intero
+ * @return TRUE se il valore è valido per la voce
+ */
+static bool assegna(const voce_t &voce, gpointer copia, char *valore, int intero)
+{
+	char *posto = (char *) copia + voce.in_copia;
+
+	if ( numerica(voce) ){
+		if ( valore != 0 && !leggi_intero(valore, intero) )
+			return false;
+
+		if (voce.tipo == VOCE_BOOLEANO){
+			*(bool *) posto = (intero != 0);
+			return true;
+		}
+
+		if (voce.limite > 0 && (intero < 0 || intero > voce.limite))
+			return false;
+
+		*(int *) posto = intero;
+		return true;
+	}
+
+	if (voce.tipo == VOCE_DATA){
+		if (strlen(valore) >= (size_t) voce.limite)
+			return false;
+		strcpy(posto, valore);
+		return true;
+	}
+
+	*(char **) posto = valore;
+	return true;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+const tracciato_t TRACCIATO_CIRCOLO = { "circolo", VOCI_CIRCOLO, G_N_ELEMENTS(VOCI_CIRCOLO) };
+const tracciato_t TRACCIATO_GIOCATORE = { "giocatore", VOCI_GIOCATORE, G_N_ELEMENTS(VOCI_GIOCATORE) };
+const tracciato_t TRACCIATO_CAMPO = { "campo", VOCI_CAMPO, G_N_ELEMENTS(VOCI_CAMPO) };
+const tracciato_t TRACCIATO_ORA = { "ora", VOCI_ORA, G_N_ELEMENTS(VOCI_ORA) };
+const tracciato_t TRACCIATO_ORARI = { "orari", VOCI_ORARI, G_N_ELEMENTS(VOCI_ORARI) };
+
+void scrivi_record(GString *testo, formato_t formato, const tracciato_t &tracciato, gconstpointer elemento)
+{
+	if (testo == 0 || elemento == 0) return;
+
+	scrivi(testo, formato, tracciato, elemento, false);
+}
+
+void scrivi_copia(GString *testo, formato_t formato, const tracciato_t &tracciato, gconstpointer copia)
+{
+	if (testo == 0 || copia == 0) return;
+
+	scrivi(testo, formato, tracciato, copia, true);
+}
+
+void scrivi_intestazione(GString *testo, const tracciato_t &tracciato)
+{
+	if (testo == 0) return;
+
+	for (int i = 0; i < tracciato.n_voci; i++){
+		if (i > 0)
+			g_string_append_c(testo, ',');
+		g_string_append(testo, tracciato.voci[i].nome);
+	}
+	g_string_append_c(testo, '\n');
+}
+
+bool leggi_record(char *&testo, const char *fine, formato_t formato, const tracciato_t &tracciato, gpointer copia)
+{
+	if (testo == 0 || fine < testo || copia == 0) return false;
+
+	lettura_t l = { testo, (char *) fine, false };
+
+	if (formato == FORMATO_BINARIO){
+		if (fine - testo < 4)
+			return false;
+		guint32 lunghezza = leggi_32(testo);
+		if (lunghezza > (gsize) (fine - testo) - 4)
+			return false;
+		l.cursore = testo + 4;
+		l.fine = l.cursore + lunghezza;
+		l.finito = (lunghezza == 0);
+	}
+	else if (formato == FORMATO_TESTO && l.fine > l.cursore && l.fine[-1] == '\n'){
+		//l'a capo finale chiude l'ultima voce e non ne fa parte
+		*--l.fine = '\0';
+	}
+
+	for (int i = 0; i < tracciato.n_voci; i++){
+		const voce_t &voce = tracciato.voci[i];
+		char *valore = 0;
+		int intero = 0;
+		bool valido = true;
+
+		if (l.finito){
+			if (!voce.facoltativa){
+				D1(cout<<"Record "<<tracciato.nome<<" incompleto"<<endl)
+				return false;
+			}
+			continue;
+		}
+
+		switch (formato){
+			case FORMATO_TESTO:
+				valore = valore_testo(l, i == tracciato.n_voci - 1);
+				break;
+			case FORMATO_CSV:
+				valore = valore_csv(l);
+				valido = (valore != 0);
+				break;
+			case FORMATO_BINARIO:
+				valido = valore_binario(l, voce, valore, intero);
+				break;
+		}
+
+		if ( !valido || !assegna(voce, copia, valore, intero) ){
+			D1(cout<<"Voce "<<voce.nome<<" del record "<<tracciato.nome<<" errata"<<endl)
+			return false;
+		}
+	}
+
+	//valori in più rispetto al tracciato
+	if (!l.finito){
+		D1(cout<<"Record "<<tracciato.nome<<" troppo lungo"<<endl)
+		return false;
+	}
+
+	testo = (formato == FORMATO_TESTO) ? (char *) fine : l.cursore;
+
+	return true;
+}
+
+bool leggi_intero(const char testo[], int &valore)
+{
+	char *fine;
+	errno = 0;
+	long letto = strtol(testo, &fine, 10);
+
+	if (fine == testo || errno != 0 || letto < G_MININT || letto > G_MAXINT)
+		return false;
+
+	while (*fine == ' ')
+		fine++;
+	if (*fine != '\0')
+		return false;
+
+	valore = letto;
+	return true;
+}
+
+/* Fine definizioni pubbliche */
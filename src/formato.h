@@ -0,0 +1,122 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo formato.cc
+ */
+
+#ifndef FORMATO
+#define FORMATO
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo formato */
+
+/** Formati in cui possono essere scritti e letti i record.
+ * FORMATO_TESTO è quello dei file dei dati: un valore per riga, l'ultimo può occupare il resto del testo.
+ * FORMATO_BINARIO antepone al record la sua lunghezza, scrive gli interi su 4 byte little endian,
+ * i booleani su un byte e i testi come lunghezza su 4 byte seguita dai caratteri e dal terminatore.
+ * FORMATO_CSV scrive un record per riga, con i valori separati da virgole e tra virgolette se serve
+ */
+enum formato_t {FORMATO_TESTO, FORMATO_BINARIO, FORMATO_CSV};
+
+/** Tipo di una voce di un record.
+ * VOCE_DATO_GIOCATORE è un dato di testo letto con dato_giocatore(),
+ * VOCE_PRENOTANTE un puntatore al giocatore scritto come il suo ID,
+ * VOCE_DATA un testo che nella copia piatta è un array di caratteri
+ */
+enum tipo_voce_t {VOCE_INTERO, VOCE_BOOLEANO, VOCE_TESTO, VOCE_DATO_GIOCATORE, VOCE_PRENOTANTE, VOCE_DATA};
+
+/** Descrittore di una voce di un record.
+ * in_memoria è la posizione della voce nella struttura del circolo, non usata per VOCE_DATO_GIOCATORE;
+ * in_copia è la posizione nella copia piatta, dove i testi sono puntatori a caratteri e i riferimenti ID.
+ * limite è per VOCE_INTERO il valore massimo se positivo e per VOCE_DATA la dimensione dell'array;
+ * le voci facoltative possono mancare in fondo al record e in quel caso la copia resta invariata.
+ * dato è il dato letto con dato_giocatore() per VOCE_DATO_GIOCATORE
+ */
+struct voce_t {
+	const char *nome;
+	tipo_voce_t tipo;
+	size_t in_memoria;
+	size_t in_copia;
+	int limite;
+	bool facoltativa;
+	dato_giocatore_t dato;
+};
+
+/** Tracciato di un record: le sue voci nell'ordine in cui vengono scritte.
+ * I tracciati sono tabelle costanti interpretate a ogni record: le funzioni di lettura
+ * e scrittura scorrono le voci e scelgono il trattamento in base al tipo di ciascuna
+ */
+struct tracciato_t {
+	const char *nome;
+	const voce_t *voci;
+	int n_voci;
+};
+
+/** Copia piatta dei dati propri di un circolo.
+ */
+struct dati_circolo_t {
+	const char *nome;
+	const char *indirizzo;
+	const char *email;
+	const char *telefono;
+	orari_t orari;
+};
+
+//@{
+/** Tracciati dei record.
+ * Le copie piatte sono dati_circolo_t, ist_giocatore_t, ist_campo_t, ist_ora_t e orari_t;
+ * gli orari del campo sono un record a parte, quelli del circolo sono in fondo al suo record
+ */
+extern const tracciato_t TRACCIATO_CIRCOLO;
+extern const tracciato_t TRACCIATO_GIOCATORE;
+extern const tracciato_t TRACCIATO_CAMPO;
+extern const tracciato_t TRACCIATO_ORA;
+extern const tracciato_t TRACCIATO_ORARI;	//@}
+
+/** Aggiunge al testo il record di un elemento del circolo.
+ * @param[in,out] testo Testo a cui aggiungere il record
+ * @param[in] formato Formato del record
+ * @param[in] tracciato Tracciato del tipo dell'elemento
+ * @param[in] elemento Circolo, giocatore, campo, ora o orari
+ */
+void scrivi_record(GString *testo, formato_t formato, const tracciato_t &tracciato, gconstpointer elemento);
+
+/** Aggiunge al testo il record di una copia piatta.
+ * @param[in,out] testo Testo a cui aggiungere il record
+ * @param[in] formato Formato del record
+ * @param[in] tracciato Tracciato del tipo della copia
+ * @param[in] copia Copia piatta
+ */
+void scrivi_copia(GString *testo, formato_t formato, const tracciato_t &tracciato, gconstpointer copia);
+
+/** Aggiunge al testo la riga con i nomi delle voci del tracciato, separati da virgole.
+ * @param[in,out] testo Testo a cui aggiungere la riga
+ * @param[in] tracciato Tracciato
+ */
+void scrivi_intestazione(GString *testo, const tracciato_t &tracciato);
+
+/** Legge un record in una copia piatta.
+ * Il testo viene diviso sul posto e i testi della copia puntano al suo interno;
+ * dopo la fine del testo deve esserci un terminatore. Nel formato testo il record occupa tutto il testo
+ * @param[in,out] testo Inizio del record, avanza all'inizio del record successivo
+ * @param[in] fine Fine del testo
+ * @param[in] formato Formato del record
+ * @param[in] tracciato Tracciato del tipo della copia
+ * @param[out] copia Copia piatta
+ * @return TRUE se il testo contiene un record valido
+ */
+bool leggi_record(char *&testo, const char *fine, formato_t formato, const tracciato_t &tracciato, gpointer copia);
+
+/** Converte in intero un valore letto da un file.
+ * Diversamente da atoi() il testo deve contenere solo l'intero, eventualmente seguito da spazi
+ * @param[in] testo Testo da convertire
+ * @param[out] valore Intero letto
+ * @return TRUE se il testo è un intero valido
+ */
+bool leggi_intero(const char testo[], int &valore);
+
+/* Fine interfaccia del modulo formato */
+
+#endif
@@ -12,24 +12,42 @@
 #include "struttura_dati.h"
 #include "accesso_dati.h"
 #include "file_IO.h"
+#include "esecutore.h"
+#include "ricerca.h"
+#include "modello_giocatori.h"
+#include "tabella_ore.h"
+#include "indice_giorni.h"
+#include "corsi.h"
+#include "torneo.h"
+#include "allocazione.h"
+#include "occupazione.h"
+#include "selezione.h"
+#include "prestazioni.h"
 #include "debug.h"
 
 extern GtkBuilder *build;
 
-extern const char DATA_PATH[];
-
 /* Inizio definizioni delle entità private del modulo */
 
-enum tipo_ora { VUOTA, PRENOTATA };	/**< Tipo rapresentante il tipo d'ora nella tabella */
-
 circolo_t *circolo;
 
+static caricamento_t *caricamento = 0;	/**< Caricamento del circolo in corso, 0 se non ce ne sono */
+
+static GtkTreeModel *modello_giocatori = 0;	/**< Modello dell'elenco giocatori, creato alla prima apertura */
+static GtkTreeModel *modello_soci = 0;		/**< Modello dell'elenco soci, creato alla prima apertura */
+static GtkTreeModel *modello_filtrato = 0;	/**< Modello attualmente limitato dalla ricerca */
+static GtkTreeModel *modello_torneo = 0;	/**< Modello dei giocatori da scegliere per il torneo */
+
+static torneo_t *torneo = 0;		/**< Torneo pianificato, resta in memoria per ripianificarlo */
+static GArray *richieste = 0;		/**< Richieste di prenotazione in attesa di allocazione */
+
+static GtkWidget *tabella = 0;		/**< Tabella delle ore, creata al primo disegno */
+
 const char ESTENSIONE_BACKUP[] = ".abk";
 const char *coperture[] = {"INDOOR", "OUTDOOR"};
 const char *terreni[] = {"ERBA", "ERBA SINTETICA", "TERRA", "SINTETICO", "CEMENTO"};
 
-const int ORA_APERTURA = 8;
-const int ORA_CHIUSURA = 23;
+const unsigned int MAX_RISULTATI = 50;	/**< Giocatori proposti al massimo nella prenotazione */
 
 /** Trsforma un intero in una stringa orario.
  * Prende l'intero rappresentate i minuti totali e lo
@@ -94,11 +112,11 @@ static void insert_list_giocatore(gpointer data_, gpointer list_)
 
 	gtk_list_store_append(list, &iter);
 	gtk_list_store_set(list, &iter, 
-				0, data->nome->str,
-				1, data->cognome->str,
-				2, data->nascita->str,
-				3, data->classifica->str,
-				4, data->circolo->str,
+				0, dato_giocatore(data, DATO_NOME),
+				1, dato_giocatore(data, DATO_COGNOME),
+				2, dato_giocatore(data, DATO_NASCITA),
+				3, dato_giocatore(data, DATO_CLASSIFICA),
+				4, dato_giocatore(data, DATO_CIRCOLO),
 				5, data->socio,
 				6, data->retta,
 				7, data,
@@ -128,146 +146,77 @@ static void insert_list_campi(gpointer data_, gpointer list_)
 				-1);
 }
 
-/** Aggiunge alla tabella le righe dei campi.
- * Per ogni campo aggiunge una riga alla tabella con il numero del campo
- * @param[in] campo_ Puntatore al campo
- * @param[out] tabella_ Puntatore alla tabella
- */
-static void inserisci_righe_campi(gpointer campo_, gpointer tabella_)
-{
-	campo_t *campo = (campo_t *) campo_;
-	GtkGrid *tabella = (GtkGrid *) tabella_;
-	char *tmp = g_strdup_printf("%d", campo->numero);
-	GtkWidget *etichetta = GTK_WIDGET( gtk_label_new(tmp) );
-	
-	gtk_grid_insert_row(tabella, 1);
-	gtk_grid_attach(tabella, etichetta, 0, 1, 1, 1);
-
-	g_free(tmp);
-}
-
-/** Restituisce una stringa con la data.
- * @param[in] calendario Calendario
- * @return Data
+/** Riempie l'elenco dei giocatori della prenotazione.
+ * Mostra i primi giocatori che corrispondono al testo cercato e seleziona il primo
+ * @param[in] testo Testo cercato
  */
-static char *get_stringa_data(GtkCalendar *calendario)
+static void riempi_giocatori_ora(const char testo[])
 {
-	unsigned int giorno, mese, anno;
-
-	gtk_calendar_get_date(calendario, &anno, &mese, &giorno);
-	mese++;
-	char *data = g_strdup_printf("%02d-%02d-%04d", giorno, mese, anno);
-	
-	return data;
-}
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "giocatori_ora") );
+	GtkComboBox *nome = GTK_COMBO_BOX( gtk_builder_get_object(build, "nome_ora_n") );
 
-/** Controlla se un ora è disponibile.
- * Controlla che la combinazione ora durata non vada in conflitto con ore già prenotate
- * @param[in] campo Campo
- * @param[in] orario Orario
- * @param[in] durata Durata
- * @return Risultato del test
- */
-static bool controlla_disponibilita_ora(campo_t *campo, int orario, int durata)
-{
-	GList *tmp = campo->ore;
-	while(tmp != 0){
-		ora_t *ora = (ora_t *) tmp->data;
-		if ( (orario < ora->orario + ora->durata) && (orario + durata > ora->orario) )
-			return false;
+	GList *trovati = cerca_giocatori(circolo, testo, false, MAX_RISULTATI);
 
-		tmp = g_list_next(tmp);
-	}
+	gtk_list_store_clear(list);
+	g_list_foreach(trovati, insert_list_giocatore, list);
+	g_list_free(trovati);
 
-	return true;
+	gtk_combo_box_set_active(nome, 0);
 }
 
-/** Distrugge la cella del container se non fa parte della struttara esterna.
- * @param[in] widget Cella da eliminare
- * @param[in] container Contenitore della cella
+/** Svuota la casella di ricerca senza richiamare la ricerca.
+ * @param[in] nome Nome della casella
+ * @param[in] handler Handler collegato alla casella
  */
-static void distruggi_cella_se_interna(GtkWidget *widget, gpointer container)
+static void svuota_ricerca(const char nome[], GCallback handler)
 {
-	int top, left;
-	gtk_container_child_get( GTK_CONTAINER(container), widget,
-						"top-attach", &top,
-						"left-attach", &left,
-						NULL);
-	
-	if (top == 0 || left == 0)
-		return;
+	GObject *cerca = gtk_builder_get_object(build, nome);
 
-	gtk_widget_destroy(widget);
+	g_signal_handlers_block_by_func(cerca, (gpointer) handler, NULL);
+	gtk_entry_set_text( GTK_ENTRY(cerca), "" );
+	g_signal_handlers_unblock_by_func(cerca, (gpointer) handler, NULL);
 }
 
-/** Inserisce ore vuote nella tabella.
- * Inserisce nella tabella ore vuote dall'inizio alla fine della riga del campo
- * @param[in] inizio Inizio dell'inserimento
- * @param[in] fine Fine dell'inserimento
- * @param[in] tabella Tabella dove inserire
- * @param[in] campo Campo dove inserire le ore
+/** Mostra l'elenco dei giocatori o dei soci.
+ * I modelli vengono creati alla prima apertura e poi si aggiornano da soli,
+ * quindi riaprire l'elenco non copia i giocatori
+ * @param[in] soci TRUE per l'elenco dei soci
  */
-static void inserisci_ore_vuote(int inizio, int fine, GtkGrid* tabella, campo_t *campo)
+static void mostra_elenco(bool soci)
 {
-	D1(cout<<"inserimento ore vuote"<<endl)
-	D2(cout<<"da: "<<inizio<<"a: "<<fine<<endl);	
-	
-	if (inizio == fine)
-		return;
-
-	const char segnale[] = "clicked";
-	GtkWidget *etichetta = 0;
-
-	int ora_inizio = inizio + (ORA_APERTURA)*60;
-	int scarto_inizio = 60 - (inizio % 60);
-	int scarto_fine = fine % 60;
-	int ora_scarto_fine = fine - scarto_fine + ORA_APERTURA*60;
-
-	//Di defualt le ore inizia al minuto 0 quindi controllo eventuali scarti
-	if (scarto_inizio != 60){
-		D1(cout<<"scarto_inizio"<<endl)
-
-		etichetta = GTK_WIDGET( gtk_button_new() );
-		g_signal_connect( G_OBJECT(etichetta), segnale, G_CALLBACK(handler_mostra_ora), NULL );
-		g_object_set_data( G_OBJECT(etichetta), "campo", campo);
-		g_object_set_data( G_OBJECT(etichetta), "tipo_ora", GINT_TO_POINTER( VUOTA ) );
-		g_object_set_data( G_OBJECT(etichetta), "ora", GINT_TO_POINTER(ora_inizio) );
-		
-		gtk_grid_attach(tabella, etichetta, inizio + 60, campo->numero, scarto_inizio, 1);
-
-		inizio += 60;
-	}
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_g") );
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") );
+	GtkTreeModel *&modello = soci ? modello_soci : modello_giocatori;
 
-	if (scarto_fine != 0){
-		D1(cout<<"scarto_fine"<<endl)
+	if (modello == 0)
+		modello = crea_modello_giocatori(circolo, soci);
 
-		etichetta = GTK_WIDGET( gtk_button_new() );
-		g_signal_connect( G_OBJECT(etichetta), segnale, G_CALLBACK(handler_mostra_ora), NULL );
-		g_object_set_data( G_OBJECT(etichetta), "campo", campo);
-		g_object_set_data( G_OBJECT(etichetta), "tipo_ora", GINT_TO_POINTER( VUOTA ) );
-		g_object_set_data( G_OBJECT(etichetta), "ora", GINT_TO_POINTER(ora_scarto_fine) );	
+	svuota_ricerca("cerca_g", G_CALLBACK(handler_cerca_giocatori));
 
-		gtk_grid_attach(tabella, etichetta, (fine - scarto_fine + 60), campo->numero, scarto_fine, 1);
+	if (modello_filtrato != 0){
+		gtk_tree_view_set_model(view, NULL);
+		filtra_modello_giocatori(modello_filtrato, 0, false);
+		modello_filtrato = 0;
 	}
 
-	inizio = inizio + scarto_inizio;
-	fine = fine - scarto_fine;
+	gtk_tree_view_set_model(view, modello);
 
-	while (inizio <= fine){
-		D2(cout<<inizio<<endl)
-		ora_inizio = inizio + (ORA_APERTURA - 1)*60;
+	gtk_widget_show_all(window);
+}
 
-		etichetta = GTK_WIDGET( gtk_button_new() );
-		g_signal_connect( G_OBJECT(etichetta), segnale, G_CALLBACK(handler_mostra_ora), NULL );
-		g_object_set_data( G_OBJECT(etichetta), "campo", campo);
-		g_object_set_data( G_OBJECT(etichetta), "tipo_ora", GINT_TO_POINTER( VUOTA ) );
-		g_object_set_data( G_OBJECT(etichetta), "ora", GINT_TO_POINTER(ora_inizio) );
-		
-		gtk_grid_attach(tabella, etichetta, inizio, campo->numero, 60, 1);
+/** Restituisce una stringa con la data.
+ * @param[in] calendario Calendario
+ * @return Data
+ */
+static char *get_stringa_data(GtkCalendar *calendario)
+{
+	unsigned int giorno, mese, anno;
 
-		inizio += 60;
-	}
+	gtk_calendar_get_date(calendario, &anno, &mese, &giorno);
+	mese++;
+	char *data = g_strdup_printf("%02d-%02d-%04d", giorno, mese, anno);
 	
+	return data;
 }
 
 /** Converte una stringa rappresentante un orario in intero.
@@ -352,199 +301,972 @@ static int controlla_formato_ora(const char *data)
 }
 
 
-/* Fine definizioni private */
+/** Converte una stringa rappresentante l'orario di chiusura in intero.
+ * Oltre ai formati di controlla_formato_ora() accetta la mezzanotte come 24:00
+ * @param[in] data Stringa
+ * @return minuti rappresentanti l'ora
+ */
+static int controlla_formato_chiusura(const char *data)
+{
+	if ( g_strcmp0(data, "24") == 0 || g_strcmp0(data, "24:00") == 0 )
+		return 24*60;
 
-/* Inizio definizioni pubbliche */
+	return controlla_formato_ora(data);
+}
 
-extern "C"
+/** Mostra la finestra degli orari del circolo o di un campo.
+ * @param[in] campo Campo, 0 per gli orari del circolo
+ */
+static void mostra_orari(campo_t *campo)
 {
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "finestra_orari") );
+	GtkToggleButton *propri = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "orari_propri") );
+	GtkEntry *apertura = GTK_ENTRY( gtk_builder_get_object(build, "apertura_o") );
+	GtkEntry *chiusura = GTK_ENTRY( gtk_builder_get_object(build, "chiusura_o") );
+	GtkSpinButton *passo = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "passo_o") );
 
+	const orari_t *orari = (campo != 0) ? get_orari_campo(campo) : &circolo->orari;
+	char *apertura_ = STRINGA_ORARIO(orari->apertura);
+	char *chiusura_ = STRINGA_ORARIO(orari->chiusura);
 
-void mostra_finestra(GtkMenuItem *actived, gpointer finestra)
+	gtk_entry_set_text(apertura, apertura_);
+	gtk_entry_set_text(chiusura, chiusura_);
+	gtk_spin_button_set_value(passo, orari->passo);
+
+	g_free(apertura_);
+	g_free(chiusura_);
+
+	g_object_set_data( gtk_builder_get_object(build, "orari_ok"), "campo", campo);
+
+	gtk_widget_show_all(window);
+
+	//la scelta tra orari propri e del circolo vale solo per i campi
+	gtk_widget_set_visible( GTK_WIDGET(propri), campo != 0 );
+	gtk_toggle_button_set_active(propri, campo == 0 || campo->orari.passo != 0);
+	handler_orari_propri(propri, NULL);
+}
+
+/** Inserisce una statistica nella lista della finestra di diagnostica.
+ * @param[in] stat Statistica
+ * @param[in,out] list_ Lista in cui inserirla
+ */
+static void insert_list_statistica(statistica_t *stat, gpointer list_)
 {
-	gtk_widget_show_all( GTK_WIDGET(finestra) );
+	GtkListStore *list = GTK_LIST_STORE(list_);
+	GtkTreeIter iter;
+	const char *tipi[] = {"contatore", "tempo (us)", "istogramma"};
+
+	g_mutex_lock(&stat->mutex);
+
+	char *n = g_strdup_printf("%" G_GUINT64_FORMAT, stat->conteggio);
+	gtk_list_store_append(list, &iter);
+	gtk_list_store_set(list, &iter, 0, stat->nome, 1, tipi[stat->tipo], 2, n, -1);
+	g_free(n);
+
+	if (stat->tipo != STAT_CONTATORE && stat->conteggio > 0){
+		gint64 valori[] = {stat->somma, stat->somma / (gint64) stat->conteggio, stat->minimo,
+				percentile_statistica(stat, 0.5), percentile_statistica(stat, 0.99), stat->massimo};
+
+		for (int i = 0; i < 6; i++){
+			char *valore = g_strdup_printf("%" G_GINT64_FORMAT, valori[i]);
+			gtk_list_store_set(list, &iter, 3 + i, valore, -1);
+			g_free(valore);
+		}
+	}
+
+	g_mutex_unlock(&stat->mutex);
 }
 
-gboolean nascondi_finestra(GtkWidget *widget, GdkEvent *event, gpointer user_data)
+/** Mostra un messaggio se un'operazione in background è fallita.
+ * Usata come completamento delle operazioni accodate all'esecutore
+ * @param[in] esito Esito dell'operazione
+ * @param[in] messaggio Messaggio da mostrare
+ */
+static void esito_operazione(bool esito, gpointer messaggio)
 {
-	gtk_widget_hide(widget);
-	return TRUE;
+	if (!esito)
+		finestra_errore( (const char *) messaggio );
 }
 
-void finestra_errore(const char messaggio[])
+/** Carica il circolo appena ripristinato.
+ * @param[in] esito Esito del ripristino
+ * @param[in] nome_cir Nome del circolo ripristinato
+ */
+static void fine_ripristino(bool esito, gpointer nome_cir)
 {
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "errore") );
-	GtkLabel *errore = GTK_LABEL( gtk_builder_get_object(build, "errore_m") );
-	gtk_label_set_text(errore, messaggio);
-	gtk_widget_show_all(window);	
+	if (esito)
+		handler_carica_circolo(NULL, nome_cir);
+	else
+		finestra_errore("Non è stato possibile ripristinare il backup");
+
+	g_free(nome_cir);
 }
 
-bool alert(const char messaggio[])
+/** Chiude il circolo attuale.
+ * Annulla l'eventuale caricamento in corso e dealloca il circolo
+ */
+static void chiudi_circolo()
 {
-	gint response;
+	gtk_tree_view_set_model( GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") ), NULL );
+	gtk_tree_view_set_model( GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_torneo_view") ), NULL );
 
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "alert") );
-	GtkLabel *errore = GTK_LABEL( gtk_builder_get_object(build, "alert_m") );
-	gtk_label_set_text(errore, messaggio);
-	gtk_widget_show_all(window);
+	if (modello_giocatori != 0)
+		g_object_unref(modello_giocatori);
+	if (modello_soci != 0)
+		g_object_unref(modello_soci);
+	if (modello_torneo != 0)
+		g_object_unref(modello_torneo);
 
-	response = gtk_dialog_run( GTK_DIALOG(window) );
-	if (response == GTK_RESPONSE_YES){
-		nascondi_finestra(window, NULL, NULL);
-		return true;
-	}
+	modello_giocatori = modello_soci = modello_filtrato = modello_torneo = 0;
 
-	nascondi_finestra(window, NULL, NULL);
+	//il torneo smette di osservare il circolo prima che venga deallocato
+	elimina_torneo(torneo);
+	torneo = 0;
 
-	return false;
-}
+	if (richieste != 0)
+		g_array_set_size(richieste, 0);
 
-void socio_toggle(GtkToggleButton *button, gpointer user_data)
-{
-	GtkWidget *circolo = GTK_WIDGET(gtk_builder_get_object(build, "circolo_g"));
-	GtkToggleButton *retta = GTK_TOGGLE_BUTTON(gtk_builder_get_object(build, "retta_g"));
-	bool stato = gtk_toggle_button_get_active(button);
-	
-	if (stato) {
-		gtk_toggle_button_set_inconsistent(retta, false);
-		gtk_widget_set_sensitive(circolo, false);
-	} else {
-		gtk_toggle_button_set_inconsistent(retta, true);
-		gtk_widget_set_sensitive(circolo, true);
+	//la tabella non deve più puntare ai campi del circolo
+	if (tabella != 0)
+		imposta_giorno_tabella(tabella, 0, 0);
+
+	if (caricamento != 0){
+		annulla_caricamento(caricamento);
+		caricamento = 0;
 	}
+
+	if ( circolo != 0 )
+		elimina_circolo(circolo);
 }
 
-gboolean handler_esci(GtkWidget *widget, GdkEvent *event, gpointer user_data)
+/** Abilita o disabilita le parti dell'interfaccia che richiedono il circolo completo.
+ * @param[in] stato TRUE per abilitare
+ */
+static void circolo_completo(bool stato)
 {
-	gtk_main_quit();
-	return TRUE;
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_modifica") ), stato);
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_backup") ), stato);
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_visualizza") ), stato);
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "calendario") ), stato);
 }
 
-void set_active(GtkWidget *widget, gpointer user_data)
+/** Aggiorna l'interfaccia durante il caricamento del circolo.
+ * La tabella del giorno viene disegnata appena arrivano campi e ore del giorno,
+ * il resto dell'interfaccia viene abilitato a caricamento finito
+ * @param[in] caricato Circolo in caricamento
+ * @param[in] fase Fase del caricamento
+ * @param[in] frazione Frazione dei file letti
+ */
+static void progresso_caricamento(circolo_t *caricato, fase_caricamento_t fase, double frazione, gpointer user_data)
 {
-	gtk_combo_box_set_active( GTK_COMBO_BOX(widget), 0);
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "carica_circolo") );
+	GtkProgressBar *barra = GTK_PROGRESS_BAR( gtk_builder_get_object(build, "progresso_caricamento") );
+
+	switch (fase){
+	case CARICAMENTO_GIORNO:
+		circolo = caricato;
+		disegna_tabella_ore();
+		gtk_progress_bar_set_text(barra, "Caricamento giocatori");
+		break;
+	case CARICAMENTO_GIOCATORI:
+		gtk_progress_bar_set_text(barra, "Caricamento giocatori");
+		break;
+	case CARICAMENTO_STORICO:
+		gtk_progress_bar_set_text(barra, "Caricamento storico");
+		break;
+	case CARICAMENTO_FINITO:
+		caricamento = 0;
+		nascondi_finestra(window, NULL, NULL);
+		circolo_completo(true);
+		//le ore degli altri giorni e i loro prenotanti sono ora presenti
+		aggiorna_tabella_ore(NULL, NULL);
+		break;
+	case CARICAMENTO_FALLITO:
+		caricamento = 0;
+		finestra_errore("Impossibile caricare il circolo");
+		break;
+	}
+
+	gtk_progress_bar_set_fraction(barra, frazione);
+
+	if (fase == CARICAMENTO_FINITO || fase == CARICAMENTO_FALLITO){
+		gtk_widget_set_visible( GTK_WIDGET(barra), FALSE );
+		gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "circolo_view") ), TRUE);
+		gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "button9") ), TRUE);
+	}
 }
 
-void handler_annulla(GtkButton *button, gpointer user_data)
+/** Aggiorna l'elenco dei circoli dopo l'eliminazione di un circolo.
+ * @param[in] esito Esito dell'eliminazione
+ */
+static void fine_elimina_circolo(bool esito, gpointer user_data)
 {
-	GtkWidget *window = gtk_widget_get_toplevel( GTK_WIDGET(button) );
-	gtk_widget_hide(window);
+	if (!esito)
+		finestra_errore("Non è stato possibile eliminare il circolo");
+
+	handler_apri_circolo(NULL, NULL);
 }
 
-void handler_nuovo_giocatore(GtkMenuItem *item, gpointer giocatore_)
+/** Prenota un'ora che si ripete nello stesso giorno della settimana fino alla data indicata.
+ * Prima di aggiungere la regola controlla che nessuna occorrenza si sovrapponga
+ * alle ore singole o alle altre regole del campo
+ * @param[in] orario Orario dell'ora
+ * @param[in] durata Durata dell'ora
+ * @param[in] giorno Giorno giuliano della prima occorrenza
+ * @param[in] giocatore Prenotante
+ * @param[in,out] campo Campo
+ */
+static void prenota_ricorrente(int orario, int durata, guint giorno, giocatore_t *giocatore, campo_t *campo)
 {
-	giocatore_t *giocatore = (giocatore_t *) giocatore_;
+	GtkEntry *entry_fine = GTK_ENTRY( gtk_builder_get_object(build, "fine_ora_n") );
+	GtkSpinButton *entry_settimane = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "settimane_ora_n") );
 
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "agg_giocatore") );
-	GObject *pulsante = gtk_builder_get_object(build, "giocatore_ok");
+	guint fine = giorno_da_data( gtk_entry_get_text(entry_fine) );
+	int settimane = gtk_spin_button_get_value_as_int(entry_settimane);
 
-	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_g") );
-	GtkEntry *entry_cognome = GTK_ENTRY( gtk_builder_get_object(build, "cognome_g") );
-	GtkEntry *entry_nascita = GTK_ENTRY( gtk_builder_get_object(build, "nascita_g") );
-	GtkEntry *entry_tessera = GTK_ENTRY( gtk_builder_get_object(build, "tessera_g") );
-	GtkEntry *entry_telefono = GTK_ENTRY( gtk_builder_get_object(build, "telefono_g") );
-	GtkEntry *entry_email = GTK_ENTRY( gtk_builder_get_object(build, "email_g") );
-	GtkEntry *entry_classifica = GTK_ENTRY( gtk_builder_get_object(build, "classifica_g") );
-	GtkEntry *entry_circolo = GTK_ENTRY( gtk_builder_get_object(build, "circolo_g") );
-	GtkToggleButton *toggle_socio = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "socio_g") );
-	GtkToggleButton *toggle_retta = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "retta_g") );
+	if (fine < giorno){
+		D1(cout<<"data di fine errata"<<endl)
+		finestra_errore("Data di fine della ripetizione errata");
+		return;
+	}
 
-	if (giocatore != NULL){
-		gtk_entry_set_text(entry_nome, giocatore->nome->str);
-		gtk_entry_set_text(entry_cognome, giocatore->cognome->str);
-		gtk_entry_set_text(entry_nascita, giocatore->nascita->str);
-		gtk_entry_set_text(entry_tessera, giocatore->tessera->str);
-		gtk_entry_set_text(entry_telefono, giocatore->telefono->str);
-		gtk_entry_set_text(entry_email, giocatore->email->str);
-		gtk_entry_set_text(entry_classifica, giocatore->classifica->str);
-		gtk_entry_set_text(entry_circolo, giocatore->circolo->str);
-		gtk_toggle_button_set_active(toggle_socio, giocatore->socio);
-		gtk_toggle_button_set_active(toggle_retta, giocatore->retta);
-	} 
-	else {
-		gtk_entry_set_text(entry_nome, "");
-		gtk_entry_set_text(entry_cognome, "");
-		gtk_entry_set_text(entry_nascita, "");
-		gtk_entry_set_text(entry_tessera, "");
-		gtk_entry_set_text(entry_telefono, "");
-		gtk_entry_set_text(entry_email, "");
-		gtk_entry_set_text(entry_classifica, "");
-		gtk_entry_set_text(entry_circolo, "");
-		gtk_toggle_button_set_active(toggle_socio, false);
-		gtk_toggle_button_set_active(toggle_retta, false);
+	//regola di prova, senza eccezioni, per il solo controllo dei conflitti
+	regola_t prova = {0, orario, durata, giorno, fine, 1 << ((giorno - 1) % 7), settimane,
+				g_array_new(FALSE, FALSE, sizeof(guint)), giocatore, 0};
+	guint conflitto = conflitto_regola(circolo, campo, &prova, 0);
+	g_array_free(prova.eccezioni, TRUE);
+
+	if (conflitto != 0){
+		char *data = data_da_giorno(conflitto);
+		char *messaggio = g_strdup_printf("Ora non disponibile il %s", data);
+		finestra_errore(messaggio);
+		g_free(messaggio);
+		g_free(data);
+		return;
+	}
 
+	regola_t *regola = aggiungi_regola(0, orario, durata, giorno, fine, prova.giorni, settimane, giocatore, 0, campo);
+	if (regola == 0){
+		finestra_errore("Impossibile creare la prenotazione ricorrente");
+		return;
 	}
 
-	g_object_set_data(pulsante, "giocatore", giocatore);	
+	salva_regola_async(regola, campo, circolo, esito_operazione,
+		(gpointer) "Attenzione! non è stato possibile salvare la prenotazione ricorrente su file");
+}
 
-	mostra_finestra(NULL, window);
+/** Inserisce il corso nella ListStore.
+ * @param[in] data_ Puntatore al corso
+ * @param[out] list_ Puntatore alla ListStore
+ */
+static void insert_list_corsi(gpointer data_, gpointer list_)
+{
+	GtkTreeIter iter;
+	corso_t *data = (corso_t *) data_;
+	GtkListStore *list = (GtkListStore *) list_;
+
+	gtk_list_store_append(list, &iter);
+	gtk_list_store_set(list, &iter,
+				0, data->nome->str,
+				1, dato_giocatore(data->istruttore, DATO_COGNOME),
+				2, (int) g_list_length(data->iscritti),
+				3, conta_lezioni(data, circolo),
+				4, data,
+				-1);
 }
 
-void handler_visualizza_giocatore(GtkButton *button, gpointer user_data)
+/** Ritorna il corso selezionato nell'elenco dei corsi.
+ * @return Corso selezionato, 0 se non ce ne sono
+ */
+static corso_t *corso_selezionato()
 {
-	GtkWidget *window = GTK_WIDGET( gtk_widget_get_toplevel( GTK_WIDGET(button) ) );
-	
 	GtkTreeIter iter;
 	GtkTreeModel *model;
-	giocatore_t *giocatore_sel = 0;
-	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") );
-	GtkTreeSelection *selezione = gtk_tree_view_get_selection(view);
+	corso_t *corso = 0;
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "corsi_view") );
 
-	if ( !gtk_tree_selection_get_selected(selezione, &model, &iter) ){
-		finestra_errore("Selezionare un elemento");
-		return;
-	}
-	gtk_tree_model_get(model, &iter, 7, &giocatore_sel, -1);
-	
-	nascondi_finestra(window, NULL, NULL);
+	if ( !gtk_tree_selection_get_selected(gtk_tree_view_get_selection(view), &model, &iter) )
+		return 0;
 
-	if(giocatore_sel != NULL)
-		handler_nuovo_giocatore(NULL, giocatore_sel);
-	
+	gtk_tree_model_get(model, &iter, 4, &corso, -1);
+
+	return corso;
 }
 
-void handler_aggiungi_giocatore(GtkButton *button, gpointer user_data)
+/** Ritorna il giocatore scelto nella finestra dei corsi.
+ * @return Giocatore scelto, 0 se non ce ne sono
+ */
+static giocatore_t *giocatore_corso()
 {
-	if (circolo == 0){
-		finestra_errore("Circolo non inizializzato");
-		return;
-	}
-
-	GObject *giocatore_ = gtk_builder_get_object(build, "giocatore_ok");
-	giocatore_t *vecchio_g = (giocatore_t *) g_object_get_data(giocatore_, "giocatore");
-
+	GtkTreeIter iter;
 	giocatore_t *giocatore = 0;
+	GtkComboBox *selezione = GTK_COMBO_BOX( gtk_builder_get_object(build, "giocatore_corso") );
 
-	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_g") );
-	GtkEntry *entry_cognome = GTK_ENTRY( gtk_builder_get_object(build, "cognome_g") );
-	GtkEntry *entry_nascita = GTK_ENTRY( gtk_builder_get_object(build, "nascita_g") );
-	GtkEntry *entry_tessera = GTK_ENTRY( gtk_builder_get_object(build, "tessera_g") );
-	GtkEntry *entry_telefono = GTK_ENTRY( gtk_builder_get_object(build, "telefono_g") );
-	GtkEntry *entry_email = GTK_ENTRY( gtk_builder_get_object(build, "email_g") );
-	GtkEntry *entry_classifica = GTK_ENTRY( gtk_builder_get_object(build, "classifica_g") );
-	GtkEntry *entry_circolo = GTK_ENTRY( gtk_builder_get_object(build, "circolo_g") );
-	GtkToggleButton *toggle_socio = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "socio_g") );
-	GtkToggleButton *toggle_retta = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "retta_g") );
+	if ( !gtk_combo_box_get_active_iter(selezione, &iter) )
+		return 0;
 
-	const char *nome = gtk_entry_get_text(entry_nome);
-	const char *cognome = gtk_entry_get_text(entry_cognome);
-	const char *nascita = gtk_entry_get_text(entry_nascita);
-	const char *tessera = gtk_entry_get_text(entry_tessera);
-	const char *telefono = gtk_entry_get_text(entry_telefono);
-	const char *email = gtk_entry_get_text(entry_email);
-	const char *classifica = gtk_entry_get_text(entry_classifica);
-	const char *circolo_g = gtk_entry_get_text(entry_circolo);
-	bool socio = gtk_toggle_button_get_active(toggle_socio);
-	bool retta = gtk_toggle_button_get_active(toggle_retta);
+	gtk_tree_model_get(gtk_combo_box_get_model(selezione), &iter, 7, &giocatore, -1);
 
-	if (nome[0] == '\0' || cognome[0] == '\0'){
-		finestra_errore("Inserisci nome e cognome");
+	return giocatore;
+}
+
+/** Mostra l'errore di un'operazione sulle lezioni di un corso.
+ * @param[in] conflitto Giorno della prima sovrapposizione, 0 se l'errore è negli orari
+ */
+static void errore_lezioni(guint conflitto)
+{
+	if (conflitto == 0){
+		finestra_errore("Orari delle lezioni non validi per i campi scelti");
 		return;
 	}
 
-	if (socio)
-		giocatore = aggiungi_socio(nome, cognome, nascita, tessera, telefono, email, classifica, retta, vecchio_g, circolo);
-	else
+	char *data = data_da_giorno(conflitto);
+	char *messaggio = g_strdup_printf("Le lezioni si sovrappongono ad altre prenotazioni il %s", data);
+	finestra_errore(messaggio);
+	g_free(messaggio);
+	g_free(data);
+}
+
+/** Ritorna il cognome di un giocatore del torneo.
+ * @param[in] indice Indice del giocatore nel tabellone
+ * @return Cognome, "?" se il giocatore è stato eliminato
+ */
+static const char *cognome_torneo(int indice)
+{
+	giocatore_t *giocatore = (giocatore_t *) g_ptr_array_index(torneo->giocatori, indice);
+
+	return giocatore != 0 ? dato_giocatore(giocatore, DATO_COGNOME) : "?";
+}
+
+/** Mostra gli incontri del torneo con il loro campo e orario.
+ */
+static void mostra_incontri()
+{
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "incontri") );
+
+	gtk_list_store_clear(list);
+
+	if (torneo == 0)
+		return;
+
+	for (guint i = 0; i < torneo->incontri->len; i++){
+		incontro_t *incontro = &g_array_index(torneo->incontri, incontro_t, i);
+		if (!incontro->da_giocare)
+			continue;
+
+		const int *partecipanti = &g_array_index(torneo->partecipanti, int, incontro->primo);
+		char *nomi = (incontro->n_partecipanti == 2) ?
+				g_strdup_printf("%s - %s", cognome_torneo(partecipanti[0]), cognome_torneo(partecipanti[1])) :
+				g_strdup_printf("Vincenti del turno %d", incontro->turno);
+		char *data = (incontro->campo != 0) ? data_da_giorno(incontro->giorno) : g_strdup("");
+		char *orario = (incontro->campo != 0) ? STRINGA_ORARIO(incontro->orario) : g_strdup("");
+
+		GtkTreeIter iter;
+		gtk_list_store_append(list, &iter);
+		gtk_list_store_set(list, &iter,
+					0, incontro->turno + 1,
+					1, nomi,
+					2, (incontro->campo != 0) ? incontro->campo->numero : 0,
+					3, data,
+					4, orario,
+					-1);
+
+		g_free(nomi);
+		g_free(data);
+		g_free(orario);
+	}
+}
+
+/** Legge i vincoli del torneo dalla finestra.
+ * Il terreno scelto è preferito, oppure l'unico ammesso se richiesto
+ * @param[out] vincoli Vincoli letti
+ * @return FALSE se i dati non sono validi, dopo aver mostrato l'errore
+ */
+static bool leggi_vincoli_torneo(vincoli_torneo_t &vincoli)
+{
+	GtkEntry *entry_inizio = GTK_ENTRY( gtk_builder_get_object(build, "inizio_torneo") );
+	GtkEntry *entry_fine = GTK_ENTRY( gtk_builder_get_object(build, "fine_torneo") );
+	GtkEntry *entry_durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_torneo") );
+	GtkEntry *entry_riposo = GTK_ENTRY( gtk_builder_get_object(build, "riposo_torneo") );
+	GtkComboBox *entry_terreno = GTK_COMBO_BOX( gtk_builder_get_object(build, "terreno_torneo") );
+	GtkToggleButton *entry_solo = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "solo_terreno_torneo") );
+
+	vincoli.inizio = giorno_da_data( gtk_entry_get_text(entry_inizio) );
+	vincoli.fine = giorno_da_data( gtk_entry_get_text(entry_fine) );
+	vincoli.durata = controlla_formato_ora( gtk_entry_get_text(entry_durata) );
+	vincoli.riposo = controlla_formato_ora( gtk_entry_get_text(entry_riposo) );
+
+	//la prima voce indica nessun terreno preferito, le altre seguono terreno_t
+	int terreno = gtk_combo_box_get_active(entry_terreno);
+	vincoli.preferiti = (terreno > 0) ? 1 << (terreno - 1) : 0;
+	vincoli.terreni = gtk_toggle_button_get_active(entry_solo) ? vincoli.preferiti : 0;
+
+	vincoli.indisponibilita = 0;
+	vincoli.n_indisponibilita = 0;
+
+	if (vincoli.inizio == 0 || vincoli.fine < vincoli.inizio){
+		finestra_errore("Periodo del torneo errato");
+		return false;
+	}
+
+	if (vincoli.durata <= 0 || vincoli.riposo < 0){
+		finestra_errore("Durata degli incontri o riposo errati");
+		return false;
+	}
+
+	return true;
+}
+
+/** Pianifica il torneo da un giorno e un orario e scrive le prenotazioni.
+ * @param[in] vincoli Vincoli del torneo
+ * @param[in] giorno Giorno giuliano da cui pianificare
+ * @param[in] orario Orario in minuti da cui pianificare
+ */
+static void pianifica(const vincoli_torneo_t &vincoli, guint giorno, int orario)
+{
+	int non_pianificato = -1;
+
+	if ( !pianifica_torneo(torneo, &vincoli, giorno, orario, non_pianificato) ){
+		if (non_pianificato >= 0){
+			int turno = g_array_index(torneo->incontri, incontro_t, non_pianificato).turno;
+			char *messaggio = g_strdup_printf("Un incontro del turno %d non trova posto nel periodo del torneo", turno + 1);
+			finestra_errore(messaggio);
+			g_free(messaggio);
+		}
+		else
+			finestra_errore("Impossibile pianificare il torneo");
+	}
+	else if ( prenota_torneo(torneo, esito_operazione, (gpointer) "Impossibile salvare le prenotazioni del torneo") < 0 )
+		finestra_errore("L'organizzatore del torneo è stato eliminato");
+
+	mostra_incontri();
+	aggiorna_tabella_ore(NULL, NULL);
+}
+
+/** Ritorna il giorno selezionato nel calendario.
+ * @return Giorno giuliano
+ */
+static guint giorno_selezionato()
+{
+	char *data = get_stringa_data( GTK_CALENDAR( gtk_builder_get_object(build, "calendario") ) );
+	guint giorno = giorno_da_data(data);
+	g_free(data);
+
+	return giorno;
+}
+
+/** Mostra le richieste di prenotazione con il campo e l'orario assegnati.
+ */
+static void mostra_richieste()
+{
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "richieste") );
+
+	gtk_list_store_clear(list);
+
+	for (guint i = 0; i < richieste->len; i++){
+		richiesta_t *richiesta = &g_array_index(richieste, richiesta_t, i);
+		GString *preferenze = g_string_new("");
+
+		for (int t = ERBA; t <= CEMENTO; t++)
+			if (richiesta->terreni & (1 << t))
+				g_string_append_printf(preferenze, "%s ", terreni[t]);
+		for (int c = INDOOR; c <= OUTDOOR; c++)
+			if (richiesta->coperture & (1 << c))
+				g_string_append_printf(preferenze, "%s ", coperture[c]);
+		if (richiesta->vincolante)
+			g_string_append(preferenze, "(vincolante)");
+
+		char *orario = STRINGA_ORARIO(richiesta->orario);
+		char *durata = STRINGA_ORARIO(richiesta->durata);
+		char *campo = (richiesta->campo != 0) ? g_strdup_printf("%d", richiesta->campo->numero) : g_strdup("");
+		char *inizio = (richiesta->campo != 0) ? STRINGA_ORARIO(richiesta->inizio) : g_strdup("");
+
+		GtkTreeIter iter;
+		gtk_list_store_append(list, &iter);
+		gtk_list_store_set(list, &iter,
+					0, dato_giocatore(richiesta->prenotante, DATO_COGNOME),
+					1, orario,
+					2, durata,
+					3, preferenze->str,
+					4, campo,
+					5, inizio,
+					6, i,
+					-1);
+
+		g_free(orario);
+		g_free(durata);
+		g_free(campo);
+		g_free(inizio);
+		g_string_free(preferenze, true);
+	}
+}
+
+/** Toglie le richieste di un giocatore che sta per essere eliminato.
+ * @param[in] giocatore Giocatore
+ */
+static void togli_richieste_giocatore(giocatore_t *giocatore)
+{
+	for (guint i = richieste != 0 ? richieste->len : 0; i > 0; i--)
+		if (g_array_index(richieste, richiesta_t, i - 1).prenotante == giocatore)
+			g_array_remove_index(richieste, i - 1);
+}
+
+/** Mostra l'esito dell'allocazione delle richieste.
+ * @param[in] testo Testo da mostrare
+ */
+static void esito_allocazione(const char testo[])
+{
+	gtk_label_set_text( GTK_LABEL( gtk_builder_get_object(build, "esito_allocazione") ), testo );
+}
+
+/** Ritorna il colore di una cella della mappa di occupazione.
+ * @param[in] percentuale Percentuale di occupazione, -1 se il campo è chiuso
+ * @return Colore, da liberare con g_free()
+ */
+static char *colore_occupazione(int percentuale)
+{
+	if (percentuale < 0)
+		return g_strdup("#d0d0d0");
+
+	//dal bianco dei campi vuoti al rosso dei campi pieni
+	int chiaro = 255 - MIN(percentuale, 100) * 2;
+	return g_strdup_printf("#ff%02x%02x", chiaro, chiaro);
+}
+
+/** Aggiunge una riga ai totali di occupazione.
+ */
+static void aggiungi_totale(GtkListStore *list, const char voce[], guint prenotati, guint disponibili)
+{
+	int percentuale = percentuale_occupazione(prenotati, disponibili);
+	char *perc = (percentuale < 0) ? g_strdup("-") : g_strdup_printf("%d%%", percentuale);
+
+	GtkTreeIter iter;
+	gtk_list_store_append(list, &iter);
+	gtk_list_store_set(list, &iter,
+				0, voce,
+				1, prenotati / 60,
+				2, disponibili / 60,
+				3, perc,
+				-1);
+
+	g_free(perc);
+}
+
+/** Mostra la mappa di occupazione per fascia oraria e giorno della settimana e i totali.
+ * @param[in] occupazione Occupazione calcolata
+ * @param[in] selezionato Indice del campo da mostrare nella mappa, -1 per tutti i campi
+ */
+static void mostra_occupazione(const occupazione_t *occupazione, int selezionato)
+{
+	GtkListStore *mappa = GTK_LIST_STORE( gtk_builder_get_object(build, "mappa_occupazione") );
+	GtkListStore *totali = GTK_LIST_STORE( gtk_builder_get_object(build, "totali_occupazione") );
+	const char *giorni[] = {"lunedì", "martedì", "mercoledì", "giovedì", "venerdì", "sabato", "domenica"};
+
+	gtk_list_store_clear(mappa);
+	gtk_list_store_clear(totali);
+
+	guint prenotati[GIORNI_SETTIMANA][ORE_GIORNO] = {{0}};
+	guint disponibili[GIORNI_SETTIMANA][ORE_GIORNO] = {{0}};
+
+	for (int c = 0; c < occupazione->n_campi; c++){
+		const occupazione_campo_t *occ = &occupazione->campi[c];
+		if (selezionato >= 0 && selezionato != c)
+			continue;
+
+		for (int g = 0; g < GIORNI_SETTIMANA; g++)
+			for (int h = 0; h < ORE_GIORNO; h++){
+				prenotati[g][h] += occ->prenotati[g][h];
+				disponibili[g][h] += occ->disponibili[g][h];
+			}
+	}
+
+	int picco = -1, giorno_picco = 0, ora_picco = 0;
+
+	for (int h = 0; h < ORE_GIORNO; h++){
+		bool aperto = false;
+		for (int g = 0; g < GIORNI_SETTIMANA; g++)
+			aperto = aperto || disponibili[g][h] != 0;
+		if (!aperto)
+			continue;
+
+		char *fascia = g_strdup_printf("%02d:00 - %02d:00", h, h + 1);
+		GtkTreeIter iter;
+		gtk_list_store_append(mappa, &iter);
+		gtk_list_store_set(mappa, &iter, 0, fascia, -1);
+		g_free(fascia);
+
+		for (int g = 0; g < GIORNI_SETTIMANA; g++){
+			int percentuale = percentuale_occupazione(prenotati[g][h], disponibili[g][h]);
+			char *testo = (percentuale < 0) ? g_strdup("") : g_strdup_printf("%d%%", percentuale);
+			char *colore = colore_occupazione(percentuale);
+
+			gtk_list_store_set(mappa, &iter, 1 + g, testo, 1 + GIORNI_SETTIMANA + g, colore, -1);
+
+			if (percentuale > picco){
+				picco = percentuale;
+				giorno_picco = g;
+				ora_picco = h;
+			}
+
+			g_free(testo);
+			g_free(colore);
+		}
+	}
+
+	for (int c = 0; c < occupazione->n_campi; c++){
+		const occupazione_campo_t *occ = &occupazione->campi[c];
+		char *voce = g_strdup_printf("Campo %d", occ->campo->numero);
+		aggiungi_totale(totali, voce, occ->totale_prenotati, occ->totale_disponibili);
+		g_free(voce);
+	}
+
+	for (int t = ERBA; t <= CEMENTO; t++)
+		if (occupazione->disponibili_terreno[t] != 0)
+			aggiungi_totale(totali, terreni[t], occupazione->prenotati_terreno[t], occupazione->disponibili_terreno[t]);
+
+	for (int c = INDOOR; c <= OUTDOOR; c++)
+		if (occupazione->disponibili_copertura[c] != 0)
+			aggiungi_totale(totali, coperture[c], occupazione->prenotati_copertura[c], occupazione->disponibili_copertura[c]);
+
+	GtkLabel *label = GTK_LABEL( gtk_builder_get_object(build, "picco_occupazione") );
+	char *testo = (picco < 0) ? g_strdup("Nessun campo aperto nel periodo") :
+				g_strdup_printf("Fascia più occupata: %s dalle %02d:00 (%d%%)", giorni[giorno_picco], ora_picco, picco);
+	gtk_label_set_text(label, testo);
+	g_free(testo);
+}
+
+/** Esce dal main loop quando le scritture accodate sono state completate.
+ */
+static void esci_al_termine(bool esito, gpointer dati)
+{
+	gtk_main_quit();
+}
+
+/** Crea il circolo con i dati inseriti dopo aver controllato che il nome sia libero.
+ * @param[in] esistente TRUE se esiste già un circolo con il nome scelto
+ * @param[in] finestra Finestra di creazione del circolo, resa insensibile durante il controllo
+ */
+static void crea_circolo_controllato(bool esistente, gpointer finestra)
+{
+	gtk_widget_set_sensitive(GTK_WIDGET(finestra), TRUE);
+
+	if (esistente){
+		finestra_errore("Esiste già un circolo con questo nome");
+		return;
+	}
+
+	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_cir") );
+	GtkEntry *entry_indirizzo = GTK_ENTRY( gtk_builder_get_object(build, "indirizzo_cir") );
+	GtkEntry *entry_email = GTK_ENTRY( gtk_builder_get_object(build, "email_cir") );
+	GtkEntry *entry_telefono = GTK_ENTRY( gtk_builder_get_object(build, "telefono_cir") );
+
+	const char *nome = gtk_entry_get_text(entry_nome);
+	const char *indirizzo = gtk_entry_get_text(entry_indirizzo);
+	const char *email = gtk_entry_get_text(entry_email);
+	const char *telefono = gtk_entry_get_text(entry_telefono);
+
+	if ( circolo != 0 && !alert("Verrà chiuso il circolo attuale. Continuare?") )
+		return;
+
+	chiudi_circolo();
+
+	if ( (circolo = inizializza_circolo(nome, indirizzo, email, telefono)) == 0 )
+		finestra_errore("Impossibile creare il circolo");
+
+	salva_circolo_async(circolo, esito_operazione,
+		(gpointer) "Attenzione! non è stato possibile salvare il circolo su file\n alla chiusura del programma \
+				il circolo non sarà più recuperabile");
+
+	nascondi_finestra( GTK_WIDGET(finestra), NULL, NULL);
+
+	handler_carica_circolo(NULL, (void *) nome);
+}
+
+/** Mostra la finestra di scelta del circolo con i circoli elencati.
+ * @param[in] esito Esito dell'elenco
+ * @param[in] circoli_ Posto dei nomi dei circoli, da deallocare
+ */
+static void mostra_circoli(bool esito, gpointer circoli_)
+{
+	GPtrArray **circoli = (GPtrArray **) circoli_;
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "carica_circolo") );
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "circoli") );
+	GtkTreeIter iter;
+
+	gtk_list_store_clear(list);
+
+	if (*circoli != 0){
+		for (guint i = 0; i < (*circoli)->len; i++){
+			gtk_list_store_append(list, &iter);
+			gtk_list_store_set(list, &iter, 0, (const char *) g_ptr_array_index(*circoli, i), -1);
+		}
+
+		g_ptr_array_free(*circoli, TRUE);
+	}
+
+	g_free(circoli);
+
+	mostra_finestra(NULL, window);
+}
+
+/** Dati del ripristino in attesa dei controlli sul file di backup.
+ */
+struct ripristino_t {
+	char *file;
+	char *nome_cir;
+};
+
+/** Ripristina il backup dopo aver controllato se il suo circolo è già presente.
+ * Il circolo viene caricato, e nome_cir deallocato, al termine del ripristino
+ * @param[in] esistente TRUE se il circolo del backup è già presente
+ * @param[in] rip_ Dati del ripristino, da deallocare
+ */
+static void ripristina_controllato(bool esistente, gpointer rip_)
+{
+	ripristino_t *rip = (ripristino_t *) rip_;
+
+	if (esistente){
+		D1(cout<<"Circolo esistente"<<endl)
+		if ( alert("Questo backup fa riferimento ad un circolo presente. Vuoi sovrascriverlo?") )
+			elimina_file_circolo_async(rip->nome_cir, NULL, NULL);
+		else {
+			g_free(rip->nome_cir);
+			rip->nome_cir = 0;
+		}
+	}
+
+	if (rip->nome_cir != 0)
+		ripristina_async(rip->file, rip->nome_cir, fine_ripristino, rip->nome_cir);
+
+	g_free(rip->file);
+	g_free(rip);
+}
+
+/** Controlla se il circolo del backup è già presente dopo averne letto il nome.
+ * @param[in] esito Esito della lettura del nome
+ * @param[in] rip_ Dati del ripristino
+ */
+static void nome_backup_letto(bool esito, gpointer rip_)
+{
+	ripristino_t *rip = (ripristino_t *) rip_;
+
+	if (!esito){
+		finestra_errore("Il file di backup non è valido");
+		g_free(rip->file);
+		g_free(rip);
+		return;
+	}
+
+	circolo_esistente_async(rip->nome_cir, ripristina_controllato, rip);
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni pubbliche */
+
+extern "C"
+{
+
+
+void mostra_finestra(GtkMenuItem *actived, gpointer finestra)
+{
+	gtk_widget_show_all( GTK_WIDGET(finestra) );
+}
+
+gboolean nascondi_finestra(GtkWidget *widget, GdkEvent *event, gpointer user_data)
+{
+	gtk_widget_hide(widget);
+	return TRUE;
+}
+
+void finestra_errore(const char messaggio[])
+{
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "errore") );
+	GtkLabel *errore = GTK_LABEL( gtk_builder_get_object(build, "errore_m") );
+	gtk_label_set_text(errore, messaggio);
+	gtk_widget_show_all(window);	
+}
+
+bool alert(const char messaggio[])
+{
+	gint response;
+
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "alert") );
+	GtkLabel *errore = GTK_LABEL( gtk_builder_get_object(build, "alert_m") );
+	gtk_label_set_text(errore, messaggio);
+	gtk_widget_show_all(window);
+
+	response = gtk_dialog_run( GTK_DIALOG(window) );
+	if (response == GTK_RESPONSE_YES){
+		nascondi_finestra(window, NULL, NULL);
+		return true;
+	}
+
+	nascondi_finestra(window, NULL, NULL);
+
+	return false;
+}
+
+void socio_toggle(GtkToggleButton *button, gpointer user_data)
+{
+	GtkWidget *circolo = GTK_WIDGET(gtk_builder_get_object(build, "circolo_g"));
+	GtkToggleButton *retta = GTK_TOGGLE_BUTTON(gtk_builder_get_object(build, "retta_g"));
+	bool stato = gtk_toggle_button_get_active(button);
+	
+	if (stato) {
+		gtk_toggle_button_set_inconsistent(retta, false);
+		gtk_widget_set_sensitive(circolo, false);
+	} else {
+		gtk_toggle_button_set_inconsistent(retta, true);
+		gtk_widget_set_sensitive(circolo, true);
+	}
+}
+
+gboolean handler_esci(GtkWidget *widget, GdkEvent *event, gpointer user_data)
+{
+	static bool in_uscita = false;
+
+	//una seconda richiesta di chiusura durante l'attesa viene ignorata
+	if (in_uscita)
+		return TRUE;
+	in_uscita = true;
+
+	if (caricamento != 0){
+		annulla_caricamento(caricamento);
+		caricamento = 0;
+	}
+
+	//le scritture accodate vanno completate prima di uscire, senza bloccare il main loop
+	gtk_widget_set_sensitive(gtk_widget_get_toplevel(widget), FALSE);
+	al_termine_esecutore(esci_al_termine, NULL);
+	return TRUE;
+}
+
+void set_active(GtkWidget *widget, gpointer user_data)
+{
+	gtk_combo_box_set_active( GTK_COMBO_BOX(widget), 0);
+}
+
+void handler_annulla(GtkButton *button, gpointer user_data)
+{
+	GtkWidget *window = gtk_widget_get_toplevel( GTK_WIDGET(button) );
+	gtk_widget_hide(window);
+}
+
+void handler_nuovo_giocatore(GtkMenuItem *item, gpointer giocatore_)
+{
+	giocatore_t *giocatore = (giocatore_t *) giocatore_;
+
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "agg_giocatore") );
+	GObject *pulsante = gtk_builder_get_object(build, "giocatore_ok");
+
+	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_g") );
+	GtkEntry *entry_cognome = GTK_ENTRY( gtk_builder_get_object(build, "cognome_g") );
+	GtkEntry *entry_nascita = GTK_ENTRY( gtk_builder_get_object(build, "nascita_g") );
+	GtkEntry *entry_tessera = GTK_ENTRY( gtk_builder_get_object(build, "tessera_g") );
+	GtkEntry *entry_telefono = GTK_ENTRY( gtk_builder_get_object(build, "telefono_g") );
+	GtkEntry *entry_email = GTK_ENTRY( gtk_builder_get_object(build, "email_g") );
+	GtkEntry *entry_classifica = GTK_ENTRY( gtk_builder_get_object(build, "classifica_g") );
+	GtkEntry *entry_circolo = GTK_ENTRY( gtk_builder_get_object(build, "circolo_g") );
+	GtkToggleButton *toggle_socio = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "socio_g") );
+	GtkToggleButton *toggle_retta = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "retta_g") );
+
+	if (giocatore != NULL){
+		gtk_entry_set_text(entry_nome, dato_giocatore(giocatore, DATO_NOME));
+		gtk_entry_set_text(entry_cognome, dato_giocatore(giocatore, DATO_COGNOME));
+		gtk_entry_set_text(entry_nascita, dato_giocatore(giocatore, DATO_NASCITA));
+		gtk_entry_set_text(entry_tessera, dato_giocatore(giocatore, DATO_TESSERA));
+		gtk_entry_set_text(entry_telefono, dato_giocatore(giocatore, DATO_TELEFONO));
+		gtk_entry_set_text(entry_email, dato_giocatore(giocatore, DATO_EMAIL));
+		gtk_entry_set_text(entry_classifica, dato_giocatore(giocatore, DATO_CLASSIFICA));
+		gtk_entry_set_text(entry_circolo, dato_giocatore(giocatore, DATO_CIRCOLO));
+		gtk_toggle_button_set_active(toggle_socio, giocatore->socio);
+		gtk_toggle_button_set_active(toggle_retta, giocatore->retta);
+	} 
+	else {
+		gtk_entry_set_text(entry_nome, "");
+		gtk_entry_set_text(entry_cognome, "");
+		gtk_entry_set_text(entry_nascita, "");
+		gtk_entry_set_text(entry_tessera, "");
+		gtk_entry_set_text(entry_telefono, "");
+		gtk_entry_set_text(entry_email, "");
+		gtk_entry_set_text(entry_classifica, "");
+		gtk_entry_set_text(entry_circolo, "");
+		gtk_toggle_button_set_active(toggle_socio, false);
+		gtk_toggle_button_set_active(toggle_retta, false);
+
+	}
+
+	g_object_set_data(pulsante, "giocatore", giocatore);	
+
+	mostra_finestra(NULL, window);
+}
+
+void handler_visualizza_giocatore(GtkButton *button, gpointer user_data)
+{
+	GtkWidget *window = GTK_WIDGET( gtk_widget_get_toplevel( GTK_WIDGET(button) ) );
+	
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	giocatore_t *giocatore_sel = 0;
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") );
+	GtkTreeSelection *selezione = gtk_tree_view_get_selection(view);
+
+	if ( !gtk_tree_selection_get_selected(selezione, &model, &iter) ){
+		finestra_errore("Selezionare un elemento");
+		return;
+	}
+	gtk_tree_model_get(model, &iter, 7, &giocatore_sel, -1);
+	
+	nascondi_finestra(window, NULL, NULL);
+
+	if(giocatore_sel != NULL)
+		handler_nuovo_giocatore(NULL, giocatore_sel);
+	
+}
+
+void handler_aggiungi_giocatore(GtkButton *button, gpointer user_data)
+{
+	if (circolo == 0){
+		finestra_errore("Circolo non inizializzato");
+		return;
+	}
+
+	GObject *giocatore_ = gtk_builder_get_object(build, "giocatore_ok");
+	giocatore_t *vecchio_g = (giocatore_t *) g_object_get_data(giocatore_, "giocatore");
+
+	giocatore_t *giocatore = 0;
+
+	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_g") );
+	GtkEntry *entry_cognome = GTK_ENTRY( gtk_builder_get_object(build, "cognome_g") );
+	GtkEntry *entry_nascita = GTK_ENTRY( gtk_builder_get_object(build, "nascita_g") );
+	GtkEntry *entry_tessera = GTK_ENTRY( gtk_builder_get_object(build, "tessera_g") );
+	GtkEntry *entry_telefono = GTK_ENTRY( gtk_builder_get_object(build, "telefono_g") );
+	GtkEntry *entry_email = GTK_ENTRY( gtk_builder_get_object(build, "email_g") );
+	GtkEntry *entry_classifica = GTK_ENTRY( gtk_builder_get_object(build, "classifica_g") );
+	GtkEntry *entry_circolo = GTK_ENTRY( gtk_builder_get_object(build, "circolo_g") );
+	GtkToggleButton *toggle_socio = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "socio_g") );
+	GtkToggleButton *toggle_retta = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "retta_g") );
+
+	const char *nome = gtk_entry_get_text(entry_nome);
+	const char *cognome = gtk_entry_get_text(entry_cognome);
+	const char *nascita = gtk_entry_get_text(entry_nascita);
+	const char *tessera = gtk_entry_get_text(entry_tessera);
+	const char *telefono = gtk_entry_get_text(entry_telefono);
+	const char *email = gtk_entry_get_text(entry_email);
+	const char *classifica = gtk_entry_get_text(entry_classifica);
+	const char *circolo_g = gtk_entry_get_text(entry_circolo);
+	bool socio = gtk_toggle_button_get_active(toggle_socio);
+	bool retta = gtk_toggle_button_get_active(toggle_retta);
+
+	if (nome[0] == '\0' || cognome[0] == '\0'){
+		finestra_errore("Inserisci nome e cognome");
+		return;
+	}
+
+	if (socio)
+		giocatore = aggiungi_socio(nome, cognome, nascita, tessera, telefono, email, classifica, retta, vecchio_g, circolo);
+	else
 		giocatore = aggiungi_giocatore(nome, cognome, nascita, tessera, telefono, email, classifica, circolo_g, vecchio_g,
 						circolo);
 
@@ -553,606 +1275,1039 @@ void handler_aggiungi_giocatore(GtkButton *button, gpointer user_data)
 		return;
 	}
 
-	if ( !salva_giocatore(giocatore, circolo) )
-		finestra_errore("Attenzione! non è stato possibile salvare il giocatore su file\n alla chiusura del programma \
-				il giocatore non sarà più recuperabile");
+	salva_giocatore_async(giocatore, circolo, esito_operazione,
+		(gpointer) "Attenzione! non è stato possibile salvare il giocatore su file\n alla chiusura del programma \
+				il giocatore non sarà più recuperabile");
+
+	nascondi_finestra( gtk_widget_get_toplevel( GTK_WIDGET(button) ), NULL, NULL);	
+}
+
+void handler_inizializza_cir(GtkButton *button, gpointer user_data)
+{
+	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_cir") );
+
+	const char *nome = gtk_entry_get_text(entry_nome);
+
+	if (nome[0] == '\0'){
+		finestra_errore("Inserire un nome per il circolo");
+		return;
+	}
+
+	//il circolo viene creato al termine del controllo, la finestra resta ferma fino ad allora
+	GtkWidget *finestra = gtk_widget_get_toplevel( GTK_WIDGET(button) );
+	gtk_widget_set_sensitive(finestra, FALSE);
+	circolo_esistente_async(nome, crea_circolo_controllato, finestra);
+}
+
+void handler_nuovo_campo(GtkMenuItem *item, gpointer campo_)
+{
+	campo_t *campo = (campo_t *) campo_;
+
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "agg_campo") );
+	GObject *pulsante = gtk_builder_get_object(build, "campo_ok");
+
+	GtkSpinButton *entry_numero = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "numero_c") );
+	GtkComboBox *entry_copertura = GTK_COMBO_BOX( gtk_builder_get_object(build, "copertura_c") );
+	GtkComboBox *entry_terreno = GTK_COMBO_BOX( gtk_builder_get_object(build, "terreno_c") );
+	GtkEntry *entry_note = GTK_ENTRY( gtk_builder_get_object(build, "note_c") );
+	
+	if (campo != NULL){
+		gtk_spin_button_set_value(entry_numero, campo->numero);
+		gtk_combo_box_set_active(entry_copertura, campo->copertura);
+		gtk_combo_box_set_active(entry_terreno, campo->terreno);
+		gtk_entry_set_text(entry_note, campo->note->str);
+	} 
+	else {
+		gtk_spin_button_set_value(entry_numero, circolo->n_campi + 1);
+		gtk_combo_box_set_active(entry_copertura, 0);
+		gtk_combo_box_set_active(entry_terreno, 0);
+		gtk_entry_set_text(entry_note, "");
+	}
+
+	g_object_set_data(pulsante, "campo", campo);	
+
+
+	mostra_finestra(NULL, window);
+}
+
+void handler_visualizza_campo(GtkButton *button, gpointer user_data)
+{
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_c") );
+	
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	campo_t *campo_sel = 0;
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "campi_view") );
+	GtkTreeSelection *selezione = gtk_tree_view_get_selection(view);
+
+	if ( !gtk_tree_selection_get_selected(selezione, &model, &iter) ){
+		finestra_errore("Selezionare un elemento");
+		return;
+	}
+	gtk_tree_model_get(model, &iter, 3, &campo_sel, -1);
+	
+	nascondi_finestra(window, NULL, NULL);
+
+	if(campo_sel != NULL)
+		handler_nuovo_campo(NULL, campo_sel);
+	
+}
+
+void aggiorna_tabella_ore(GtkCalendar *calendario, gpointer user_data)
+{
+	TEMPO("handler: aggiorna_tabella_ore")
+	TRACCIA("aggiorna_tabella_ore", "tabella", 0)
+
+	if (tabella == 0)
+		return;
+
+	if (!calendario)
+		calendario = GTK_CALENDAR( gtk_builder_get_object(build, "calendario") );
+
+	char *data = get_stringa_data(calendario);
+	D1(cout<<"Giorno aquisito"<<endl)
+
+	imposta_giorno_tabella(tabella, circolo, data);
+
+	g_free(data);
+}
+
+void disegna_tabella_ore()
+{
+	if (tabella == 0){
+		GtkContainer *finestra = GTK_CONTAINER( gtk_builder_get_object(build, "tabella_ore") );
+		GList *figli = gtk_container_get_children(finestra);
+
+		gtk_widget_destroy( GTK_WIDGET(figli->data) );
+		g_list_free(figli);
+
+		tabella = crea_tabella_ore(handler_mostra_ora, NULL);
+		imposta_giorni_tabella(tabella,
+			gtk_spin_button_get_value_as_int( GTK_SPIN_BUTTON( gtk_builder_get_object(build, "giorni_tabella") ) ) );
+		gtk_container_add(finestra, tabella);
+		gtk_widget_show_all( GTK_WIDGET(finestra) );
+	}
+
+	aggiorna_tabella_ore(NULL, NULL);
+}
+
+void handler_giorni_tabella(GtkSpinButton *giorni, gpointer user_data)
+{
+	if (tabella == 0)
+		return;
+
+	imposta_giorni_tabella(tabella, gtk_spin_button_get_value_as_int(giorni) );
+}
+
+void handler_mostra_ora(campo_t *campo, const char giorno[], int orario_cella, ora_t *ora, gpointer user_data)
+{
+	char *campo_numero = g_strdup_printf("%d", campo->numero);
+
+	GtkWidget *box_n = GTK_WIDGET( gtk_builder_get_object(build, "ora_nuova") );
+	GtkWidget *box_v = GTK_WIDGET( gtk_builder_get_object(build, "ora_esistente") );
+
+	if (ora == 0){
+		svuota_ricerca("cerca_ora_n", G_CALLBACK(handler_cerca_ora));
+		riempi_giocatori_ora("");
+
+		GtkEntry *orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_ora_n") );
+		GtkEntry *durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_ora_n") );
+		GtkEntry *data = GTK_ENTRY( gtk_builder_get_object(build, "data_ora_n") );
+		GtkLabel *campo_label = GTK_LABEL( gtk_builder_get_object(build, "campo_ora_n") );
+
+		//durata proposta: l'ora intera arrotondata agli slot, almeno uno slot
+		int passo = get_orari_campo(campo)->passo;
+		char *orario_ = STRINGA_ORARIO(orario_cella);
+		char *durata_ = STRINGA_ORARIO( MAX(60 / passo, 1) * passo );
+
+		gtk_entry_set_text(orario, orario_ );
+		gtk_entry_set_text(durata, durata_);
+		gtk_entry_set_text(data, giorno);
+		gtk_label_set_text(campo_label, campo_numero);
+
+		g_object_set_data( G_OBJECT(box_n), "campo", campo);
+
+		g_free(orario_);
+		g_free(durata_);
+		g_free(campo_numero);
+		
+		gtk_widget_set_visible(box_n, TRUE);
+		gtk_widget_set_visible(box_v, FALSE);
+
+		return;
+	}
+	
+	D1(cout<<"ora non vuota"<<endl)
+
+	GtkLabel *nome = GTK_LABEL( gtk_builder_get_object(build, "nome_ora") );
+	GtkLabel *orario = GTK_LABEL( gtk_builder_get_object(build, "orario_ora") );
+	GtkLabel *data = GTK_LABEL( gtk_builder_get_object(build, "data_ora") );
+	GtkLabel *durata = GTK_LABEL( gtk_builder_get_object(build, "durata_ora") );
+	GtkLabel *campo_label = GTK_LABEL( gtk_builder_get_object(build, "campo_ora") );
+
+	char *orario_ = STRINGA_ORARIO(ora->orario);
+	char *durata_ = STRINGA_ORARIO(ora->durata);
+
+	gtk_label_set_text(nome, get_nome_ora(ora));
+	gtk_label_set_text(orario, orario_);
+	gtk_label_set_text(data, ora->data->str);
+	gtk_label_set_text(durata, durata_);
+	gtk_label_set_text(campo_label, campo_numero);
+
+	g_object_set_data( G_OBJECT(box_v), "ora", ora);
+	g_object_set_data( G_OBJECT(box_v), "campo", campo);	
+
+	gtk_widget_set_visible(box_v, TRUE);
+	gtk_widget_set_visible(box_n, FALSE);
+
+	g_free(orario_);
+	g_free(durata_);
+	g_free(campo_numero);
+}
+
+void handler_prenota_ora(GtkButton *button, gpointer user_data)
+{
+	D1(cout<<"prenota ora"<<endl)
+
+	GObject *box_n = gtk_builder_get_object(build, "ora_nuova");
+
+	gpointer campo_ = g_object_get_data(box_n, "campo");
+
+	GtkComboBox *selezione = GTK_COMBO_BOX( gtk_builder_get_object(build, "nome_ora_n") );
+	GtkEntry *entry_orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_ora_n") );
+	GtkEntry *entry_durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_ora_n") );
+	GtkEntry *entry_data = GTK_ENTRY( gtk_builder_get_object(build, "data_ora_n") );
+
+	const char *orario_ = gtk_entry_get_text(entry_orario);
+	const char *durata_ = gtk_entry_get_text(entry_durata);
+	const char *data = gtk_entry_get_text(entry_data);	
+
+	int orario = controlla_formato_ora(orario_);
+	int durata = controlla_formato_ora(durata_);
+	guint giorno = giorno_da_data(data);
+	campo_t *campo = (campo_t *) campo_;
+
+	if (giorno == 0){
+		D1(cout<<"data errata"<<endl)
+		finestra_errore("Data Errata");
+		return;
+	}
+
+	if (orario < 0 || durata < 0 || !orario_valido(campo, orario, durata) ){
+		D1(cout<<"orario errato"<<endl)
+		const orari_t *orari = get_orari_campo(campo);
+		char *apertura = STRINGA_ORARIO(orari->apertura);
+		char *chiusura = STRINGA_ORARIO(orari->chiusura);
+		char *messaggio = g_strdup_printf("Orario o durata errati: il campo è aperto dalle %s alle %s\n"
+						"e si prenota a slot di %d minuti", apertura, chiusura, orari->passo);
+		finestra_errore(messaggio);
+		g_free(messaggio);
+		g_free(chiusura);
+		g_free(apertura);
+		return;
+	}
+
+	if ( !ora_libera(circolo, campo, giorno, orario, durata) ){
+		finestra_errore("Ora non disponibile");
+		return;
+	}
+
+	giocatore_t *giocatore = 0;
+	GtkTreeIter iter;
+	GtkTreeModel *model = gtk_combo_box_get_model(selezione);
+	
+	if ( !gtk_combo_box_get_active_iter(selezione, &iter) ){
+		finestra_errore("Selezionare un giocatore");
+		return;
+	}
+
+	gtk_tree_model_get(model, &iter, 7, &giocatore, -1);
+
+	GtkToggleButton *ripeti = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "ripeti_ora_n") );
+
+	if ( gtk_toggle_button_get_active(ripeti) )
+		prenota_ricorrente(orario, durata, giorno, giocatore, campo);
+	else {
+		ora_t *ora = aggiungi_ora(orario, data, durata, giocatore, campo);
+		salva_ora_async(ora, campo, circolo, esito_operazione,
+			(gpointer) "Attenzione! non è stato possibile salvare l'ora su file");
+	}
+
+	aggiorna_tabella_ore(NULL, NULL);	
+}
+
+void handler_aggiungi_campo(GtkButton *button, gpointer user_data)
+{
+	if (circolo == 0){
+		finestra_errore("Circolo non inizializzato");
+		return;
+	}
+
+	GObject *campo_ = gtk_builder_get_object(build, "campo_ok");
+	campo_t *vecchio_c = (campo_t *) g_object_get_data(campo_, "campo");
+
+	campo_t *campo = 0;
+
+	GtkSpinButton *entry_numero = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "numero_c") );
+	GtkComboBox *entry_copertura = GTK_COMBO_BOX( gtk_builder_get_object(build, "copertura_c") );
+	GtkComboBox *entry_terreno = GTK_COMBO_BOX( gtk_builder_get_object(build, "terreno_c") );
+	GtkEntry *entry_note = GTK_ENTRY( gtk_builder_get_object(build, "note_c") );
+
+	int numero = gtk_spin_button_get_value_as_int(entry_numero);
+	copertura_t copertura = (copertura_t) gtk_combo_box_get_active(entry_copertura);
+	terreno_t terreno = (terreno_t) gtk_combo_box_get_active(entry_terreno);
+	const char *note = gtk_entry_get_text(entry_note);
+
+	if ( esiste(scorri_campi(circolo, campo_con_numero(numero))) ){
+		finestra_errore("numero campo già prsente");
+		return;
+	}
+
+	campo = aggiungi_campo(numero, copertura, terreno, note, vecchio_c, circolo);
+
+	if (campo == 0){
+		finestra_errore("Impossibile aggiungere il campo");
+		return;
+	}
+
+	salva_campo_async(campo, circolo, esito_operazione,
+		(gpointer) "Attenzione! non è stato possibile salvare il campo su file\n alla chiusura del programma \
+				il campo non sarà più recuperabile");
 
-	nascondi_finestra( gtk_widget_get_toplevel( GTK_WIDGET(button) ), NULL, NULL);	
+	nascondi_finestra( gtk_widget_get_toplevel( GTK_WIDGET(button) ), NULL, NULL);
+	disegna_tabella_ore();
 }
 
-void handler_inizializza_cir(GtkButton *button, gpointer user_data)
+void handler_orari_circolo(GtkMenuItem *item, gpointer user_data)
 {
-	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_cir") );
-	GtkEntry *entry_indirizzo = GTK_ENTRY( gtk_builder_get_object(build, "indirizzo_cir") );
-	GtkEntry *entry_email = GTK_ENTRY( gtk_builder_get_object(build, "email_cir") );
-	GtkEntry *entry_telefono = GTK_ENTRY( gtk_builder_get_object(build, "telefono_cir") );
+	mostra_orari(0);
+}
 
-	const char *nome = gtk_entry_get_text(entry_nome);
-	const char *indirizzo = gtk_entry_get_text(entry_indirizzo);
-	const char *email = gtk_entry_get_text(entry_email);
-	const char *telefono = gtk_entry_get_text(entry_telefono);
+void handler_orari_campo(GtkButton *button, gpointer user_data)
+{
+	campo_t *campo = (campo_t *) g_object_get_data( gtk_builder_get_object(build, "campo_ok"), "campo" );
 
-	if (nome[0] == '\0'){
-		finestra_errore("Inserire un nome per il circolo");
-		return;
-	}
-	
-	char *dir_cir = get_dir_circolo(nome);
-	if ( g_file_test(dir_cir, G_FILE_TEST_IS_DIR) ){
-		finestra_errore("Esiste già un circolo con questo nome");
-		g_free(dir_cir);
+	if (campo == 0){
+		finestra_errore("Aggiungere il campo prima di impostarne gli orari");
 		return;
 	}
-	g_free(dir_cir);
 
-	if ( circolo != 0 && !alert("Verrà chiuso il circolo attuale. Continuare?") )
-		return;
+	mostra_orari(campo);
+}
 
-	if ( circolo != 0 )
-		elimina_circolo(circolo);	
+void handler_orari_propri(GtkToggleButton *propri, gpointer user_data)
+{
+	gboolean attivo = gtk_toggle_button_get_active(propri);
 
-	if ( (circolo = inizializza_circolo(nome, indirizzo, email, telefono)) == 0 )
-		finestra_errore("Impossibile creare il circolo");
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "apertura_o") ), attivo);
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "chiusura_o") ), attivo);
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "passo_o") ), attivo);
+}
 
-	if ( !salva_circolo(circolo) )
-		finestra_errore("Attenzione! non è stato possibile salvare il circolo su file\n alla chiusura del programma \
-				il circolo non sarà più recuperabile");
+void handler_salva_orari(GtkButton *button, gpointer user_data)
+{
+	campo_t *campo = (campo_t *) g_object_get_data( G_OBJECT(button), "campo" );
+
+	GtkToggleButton *propri = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "orari_propri") );
+	GtkEntry *entry_apertura = GTK_ENTRY( gtk_builder_get_object(build, "apertura_o") );
+	GtkEntry *entry_chiusura = GTK_ENTRY( gtk_builder_get_object(build, "chiusura_o") );
+	GtkSpinButton *entry_passo = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "passo_o") );
+
+	int apertura = controlla_formato_ora( gtk_entry_get_text(entry_apertura) );
+	int chiusura = controlla_formato_chiusura( gtk_entry_get_text(entry_chiusura) );
+	int passo = gtk_spin_button_get_value_as_int(entry_passo);
+
+	//un campo senza orari propri torna a quelli del circolo
+	if (campo != 0 && !gtk_toggle_button_get_active(propri) )
+		passo = 0;
+	else if ( !orari_validi(apertura, chiusura, passo) ){
+		finestra_errore("Orari non validi: l'apertura deve precedere la chiusura\n"
+				"e l'intervallo deve contenere un numero intero di slot");
+		return;
+	}
 
-	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_modifica") ), TRUE);
-	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_backup") ), TRUE);
-	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_visualizza") ), TRUE);	
+	if (campo != 0){
+		imposta_orari_campo(campo, apertura, chiusura, passo);
+		salva_campo_async(campo, circolo, esito_operazione,
+			(gpointer) "Attenzione! non è stato possibile salvare gli orari del campo su file");
+	}
+	else {
+		imposta_orari_circolo(circolo, apertura, chiusura, passo);
+		salva_circolo_async(circolo, esito_operazione,
+			(gpointer) "Attenzione! non è stato possibile salvare gli orari del circolo su file");
+	}
 
 	nascondi_finestra( gtk_widget_get_toplevel( GTK_WIDGET(button) ), NULL, NULL);
-	
-	handler_carica_circolo(NULL, (void *) nome);
+	disegna_tabella_ore();
 }
 
-void handler_nuovo_campo(GtkMenuItem *item, gpointer campo_)
+void handler_diagnostica(GtkWidget *widget, gpointer user_data)
 {
-	campo_t *campo = (campo_t *) campo_;
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "diagnostica") );
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "statistiche") );
+	GtkLabel *stato = GTK_LABEL( gtk_builder_get_object(build, "diagnostica_stato") );
 
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "agg_campo") );
-	GObject *pulsante = gtk_builder_get_object(build, "campo_ok");
+	if ( prestazioni_attive() )
+		gtk_label_set_text(stato, "Statistiche raccolte dall'avvio o dall'ultimo azzeramento, tempi in microsecondi; "
+					"percentili stimati a potenze di due");
+	else
+		gtk_label_set_text(stato, "Strumentazione non attiva: compilare con make profilo");
 
-	GtkSpinButton *entry_numero = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "numero_c") );
-	GtkComboBox *entry_copertura = GTK_COMBO_BOX( gtk_builder_get_object(build, "copertura_c") );
-	GtkComboBox *entry_terreno = GTK_COMBO_BOX( gtk_builder_get_object(build, "terreno_c") );
-	GtkEntry *entry_note = GTK_ENTRY( gtk_builder_get_object(build, "note_c") );
-	
-	if (campo != NULL){
-		gtk_spin_button_set_value(entry_numero, campo->numero);
-		gtk_combo_box_set_active(entry_copertura, campo->copertura);
-		gtk_combo_box_set_active(entry_terreno, campo->terreno);
-		gtk_entry_set_text(entry_note, campo->note->str);
-	} 
-	else {
-		gtk_spin_button_set_value(entry_numero, circolo->n_campi + 1);
-		gtk_combo_box_set_active(entry_copertura, 0);
-		gtk_combo_box_set_active(entry_terreno, 0);
-		gtk_entry_set_text(entry_note, "");
-	}
+	gtk_list_store_clear(list);
+	foreach_statistica(insert_list_statistica, list);
 
-	g_object_set_data(pulsante, "campo", campo);	
+	gtk_widget_show_all(window);
+}
 
+void handler_azzera_diagnostica(GtkButton *button, gpointer user_data)
+{
+	azzera_statistiche();
+	handler_diagnostica(NULL, NULL);
+}
 
-	mostra_finestra(NULL, window);
+void handler_apri_circolo(GtkMenuItem *button, gpointer user_data)
+{
+	//la finestra viene mostrata quando l'esecutore ha elencato i circoli
+	GPtrArray **circoli = g_new(GPtrArray *, 1);
+	elenca_circoli_async(circoli, mostra_circoli, circoli);
 }
 
-void handler_visualizza_campo(GtkButton *button, gpointer user_data)
+void handler_carica_circolo(GtkButton *button, gpointer user_data)
 {
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_c") );
+	if ( circolo != 0 && user_data == 0 && !alert("Verrà chiuso il circolo attuale. Continuare?") )
+		return;
+
+	chiudi_circolo();
 	
-	GtkTreeIter iter;
-	GtkTreeModel *model;
-	campo_t *campo_sel = 0;
-	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "campi_view") );
-	GtkTreeSelection *selezione = gtk_tree_view_get_selection(view);
+	char *circolo_sel = 0;	
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "carica_circolo") );
 
-	if ( !gtk_tree_selection_get_selected(selezione, &model, &iter) ){
-		finestra_errore("Selezionare un elemento");
-		return;
+	if ( user_data != 0 )
+		circolo_sel = (char *) user_data;
+	else {	
+
+		GtkTreeIter iter;
+		GtkTreeModel *model;
+		GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "circolo_view") );
+		GtkTreeSelection *selezione = gtk_tree_view_get_selection(view);
+	
+		if ( !gtk_tree_selection_get_selected(selezione, &model, &iter) ){
+			finestra_errore("Selezionare un elemento");
+			return;
+		}
+		gtk_tree_model_get(model, &iter, 0, &circolo_sel, -1);
+	
 	}
-	gtk_tree_model_get(model, &iter, 3, &campo_sel, -1);
 	
-	nascondi_finestra(window, NULL, NULL);
+	//fino alla fine del caricamento è utilizzabile solo la tabella del giorno
+	circolo_completo(false);
+
+	GtkProgressBar *barra = GTK_PROGRESS_BAR( gtk_builder_get_object(build, "progresso_caricamento") );
+	gtk_progress_bar_set_fraction(barra, 0);
+	gtk_progress_bar_set_text(barra, "Caricamento campi");
+	gtk_widget_set_visible( GTK_WIDGET(barra), TRUE );
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "circolo_view") ), FALSE);
+	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "button9") ), FALSE);
+	mostra_finestra(NULL, window);
 
-	if(campo_sel != NULL)
-		handler_nuovo_campo(NULL, campo_sel);
-	
+	char *oggi = get_stringa_data( GTK_CALENDAR( gtk_builder_get_object(build, "calendario") ) );
+	caricamento = carica_circolo_async(circolo_sel, oggi, progresso_caricamento, NULL);
+	g_free(oggi);
+
+	if (user_data == 0)
+		g_free(circolo_sel);
 }
 
-void aggiorna_tabella_ore(GtkCalendar *calendario, gpointer user_data)
+void handler_backup(GtkMenuItem *button, gpointer user_data)
 {
-	if (!calendario)
-		calendario = GTK_CALENDAR( gtk_builder_get_object(build, "calendario") );
+	gint response;
+	char *file = 0;
+	GtkFileChooser *scegli_file = GTK_FILE_CHOOSER( gtk_builder_get_object(build, "scegli_file") );
+	
+	gtk_file_chooser_set_action(scegli_file, GTK_FILE_CHOOSER_ACTION_SAVE);
+	gtk_file_chooser_set_do_overwrite_confirmation(scegli_file, TRUE);
+
+	mostra_finestra(NULL, scegli_file);
+	
+	response = gtk_dialog_run( GTK_DIALOG(scegli_file) );
+	if (response == GTK_RESPONSE_YES){
+		file = gtk_file_chooser_get_filename(scegli_file);
+		
+		D2(cout<<"nome: "<<file<<endl);
+
+		backup_async(file, circolo, esito_operazione, (gpointer) "Non è stato possibile effetturare il backup");
+		g_free(file);
+	}
 
-	GtkContainer *cont_tabella = GTK_CONTAINER( gtk_builder_get_object(build, "tabella_ore") );
-	GList *figli = gtk_container_get_children(cont_tabella);
-	GtkGrid *tabella = GTK_GRID(figli->data);
+	nascondi_finestra( GTK_WIDGET(scegli_file), NULL, NULL);
+}
 
-	gtk_container_foreach( GTK_CONTAINER(tabella), distruggi_cella_se_interna, tabella);
+void handler_ripristina(GtkMenuItem *button, gpointer user_data)
+{
+	gint response;
+	char *file = 0;
+	GtkFileChooser *scegli_file = GTK_FILE_CHOOSER( gtk_builder_get_object(build, "scegli_file") );
 	
-	char *data = get_stringa_data(calendario);
-	D1(cout<<"Giorno aquisito"<<endl)	
-
-	GList *tmp_c = circolo->campi;
-	while(tmp_c != NULL){
-		campo_t *campo = (campo_t *) tmp_c->data;
-
-		int inizio = 0;
-		int fine = 0; 
-		GList *tmp_o = campo->ore;
-		while(tmp_o != NULL){
-			ora_t *ora = (ora_t *) tmp_o->data;
-			if ( g_strcmp0(ora->data->str, data) == 0 ){
-
-				//Crea un bottone contente dati utili e lo inserisce nella tabella
-				const char *nome = get_nome_ora(ora);
-				GtkWidget *etichetta = GTK_WIDGET( gtk_button_new_with_label(nome) );
-				g_signal_connect(etichetta, "clicked", G_CALLBACK(handler_mostra_ora), ora);
-				g_object_set_data( G_OBJECT(etichetta), "campo", campo);
-				g_object_set_data( G_OBJECT(etichetta), "tipo_ora", GINT_TO_POINTER(PRENOTATA) );
-				g_object_set_data( G_OBJECT(etichetta), "ora", ora);
-
-				fine = ora->orario - (ORA_APERTURA*60);
-				inserisci_ore_vuote(inizio, fine, tabella, campo);
-				inizio = (ora->orario)+(ora->durata)-(ORA_APERTURA*60);
-				
-				gtk_grid_attach(tabella, etichetta, (ora->orario-(ORA_APERTURA-1)*60), campo->numero, ora->durata, 1);
-			}
-			
-			tmp_o = g_list_next(tmp_o);
-		}
+	gtk_file_chooser_set_action(scegli_file, GTK_FILE_CHOOSER_ACTION_OPEN);
+
+	mostra_finestra(NULL, scegli_file);
 	
-		fine = (ORA_CHIUSURA - ORA_APERTURA)*60;
-		inserisci_ore_vuote(inizio, fine, tabella, campo);
+	response = gtk_dialog_run( GTK_DIALOG(scegli_file) );
+	if (response == GTK_RESPONSE_YES){
+		file = gtk_file_chooser_get_filename(scegli_file);
+		
+		D1(cout<<"nome: "<<file<<endl);
 
-		tmp_c = g_list_next(tmp_c);
+		//il nome del circolo viene letto e controllato dall'esecutore, poi parte il ripristino
+		ripristino_t *rip = g_new(ripristino_t, 1);
+		rip->file = file;
+		get_nome_backup_async(file, &rip->nome_cir, nome_backup_letto, rip);
 	}
 
-	g_free(data);
-
-	gtk_widget_show_all( GTK_WIDGET(cont_tabella) );
+	nascondi_finestra( GTK_WIDGET(scegli_file), NULL, NULL);
 }
 
-void disegna_tabella_ore()
+void handler_file_ok(GtkWidget *widget, GdkEvent *event, gpointer user_data)
 {
-	GtkContainer *finestra = GTK_CONTAINER( gtk_builder_get_object(build, "tabella_ore") );
-	GList *figli = gtk_container_get_children(finestra);
-	GtkWidget *vecchio = GTK_WIDGET(figli->data);
+	GtkFileChooser *chooser = GTK_FILE_CHOOSER(user_data);
 
-	gtk_widget_destroy(vecchio);
+	char *file = 0;
+
+	file = gtk_file_chooser_get_filename(chooser);
+
+	g_free(file);
+
+		if (!file){
+			finestra_errore("Percorso non valido");
+			gtk_dialog_response( GTK_DIALOG(chooser), GTK_RESPONSE_REJECT);
+			return;
+		}
+
+	if ( gtk_file_chooser_get_action(chooser) == GTK_FILE_CHOOSER_ACTION_SAVE ){
+		char *file = get_current_name(chooser);
 		
-	GtkGrid *tabella = GTK_GRID( gtk_grid_new() );
+		controllo_estensione(file, ESTENSIONE_BACKUP);
+		D1(cout<<file<<endl);
+		gtk_file_chooser_set_current_name(chooser, file);
+	}
+}
+
+void handler_elenco_giocatori(GtkMenuItem *button, gpointer user_data)
+{
+	mostra_elenco(false);
+}
 
-	gtk_container_add(finestra, GTK_WIDGET(tabella) );
+void handler_elenco_soci(GtkMenuItem *button, gpointer user_data)
+{
+	mostra_elenco(true);
+}
 
-	gtk_grid_set_column_spacing(tabella, 1);
+void handler_cerca_giocatori(GtkEditable *cerca, gpointer user_data)
+{
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") );
+	GtkTreeModel *modello = gtk_tree_view_get_model(view);
+	const char *testo = gtk_entry_get_text( GTK_ENTRY(cerca) );
 
-	//colonna campi
-	gtk_grid_insert_column(tabella, 0);
+	if (modello == 0)
+		return;
 
-	//creazione colonne di tutta la giornata
-	for (int i = 0; i < ( (ORA_CHIUSURA-ORA_APERTURA-1)*60 ); i++)
-		gtk_grid_insert_column(tabella, 0);
+	//la vista viene staccata per non farle elaborare le righe una alla volta
+	g_object_ref(modello);
+	gtk_tree_view_set_model(view, NULL);
 
-	//riga per gli orari
-	gtk_grid_insert_row(tabella, 0);
-	for (int i = ORA_APERTURA; i <= ORA_CHIUSURA-1; i++){
-		char *tmp = g_strdup_printf("%02d:00", i);
-		GtkWidget *etichetta = GTK_WIDGET( gtk_label_new(tmp) );
-		gtk_grid_attach(tabella, etichetta, ( (i - ORA_APERTURA + 1) * 60 ), 0, 60, 1);
-		g_free(tmp);
+	if (testo[0] == '\0'){
+		filtra_modello_giocatori(modello, 0, false);
+		modello_filtrato = 0;
+	} else {
+		GList *trovati = cerca_giocatori(circolo, testo, modello == modello_soci, 0);
+		filtra_modello_giocatori(modello, trovati, true);
+		g_list_free(trovati);
+		modello_filtrato = modello;
 	}
 
-	//righe dei campi
-	g_list_foreach(circolo->campi, inserisci_righe_campi , tabella);
+	gtk_tree_view_set_model(view, modello);
+	g_object_unref(modello);
+}
 
-	aggiorna_tabella_ore(NULL, NULL);
-	gtk_widget_show_all( GTK_WIDGET(finestra) );
+void handler_cerca_ora(GtkEditable *cerca, gpointer user_data)
+{
+	riempi_giocatori_ora( gtk_entry_get_text( GTK_ENTRY(cerca) ) );
 }
 
-void handler_mostra_ora(GtkButton *button, gpointer user_data)
+void handler_elenco_campi(GtkMenuItem *button, gpointer user_data)
 {
-	GObject *cella = G_OBJECT(button);
-	tipo_ora tipo = (tipo_ora) GPOINTER_TO_INT( g_object_get_data(cella, "tipo_ora") );
-	campo_t *campo = (campo_t *) g_object_get_data(cella, "campo");
-	gpointer ora_ = g_object_get_data(cella, "ora");
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_c") );
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "campi") );
+	
+	gtk_list_store_clear(list);
 
-	char *campo_numero = g_strdup_printf("%d", campo->numero);
+	g_ptr_array_foreach(circolo->campi, insert_list_campi, list);
 
-	GtkCalendar *calendario = GTK_CALENDAR( gtk_builder_get_object(build, "calendario") );
-	GtkWidget *box_n = GTK_WIDGET( gtk_builder_get_object(build, "ora_nuova") );
-	GtkWidget *box_v = GTK_WIDGET( gtk_builder_get_object(build, "ora_esistente") );
+	gtk_widget_show_all(window);
+}
 
-	if (tipo == VUOTA){
-		GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "giocatori") );
-		gtk_list_store_clear(list);
-		g_list_foreach(circolo->giocatori, insert_list_giocatore, list);
+void handler_elenco_corsi(GtkMenuItem *button, gpointer user_data)
+{
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "corsi_w") );
+	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "corsi") );
 
-		GtkComboBox *nome = GTK_COMBO_BOX( gtk_builder_get_object(build, "nome_ora_n") );
-		GtkEntry *orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_ora_n") );
-		GtkEntry *durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_ora_n") );
-		GtkEntry *data = GTK_ENTRY( gtk_builder_get_object(build, "data_ora_n") );
-		GtkLabel *campo_label = GTK_LABEL( gtk_builder_get_object(build, "campo_ora_n") );
+	if (circolo == 0){
+		finestra_errore("Circolo non inizializzato");
+		return;
+	}
 
-		char *orario_ = STRINGA_ORARIO( GPOINTER_TO_INT(ora_) );
-		char *data_ = get_stringa_data(calendario);
+	gtk_list_store_clear(list);
+	g_list_foreach(circolo->corsi, insert_list_corsi, list);
 
-		gtk_combo_box_set_active(nome, 0);
-		gtk_entry_set_text(orario, orario_ );
-		gtk_entry_set_text(durata, "01:00");
-		gtk_entry_set_text(data, data_);
-		gtk_label_set_text(campo_label, campo_numero);
+	riempi_giocatori_ora("");
 
-		g_object_set_data( G_OBJECT(box_n), "campo", campo);
+	gtk_widget_show_all(window);
+}
 
-		g_free(orario_);
-		g_free(data_);
-		g_free(campo_numero);
-		
-		gtk_widget_set_visible(box_n, TRUE);
-		gtk_widget_set_visible(box_v, FALSE);
+void handler_aggiungi_corso(GtkButton *button, gpointer user_data)
+{
+	GtkEntry *entry_nome = GTK_ENTRY( gtk_builder_get_object(build, "nome_corso") );
+	giocatore_t *istruttore = giocatore_corso();
 
+	if (istruttore == 0){
+		finestra_errore("Selezionare l'istruttore");
 		return;
 	}
-	
-	D1(cout<<"ora non vuota"<<endl)
 
-	ora_t *ora = (ora_t *) ora_;
+	corso_t *corso = aggiungi_corso(0, gtk_entry_get_text(entry_nome), istruttore, circolo);
 
-	GtkLabel *nome = GTK_LABEL( gtk_builder_get_object(build, "nome_ora") );
-	GtkLabel *orario = GTK_LABEL( gtk_builder_get_object(build, "orario_ora") );
-	GtkLabel *data = GTK_LABEL( gtk_builder_get_object(build, "data_ora") );
-	GtkLabel *durata = GTK_LABEL( gtk_builder_get_object(build, "durata_ora") );
-	GtkLabel *campo_label = GTK_LABEL( gtk_builder_get_object(build, "campo_ora") );
+	if (corso == 0){
+		finestra_errore("Inserire il nome del corso");
+		return;
+	}
 
-	char *orario_ = STRINGA_ORARIO(ora->orario);
-	char *durata_ = STRINGA_ORARIO(ora->durata);
+	salva_corso_async(corso, circolo, esito_operazione,
+		(gpointer) "Attenzione! non è stato possibile salvare il corso su file");
 
-	gtk_label_set_text(nome, get_nome_ora(ora));
-	gtk_label_set_text(orario, orario_);
-	gtk_label_set_text(data, ora->data->str);
-	gtk_label_set_text(durata, durata_);
-	gtk_label_set_text(campo_label, campo_numero);
+	handler_elenco_corsi(NULL, NULL);
+}
 
-	g_object_set_data( G_OBJECT(box_v), "ora", ora);
-	g_object_set_data( G_OBJECT(box_v), "campo", campo);	
+void handler_iscrivi_corso(GtkButton *button, gpointer user_data)
+{
+	corso_t *corso = corso_selezionato();
+	giocatore_t *giocatore = giocatore_corso();
 
-	gtk_widget_set_visible(box_v, TRUE);
-	gtk_widget_set_visible(box_n, FALSE);
+	if (corso == 0 || giocatore == 0){
+		finestra_errore("Selezionare un corso e un giocatore");
+		return;
+	}
 
-	g_free(orario_);
-	g_free(durata_);
-	g_free(campo_numero);
+	if ( !iscrivi_corso(corso, giocatore, circolo) ){
+		finestra_errore("Giocatore già iscritto al corso");
+		return;
+	}
+
+	salva_corso_async(corso, circolo, esito_operazione,
+		(gpointer) "Attenzione! non è stato possibile salvare il corso su file");
+
+	handler_elenco_corsi(NULL, NULL);
 }
 
-void handler_prenota_ora(GtkButton *button, gpointer user_data)
+void handler_programma_corso(GtkButton *button, gpointer user_data)
 {
-	D1(cout<<"prenota ora"<<endl)
-
-	GObject *box_n = gtk_builder_get_object(build, "ora_nuova");
+	corso_t *corso = corso_selezionato();
 
-	gpointer campo_ = g_object_get_data(box_n, "campo");
-
-	GtkComboBox *selezione = GTK_COMBO_BOX( gtk_builder_get_object(build, "nome_ora_n") );
-	GtkEntry *entry_orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_ora_n") );
-	GtkEntry *entry_durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_ora_n") );
-	GtkEntry *entry_data = GTK_ENTRY( gtk_builder_get_object(build, "data_ora_n") );
+	if (corso == 0){
+		finestra_errore("Selezionare un corso");
+		return;
+	}
 
-	const char *orario_ = gtk_entry_get_text(entry_orario);
-	const char *durata_ = gtk_entry_get_text(entry_durata);
-	const char *data = gtk_entry_get_text(entry_data);	
+	GtkEntry *entry_campi = GTK_ENTRY( gtk_builder_get_object(build, "campi_corso") );
+	GtkComboBox *entry_giorno = GTK_COMBO_BOX( gtk_builder_get_object(build, "giorno_corso") );
+	GtkEntry *entry_orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_corso") );
+	GtkEntry *entry_durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_corso") );
+	GtkEntry *entry_inizio = GTK_ENTRY( gtk_builder_get_object(build, "inizio_corso") );
+	GtkEntry *entry_fine = GTK_ENTRY( gtk_builder_get_object(build, "fine_corso") );
 
-	int orario = controlla_formato_ora(orario_);
-	int durata = controlla_formato_ora(durata_);
+	int orario = controlla_formato_ora( gtk_entry_get_text(entry_orario) );
+	int durata = controlla_formato_ora( gtk_entry_get_text(entry_durata) );
+	guint inizio = giorno_da_data( gtk_entry_get_text(entry_inizio) );
+	guint fine = giorno_da_data( gtk_entry_get_text(entry_fine) );
 
-	if (orario < 0 || orario >= ORA_CHIUSURA*60){
-		D1(cout<<"orario errato"<<endl)
-		finestra_errore("Orario Errato");
+	if (inizio == 0 || fine < inizio){
+		finestra_errore("Periodo del corso errato");
 		return;
 	}
 
-	if (durata < 0 || durata > ORA_CHIUSURA*60 - orario){
-		D1(cout<<"durata errata"<<endl)
-		finestra_errore("Durata Errata");
+	if (orario < 0 || durata < 0){
+		finestra_errore("Orario o durata errati");
 		return;
 	}
 
-	campo_t *campo = (campo_t *) campo_;
+	//un blocco per ogni campo indicato, separati da spazi o virgole
+	char **numeri = g_strsplit_set(gtk_entry_get_text(entry_campi), " ,", 0);
+	GArray *blocchi = g_array_new(FALSE, FALSE, sizeof(blocco_corso_t));
 
-	if ( !controlla_disponibilita_ora(campo, orario, durata) ){
-		finestra_errore("Ora non disponibile");
-		return;
-	}
+	for (int i = 0; numeri[i] != 0; i++){
+		if (numeri[i][0] == '\0')
+			continue;
 
-	giocatore_t *giocatore = 0;
-	GtkTreeIter iter;
-	GtkTreeModel *model = gtk_combo_box_get_model(selezione);
-	
-	if ( !gtk_combo_box_get_active_iter(selezione, &iter) ){
-		finestra_errore("Selezionare un giocatore");
-		return;
+		campo_t *campo = primo_campo(circolo, campo_con_numero(atoi(numeri[i])));
+		if (campo == 0){
+			char *messaggio = g_strdup_printf("Campo %s inesistente", numeri[i]);
+			finestra_errore(messaggio);
+			g_free(messaggio);
+			g_array_free(blocchi, TRUE);
+			g_strfreev(numeri);
+			return;
+		}
+
+		blocco_corso_t blocco = { campo, gtk_combo_box_get_active(entry_giorno), orario, durata };
+		g_array_append_val(blocchi, blocco);
 	}
+	g_strfreev(numeri);
 
-	gtk_tree_model_get(model, &iter, 7, &giocatore, -1);
+	guint conflitto = 0;
 
-	ora_t *ora = aggiungi_ora(orario, data, durata, giocatore, campo);
-	salva_ora(ora, campo, circolo);
+	if (blocchi->len == 0)
+		finestra_errore("Indicare almeno un campo");
+	else if ( !programma_corso(corso, (blocco_corso_t *) blocchi->data, blocchi->len, inizio, fine, conflitto,
+				circolo, esito_operazione, (gpointer) "Attenzione! non è stato possibile salvare il corso su file") )
+		errore_lezioni(conflitto);
 
-	aggiorna_tabella_ore(NULL, NULL);	
+	g_array_free(blocchi, TRUE);
+
+	handler_elenco_corsi(NULL, NULL);
+	aggiorna_tabella_ore(NULL, NULL);
 }
 
-void handler_aggiungi_campo(GtkButton *button, gpointer user_data)
+void handler_sposta_corso(GtkButton *button, gpointer user_data)
 {
-	if (circolo == 0){
-		finestra_errore("Circolo non inizializzato");
+	corso_t *corso = corso_selezionato();
+
+	if (corso == 0){
+		finestra_errore("Selezionare un corso");
 		return;
 	}
 
-	GObject *campo_ = gtk_builder_get_object(build, "campo_ok");
-	campo_t *vecchio_c = (campo_t *) g_object_get_data(campo_, "campo");
-
-	campo_t *campo = 0;
+	GtkSpinButton *entry_minuti = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "minuti_corso") );
+	GtkSpinButton *entry_giorni = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "giorni_corso") );
+	guint conflitto = 0;
 
-	GtkSpinButton *entry_numero = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "numero_c") );
-	GtkComboBox *entry_copertura = GTK_COMBO_BOX( gtk_builder_get_object(build, "copertura_c") );
-	GtkComboBox *entry_terreno = GTK_COMBO_BOX( gtk_builder_get_object(build, "terreno_c") );
-	GtkEntry *entry_note = GTK_ENTRY( gtk_builder_get_object(build, "note_c") );
+	if ( !sposta_corso(corso, gtk_spin_button_get_value_as_int(entry_minuti), gtk_spin_button_get_value_as_int(entry_giorni),
+				conflitto, circolo, esito_operazione,
+				(gpointer) "Attenzione! non è stato possibile salvare il corso su file") )
+		errore_lezioni(conflitto);
 
-	int numero = gtk_spin_button_get_value_as_int(entry_numero);
-	copertura_t copertura = (copertura_t) gtk_combo_box_get_active(entry_copertura);
-	terreno_t terreno = (terreno_t) gtk_combo_box_get_active(entry_terreno);
-	const char *note = gtk_entry_get_text(entry_note);
+	aggiorna_tabella_ore(NULL, NULL);
+}
 
-	GList *list = cerca_lista_int(circolo->campi, numero, numero, campo_t);
+void handler_elimina_corso(GtkButton *button, gpointer user_data)
+{
+	corso_t *corso = corso_selezionato();
 
-	if (list != NULL){
-		finestra_errore("numero campo già prsente");
+	if (corso == 0){
+		finestra_errore("Selezionare un corso");
 		return;
 	}
 
-	g_list_free(list);
+	if ( !alert("Eliminare il corso con tutte le sue lezioni?") )
+		return;
 
-	campo = aggiungi_campo(numero, copertura, terreno, note, vecchio_c, circolo);
+	elimina_file_corso_async(corso, circolo, esito_operazione, (gpointer) "Impossibile eliminare il file del corso");
+	elimina_corso(corso, circolo);
 
-	if (campo == 0){
-		finestra_errore("Impossibile aggiungere il campo");
+	handler_elenco_corsi(NULL, NULL);
+	aggiorna_tabella_ore(NULL, NULL);
+}
+
+void handler_torneo(GtkMenuItem *item, gpointer user_data)
+{
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "torneo_w") );
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_torneo_view") );
+	GtkComboBox *organizzatore = GTK_COMBO_BOX( gtk_builder_get_object(build, "organizzatore_torneo") );
+
+	if (circolo == 0){
+		finestra_errore("Circolo non inizializzato");
 		return;
 	}
 
-	if ( !salva_campo(campo, circolo) )
-		finestra_errore("Attenzione! non è stato possibile salvare il campo su file\n alla chiusura del programma \
-				il campo non sarà più recuperabile");
+	if (modello_torneo == 0){
+		modello_torneo = crea_modello_giocatori(circolo, false);
+		gtk_tree_view_set_model(view, modello_torneo);
+	}
 
-	nascondi_finestra( gtk_widget_get_toplevel( GTK_WIDGET(button) ), NULL, NULL);
-	disegna_tabella_ore();
+	riempi_giocatori_ora("");
+	gtk_combo_box_set_active(organizzatore, 0);
+
+	mostra_incontri();
+
+	gtk_widget_show_all(window);
 }
 
-void handler_apri_circolo(GtkMenuItem *button, gpointer user_data)
+void handler_pianifica_torneo(GtkButton *button, gpointer user_data)
 {
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "carica_circolo") );
-	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "circoli") );
-	GDir *dir = g_dir_open(DATA_PATH, 0, NULL);
-	const char *file = 0;
-	char *file_path = 0;
-	GtkTreeIter iter;
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_torneo_view") );
+	GtkComboBox *entry_organizzatore = GTK_COMBO_BOX( gtk_builder_get_object(build, "organizzatore_torneo") );
+	GtkComboBox *entry_formula = GTK_COMBO_BOX( gtk_builder_get_object(build, "formula_torneo") );
 
-	gtk_list_store_clear(list);
+	GtkTreeIter iter;
+	giocatore_t *organizzatore = 0;
+	if ( gtk_combo_box_get_active_iter(entry_organizzatore, &iter) )
+		gtk_tree_model_get(gtk_combo_box_get_model(entry_organizzatore), &iter, 7, &organizzatore, -1);
 
-	while( (file = g_dir_read_name(dir)) ){
-		if ( file_nascosto(file) )
-			continue;
+	if (organizzatore == 0){
+		finestra_errore("Selezionare l'organizzatore del torneo");
+		return;
+	}
 
-		file_path = g_build_filename(DATA_PATH, file, NULL);
+	vincoli_torneo_t vincoli;
+	if ( !leggi_vincoli_torneo(vincoli) )
+		return;
 
-		if ( !g_file_test(file_path, G_FILE_TEST_IS_DIR) ){
-			g_free(file_path);
-			continue;
-		}
-	
-		g_free(file_path);
+	//i giocatori selezionati, nell'ordine dell'elenco, sono le teste di serie
+	GtkTreeModel *model;
+	GList *righe = gtk_tree_selection_get_selected_rows(gtk_tree_view_get_selection(view), &model);
+	int n = g_list_length(righe);
 
-		gtk_list_store_append(list, &iter);
-		gtk_list_store_set(list, &iter, 0, file, -1);
+	if (n < 2){
+		finestra_errore("Selezionare almeno due giocatori");
+		g_list_free_full(righe, (GDestroyNotify) gtk_tree_path_free);
+		return;
 	}
 
-	g_dir_close(dir);
+	giocatore_t **giocatori = g_new(giocatore_t *, n);
+	int i = 0;
+	for (GList *tmp = righe; tmp != NULL; tmp = g_list_next(tmp))
+		if ( gtk_tree_model_get_iter(model, &iter, (GtkTreePath *) tmp->data) )
+			gtk_tree_model_get(model, &iter, COL_GIOCATORE, &giocatori[i++], -1);
+	g_list_free_full(righe, (GDestroyNotify) gtk_tree_path_free);
 
-	mostra_finestra(NULL, window);
-}
+	formula_t formula = (gtk_combo_box_get_active(entry_formula) == 1) ? GIRONE : ELIMINAZIONE;
 
-void handler_carica_circolo(GtkButton *button, gpointer user_data)
-{
-	if ( circolo != 0 && user_data == 0 && !alert("Verrà chiuso il circolo attuale. Continuare?") )
+	elimina_torneo(torneo);
+	torneo = crea_torneo(formula, giocatori, i, organizzatore, circolo);
+	g_free(giocatori);
+
+	if (torneo == 0){
+		finestra_errore("Impossibile creare il torneo");
+		mostra_incontri();
 		return;
+	}
 
-	if ( circolo != 0 )
-		elimina_circolo(circolo);
-	
-	char *circolo_sel = 0;	
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "carica_circolo") );
+	pianifica(vincoli, vincoli.inizio, 0);
+}
 
-	if ( user_data != 0 )
-		circolo_sel = (char *) user_data;
-	else {	
+void handler_ripianifica_torneo(GtkButton *button, gpointer user_data)
+{
+	GtkEntry *entry_data = GTK_ENTRY( gtk_builder_get_object(build, "data_ripianifica") );
+	GtkEntry *entry_orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_ripianifica") );
 
-		GtkTreeIter iter;
-		GtkTreeModel *model;
-		GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "circolo_view") );
-		GtkTreeSelection *selezione = gtk_tree_view_get_selection(view);
-	
-		if ( !gtk_tree_selection_get_selected(selezione, &model, &iter) ){
-			finestra_errore("Selezionare un elemento");
-			return;
-		}
-		gtk_tree_model_get(model, &iter, 0, &circolo_sel, -1);
-	
+	if (torneo == 0 || torneo->circolo == 0){
+		finestra_errore("Nessun torneo da ripianificare");
+		return;
 	}
-	
-	circolo = carica_circolo(circolo_sel);
 
-	if (user_data == 0)
-		g_free(circolo_sel);
+	vincoli_torneo_t vincoli;
+	if ( !leggi_vincoli_torneo(vincoli) )
+		return;
 
-	nascondi_finestra(window, NULL, NULL);
-	disegna_tabella_ore();
+	guint giorno = giorno_da_data( gtk_entry_get_text(entry_data) );
+	int orario = controlla_formato_ora( gtk_entry_get_text(entry_orario) );
+
+	if (giorno == 0 || orario < 0){
+		finestra_errore("Data o orario da cui ripianificare errati");
+		return;
+	}
 
-	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_modifica") ), TRUE);
-	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_backup") ), TRUE);
-	gtk_widget_set_sensitive( GTK_WIDGET( gtk_builder_get_object(build, "menu_visualizza") ), TRUE);
+	pianifica(vincoli, giorno, orario);
 }
 
-void handler_backup(GtkMenuItem *button, gpointer user_data)
+void handler_allocazione(GtkMenuItem *item, gpointer user_data)
 {
-	gint response;
-	bool stato = true;
-	char *file = 0;
-	GtkFileChooser *scegli_file = GTK_FILE_CHOOSER( gtk_builder_get_object(build, "scegli_file") );
-	
-	gtk_file_chooser_set_action(scegli_file, GTK_FILE_CHOOSER_ACTION_SAVE);
-	gtk_file_chooser_set_do_overwrite_confirmation(scegli_file, TRUE);
-
-	mostra_finestra(NULL, scegli_file);
-	
-	response = gtk_dialog_run( GTK_DIALOG(scegli_file) );
-	if (response == GTK_RESPONSE_YES){
-		file = gtk_file_chooser_get_filename(scegli_file);
-		
-		D2(cout<<"nome: "<<file<<endl);
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "allocazione_w") );
+	GtkComboBox *giocatore = GTK_COMBO_BOX( gtk_builder_get_object(build, "giocatore_richiesta") );
 
-		stato = backup(file, circolo);
-		g_free(file);
+	if (circolo == 0){
+		finestra_errore("Circolo non inizializzato");
+		return;
 	}
 
-	if (stato == false)
-		finestra_errore("Non è stato possibile effetturare il backup");
-	
-	nascondi_finestra( GTK_WIDGET(scegli_file), NULL, NULL);
+	if (richieste == 0)
+		richieste = g_array_new(FALSE, FALSE, sizeof(richiesta_t));
+
+	riempi_giocatori_ora("");
+	gtk_combo_box_set_active(giocatore, 0);
+
+	mostra_richieste();
+	esito_allocazione("");
+
+	gtk_widget_show_all(window);
 }
 
-void handler_ripristina(GtkMenuItem *button, gpointer user_data)
+void handler_aggiungi_richiesta(GtkButton *button, gpointer user_data)
 {
-	gint response;
-	bool stato = true;
-	char *file = 0;
-	GtkFileChooser *scegli_file = GTK_FILE_CHOOSER( gtk_builder_get_object(build, "scegli_file") );
-	
-	gtk_file_chooser_set_action(scegli_file, GTK_FILE_CHOOSER_ACTION_OPEN);
+	GtkComboBox *entry_giocatore = GTK_COMBO_BOX( gtk_builder_get_object(build, "giocatore_richiesta") );
+	GtkEntry *entry_orario = GTK_ENTRY( gtk_builder_get_object(build, "orario_richiesta") );
+	GtkSpinButton *entry_tolleranza = GTK_SPIN_BUTTON( gtk_builder_get_object(build, "tolleranza_richiesta") );
+	GtkEntry *entry_durata = GTK_ENTRY( gtk_builder_get_object(build, "durata_richiesta") );
+	GtkComboBox *entry_terreno = GTK_COMBO_BOX( gtk_builder_get_object(build, "terreno_richiesta") );
+	GtkComboBox *entry_copertura = GTK_COMBO_BOX( gtk_builder_get_object(build, "copertura_richiesta") );
+	GtkToggleButton *entry_vincolante = GTK_TOGGLE_BUTTON( gtk_builder_get_object(build, "vincolante_richiesta") );
+
+	richiesta_t richiesta;
+	GtkTreeIter iter;
 
-	mostra_finestra(NULL, scegli_file);
-	
-	response = gtk_dialog_run( GTK_DIALOG(scegli_file) );
-	if (response == GTK_RESPONSE_YES){
-		file = gtk_file_chooser_get_filename(scegli_file);
-		
-		D1(cout<<"nome: "<<file<<endl);
-		char *nome_cir = get_nome_backup(file);
+	richiesta.prenotante = 0;
+	if ( gtk_combo_box_get_active_iter(entry_giocatore, &iter) )
+		gtk_tree_model_get(gtk_combo_box_get_model(entry_giocatore), &iter, 7, &richiesta.prenotante, -1);
 
-		if ( circolo_esistente(nome_cir) ){
-			//Circolo già presente
-			D1(cout<<"Circolo esistente"<<endl)
-			if ( alert("Questo backup fa riferimento ad un circolo presente. Vuoi sovrascriverlo?") ){
-				elimina_file_circolo(nome_cir);
-			}
-			else
-			{
-				g_free(file);
-				g_free(nome_cir);
-				return;
-			}
-		}
+	if (richiesta.prenotante == 0){
+		finestra_errore("Selezionare il giocatore");
+		return;
+	}
 
-		stato = ripristina(file);
-		handler_carica_circolo(NULL, nome_cir);
+	richiesta.orario = controlla_formato_ora( gtk_entry_get_text(entry_orario) );
+	richiesta.durata = controlla_formato_ora( gtk_entry_get_text(entry_durata) );
+	richiesta.tolleranza = gtk_spin_button_get_value_as_int(entry_tolleranza);
 
-		g_free(file);
-		g_free(nome_cir);
+	if (richiesta.orario < 0 || richiesta.durata <= 0){
+		finestra_errore("Orario o durata errati");
+		return;
 	}
 
-	if (stato == false)
-		finestra_errore("Non è stato possibile ripristinare il backup");
-	
-	nascondi_finestra( GTK_WIDGET(scegli_file), NULL, NULL);
+	//la prima voce delle preferenze è indifferente, le altre seguono terreno_t e copertura_t
+	int terreno = gtk_combo_box_get_active(entry_terreno);
+	int copertura = gtk_combo_box_get_active(entry_copertura);
+	richiesta.terreni = (terreno > 0) ? 1 << (terreno - 1) : 0;
+	richiesta.coperture = (copertura > 0) ? 1 << (copertura - 1) : 0;
+	richiesta.vincolante = gtk_toggle_button_get_active(entry_vincolante);
+	richiesta.campo = 0;
+	richiesta.inizio = 0;
+
+	g_array_append_val(richieste, richiesta);
+
+	mostra_richieste();
 }
 
-void handler_file_ok(GtkWidget *widget, GdkEvent *event, gpointer user_data)
+void handler_togli_richiesta(GtkButton *button, gpointer user_data)
 {
-	GtkFileChooser *chooser = GTK_FILE_CHOOSER(user_data);
+	GtkTreeIter iter;
+	GtkTreeModel *model;
+	int indice;
+	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "richieste_view") );
 
-	char *file = 0;
+	if ( !gtk_tree_selection_get_selected(gtk_tree_view_get_selection(view), &model, &iter) ){
+		finestra_errore("Selezionare una richiesta");
+		return;
+	}
 
-	file = gtk_file_chooser_get_filename(chooser);
+	gtk_tree_model_get(model, &iter, 6, &indice, -1);
+	g_array_remove_index(richieste, indice);
 
-	g_free(file);
+	mostra_richieste();
+}
 
-		if (!file){
-			finestra_errore("Percorso non valido");
-			gtk_dialog_response( GTK_DIALOG(chooser), GTK_RESPONSE_REJECT);
-			return;
-		}
+void handler_calcola_allocazione(GtkButton *button, gpointer user_data)
+{
+	guint giorno = giorno_selezionato();
+	int soddisfatte = risolvi_allocazione( (richiesta_t *) richieste->data, richieste->len, giorno, circolo );
 
-	if ( gtk_file_chooser_get_action(chooser) == GTK_FILE_CHOOSER_ACTION_SAVE ){
-		char *file = get_current_name(chooser);
-		
-		controllo_estensione(file, ESTENSIONE_BACKUP);
-		D1(cout<<file<<endl);
-		gtk_file_chooser_set_current_name(chooser, file);
-	}
+	char *data = data_da_giorno(giorno);
+	char *testo = g_strdup_printf("Assegnate %d richieste su %u per il %s", soddisfatte, richieste->len, data);
+	esito_allocazione(testo);
+	g_free(testo);
+	g_free(data);
+
+	mostra_richieste();
 }
 
-void handler_elenco_giocatori(GtkMenuItem *button, gpointer user_data)
+void handler_prenota_allocazione(GtkButton *button, gpointer user_data)
 {
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_g") );
-	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") );
-	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "giocatori") );
+	guint giorno = giorno_selezionato();
 
-	gtk_tree_view_set_model(view, GTK_TREE_MODEL(list) );
-	
-	gtk_list_store_clear(list);
+	//l'allocazione viene ricalcolata sulle prenotazioni attuali del giorno selezionato
+	risolvi_allocazione( (richiesta_t *) richieste->data, richieste->len, giorno, circolo );
 
-	g_list_foreach(circolo->giocatori, insert_list_giocatore, list);
+	int prenotate = prenota_allocazione( (richiesta_t *) richieste->data, richieste->len, giorno, circolo,
+				esito_operazione, (gpointer) "Impossibile salvare una prenotazione" );
 
-	gtk_widget_show_all(window);
-	
+	if (prenotate < 0){
+		finestra_errore("Un orario assegnato non è più libero, ricalcolare l'allocazione");
+		return;
+	}
+
+	//restano solo le richieste non soddisfatte
+	for (guint i = richieste->len; i > 0; i--)
+		if (g_array_index(richieste, richiesta_t, i - 1).campo != 0)
+			g_array_remove_index(richieste, i - 1);
+
+	char *testo = g_strdup_printf("Prenotate %d richieste, %u non soddisfatte", prenotate, richieste->len);
+	esito_allocazione(testo);
+	g_free(testo);
+
+	mostra_richieste();
+	aggiorna_tabella_ore(NULL, NULL);
 }
 
-void handler_elenco_soci(GtkMenuItem *button, gpointer user_data)
+void handler_occupazione(GtkMenuItem *item, gpointer user_data)
 {
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_g") );
-	GtkTreeView *view = GTK_TREE_VIEW( gtk_builder_get_object(build, "giocatori_view") );
-	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "soci") );
+	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "occupazione_w") );
+	GtkComboBoxText *entry_campo = GTK_COMBO_BOX_TEXT( gtk_builder_get_object(build, "campo_occupazione") );
+	GtkEntry *entry_inizio = GTK_ENTRY( gtk_builder_get_object(build, "inizio_occupazione") );
+	GtkEntry *entry_fine = GTK_ENTRY( gtk_builder_get_object(build, "fine_occupazione") );
 
-	gtk_tree_view_set_model(view, GTK_TREE_MODEL(list) );
+	if (circolo == 0){
+		finestra_errore("Circolo non inizializzato");
+		return;
+	}
 
-	GList *soci = cerca_lista_int(circolo->giocatori, socio, true, giocatore_t);
+	gtk_combo_box_text_remove_all(entry_campo);
+	gtk_combo_box_text_append_text(entry_campo, "Tutti i campi");
+	for (guint i = 0; i < circolo->campi->len; i++){
+		char *voce = g_strdup_printf("Campo %d", ((campo_t *) g_ptr_array_index(circolo->campi, i))->numero);
+		gtk_combo_box_text_append_text(entry_campo, voce);
+		g_free(voce);
+	}
+	gtk_combo_box_set_active(GTK_COMBO_BOX(entry_campo), 0);
 
-	gtk_list_store_clear(list);
+	//il periodo predefinito è il mese del giorno selezionato nel calendario
+	GDate date;
+	g_date_clear(&date, 1);
+	g_date_set_julian(&date, giorno_selezionato());
+	g_date_set_day(&date, 1);
 
-	g_list_foreach(soci, insert_list_giocatore, list);
+	guint inizio = g_date_get_julian(&date);
+	guint fine = inizio + g_date_get_days_in_month(g_date_get_month(&date), g_date_get_year(&date)) - 1;
+	char *data_inizio = data_da_giorno(inizio);
+	char *data_fine = data_da_giorno(fine);
+	gtk_entry_set_text(entry_inizio, data_inizio);
+	gtk_entry_set_text(entry_fine, data_fine);
+	g_free(data_inizio);
+	g_free(data_fine);
 
-	g_list_free(soci);
+	handler_calcola_occupazione(0, 0);
 
 	gtk_widget_show_all(window);
 }
 
-void handler_elenco_campi(GtkMenuItem *button, gpointer user_data)
+void handler_calcola_occupazione(GtkButton *button, gpointer user_data)
 {
-	GtkWidget *window = GTK_WIDGET( gtk_builder_get_object(build, "elenco_c") );
-	GtkListStore *list = GTK_LIST_STORE( gtk_builder_get_object(build, "campi") );
-	
-	gtk_list_store_clear(list);
+	GtkComboBox *entry_campo = GTK_COMBO_BOX( gtk_builder_get_object(build, "campo_occupazione") );
+	GtkEntry *entry_inizio = GTK_ENTRY( gtk_builder_get_object(build, "inizio_occupazione") );
+	GtkEntry *entry_fine = GTK_ENTRY( gtk_builder_get_object(build, "fine_occupazione") );
 
-	g_list_foreach(circolo->campi, insert_list_campi, list);
+	guint inizio = giorno_da_data( gtk_entry_get_text(entry_inizio) );
+	guint fine = giorno_da_data( gtk_entry_get_text(entry_fine) );
 
-	gtk_widget_show_all(window);
+	occupazione_t *occupazione = calcola_occupazione(circolo, inizio, fine);
+	if (occupazione == 0){
+		finestra_errore("Periodo errato");
+		return;
+	}
+
+	//la prima voce comprende tutti i campi, le altre seguono l'ordine del circolo
+	mostra_occupazione(occupazione, gtk_combo_box_get_active(entry_campo) - 1);
+	elimina_occupazione(occupazione);
 }
 
 void handler_elimina_ora(GtkButton *button, gpointer user_data)
 {
-	if ( !alert("Sei sicuro di voler eliminare l'ora?") )
-		return;
-	
 	GObject *box_v = gtk_builder_get_object(build, "ora_esistente");
 
 	campo_t *campo = (campo_t *) g_object_get_data(box_v, "campo");
@@ -1161,7 +2316,39 @@ void handler_elimina_ora(GtkButton *button, gpointer user_data)
 	D1(cout<<campo->numero<<endl);
 	D2(cout<<ora<<endl);
 
-	elimina_file_ora(ora, campo, circolo);
+	//una lezione di un corso si annulla solo per quel giorno, il corso si elimina dall'elenco dei corsi
+	if (ora->corso != 0){
+		if ( alert("Annullare la lezione del corso di questo giorno?") )
+			annulla_lezione(ora->regola, campo, giorno_da_data(ora->data->str), circolo, esito_operazione,
+				(gpointer) "Impossibile salvare il corso");
+
+		aggiorna_tabella_ore(NULL, NULL);
+		return;
+	}
+
+	//un'occorrenza di una prenotazione ricorrente si toglie con un'eccezione
+	if (ora->regola != 0){
+		regola_t *regola = ora->regola;
+		guint giorno = giorno_da_data(ora->data->str);
+
+		if ( alert("L'ora fa parte di una prenotazione ricorrente.\nEliminare solo l'ora di questo giorno?") ){
+			aggiungi_eccezione(regola, giorno, campo);
+			salva_regola_async(regola, campo, circolo, esito_operazione,
+				(gpointer) "Impossibile salvare la prenotazione ricorrente");
+		} else if ( alert("Eliminare tutta la prenotazione ricorrente?") ){
+			elimina_file_regola_async(regola, campo, circolo, esito_operazione,
+				(gpointer) "Impossibile eliminare il file della prenotazione ricorrente");
+			elimina_regola(regola, campo);
+		}
+
+		aggiorna_tabella_ore(NULL, NULL);
+		return;
+	}
+
+	if ( !alert("Sei sicuro di voler eliminare l'ora?") )
+		return;
+
+	elimina_file_ora_async(ora, campo, circolo, esito_operazione, (gpointer) "Impossibile eliminare il file dell'ora");
 	elimina_ora(ora, campo);
 
 	aggiorna_tabella_ore(NULL, NULL);
@@ -1185,9 +2372,16 @@ void handler_elimina_campo(GtkButton *button, gpointer user_data)
 
 	gtk_tree_model_get(model, &iter, 3, &campo, -1);
 
-	elimina_file_campo(campo, circolo);
+	//i corsi perdono le lezioni del campo e vanno salvati di nuovo
+	GList *corsi = corsi_del_campo(campo);
+
+	elimina_file_campo_async(campo, circolo, esito_operazione, (gpointer) "Impossibile eliminare i file del campo");
 	elimina_campo(campo, circolo);
 
+	for (GList *tmp = corsi; tmp != NULL; tmp = g_list_next(tmp))
+		salva_corso_async( (corso_t *) tmp->data, circolo, esito_operazione, (gpointer) "Impossibile salvare il corso" );
+	g_list_free(corsi);
+
 	handler_elenco_campi(NULL, NULL);
 	disegna_tabella_ore();
 }
@@ -1210,10 +2404,10 @@ void handler_elimina_giocatore(GtkButton *button, gpointer user_data)
 
 	gtk_tree_model_get(model, &iter, 7, &giocatore, -1);
 
-	elimina_file_giocatore(giocatore, circolo);
+	elimina_file_giocatore_async(giocatore, circolo, esito_operazione, (gpointer) "Impossibile eliminare il file del giocatore");
+	togli_richieste_giocatore(giocatore);
 	elimina_giocatore(giocatore, circolo);
 
-	handler_elenco_giocatori(NULL, NULL);
 	aggiorna_tabella_ore(NULL, NULL);
 }
 
@@ -1246,12 +2440,11 @@ void handler_elimina_circolo(GtkButton *button, gpointer user_data)
 	if ( !alert("Sei sicuro di voler eliminare il circolo?") )
 		return;	
 
-	elimina_file_circolo(circolo_sel);
+	//l'elenco viene aggiornato al termine dell'eliminazione
+	elimina_file_circolo_async(circolo_sel, fine_elimina_circolo, NULL);
 
 	g_free(circolo_sel);
 	g_free(dir_cir);
-
-	handler_apri_circolo(NULL, NULL);
 }
 
 
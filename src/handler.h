@@ -8,6 +8,8 @@
 
 #include <gtk/gtk.h>
 
+#include "struttura_dati.h"
+
 /* Inizio interfaccia del modulo handler */
 
 extern "C" {
@@ -88,8 +90,8 @@ void handler_visualizza_campo(GtkButton *button, gpointer user_data);
  */
 void aggiorna_tabella_ore(GtkCalendar *calendario, gpointer user_data);
 
-/** Disegna la base della tabella ore.
- * Disegna gli orari e le righe per i campi
+/** Disegna la tabella ore.
+ * Crea la tabella alla prima chiamata e la riempie con i campi del circolo
  */
 void disegna_tabella_ore();
 
@@ -98,6 +100,33 @@ void disegna_tabella_ore();
  */
 void handler_aggiungi_campo(GtkButton *button, gpointer user_data);
 
+/** Mostra la finestra degli orari di prenotazione del circolo.
+ */
+void handler_orari_circolo(GtkMenuItem *item, gpointer user_data);
+
+/** Mostra la finestra degli orari di prenotazione del campo in modifica.
+ */
+void handler_orari_campo(GtkButton *button, gpointer user_data);
+
+/** Abilita le caselle degli orari se il campo ha orari propri.
+ * @param[in] propri Casella degli orari propri
+ */
+void handler_orari_propri(GtkToggleButton *propri, gpointer user_data);
+
+/** Salva gli orari di prenotazione del circolo o del campo.
+ * Ridisegna la tabella delle ore con i nuovi orari
+ */
+void handler_salva_orari(GtkButton *button, gpointer user_data);
+
+/** Mostra la finestra di diagnostica con le statistiche raccolte.
+ * Le statistiche sono presenti solo se il programma è compilato con PRESTAZIONI
+ */
+void handler_diagnostica(GtkWidget *widget, gpointer user_data);
+
+/** Azzera le statistiche e aggiorna la finestra di diagnostica.
+ */
+void handler_azzera_diagnostica(GtkButton *button, gpointer user_data);
+
 /** Crea l'elenco dei circoli caricabili e lo mostra.
  */
 void handler_apri_circolo(GtkMenuItem *button, gpointer user_data);
@@ -130,10 +159,100 @@ void handler_elenco_soci(GtkMenuItem *button, gpointer user_data);
  */
 void handler_elenco_campi(GtkMenuItem *button, gpointer user_data);
 
-/** Mostra i dati dell'ora.
- * @param[in] ora_ Ora da visualizzare
+/** Visualizza l'elenco dei corsi.
+ * Riempie anche l'elenco dei giocatori da scegliere come istruttori o iscritti
+ */
+void handler_elenco_corsi(GtkMenuItem *button, gpointer user_data);
+
+/** Aggiunge un corso con il nome e l'istruttore scelti.
+ */
+void handler_aggiungi_corso(GtkButton *button, gpointer user_data);
+
+/** Iscrive il giocatore scelto al corso selezionato.
+ */
+void handler_iscrivi_corso(GtkButton *button, gpointer user_data);
+
+/** Programma le lezioni settimanali del corso selezionato sui campi indicati.
+ */
+void handler_programma_corso(GtkButton *button, gpointer user_data);
+
+/** Sposta tutte le lezioni del corso selezionato.
+ */
+void handler_sposta_corso(GtkButton *button, gpointer user_data);
+
+/** Elimina il corso selezionato con tutte le sue lezioni.
+ */
+void handler_elimina_corso(GtkButton *button, gpointer user_data);
+
+/** Visualizza la finestra del torneo.
+ * Mostra gli incontri dell'eventuale torneo già pianificato
+ */
+void handler_torneo(GtkMenuItem *item, gpointer user_data);
+
+/** Crea il torneo con i giocatori selezionati e prenota i suoi incontri.
+ * Il torneo precedente viene sostituito, le sue prenotazioni restano nel circolo
+ */
+void handler_pianifica_torneo(GtkButton *button, gpointer user_data);
+
+/** Ripianifica gli incontri del torneo da un giorno e un orario.
+ * Gli incontri prenotati prima restano dove sono, gli altri vengono spostati
+ */
+void handler_ripianifica_torneo(GtkButton *button, gpointer user_data);
+
+/** Visualizza le richieste di prenotazione da allocare sui campi.
+ */
+void handler_allocazione(GtkMenuItem *item, gpointer user_data);
+
+/** Aggiunge una richiesta con il giocatore, l'orario e le preferenze scelti.
+ */
+void handler_aggiungi_richiesta(GtkButton *button, gpointer user_data);
+
+/** Toglie la richiesta selezionata.
+ */
+void handler_togli_richiesta(GtkButton *button, gpointer user_data);
+
+/** Assegna campi e orari alle richieste per il giorno selezionato nel calendario.
+ */
+void handler_calcola_allocazione(GtkButton *button, gpointer user_data);
+
+/** Prenota tutte le richieste soddisfatte nel giorno selezionato.
+ * Le richieste non soddisfatte restano nell'elenco
+ */
+void handler_prenota_allocazione(GtkButton *button, gpointer user_data);
+
+/** Visualizza l'occupazione dei campi nel mese del giorno selezionato nel calendario.
+ */
+void handler_occupazione(GtkMenuItem *item, gpointer user_data);
+
+/** Calcola l'occupazione dei campi nel periodo inserito.
+ * Mostra la mappa per fascia oraria e giorno della settimana del campo scelto
+ * e i totali per campo, terreno e copertura
+ */
+void handler_calcola_occupazione(GtkButton *button, gpointer user_data);
+
+/** Filtra l'elenco dei giocatori o dei soci con il testo cercato.
+ * @param[in] cerca Casella di ricerca
+ */
+void handler_cerca_giocatori(GtkEditable *cerca, gpointer user_data);
+
+/** Filtra i giocatori proposti nella prenotazione con il testo cercato.
+ * @param[in] cerca Casella di ricerca
+ */
+void handler_cerca_ora(GtkEditable *cerca, gpointer user_data);
+
+/** Cambia il numero di giorni mostrati dalla tabella delle ore.
+ * @param[in] giorni Casella del numero di giorni
+ */
+void handler_giorni_tabella(GtkSpinButton *giorni, gpointer user_data);
+
+/** Mostra i dati dell'ora cliccata nella tabella.
+ * Se la cella è libera prepara la prenotazione di una nuova ora
+ * @param[in] campo Campo della cella
+ * @param[in] giorno Giorno della cella
+ * @param[in] orario_cella Orario d'inizio della cella in minuti
+ * @param[in] ora Ora da visualizzare, 0 se la cella è libera
  */
-void handler_mostra_ora(GtkButton *button, gpointer ora_);
+void handler_mostra_ora(campo_t *campo, const char giorno[], int orario_cella, ora_t *ora, gpointer user_data);
 
 /** Visualizza il prenotante dell'ora.
  * @param[in] ora_ Ora
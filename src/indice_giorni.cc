@@ -0,0 +1,407 @@
+/**
+ * @file
+ * File contenente il modulo indice_giorni.
+ * Indicizza le ore prenotate per giorno e per campo, così che la tabella
+ * possa chiedere le ore dei soli giorni visibili senza scorrere tutte le ore dei campi.
+ * Le prenotazioni ricorrenti non vengono indicizzate: le loro occorrenze vengono create
+ * solo per i giorni richiesti e tenute finché le ore o le regole del campo non cambiano
+ */
+
+#include <glib.h>
+#include <cstdio>
+
+#include "indice_giorni.h"
+#include "accesso_dati.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+/** Indice delle ore di un circolo.
+ * giorni associa a ogni giorno giuliano una tabella che associa a ogni campo
+ * l'array delle sue ore in ordine di orario,
+ * ore associa a ogni ora indicizzata il giorno in cui è stata inserita,
+ * espansi ha la stessa forma di giorni e contiene per i giorni richiesti le ore
+ * dei campi con prenotazioni ricorrenti insieme alle occorrenze delle regole
+ */
+struct stato_giorni_t {
+	GHashTable *giorni;
+	GHashTable *ore;
+	GHashTable *espansi;
+};
+
+static void libera_ore(gpointer ore)
+{
+	g_ptr_array_free( (GPtrArray *) ore, TRUE );
+}
+
+/** Dealloca un array di espansi insieme alle occorrenze che contiene.
+ */
+static void libera_espansi(gpointer ore_)
+{
+	GPtrArray *ore = (GPtrArray *) ore_;
+
+	for (guint i = 0; i < ore->len; i++){
+		ora_t *ora = (ora_t *) g_ptr_array_index(ore, i);
+		if (ora->regola == 0)
+			continue;
+
+		g_string_free(ora->data, TRUE);
+		g_free(ora);
+	}
+
+	g_ptr_array_free(ore, TRUE);
+}
+
+static void libera_campi_espansi(gpointer campi)
+{
+	g_hash_table_destroy( (GHashTable *) campi );
+}
+
+/** Inserisce l'ora nell'array mantenendo l'ordine per orario.
+ */
+static void inserisci_in_ordine(GPtrArray *ore, ora_t *ora)
+{
+	//ricerca binaria della posizione
+	guint inizio = 0, fine = ore->len;
+	while (inizio < fine){
+		guint medio = (inizio + fine) / 2;
+		if ( ((ora_t *) g_ptr_array_index(ore, medio))->orario <= ora->orario )
+			inizio = medio + 1;
+		else
+			fine = medio;
+	}
+
+	g_ptr_array_insert(ore, inizio, ora);
+}
+
+/** Ritorna le ore prenotate singolarmente di un campo in un giorno, 0 se non ce ne sono.
+ */
+static GPtrArray *ore_indicizzate(stato_giorni_t *stato, campo_t *campo, guint giorno)
+{
+	GHashTable *campi = (GHashTable *) g_hash_table_lookup(stato->giorni, GUINT_TO_POINTER(giorno));
+	if (campi == 0)
+		return 0;
+
+	return (GPtrArray *) g_hash_table_lookup(campi, campo);
+}
+
+/** Scarta le occorrenze espanse di un campo in un giorno.
+ */
+static void invalida_giorno(stato_giorni_t *stato, campo_t *campo, guint giorno)
+{
+	GHashTable *campi = (GHashTable *) g_hash_table_lookup(stato->espansi, GUINT_TO_POINTER(giorno));
+	if (campi == 0)
+		return;
+
+	g_hash_table_remove(campi, campo);
+	if (g_hash_table_size(campi) == 0)
+		g_hash_table_remove(stato->espansi, GUINT_TO_POINTER(giorno));
+}
+
+static gboolean togli_campo(gpointer giorno, gpointer campi, gpointer campo)
+{
+	g_hash_table_remove( (GHashTable *) campi, campo );
+
+	return g_hash_table_size( (GHashTable *) campi ) == 0;
+}
+
+/** Scarta le occorrenze espanse di un campo in tutti i giorni.
+ */
+static void invalida_campo(stato_giorni_t *stato, campo_t *campo)
+{
+	g_hash_table_foreach_remove(stato->espansi, togli_campo, campo);
+}
+
+/** Crea le ore di un campo in un giorno unendo le ore indicizzate e le occorrenze delle regole.
+ * @return Array da aggiungere agli espansi, 0 se nessuna regola si ripete nel giorno
+ */
+static GPtrArray *espandi_giorno(stato_giorni_t *stato, campo_t *campo, guint giorno)
+{
+	GPtrArray *ore = 0;
+	char *data = 0;
+
+	for (GList *tmp = campo->regole; tmp != NULL; tmp = g_list_next(tmp)){
+		regola_t *regola = (regola_t *) tmp->data;
+		if ( !regola_nel_giorno(regola, giorno) )
+			continue;
+
+		if (ore == 0){
+			GPtrArray *indicizzate = ore_indicizzate(stato, campo, giorno);
+			ore = g_ptr_array_new();
+			for (guint i = 0; indicizzate != 0 && i < indicizzate->len; i++)
+				g_ptr_array_add(ore, g_ptr_array_index(indicizzate, i));
+			data = data_da_giorno(giorno);
+		}
+
+		ora_t *ora = g_new(ora_t, 1);
+		ora->orario = regola->orario;
+		ora->data = g_string_new(data);
+		ora->durata = regola->durata;
+		ora->prenotante = regola->prenotante;
+		ora->regola = regola;
+		ora->corso = regola->corso;
+		inserisci_in_ordine(ore, ora);
+	}
+
+	g_free(data);
+
+	return ore;
+}
+
+static void libera_campi(gpointer campi)
+{
+	g_hash_table_destroy( (GHashTable *) campi );
+}
+
+/** Aggiunge l'ora all'indice mantenendo l'ordine per orario.
+ */
+static void indicizza_ora(stato_giorni_t *stato, ora_t *ora, campo_t *campo)
+{
+	guint giorno = giorno_da_data(ora->data->str);
+	if (giorno == 0)
+		return;
+
+	GHashTable *campi = (GHashTable *) g_hash_table_lookup(stato->giorni, GUINT_TO_POINTER(giorno));
+	if (campi == 0){
+		campi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_ore);
+		g_hash_table_insert(stato->giorni, GUINT_TO_POINTER(giorno), campi);
+	}
+
+	GPtrArray *ore = (GPtrArray *) g_hash_table_lookup(campi, campo);
+	if (ore == 0){
+		ore = g_ptr_array_new();
+		g_hash_table_insert(campi, campo, ore);
+	}
+
+	inserisci_in_ordine(ore, ora);
+	g_hash_table_insert(stato->ore, ora, GUINT_TO_POINTER(giorno));
+	invalida_giorno(stato, campo, giorno);
+}
+
+/** Toglie l'ora dall'indice.
+ */
+static void rimuovi_ora(stato_giorni_t *stato, ora_t *ora, campo_t *campo)
+{
+	gpointer giorno;
+	if ( !g_hash_table_lookup_extended(stato->ore, ora, NULL, &giorno) )
+		return;
+
+	g_hash_table_remove(stato->ore, ora);
+	invalida_giorno(stato, campo, GPOINTER_TO_UINT(giorno));
+
+	GHashTable *campi = (GHashTable *) g_hash_table_lookup(stato->giorni, giorno);
+	GPtrArray *ore = (GPtrArray *) g_hash_table_lookup(campi, campo);
+
+	g_ptr_array_remove(ore, ora);
+
+	if (ore->len == 0)
+		g_hash_table_remove(campi, campo);
+	if (g_hash_table_size(campi) == 0)
+		g_hash_table_remove(stato->giorni, giorno);
+}
+
+static void libera_stato(stato_giorni_t *stato)
+{
+	g_hash_table_destroy(stato->espansi);
+	g_hash_table_destroy(stato->giorni);
+	g_hash_table_destroy(stato->ore);
+	g_free(stato);
+}
+
+/** Osservatore che mantiene l'indice allineato alle ore del circolo.
+ */
+static void osserva_circolo(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati)
+{
+	stato_giorni_t *stato = (stato_giorni_t *) dati;
+
+	switch (tipo){
+		case ELEM_CIRCOLO:
+			if (modifica == RIMOZIONE){
+				((circolo_t *) elemento)->giorni = 0;
+				libera_stato(stato);
+			}
+			break;
+
+		case ELEM_CAMPO:
+			//le ore di un campo eliminato non vengono notificate una per una
+			if (modifica == RIMOZIONE){
+				GPtrArray *ore = ((campo_t *) elemento)->ore;
+				for (guint i = 0; i < ore->len; i++)
+					rimuovi_ora(stato, (ora_t *) g_ptr_array_index(ore, i), (campo_t *) elemento);
+				invalida_campo(stato, (campo_t *) elemento);
+			}
+			break;
+
+		case ELEM_ORA:
+			rimuovi_ora(stato, (ora_t *) elemento, (campo_t *) contenitore);
+			if (modifica != RIMOZIONE)
+				indicizza_ora(stato, (ora_t *) elemento, (campo_t *) contenitore);
+			break;
+
+		case ELEM_REGOLA:
+			invalida_campo(stato, (campo_t *) contenitore);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** Costruisce l'indice del circolo e registra l'osservatore.
+ */
+static stato_giorni_t *attiva_indice(circolo_t *circolo)
+{
+	D1(cout<<"Attivazione indice dei giorni"<<endl)
+
+	stato_giorni_t *stato = g_new(stato_giorni_t, 1);
+	stato->giorni = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_campi);
+	stato->ore = g_hash_table_new(g_direct_hash, g_direct_equal);
+	stato->espansi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_campi_espansi);
+
+	for (guint c = 0; c < circolo->campi->len; c++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, c);
+		for (guint o = 0; o < campo->ore->len; o++)
+			indicizza_ora(stato, (ora_t *) g_ptr_array_index(campo->ore, o), campo);
+	}
+
+	circolo->giorni = stato;
+	aggiungi_osservatore(circolo, osserva_circolo, stato);
+
+	return stato;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+guint giorno_da_data(const char data[])
+{
+	int giorno, mese, anno;
+
+	if (data == 0 || sscanf(data, "%d-%d-%d", &giorno, &mese, &anno) != 3)
+		return 0;
+
+	if ( !g_date_valid_dmy(giorno, (GDateMonth) mese, anno) )
+		return 0;
+
+	GDate date;
+	g_date_clear(&date, 1);
+	g_date_set_dmy(&date, giorno, (GDateMonth) mese, anno);
+
+	return g_date_get_julian(&date);
+}
+
+char *data_da_giorno(guint giorno)
+{
+	GDate date;
+	g_date_clear(&date, 1);
+	g_date_set_julian(&date, giorno);
+
+	return g_strdup_printf("%02d-%02d-%04d", g_date_get_day(&date), g_date_get_month(&date), g_date_get_year(&date));
+}
+
+const GPtrArray *ore_del_giorno(circolo_t *circolo, campo_t *campo, guint giorno)
+{
+	if (circolo == 0) return 0;
+
+	stato_giorni_t *stato = (stato_giorni_t *) circolo->giorni;
+	if (stato == 0)
+		stato = attiva_indice(circolo);
+
+	if (campo->regole == 0)
+		return ore_indicizzate(stato, campo, giorno);
+
+	GHashTable *campi = (GHashTable *) g_hash_table_lookup(stato->espansi, GUINT_TO_POINTER(giorno));
+	GPtrArray *ore = (campi != 0) ? (GPtrArray *) g_hash_table_lookup(campi, campo) : 0;
+	if (ore != 0)
+		return ore;
+
+	ore = espandi_giorno(stato, campo, giorno);
+	if (ore == 0)
+		return ore_indicizzate(stato, campo, giorno);
+
+	if (campi == 0){
+		campi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_espansi);
+		g_hash_table_insert(stato->espansi, GUINT_TO_POINTER(giorno), campi);
+	}
+	g_hash_table_insert(campi, campo, ore);
+
+	return ore;
+}
+
+bool ora_libera(circolo_t *circolo, campo_t *campo, guint giorno, int orario, int durata)
+{
+	if (circolo == 0) return true;
+
+	stato_giorni_t *stato = (stato_giorni_t *) circolo->giorni;
+	if (stato == 0)
+		stato = attiva_indice(circolo);
+
+	const GPtrArray *ore = ore_indicizzate(stato, campo, giorno);
+
+	for (guint i = 0; ore != 0 && i < ore->len; i++){
+		ora_t *ora = (ora_t *) g_ptr_array_index(ore, i);
+
+		//le ore sono in ordine di orario
+		if (ora->orario >= orario + durata)
+			break;
+		if (orario < ora->orario + ora->durata)
+			return false;
+	}
+
+	//le regole vengono controllate senza espanderle
+	for (GList *tmp = campo->regole; tmp != NULL; tmp = g_list_next(tmp)){
+		regola_t *regola = (regola_t *) tmp->data;
+
+		if (orario < regola->orario + regola->durata && regola->orario < orario + durata &&
+				regola_nel_giorno(regola, giorno) )
+			return false;
+	}
+
+	return true;
+}
+
+guint conflitto_regola(circolo_t *circolo, campo_t *campo, const regola_t *regola, const corso_t *escluso)
+{
+	if (circolo == 0) return 0;
+
+	stato_giorni_t *stato = (stato_giorni_t *) circolo->giorni;
+	if (stato == 0)
+		stato = attiva_indice(circolo);
+
+	//regole del campo che si sovrappongono per orario e periodo
+	for (GList *tmp = campo->regole; tmp != NULL; tmp = g_list_next(tmp)){
+		const regola_t *altra = (const regola_t *) tmp->data;
+
+		if (altra == regola || (escluso != 0 && altra->corso == escluso) || altra->orario >= regola->orario + regola->durata ||
+				regola->orario >= altra->orario + altra->durata ||
+				altra->inizio > regola->fine || regola->inizio > altra->fine)
+			continue;
+
+		//si scorrono le occorrenze della regola nel periodo comune
+		guint fine = MIN(regola->fine, altra->fine);
+		for (guint g = prossima_occorrenza(regola, altra->inizio); g != 0 && g <= fine;
+				g = prossima_occorrenza(regola, g + 1))
+			if ( regola_nel_giorno(altra, g) )
+				return g;
+	}
+
+	//ore singole nei giorni delle occorrenze, cercate nell'indice
+	for (guint g = prossima_occorrenza(regola, regola->inizio); g != 0; g = prossima_occorrenza(regola, g + 1)){
+		const GPtrArray *ore = ore_indicizzate(stato, campo, g);
+
+		for (guint i = 0; ore != 0 && i < ore->len; i++){
+			ora_t *ora = (ora_t *) g_ptr_array_index(ore, i);
+
+			if (ora->orario >= regola->orario + regola->durata)
+				break;
+			if (regola->orario < ora->orario + ora->durata)
+				return g;
+		}
+	}
+
+	return 0;
+}
+
+/* Fine definizioni pubbliche */
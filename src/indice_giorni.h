@@ -0,0 +1,68 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo indice_giorni.cc
+ */
+
+#ifndef INDICE_GIORNI
+#define INDICE_GIORNI
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo indice_giorni */
+
+/** Converte una data nel formato gg-mm-aaaa nel suo giorno giuliano.
+ * @param[in] data Data da convertire
+ * @return Giorno giuliano, 0 se la data non è valida
+ */
+guint giorno_da_data(const char data[]);
+
+/** Converte un giorno giuliano in una data nel formato gg-mm-aaaa.
+ * @param[in] giorno Giorno giuliano
+ * @return Data, da liberare con g_free()
+ */
+char *data_da_giorno(guint giorno);
+
+/** Ritorna le ore prenotate di un campo in un giorno.
+ * Alla prima chiamata costruisce l'indice del circolo, che viene poi
+ * mantenuto allineato tramite gli osservatori di accesso_dati; le chiamate
+ * successive non scorrono le ore del campo
+ * @param[in,out] circolo Circolo del campo
+ * @param[in] campo Campo
+ * @param[in] giorno Giorno giuliano
+ * Se il campo ha prenotazioni ricorrenti l'array contiene anche le loro occorrenze nel giorno,
+ * create alla prima richiesta del giorno e riconoscibili dal campo regola
+ * @return Array delle ore in ordine di orario, 0 se non ce ne sono.
+ * L'array appartiene all'indice ed è valido fino alla prossima modifica delle ore o delle regole del campo
+ */
+const GPtrArray *ore_del_giorno(circolo_t *circolo, campo_t *campo, guint giorno);
+
+/** Controlla se un campo è libero in un intervallo di un giorno.
+ * Scorre solo le ore indicizzate del giorno e le regole del campo, senza crearne le occorrenze
+ * @param[in,out] circolo Circolo del campo
+ * @param[in] campo Campo
+ * @param[in] giorno Giorno giuliano
+ * @param[in] orario Inizio dell'intervallo in minuti
+ * @param[in] durata Durata dell'intervallo in minuti
+ * @return TRUE se nessuna ora prenotata si sovrappone all'intervallo
+ */
+bool ora_libera(circolo_t *circolo, campo_t *campo, guint giorno, int orario, int durata);
+
+/** Cerca la prima occorrenza di una regola che si sovrappone alle prenotazioni del campo.
+ * Le altre regole vengono confrontate solo se si sovrappongono per orario e periodo,
+ * le ore singole vengono cercate nell'indice nei soli giorni delle occorrenze;
+ * la regola può essere già agganciata al campo oppure solo preparata per il controllo.
+ * Le regole del corso escluso non vengono confrontate, serve quando tutte le lezioni
+ * di un corso vengono spostate insieme
+ * @param[in,out] circolo Circolo del campo
+ * @param[in] campo Campo
+ * @param[in] regola Regola da controllare
+ * @param[in] escluso Corso le cui regole non vanno confrontate, 0 per confrontarle tutte
+ * @return Giorno giuliano del primo conflitto, 0 se la regola è libera
+ */
+guint conflitto_regola(circolo_t *circolo, campo_t *campo, const regola_t *regola, const corso_t *escluso);
+
+/* Fine interfaccia del modulo indice_giorni */
+
+#endif
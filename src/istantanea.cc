@@ -0,0 +1,851 @@
+/**
+ * @file
+ * File contenente il modulo istantanea.
+ * Fornisce istantanee immutabili del circolo leggibili da altri thread.
+ * I dati sono mantenuti in alberi persistenti (trie a 32 vie) con condivisione strutturale:
+ * un nodo con un solo riferimento appartiene solo allo stato corrente e viene modificato sul posto,
+ * un nodo condiviso con un'istantanea viene prima copiato insieme al percorso che porta a lui
+ */
+
+#include <glib.h>
+#include <cstring>
+#include <cstddef>
+
+#include "istantanea.h"
+#include "accesso_dati.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const int BIT_RAMO = 5;				/**< Bit della chiave consumati da ogni livello */
+const int N_RAMI = 1 << BIT_RAMO;		/**< Figli di ogni nodo interno */
+const guint MASCHERA_RAMO = N_RAMI - 1;		/**< Maschera per estrarre l'indice del figlio */
+
+/** Intestazione comune a tutti i nodi condivisi.
+ * Il contatore di riferimenti è aggiornato in modo atomico
+ * perché i nodi possono essere rilasciati da qualsiasi thread
+ */
+struct nodo_t {
+	volatile gint rif;
+	void (*libera)(nodo_t *nodo);
+};
+
+/** Nodo interno del trie.
+ */
+struct ramo_t {
+	nodo_t base;
+	nodo_t *figli[N_RAMI];
+};
+
+/** Trie persistente indicizzato da interi non negativi.
+ * Viene contenuto per valore nel nodo che lo possiede
+ */
+struct trie_t {
+	int livelli;
+	nodo_t *radice;
+};
+
+/** Foglia contenente un giocatore. */
+struct nodo_giocatore_t {
+	nodo_t base;
+	ist_giocatore_t dati;
+};
+
+/** Foglia contenente le ore di un giorno di un campo, ordinate per orario. */
+struct nodo_giorno_t {
+	nodo_t base;
+	int n;
+	ist_ora_t ore[1];
+};
+
+/** Foglia contenente una prenotazione ricorrente. */
+struct nodo_regola_t {
+	nodo_t base;
+	ist_regola_t dati;
+};
+
+/** Foglia contenente un corso. */
+struct nodo_corso_t {
+	nodo_t base;
+	ist_corso_t dati;
+};
+
+/** Foglia contenente un campo con il trie dei suoi giorni e quello delle sue regole. */
+struct nodo_campo_t {
+	nodo_t base;
+	ist_campo_t dati;
+	trie_t giorni;
+	trie_t regole;
+};
+
+/** Radice di un'istantanea.
+ */
+struct istantanea_t {
+	nodo_t base;
+	char *nome;
+	char *indirizzo;
+	char *email;
+	char *telefono;
+	orari_t orari;
+	int n_campi;
+	int n_soci;
+	trie_t giocatori;
+	trie_t campi;
+	trie_t corsi;
+};
+
+/** Stato corrente mantenuto per il circolo vivo.
+ * Le tabelle delle chiavi ricordano sotto quale chiave è stato inserito ogni elemento,
+ * in modo da gestire i cambi di ID e di numero
+ */
+struct stato_ist_t {
+	istantanea_t *corrente;
+	GHashTable *chiavi_giocatori;
+	GHashTable *chiavi_campi;
+};
+
+static void nodo_rilascia(nodo_t *nodo)
+{
+	if (nodo == 0) return;
+
+	if ( g_atomic_int_dec_and_test(&nodo->rif) )
+		nodo->libera(nodo);
+}
+
+static inline nodo_t *nodo_ref(nodo_t *nodo)
+{
+	if (nodo != 0)
+		g_atomic_int_inc(&nodo->rif);
+
+	return nodo;
+}
+
+/** Indica se il nodo appartiene solo allo stato corrente e può essere modificato sul posto. */
+static inline bool nodo_esclusivo(nodo_t *nodo)
+{
+	return g_atomic_int_get(&nodo->rif) == 1;
+}
+
+static void libera_ramo(nodo_t *nodo)
+{
+	ramo_t *ramo = (ramo_t *) nodo;
+	for (int i = 0; i < N_RAMI; i++)
+		nodo_rilascia(ramo->figli[i]);
+
+	g_free(ramo);
+}
+
+static ramo_t *nuovo_ramo()
+{
+	ramo_t *ramo = g_new0(ramo_t, 1);
+	ramo->base.rif = 1;
+	ramo->base.libera = libera_ramo;
+
+	return ramo;
+}
+
+/** Rende modificabile il ramo puntato dallo slot.
+ * Se il ramo è condiviso ne crea una copia che sostituisce l'originale nello slot,
+ * se lo slot è vuoto crea un ramo nuovo
+ * @param[in,out] slot Slot che punta al ramo
+ * @return Ramo modificabile
+ */
+static ramo_t *ramo_scrivibile(nodo_t **slot)
+{
+	ramo_t *ramo = (ramo_t *) *slot;
+
+	if (ramo == 0){
+		ramo = nuovo_ramo();
+		*slot = &ramo->base;
+		return ramo;
+	}
+
+	if ( nodo_esclusivo(&ramo->base) )
+		return ramo;
+
+	ramo_t *copia = nuovo_ramo();
+	for (int i = 0; i < N_RAMI; i++)
+		copia->figli[i] = nodo_ref(ramo->figli[i]);
+
+	*slot = &copia->base;
+	nodo_rilascia(&ramo->base);
+
+	return copia;
+}
+
+/** Ritorna la foglia con la chiave data, 0 se assente.
+ */
+static nodo_t *trie_cerca(const trie_t *trie, guint chiave)
+{
+	if ( trie->livelli == 0 || (chiave >> (BIT_RAMO * trie->livelli)) != 0 )
+		return 0;
+
+	nodo_t *nodo = trie->radice;
+	for (int l = trie->livelli - 1; l >= 0 && nodo != 0; l--)
+		nodo = ((ramo_t *) nodo)->figli[ (chiave >> (BIT_RAMO * l)) & MASCHERA_RAMO ];
+
+	return nodo;
+}
+
+/** Ritorna lo slot modificabile della foglia con la chiave data.
+ * Copia i rami condivisi lungo il percorso e aggiunge livelli se la chiave non è rappresentabile
+ */
+static nodo_t **trie_slot(trie_t *trie, guint chiave)
+{
+	if (trie->livelli == 0)
+		trie->livelli = 1;
+
+	while ( (chiave >> (BIT_RAMO * trie->livelli)) != 0 ){
+		//la vecchia radice diventa il primo figlio della nuova
+		ramo_t *radice = nuovo_ramo();
+		radice->figli[0] = trie->radice;
+		trie->radice = &radice->base;
+		trie->livelli++;
+	}
+
+	nodo_t **slot = &trie->radice;
+	for (int l = trie->livelli - 1; l >= 0; l--){
+		ramo_t *ramo = ramo_scrivibile(slot);
+		slot = &ramo->figli[ (chiave >> (BIT_RAMO * l)) & MASCHERA_RAMO ];
+	}
+
+	return slot;
+}
+
+/** Rilascia i rami rimasti vuoti lungo il percorso della chiave.
+ * I rami del percorso sono esclusivi perché trie_slot() li ha appena resi modificabili
+ */
+static void pota_ramo(nodo_t **slot, int livello, guint chiave)
+{
+	ramo_t *ramo = (ramo_t *) *slot;
+	if (ramo == 0 || livello == 0) return;
+
+	pota_ramo(&ramo->figli[ (chiave >> (BIT_RAMO * (livello - 1))) & MASCHERA_RAMO ], livello - 1, chiave);
+
+	for (int i = 0; i < N_RAMI; i++)
+		if (ramo->figli[i] != 0)
+			return;
+
+	*slot = 0;
+	nodo_rilascia(&ramo->base);
+}
+
+/** Sostituisce la foglia con la chiave data.
+ * Il riferimento alla nuova foglia passa al trie, la vecchia viene rilasciata;
+ * passando 0 la foglia viene rimossa insieme ai rami rimasti vuoti,
+ * così chiavi sempre nuove, come gli ID dei giocatori, non accumulano rami
+ */
+static void trie_imposta(trie_t *trie, guint chiave, nodo_t *foglia)
+{
+	if (foglia == 0 && trie_cerca(trie, chiave) == 0)
+		return;
+
+	nodo_t **slot = trie_slot(trie, chiave);
+	nodo_t *vecchia = *slot;
+	*slot = foglia;
+
+	nodo_rilascia(vecchia);
+
+	if (foglia == 0){
+		pota_ramo(&trie->radice, trie->livelli, chiave);
+		if (trie->radice == 0)
+			trie->livelli = 0;
+	}
+}
+
+/** Visita ricorsiva in ordine di chiave delle foglie di un sotto albero. */
+static void visita_nodo(const nodo_t *nodo, int livello, void (*funzione)(const nodo_t *, void *), void *dati)
+{
+	if (nodo == 0) return;
+
+	if (livello == 0){
+		funzione(nodo, dati);
+		return;
+	}
+
+	const ramo_t *ramo = (const ramo_t *) nodo;
+	for (int i = 0; i < N_RAMI; i++)
+		visita_nodo(ramo->figli[i], livello - 1, funzione, dati);
+}
+
+static void trie_foreach(const trie_t *trie, void (*funzione)(const nodo_t *, void *), void *dati)
+{
+	visita_nodo(trie->radice, trie->livelli, funzione, dati);
+}
+
+/** Converte la data (gg-mm-aaaa) nel giorno giuliano usato come chiave.
+ * @return Giorno giuliano, 0 se la data non è valida
+ */
+static guint chiave_data(const char *data)
+{
+	for (int i = 0; i < 10; i++)
+		if ( data[i] == '\0' )
+			return 0;
+
+	int giorno = (data[0]-'0')*10 + (data[1]-'0');
+	int mese = (data[3]-'0')*10 + (data[4]-'0');
+	int anno = (data[6]-'0')*1000 + (data[7]-'0')*100 + (data[8]-'0')*10 + (data[9]-'0');
+
+	if ( !g_date_valid_dmy(giorno, (GDateMonth) mese, anno) )
+		return 0;
+
+	GDate d;
+	g_date_clear(&d, 1);
+	g_date_set_dmy(&d, giorno, (GDateMonth) mese, anno);
+
+	return g_date_get_julian(&d);
+}
+
+static void libera_giocatore(nodo_t *nodo)
+{
+	nodo_giocatore_t *g = (nodo_giocatore_t *) nodo;
+
+	g_free(g->dati.nome);
+	g_free(g->dati.cognome);
+	g_free(g->dati.nascita);
+	g_free(g->dati.tessera);
+	g_free(g->dati.telefono);
+	g_free(g->dati.email);
+	g_free(g->dati.classifica);
+	g_free(g->dati.circolo);
+	g_free(g);
+}
+
+static nodo_t *copia_giocatore(const giocatore_t *giocatore)
+{
+	nodo_giocatore_t *g = g_new(nodo_giocatore_t, 1);
+	g->base.rif = 1;
+	g->base.libera = libera_giocatore;
+
+	g->dati.ID = giocatore->ID;
+	g->dati.nome = g_strdup(dato_giocatore(giocatore, DATO_NOME));
+	g->dati.cognome = g_strdup(dato_giocatore(giocatore, DATO_COGNOME));
+	g->dati.nascita = g_strdup(dato_giocatore(giocatore, DATO_NASCITA));
+	g->dati.tessera = g_strdup(dato_giocatore(giocatore, DATO_TESSERA));
+	g->dati.telefono = g_strdup(dato_giocatore(giocatore, DATO_TELEFONO));
+	g->dati.email = g_strdup(dato_giocatore(giocatore, DATO_EMAIL));
+	g->dati.classifica = g_strdup(dato_giocatore(giocatore, DATO_CLASSIFICA));
+	g->dati.circolo = g_strdup(dato_giocatore(giocatore, DATO_CIRCOLO));
+	g->dati.socio = giocatore->socio;
+	g->dati.retta = giocatore->retta;
+
+	return &g->base;
+}
+
+static void libera_giorno(nodo_t *nodo)
+{
+	g_free(nodo);
+}
+
+static nodo_giorno_t *nuovo_giorno(int n)
+{
+	nodo_giorno_t *giorno = (nodo_giorno_t *) g_malloc( offsetof(nodo_giorno_t, ore) + sizeof(ist_ora_t) * (n > 0 ? n : 1) );
+	giorno->base.rif = 1;
+	giorno->base.libera = libera_giorno;
+	giorno->n = n;
+
+	return giorno;
+}
+
+static void libera_regola(nodo_t *nodo)
+{
+	nodo_regola_t *r = (nodo_regola_t *) nodo;
+
+	g_free(r->dati.eccezioni);
+	g_free(r);
+}
+
+static nodo_t *copia_regola(const regola_t *regola)
+{
+	nodo_regola_t *r = g_new(nodo_regola_t, 1);
+	r->base.rif = 1;
+	r->base.libera = libera_regola;
+
+	r->dati.ID = regola->ID;
+	r->dati.orario = regola->orario;
+	r->dati.durata = regola->durata;
+	r->dati.inizio = regola->inizio;
+	r->dati.fine = regola->fine;
+	r->dati.giorni = regola->giorni;
+	r->dati.settimane = regola->settimane;
+	r->dati.prenotante = regola->prenotante->ID;
+	r->dati.corso = (regola->corso != 0) ? regola->corso->ID : 0;
+	r->dati.n_eccezioni = regola->eccezioni->len;
+	r->dati.eccezioni = g_new(guint, regola->eccezioni->len);
+	if (regola->eccezioni->len > 0)
+		memcpy(r->dati.eccezioni, regola->eccezioni->data, sizeof(guint) * regola->eccezioni->len);
+
+	return &r->base;
+}
+
+static void libera_corso(nodo_t *nodo)
+{
+	nodo_corso_t *c = (nodo_corso_t *) nodo;
+
+	g_free(c->dati.nome);
+	g_free(c->dati.iscritti);
+	g_free(c);
+}
+
+static nodo_t *copia_corso(const corso_t *corso)
+{
+	nodo_corso_t *c = g_new(nodo_corso_t, 1);
+	c->base.rif = 1;
+	c->base.libera = libera_corso;
+
+	c->dati.ID = corso->ID;
+	c->dati.nome = g_strdup(corso->nome->str);
+	c->dati.istruttore = corso->istruttore->ID;
+	c->dati.n_iscritti = g_list_length(corso->iscritti);
+	c->dati.iscritti = g_new(int, c->dati.n_iscritti);
+
+	int i = 0;
+	for (GList *tmp = corso->iscritti; tmp != NULL; tmp = g_list_next(tmp))
+		c->dati.iscritti[i++] = ((giocatore_t *) tmp->data)->ID;
+
+	return &c->base;
+}
+
+static void libera_campo(nodo_t *nodo)
+{
+	nodo_campo_t *c = (nodo_campo_t *) nodo;
+
+	g_free(c->dati.note);
+	nodo_rilascia(c->giorni.radice);
+	nodo_rilascia(c->regole.radice);
+	g_free(c);
+}
+
+static nodo_campo_t *copia_campo(const campo_t *campo)
+{
+	nodo_campo_t *c = g_new(nodo_campo_t, 1);
+	c->base.rif = 1;
+	c->base.libera = libera_campo;
+
+	c->dati.numero = campo->numero;
+	c->dati.copertura = campo->copertura;
+	c->dati.terreno = campo->terreno;
+	c->dati.note = g_strdup(campo->note->str);
+	c->dati.orari = campo->orari;
+	c->giorni.livelli = 0;
+	c->giorni.radice = 0;
+	c->regole.livelli = 0;
+	c->regole.radice = 0;
+
+	return c;
+}
+
+/** Rende modificabile il campo con la chiave data.
+ * Il campo viene copiato se condiviso, i trie dei giorni e delle regole restano condivisi
+ */
+static nodo_campo_t *campo_scrivibile(trie_t *campi, guint chiave)
+{
+	nodo_campo_t *c = (nodo_campo_t *) trie_cerca(campi, chiave);
+	if (c == 0) return 0;
+
+	nodo_t **slot = trie_slot(campi, chiave);
+	if ( nodo_esclusivo(&c->base) )
+		return c;
+
+	nodo_campo_t *copia = g_new(nodo_campo_t, 1);
+	copia->base.rif = 1;
+	copia->base.libera = libera_campo;
+	copia->dati = c->dati;
+	copia->dati.note = g_strdup(c->dati.note);
+	copia->giorni = c->giorni;
+	nodo_ref(copia->giorni.radice);
+	copia->regole = c->regole;
+	nodo_ref(copia->regole.radice);
+
+	*slot = &copia->base;
+	nodo_rilascia(&c->base);
+
+	return copia;
+}
+
+static void libera_radice(nodo_t *nodo)
+{
+	istantanea_t *ist = (istantanea_t *) nodo;
+
+	g_free(ist->nome);
+	g_free(ist->indirizzo);
+	g_free(ist->email);
+	g_free(ist->telefono);
+	nodo_rilascia(ist->giocatori.radice);
+	nodo_rilascia(ist->campi.radice);
+	nodo_rilascia(ist->corsi.radice);
+	g_free(ist);
+}
+
+/** Rende modificabile la radice dello stato corrente.
+ */
+static istantanea_t *radice_scrivibile(stato_ist_t *stato)
+{
+	istantanea_t *ist = stato->corrente;
+	if ( nodo_esclusivo(&ist->base) )
+		return ist;
+
+	istantanea_t *copia = g_new(istantanea_t, 1);
+	*copia = *ist;
+	copia->base.rif = 1;
+	copia->nome = g_strdup(ist->nome);
+	copia->indirizzo = g_strdup(ist->indirizzo);
+	copia->email = g_strdup(ist->email);
+	copia->telefono = g_strdup(ist->telefono);
+	nodo_ref(copia->giocatori.radice);
+	nodo_ref(copia->campi.radice);
+	nodo_ref(copia->corsi.radice);
+
+	stato->corrente = copia;
+	nodo_rilascia(&ist->base);
+
+	return copia;
+}
+
+/** Inserisce o rimuove un'ora nel giorno corrispondente del campo.
+ * Il giorno viene sempre ricostruito: costa quanto le ore di quel giorno.
+ * Le ore con una data non valida restano nell'istantanea sotto la chiave 0,
+ * che nessun giorno giuliano usa, così il backup le conserva
+ */
+static void modifica_giorno(nodo_campo_t *c, const ora_t *ora, bool inserisci)
+{
+	guint chiave = chiave_data(ora->data->str);
+
+	const nodo_giorno_t *vecchio = (const nodo_giorno_t *) trie_cerca(&c->giorni, chiave);
+	int n = (vecchio != 0) ? vecchio->n : 0;
+
+	nodo_giorno_t *giorno = nuovo_giorno(inserisci ? n + 1 : n);
+	int j = 0;
+	bool fatto = false;
+
+	for (int i = 0; i < n; i++){
+		const ist_ora_t *o = &vecchio->ore[i];
+		if (!fatto && inserisci && ora->orario < o->orario){
+			giorno->ore[j].orario = ora->orario;
+			g_strlcpy(giorno->ore[j].data, ora->data->str, sizeof(giorno->ore[j].data));
+			giorno->ore[j].durata = ora->durata;
+			giorno->ore[j].prenotante = ora->prenotante->ID;
+			j++;
+			fatto = true;
+		}
+		if (!fatto && !inserisci && o->orario == ora->orario
+		    && strncmp(o->data, ora->data->str, sizeof(o->data) - 1) == 0){
+			fatto = true;
+			continue;
+		}
+		giorno->ore[j++] = *o;
+	}
+
+	if (!fatto && inserisci){
+		giorno->ore[j].orario = ora->orario;
+		g_strlcpy(giorno->ore[j].data, ora->data->str, sizeof(giorno->ore[j].data));
+		giorno->ore[j].durata = ora->durata;
+		giorno->ore[j].prenotante = ora->prenotante->ID;
+		j++;
+	}
+
+	giorno->n = j;
+
+	if (j == 0){
+		nodo_rilascia(&giorno->base);
+		trie_imposta(&c->giorni, chiave, 0);
+		return;
+	}
+
+	trie_imposta(&c->giorni, chiave, &giorno->base);
+}
+
+/** Inserisce nello stato corrente un campo con tutte le sue ore.
+ */
+static void inserisci_campo(stato_ist_t *stato, campo_t *campo)
+{
+	istantanea_t *radice = radice_scrivibile(stato);
+	nodo_campo_t *c = copia_campo(campo);
+
+	for (guint i = 0; i < campo->ore->len; i++)
+		modifica_giorno(c, (ora_t *) g_ptr_array_index(campo->ore, i), true);
+
+	for (GList *tmp = campo->regole; tmp != NULL; tmp = g_list_next(tmp))
+		trie_imposta(&c->regole, ((regola_t *) tmp->data)->ID, copia_regola( (regola_t *) tmp->data ));
+
+	trie_imposta(&radice->campi, campo->numero, &c->base);
+	g_hash_table_insert(stato->chiavi_campi, campo, GINT_TO_POINTER(campo->numero));
+}
+
+static void inserisci_giocatore(stato_ist_t *stato, giocatore_t *giocatore)
+{
+	istantanea_t *radice = radice_scrivibile(stato);
+
+	gpointer vecchia;
+	if ( g_hash_table_lookup_extended(stato->chiavi_giocatori, giocatore, NULL, &vecchia) &&
+			GPOINTER_TO_INT(vecchia) != giocatore->ID )
+		trie_imposta(&radice->giocatori, GPOINTER_TO_INT(vecchia), 0);
+
+	trie_imposta(&radice->giocatori, giocatore->ID, copia_giocatore(giocatore));
+	g_hash_table_insert(stato->chiavi_giocatori, giocatore, GINT_TO_POINTER(giocatore->ID));
+}
+
+static void libera_stato(stato_ist_t *stato)
+{
+	nodo_rilascia(&stato->corrente->base);
+	g_hash_table_destroy(stato->chiavi_giocatori);
+	g_hash_table_destroy(stato->chiavi_campi);
+	g_free(stato);
+}
+
+/** Osservatore che riporta ogni modifica del circolo nello stato corrente.
+ */
+static void osserva_circolo(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati)
+{
+	stato_ist_t *stato = (stato_ist_t *) dati;
+	istantanea_t *radice = 0;
+	gpointer chiave;
+
+	switch (tipo){
+		case ELEM_CIRCOLO:
+			if (modifica == RIMOZIONE){
+				circolo_t *circolo = (circolo_t *) elemento;
+				circolo->istantanee = 0;
+				libera_stato(stato);
+			}
+			else {
+				radice = radice_scrivibile(stato);
+				radice->orari = ((circolo_t *) elemento)->orari;
+			}
+			break;
+
+		case ELEM_GIOCATORE:
+			if (modifica == RIMOZIONE){
+				if ( !g_hash_table_lookup_extended(stato->chiavi_giocatori, elemento, NULL, &chiave) )
+					break;
+				radice = radice_scrivibile(stato);
+				trie_imposta(&radice->giocatori, GPOINTER_TO_INT(chiave), 0);
+				g_hash_table_remove(stato->chiavi_giocatori, elemento);
+			}
+			else
+				inserisci_giocatore(stato, (giocatore_t *) elemento);
+
+			radice = radice_scrivibile(stato);
+			radice->n_soci = ((circolo_t *) contenitore)->n_soci;
+			break;
+
+		case ELEM_CAMPO:
+			if ( g_hash_table_lookup_extended(stato->chiavi_campi, elemento, NULL, &chiave) ){
+				campo_t *campo = (campo_t *) elemento;
+				radice = radice_scrivibile(stato);
+
+				if (modifica == AGGIORNAMENTO && GPOINTER_TO_INT(chiave) == campo->numero){
+					//il campo mantiene le sue ore, cambiano solo i dati
+					nodo_campo_t *c = campo_scrivibile(&radice->campi, campo->numero);
+					g_free(c->dati.note);
+					c->dati.note = g_strdup(campo->note->str);
+					c->dati.copertura = campo->copertura;
+					c->dati.terreno = campo->terreno;
+					c->dati.orari = campo->orari;
+					break;
+				}
+
+				trie_imposta(&radice->campi, GPOINTER_TO_INT(chiave), 0);
+				g_hash_table_remove(stato->chiavi_campi, elemento);
+			}
+
+			if (modifica != RIMOZIONE)
+				inserisci_campo(stato, (campo_t *) elemento);
+
+			radice = radice_scrivibile(stato);
+			radice->n_campi = ((circolo_t *) contenitore)->n_campi - (modifica == RIMOZIONE ? 1 : 0);
+			break;
+
+		case ELEM_ORA:
+			if ( !g_hash_table_lookup_extended(stato->chiavi_campi, contenitore, NULL, &chiave) )
+				break;
+			radice = radice_scrivibile(stato);
+			modifica_giorno( campo_scrivibile(&radice->campi, GPOINTER_TO_INT(chiave)),
+					(ora_t *) elemento, modifica == INSERIMENTO );
+			break;
+
+		case ELEM_REGOLA:
+			if ( !g_hash_table_lookup_extended(stato->chiavi_campi, contenitore, NULL, &chiave) )
+				break;
+			radice = radice_scrivibile(stato);
+			trie_imposta( &campo_scrivibile(&radice->campi, GPOINTER_TO_INT(chiave))->regole,
+					((regola_t *) elemento)->ID,
+					(modifica == RIMOZIONE) ? 0 : copia_regola( (regola_t *) elemento ) );
+			break;
+
+		case ELEM_CORSO:
+			radice = radice_scrivibile(stato);
+			trie_imposta( &radice->corsi, ((corso_t *) elemento)->ID,
+					(modifica == RIMOZIONE) ? 0 : copia_corso( (corso_t *) elemento ) );
+			break;
+	}
+}
+
+/** Costruisce lo stato corrente dal circolo e registra l'osservatore.
+ */
+static stato_ist_t *attiva_istantanee(circolo_t *circolo)
+{
+	D1(cout<<"Attivazione istantanee"<<endl)
+
+	stato_ist_t *stato = g_new(stato_ist_t, 1);
+	stato->chiavi_giocatori = g_hash_table_new(g_direct_hash, g_direct_equal);
+	stato->chiavi_campi = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	istantanea_t *ist = g_new0(istantanea_t, 1);
+	ist->base.rif = 1;
+	ist->base.libera = libera_radice;
+	ist->nome = g_strdup(circolo->nome->str);
+	ist->indirizzo = g_strdup(circolo->indirizzo->str);
+	ist->email = g_strdup(circolo->email->str);
+	ist->telefono = g_strdup(circolo->telefono->str);
+	ist->orari = circolo->orari;
+	ist->n_campi = circolo->n_campi;
+	ist->n_soci = circolo->n_soci;
+	stato->corrente = ist;
+
+	for (guint i = 0; i < circolo->giocatori->len; i++)
+		inserisci_giocatore(stato, (giocatore_t *) g_ptr_array_index(circolo->giocatori, i));
+
+	for (guint i = 0; i < circolo->campi->len; i++)
+		inserisci_campo(stato, (campo_t *) g_ptr_array_index(circolo->campi, i));
+
+	for (GList *tmp = circolo->corsi; tmp != NULL; tmp = g_list_next(tmp))
+		trie_imposta(&ist->corsi, ((corso_t *) tmp->data)->ID, copia_corso( (corso_t *) tmp->data ));
+
+	circolo->istantanee = stato;
+	aggiungi_osservatore(circolo, osserva_circolo, stato);
+
+	return stato;
+}
+
+/** Dati per l'adattamento delle funzioni di visita. */
+struct visita_t {
+	void (*funzione)();
+	void *dati;
+};
+
+static void visita_giocatore(const nodo_t *nodo, void *v_)
+{
+	visita_t *v = (visita_t *) v_;
+	((ist_func_giocatore) v->funzione)( &((const nodo_giocatore_t *) nodo)->dati, v->dati );
+}
+
+static void visita_campo(const nodo_t *nodo, void *v_)
+{
+	visita_t *v = (visita_t *) v_;
+	((ist_func_campo) v->funzione)( &((const nodo_campo_t *) nodo)->dati, v->dati );
+}
+
+static void visita_regola(const nodo_t *nodo, void *v_)
+{
+	visita_t *v = (visita_t *) v_;
+	((ist_func_regola) v->funzione)( &((const nodo_regola_t *) nodo)->dati, v->dati );
+}
+
+static void visita_corso(const nodo_t *nodo, void *v_)
+{
+	visita_t *v = (visita_t *) v_;
+	((ist_func_corso) v->funzione)( &((const nodo_corso_t *) nodo)->dati, v->dati );
+}
+
+static void visita_giorno(const nodo_t *nodo, void *v_)
+{
+	visita_t *v = (visita_t *) v_;
+	const nodo_giorno_t *giorno = (const nodo_giorno_t *) nodo;
+
+	for (int i = 0; i < giorno->n; i++)
+		((ist_func_ora) v->funzione)( &giorno->ore[i], v->dati );
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+istantanea_t *crea_istantanea(circolo_t *circolo)
+{
+	if (circolo == 0) return 0;
+
+	stato_ist_t *stato = (stato_ist_t *) circolo->istantanee;
+	if (stato == 0)
+		stato = attiva_istantanee(circolo);
+
+	return (istantanea_t *) nodo_ref(&stato->corrente->base);
+}
+
+istantanea_t *ref_istantanea(istantanea_t *ist)
+{
+	if (ist != 0)
+		nodo_ref(&ist->base);
+
+	return ist;
+}
+
+void rilascia_istantanea(istantanea_t *ist)
+{
+	if (ist != 0)
+		nodo_rilascia(&ist->base);
+}
+
+const char *ist_nome_circolo(const istantanea_t *ist)
+{
+	return ist->nome;
+}
+
+void ist_dati_circolo(const istantanea_t *ist, const char **indirizzo, const char **email, const char **telefono)
+{
+	if (indirizzo) *indirizzo = ist->indirizzo;
+	if (email) *email = ist->email;
+	if (telefono) *telefono = ist->telefono;
+}
+
+const orari_t *ist_orari_circolo(const istantanea_t *ist)
+{
+	return &ist->orari;
+}
+
+void ist_foreach_giocatore(const istantanea_t *ist, ist_func_giocatore funzione, void *dati)
+{
+	visita_t v = { (void (*)()) funzione, dati };
+	trie_foreach(&ist->giocatori, visita_giocatore, &v);
+}
+
+const ist_giocatore_t *ist_cerca_giocatore(const istantanea_t *ist, int ID)
+{
+	if (ID < 0) return 0;
+
+	const nodo_giocatore_t *g = (const nodo_giocatore_t *) trie_cerca(&ist->giocatori, ID);
+	if (g == 0) return 0;
+
+	return &g->dati;
+}
+
+void ist_foreach_campo(const istantanea_t *ist, ist_func_campo funzione, void *dati)
+{
+	visita_t v = { (void (*)()) funzione, dati };
+	trie_foreach(&ist->campi, visita_campo, &v);
+}
+
+void ist_foreach_ora(const ist_campo_t *campo, ist_func_ora funzione, void *dati)
+{
+	const nodo_campo_t *c = (const nodo_campo_t *) ( (const char *) campo - offsetof(nodo_campo_t, dati) );
+
+	visita_t v = { (void (*)()) funzione, dati };
+	trie_foreach(&c->giorni, visita_giorno, &v);
+}
+
+void ist_foreach_regola(const ist_campo_t *campo, ist_func_regola funzione, void *dati)
+{
+	const nodo_campo_t *c = (const nodo_campo_t *) ( (const char *) campo - offsetof(nodo_campo_t, dati) );
+
+	visita_t v = { (void (*)()) funzione, dati };
+	trie_foreach(&c->regole, visita_regola, &v);
+}
+
+void ist_foreach_corso(const istantanea_t *ist, ist_func_corso funzione, void *dati)
+{
+	visita_t v = { (void (*)()) funzione, dati };
+	trie_foreach(&ist->corsi, visita_corso, &v);
+}
+
+/* Fine definizioni pubbliche */
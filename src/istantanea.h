@@ -0,0 +1,189 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo istantanea.cc
+ */
+
+#ifndef ISTANTANEA
+#define ISTANTANEA
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo istantanea */
+
+/** Istantanea immutabile dello stato del circolo.
+ * Può essere letta da un thread qualsiasi mentre il thread dell'interfaccia
+ * continua a modificare il circolo
+ */
+struct istantanea_t;
+
+/** Copia immutabile di un giocatore.
+ */
+struct ist_giocatore_t {
+	int ID;
+	char *nome;
+	char *cognome;
+	char *nascita;
+	char *tessera;
+	char *telefono;
+	char *email;
+	char *classifica;
+	char *circolo;
+	bool socio;
+	bool retta;
+};
+
+/** Copia immutabile di un campo.
+ * Le ore del campo si leggono con ist_foreach_ora(), le prenotazioni ricorrenti con ist_foreach_regola(),
+ * orari ha passo 0 se il campo usa gli orari del circolo
+ */
+struct ist_campo_t {
+	int numero;
+	copertura_t copertura;
+	terreno_t terreno;
+	char *note;
+	orari_t orari;
+};
+
+/** Copia immutabile di un'ora.
+ * Il prenotante è indicato dal suo ID, da cercare con ist_cerca_giocatore()
+ */
+struct ist_ora_t {
+	int orario;
+	char data[11];
+	int durata;
+	int prenotante;
+};
+
+/** Copia immutabile di una prenotazione ricorrente.
+ * I giorni sono giuliani, il prenotante e il corso sono indicati dal loro ID,
+ * corso è 0 per le regole che non sono lezioni di un corso
+ */
+struct ist_regola_t {
+	int ID;
+	int orario;
+	int durata;
+	guint inizio;
+	guint fine;
+	int giorni;
+	int settimane;
+	int prenotante;
+	int corso;
+	guint n_eccezioni;
+	guint *eccezioni;
+};
+
+/** Copia immutabile di un corso.
+ * L'istruttore e gli iscritti sono indicati dal loro ID
+ */
+struct ist_corso_t {
+	int ID;
+	char *nome;
+	int istruttore;
+	guint n_iscritti;
+	int *iscritti;
+};
+
+/** Funzione chiamata per ogni giocatore dell'istantanea. */
+typedef void (*ist_func_giocatore)(const ist_giocatore_t *giocatore, void *dati);
+
+/** Funzione chiamata per ogni campo dell'istantanea. */
+typedef void (*ist_func_campo)(const ist_campo_t *campo, void *dati);
+
+/** Funzione chiamata per ogni ora di un campo dell'istantanea. */
+typedef void (*ist_func_ora)(const ist_ora_t *ora, void *dati);
+
+/** Funzione chiamata per ogni prenotazione ricorrente di un campo dell'istantanea. */
+typedef void (*ist_func_regola)(const ist_regola_t *regola, void *dati);
+
+/** Funzione chiamata per ogni corso dell'istantanea. */
+typedef void (*ist_func_corso)(const ist_corso_t *corso, void *dati);
+
+/** Crea un'istantanea del circolo.
+ * La prima istantanea di un circolo costruisce la copia condivisa di tutti i dati,
+ * le successive costano O(1): le modifiche fatte nel frattempo sul circolo
+ * hanno già copiato solo i nodi toccati.
+ * Va chiamata dal thread che modifica il circolo
+ * @param[in,out] circolo Circolo da fotografare
+ * @return Istantanea, da rilasciare con rilascia_istantanea()
+ */
+istantanea_t *crea_istantanea(circolo_t *circolo);
+
+/** Acquisisce un ulteriore riferimento all'istantanea.
+ * @param[in] ist Istantanea
+ * @return L'istantanea stessa
+ */
+istantanea_t *ref_istantanea(istantanea_t *ist);
+
+/** Rilascia un riferimento all'istantanea.
+ * Può essere chiamata da qualsiasi thread
+ * @param[in] ist Istantanea
+ */
+void rilascia_istantanea(istantanea_t *ist);
+
+/** Ritorna il nome del circolo dell'istantanea.
+ * @param[in] ist Istantanea
+ * @return Nome del circolo
+ */
+const char *ist_nome_circolo(const istantanea_t *ist);
+
+/** Ritorna i dati del circolo dell'istantanea.
+ * I parametri di uscita possono essere 0 se non interessano
+ * @param[in] ist Istantanea
+ * @param[out] indirizzo Indirizzo del circolo
+ * @param[out] email Email del circolo
+ * @param[out] telefono Telefono del circolo
+ */
+void ist_dati_circolo(const istantanea_t *ist, const char **indirizzo, const char **email, const char **telefono);
+
+/** Ritorna gli orari di prenotazione del circolo dell'istantanea.
+ * @param[in] ist Istantanea
+ * @return Orari del circolo
+ */
+const orari_t *ist_orari_circolo(const istantanea_t *ist);
+
+/** Scorre i giocatori dell'istantanea in ordine di ID.
+ * @param[in] ist Istantanea
+ * @param[in] funzione Funzione da chiamare per ogni giocatore
+ * @param[in] dati Dati passati alla funzione
+ */
+void ist_foreach_giocatore(const istantanea_t *ist, ist_func_giocatore funzione, void *dati);
+
+/** Cerca un giocatore dell'istantanea per ID.
+ * @param[in] ist Istantanea
+ * @param[in] ID ID del giocatore
+ * @return Giocatore, 0 se non presente
+ */
+const ist_giocatore_t *ist_cerca_giocatore(const istantanea_t *ist, int ID);
+
+/** Scorre i campi dell'istantanea in ordine di numero.
+ * @param[in] ist Istantanea
+ * @param[in] funzione Funzione da chiamare per ogni campo
+ * @param[in] dati Dati passati alla funzione
+ */
+void ist_foreach_campo(const istantanea_t *ist, ist_func_campo funzione, void *dati);
+
+/** Scorre in ordine cronologico le ore di un campo dell'istantanea.
+ * @param[in] campo Campo ottenuto da ist_foreach_campo()
+ * @param[in] funzione Funzione da chiamare per ogni ora
+ * @param[in] dati Dati passati alla funzione
+ */
+void ist_foreach_ora(const ist_campo_t *campo, ist_func_ora funzione, void *dati);
+
+/** Scorre in ordine di ID le prenotazioni ricorrenti di un campo dell'istantanea.
+ * @param[in] campo Campo ottenuto da ist_foreach_campo()
+ * @param[in] funzione Funzione da chiamare per ogni regola
+ * @param[in] dati Dati passati alla funzione
+ */
+void ist_foreach_regola(const ist_campo_t *campo, ist_func_regola funzione, void *dati);
+
+/** Scorre i corsi dell'istantanea in ordine di ID.
+ * Le lezioni dei corsi si trovano tra le regole dei campi
+ * @param[in] ist Istantanea
+ * @param[in] funzione Funzione da chiamare per ogni corso
+ * @param[in] dati Dati passati alla funzione
+ */
+void ist_foreach_corso(const istantanea_t *ist, ist_func_corso funzione, void *dati);
+
+/* Fine interfaccia del modulo istantanea */
+
+#endif
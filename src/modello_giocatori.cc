@@ -0,0 +1,366 @@
+/**
+ * @file
+ * File contenente il modulo modello_giocatori.
+ * Implementa un GtkTreeModel a lista che legge i dati direttamente dai giocatori del circolo
+ * e si aggiorna tramite gli osservatori di accesso_dati
+ */
+
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include "modello_giocatori.h"
+#include "accesso_dati.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+/** Istanza del modello.
+ * righe contiene i puntatori ai giocatori mostrati, nell'ordine della vista;
+ * stamp cambia a ogni modifica per invalidare gli iteratori
+ */
+struct ModelloGiocatori {
+	GObject parent;
+	circolo_t *circolo;
+	bool solo_soci;
+	bool filtrato;
+	GPtrArray *righe;
+	gint stamp;
+};
+
+/** Classe del modello. */
+struct ModelloGiocatoriClass {
+	GObjectClass parent_class;
+};
+
+static void modello_giocatori_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(ModelloGiocatori, modello_giocatori, G_TYPE_OBJECT,
+			G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, modello_giocatori_tree_model_init))
+
+#define MODELLO(obj) (G_TYPE_CHECK_INSTANCE_CAST( (obj), modello_giocatori_get_type(), ModelloGiocatori ))
+
+/** Ritorna la posizione del giocatore nelle righe del modello.
+ * @return Posizione, -1 se il giocatore non è mostrato
+ */
+static int cerca_riga(ModelloGiocatori *modello, giocatore_t *giocatore)
+{
+	for (guint i = 0; i < modello->righe->len; i++)
+		if (g_ptr_array_index(modello->righe, i) == giocatore)
+			return i;
+
+	return -1;
+}
+
+/** Prepara l'iteratore della riga.
+ */
+static void imposta_iter(ModelloGiocatori *modello, GtkTreeIter *iter, int pos)
+{
+	iter->stamp = modello->stamp;
+	iter->user_data = GINT_TO_POINTER(pos);
+	iter->user_data2 = NULL;
+	iter->user_data3 = NULL;
+}
+
+static void aggiungi_riga(ModelloGiocatori *modello, giocatore_t *giocatore)
+{
+	GtkTreeIter iter;
+	int pos = modello->righe->len;
+
+	g_ptr_array_add(modello->righe, giocatore);
+	modello->stamp++;
+
+	GtkTreePath *path = gtk_tree_path_new_from_indices(pos, -1);
+	imposta_iter(modello, &iter, pos);
+	gtk_tree_model_row_inserted(GTK_TREE_MODEL(modello), path, &iter);
+	gtk_tree_path_free(path);
+}
+
+static void rimuovi_riga(ModelloGiocatori *modello, int pos)
+{
+	g_ptr_array_remove_index(modello->righe, pos);
+	modello->stamp++;
+
+	GtkTreePath *path = gtk_tree_path_new_from_indices(pos, -1);
+	gtk_tree_model_row_deleted(GTK_TREE_MODEL(modello), path);
+	gtk_tree_path_free(path);
+}
+
+static void riga_cambiata(ModelloGiocatori *modello, int pos)
+{
+	GtkTreeIter iter;
+	GtkTreePath *path = gtk_tree_path_new_from_indices(pos, -1);
+
+	imposta_iter(modello, &iter, pos);
+	gtk_tree_model_row_changed(GTK_TREE_MODEL(modello), path, &iter);
+	gtk_tree_path_free(path);
+}
+
+/** Toglie tutte le righe dal modello, dall'ultima alla prima.
+ */
+static void svuota(ModelloGiocatori *modello)
+{
+	for (int i = modello->righe->len - 1; i >= 0; i--)
+		rimuovi_riga(modello, i);
+}
+
+/** Controlla se il giocatore va mostrato quando il modello non è filtrato.
+ */
+static bool da_mostrare(ModelloGiocatori *modello, giocatore_t *giocatore)
+{
+	return !modello->solo_soci || giocatore->socio;
+}
+
+/** Osservatore che riporta nel modello le modifiche ai giocatori.
+ */
+static void osserva_circolo(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati)
+{
+	ModelloGiocatori *modello = MODELLO(dati);
+
+	if (tipo == ELEM_CIRCOLO && modifica == RIMOZIONE){
+		svuota(modello);
+		modello->circolo = 0;
+		return;
+	}
+
+	if (tipo != ELEM_GIOCATORE)
+		return;
+
+	giocatore_t *giocatore = (giocatore_t *) elemento;
+	int pos = cerca_riga(modello, giocatore);
+	bool visibile = modifica != RIMOZIONE && da_mostrare(modello, giocatore);
+
+	if (pos >= 0 && !visibile)
+		rimuovi_riga(modello, pos);
+	else if (pos >= 0)
+		riga_cambiata(modello, pos);
+	else if (visibile && !modello->filtrato)
+		aggiungi_riga(modello, giocatore);
+}
+
+static void modello_giocatori_finalize(GObject *oggetto)
+{
+	ModelloGiocatori *modello = MODELLO(oggetto);
+
+	if (modello->circolo != 0)
+		rimuovi_osservatore(modello->circolo, osserva_circolo, modello);
+
+	g_ptr_array_free(modello->righe, TRUE);
+
+	G_OBJECT_CLASS(modello_giocatori_parent_class)->finalize(oggetto);
+}
+
+static void modello_giocatori_class_init(ModelloGiocatoriClass *classe)
+{
+	G_OBJECT_CLASS(classe)->finalize = modello_giocatori_finalize;
+}
+
+static void modello_giocatori_init(ModelloGiocatori *modello)
+{
+	modello->circolo = 0;
+	modello->solo_soci = false;
+	modello->filtrato = false;
+	modello->righe = g_ptr_array_new();
+	modello->stamp = g_random_int();
+}
+
+/* Implementazione di GtkTreeModel */
+
+static GtkTreeModelFlags get_flags(GtkTreeModel *tree_model)
+{
+	return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint get_n_columns(GtkTreeModel *tree_model)
+{
+	return N_COLONNE_GIOCATORE;
+}
+
+static GType get_column_type(GtkTreeModel *tree_model, gint colonna)
+{
+	switch (colonna){
+		case COL_SOCIO:
+		case COL_RETTA:
+			return G_TYPE_BOOLEAN;
+		case COL_GIOCATORE:
+			return G_TYPE_POINTER;
+		default:
+			return G_TYPE_STRING;
+	}
+}
+
+static gboolean get_iter(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreePath *path)
+{
+	ModelloGiocatori *modello = MODELLO(tree_model);
+
+	if (gtk_tree_path_get_depth(path) != 1)
+		return FALSE;
+
+	int pos = gtk_tree_path_get_indices(path)[0];
+	if (pos < 0 || pos >= (int) modello->righe->len)
+		return FALSE;
+
+	imposta_iter(modello, iter, pos);
+	return TRUE;
+}
+
+static GtkTreePath *get_path(GtkTreeModel *tree_model, GtkTreeIter *iter)
+{
+	return gtk_tree_path_new_from_indices(GPOINTER_TO_INT(iter->user_data), -1);
+}
+
+/** Legge il valore della colonna direttamente dal giocatore.
+ * Le stringhe non vengono copiate: la vista le usa subito
+ */
+static void get_value(GtkTreeModel *tree_model, GtkTreeIter *iter, gint colonna, GValue *valore)
+{
+	ModelloGiocatori *modello = MODELLO(tree_model);
+
+	g_return_if_fail(iter->stamp == modello->stamp);
+
+	giocatore_t *giocatore = (giocatore_t *) g_ptr_array_index(modello->righe, GPOINTER_TO_INT(iter->user_data));
+
+	g_value_init(valore, get_column_type(tree_model, colonna));
+
+	switch (colonna){
+		case COL_NOME:
+			g_value_set_static_string(valore, dato_giocatore(giocatore, DATO_NOME));
+			break;
+		case COL_COGNOME:
+			g_value_set_static_string(valore, dato_giocatore(giocatore, DATO_COGNOME));
+			break;
+		case COL_NASCITA:
+			g_value_set_static_string(valore, dato_giocatore(giocatore, DATO_NASCITA));
+			break;
+		case COL_CLASSIFICA:
+			g_value_set_static_string(valore, dato_giocatore(giocatore, DATO_CLASSIFICA));
+			break;
+		case COL_CIRCOLO:
+			g_value_set_static_string(valore, dato_giocatore(giocatore, DATO_CIRCOLO));
+			break;
+		case COL_SOCIO:
+			g_value_set_boolean(valore, giocatore->socio);
+			break;
+		case COL_RETTA:
+			g_value_set_boolean(valore, giocatore->retta);
+			break;
+		case COL_GIOCATORE:
+			g_value_set_pointer(valore, giocatore);
+			break;
+	}
+}
+
+static gboolean iter_next(GtkTreeModel *tree_model, GtkTreeIter *iter)
+{
+	ModelloGiocatori *modello = MODELLO(tree_model);
+	int pos = GPOINTER_TO_INT(iter->user_data) + 1;
+
+	if (pos >= (int) modello->righe->len)
+		return FALSE;
+
+	iter->user_data = GINT_TO_POINTER(pos);
+	return TRUE;
+}
+
+static gboolean iter_nth_child(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *padre, gint n)
+{
+	ModelloGiocatori *modello = MODELLO(tree_model);
+
+	if (padre != NULL || n < 0 || n >= (int) modello->righe->len)
+		return FALSE;
+
+	imposta_iter(modello, iter, n);
+	return TRUE;
+}
+
+static gboolean iter_children(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *padre)
+{
+	return iter_nth_child(tree_model, iter, padre, 0);
+}
+
+static gboolean iter_has_child(GtkTreeModel *tree_model, GtkTreeIter *iter)
+{
+	return FALSE;
+}
+
+static gint iter_n_children(GtkTreeModel *tree_model, GtkTreeIter *iter)
+{
+	if (iter != NULL)
+		return 0;
+
+	return MODELLO(tree_model)->righe->len;
+}
+
+static gboolean iter_parent(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *figlio)
+{
+	return FALSE;
+}
+
+static void modello_giocatori_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags = get_flags;
+	iface->get_n_columns = get_n_columns;
+	iface->get_column_type = get_column_type;
+	iface->get_iter = get_iter;
+	iface->get_path = get_path;
+	iface->get_value = get_value;
+	iface->iter_next = iter_next;
+	iface->iter_children = iter_children;
+	iface->iter_has_child = iter_has_child;
+	iface->iter_n_children = iter_n_children;
+	iface->iter_nth_child = iter_nth_child;
+	iface->iter_parent = iter_parent;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+GtkTreeModel *crea_modello_giocatori(circolo_t *circolo, bool solo_soci)
+{
+	ModelloGiocatori *modello = MODELLO( g_object_new(modello_giocatori_get_type(), NULL) );
+
+	modello->circolo = circolo;
+	modello->solo_soci = solo_soci;
+
+	//nessuna vista è ancora collegata, quindi le righe si aggiungono senza segnali
+	for (guint i = 0; i < circolo->giocatori->len; i++){
+		giocatore_t *giocatore = (giocatore_t *) g_ptr_array_index(circolo->giocatori, i);
+		if ( da_mostrare(modello, giocatore) )
+			g_ptr_array_add(modello->righe, giocatore);
+	}
+
+	aggiungi_osservatore(circolo, osserva_circolo, modello);
+
+	return GTK_TREE_MODEL(modello);
+}
+
+void filtra_modello_giocatori(GtkTreeModel *modello_, GList *giocatori, bool filtrato)
+{
+	ModelloGiocatori *modello = MODELLO(modello_);
+
+	svuota(modello);
+	modello->filtrato = filtrato;
+
+	if (modello->circolo == 0)
+		return;
+
+	if (!filtrato){
+		GPtrArray *tutti = modello->circolo->giocatori;
+		for (guint i = 0; i < tutti->len; i++){
+			giocatore_t *giocatore = (giocatore_t *) g_ptr_array_index(tutti, i);
+			if ( da_mostrare(modello, giocatore) )
+				aggiungi_riga(modello, giocatore);
+		}
+		return;
+	}
+
+	for (GList *tmp = giocatori; tmp != NULL; tmp = g_list_next(tmp)){
+		giocatore_t *giocatore = (giocatore_t *) tmp->data;
+		if ( da_mostrare(modello, giocatore) )
+			aggiungi_riga(modello, giocatore);
+	}
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,43 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo modello_giocatori.cc
+ */
+
+#ifndef MODELLO_GIOCATORI
+#define MODELLO_GIOCATORI
+
+#include <gtk/gtk.h>
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo modello_giocatori */
+
+/** Colonne del modello dei giocatori.
+ * Sono le stesse delle ListStore dei giocatori dell'interfaccia
+ */
+enum colonna_giocatore_t {COL_NOME = 0, COL_COGNOME, COL_NASCITA, COL_CLASSIFICA, COL_CIRCOLO,
+			COL_SOCIO, COL_RETTA, COL_GIOCATORE, N_COLONNE_GIOCATORE};
+
+/** Crea un GtkTreeModel che mostra direttamente i giocatori del circolo.
+ * Il modello non copia i dati: ogni riga punta a un giocatore e i valori
+ * vengono letti solo quando la vista li chiede. Le aggiunte, le modifiche e le eliminazioni
+ * fatte tramite accesso_dati vengono segnalate alla vista.
+ * Se il circolo viene eliminato il modello si svuota
+ * @param[in,out] circolo Circolo da mostrare
+ * @param[in] solo_soci TRUE per mostrare solo i soci
+ * @return Modello, da rilasciare con g_object_unref()
+ */
+GtkTreeModel *crea_modello_giocatori(circolo_t *circolo, bool solo_soci);
+
+/** Limita il modello ai giocatori passati.
+ * Finché il modello è filtrato i nuovi giocatori non vengono aggiunti
+ * @param[in,out] modello Modello creato con crea_modello_giocatori()
+ * @param[in] giocatori Giocatori da mostrare, nell'ordine voluto
+ * @param[in] filtrato TRUE per mostrare solo i giocatori passati,
+ * FALSE per tornare a tutti i giocatori (o tutti i soci)
+ */
+void filtra_modello_giocatori(GtkTreeModel *modello, GList *giocatori, bool filtrato);
+
+/* Fine interfaccia del modulo modello_giocatori */
+
+#endif
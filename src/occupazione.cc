@@ -0,0 +1,292 @@
+/**
+ * @file
+ * File contenente il modulo occupazione.
+ * Mantiene per ogni campo i minuti prenotati in ogni fascia oraria di ogni giorno,
+ * aggiornati a ogni inserimento e rimozione di un'ora, così che l'occupazione
+ * di un'intera stagione si ottenga sommando aggregati già pronti.
+ * Le prenotazioni ricorrenti non vengono aggregate: ogni loro occorrenza occupa
+ * le stesse fasce, quindi basta contare le occorrenze nel periodo richiesto
+ */
+
+#include <glib.h>
+#include <cstring>
+
+#include "occupazione.h"
+#include "accesso_dati.h"
+#include "indice_giorni.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+/** Minuti prenotati singolarmente in un campo in un giorno, divisi per fascia oraria.
+ */
+struct giorno_occupato_t {
+	guint giorno;
+	guint minuti[ORE_GIORNO];
+};
+
+/** Aggregati di un circolo.
+ * campi associa a ogni campo l'array dei suoi giorno_occupato_t in ordine di giorno
+ */
+struct stato_occupazione_t {
+	GHashTable *campi;
+};
+
+static void libera_giorni(gpointer giorni)
+{
+	g_array_free( (GArray *) giorni, TRUE );
+}
+
+/** Ritorna il giorno della settimana di un giorno giuliano, 0 il lunedì.
+ */
+static inline int giorno_settimana(guint giorno)
+{
+	return (giorno - 1) % GIORNI_SETTIMANA;
+}
+
+/** Ritorna la posizione del primo giorno non precedente a giorno.
+ */
+static guint cerca_giorno(const GArray *giorni, guint giorno)
+{
+	guint inizio = 0, fine = giorni->len;
+	while (inizio < fine){
+		guint medio = (inizio + fine) / 2;
+		if (g_array_index(giorni, giorno_occupato_t, medio).giorno < giorno)
+			inizio = medio + 1;
+		else
+			fine = medio;
+	}
+
+	return inizio;
+}
+
+/** Distribuisce un intervallo sulle fasce orarie, aggiungendo o togliendo i suoi minuti.
+ * @param[in,out] minuti Minuti per fascia oraria
+ * @param[in] orario Inizio dell'intervallo in minuti dalla mezzanotte
+ * @param[in] durata Durata dell'intervallo in minuti
+ * @param[in] segno 1 per aggiungere, -1 per togliere
+ */
+static void distribuisci(guint minuti[], int orario, int durata, int segno)
+{
+	int fine = MIN(orario + durata, ORE_GIORNO * 60);
+
+	for (int inizio = MAX(orario, 0); inizio < fine; ){
+		int fascia = inizio / 60;
+		int fine_fascia = MIN(fine, (fascia + 1) * 60);
+
+		if (segno > 0)
+			minuti[fascia] += fine_fascia - inizio;
+		else
+			minuti[fascia] -= fine_fascia - inizio;
+		inizio = fine_fascia;
+	}
+}
+
+/** Aggiunge o toglie un'ora dagli aggregati del suo campo.
+ */
+static void aggrega_ora(stato_occupazione_t *stato, const ora_t *ora, campo_t *campo, int segno)
+{
+	guint giorno = giorno_da_data(ora->data->str);
+	if (giorno == 0)
+		return;
+
+	GArray *giorni = (GArray *) g_hash_table_lookup(stato->campi, campo);
+	if (giorni == 0){
+		if (segno < 0)
+			return;
+		giorni = g_array_new(FALSE, TRUE, sizeof(giorno_occupato_t));
+		g_hash_table_insert(stato->campi, campo, giorni);
+	}
+
+	guint pos = cerca_giorno(giorni, giorno);
+	if (pos == giorni->len || g_array_index(giorni, giorno_occupato_t, pos).giorno != giorno){
+		if (segno < 0)
+			return;
+		giorno_occupato_t nuovo;
+		memset(&nuovo, 0, sizeof(nuovo));
+		nuovo.giorno = giorno;
+		g_array_insert_val(giorni, pos, nuovo);
+	}
+
+	giorno_occupato_t &occupato = g_array_index(giorni, giorno_occupato_t, pos);
+	distribuisci(occupato.minuti, ora->orario, ora->durata, segno);
+
+	//i giorni rimasti senza prenotazioni non vengono più scorsi
+	for (int h = 0; h < ORE_GIORNO; h++)
+		if (occupato.minuti[h] != 0)
+			return;
+	g_array_remove_index(giorni, pos);
+}
+
+static void libera_stato(stato_occupazione_t *stato)
+{
+	g_hash_table_destroy(stato->campi);
+	g_free(stato);
+}
+
+/** Osservatore che mantiene gli aggregati allineati alle ore del circolo.
+ */
+static void osserva_circolo(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati)
+{
+	stato_occupazione_t *stato = (stato_occupazione_t *) dati;
+
+	switch (tipo){
+		case ELEM_CIRCOLO:
+			if (modifica == RIMOZIONE){
+				((circolo_t *) elemento)->occupazione = 0;
+				libera_stato(stato);
+			}
+			break;
+
+		case ELEM_CAMPO:
+			//le ore di un campo eliminato non vengono notificate una per una
+			if (modifica == RIMOZIONE)
+				g_hash_table_remove(stato->campi, elemento);
+			break;
+
+		case ELEM_ORA:
+			//le ore non vengono modificate, solo inserite ed eliminate
+			if (modifica == INSERIMENTO)
+				aggrega_ora(stato, (ora_t *) elemento, (campo_t *) contenitore, 1);
+			else if (modifica == RIMOZIONE)
+				aggrega_ora(stato, (ora_t *) elemento, (campo_t *) contenitore, -1);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** Costruisce gli aggregati del circolo e registra l'osservatore.
+ */
+static stato_occupazione_t *attiva_occupazione(circolo_t *circolo)
+{
+	D1(cout<<"Attivazione aggregati di occupazione"<<endl)
+
+	stato_occupazione_t *stato = g_new(stato_occupazione_t, 1);
+	stato->campi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_giorni);
+
+	for (guint c = 0; c < circolo->campi->len; c++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, c);
+		for (guint o = 0; o < campo->ore->len; o++)
+			aggrega_ora(stato, (ora_t *) g_ptr_array_index(campo->ore, o), campo, 1);
+	}
+
+	circolo->occupazione = stato;
+	aggiungi_osservatore(circolo, osserva_circolo, stato);
+
+	return stato;
+}
+
+/** Calcola i minuti di apertura del campo in ogni fascia e giorno della settimana del periodo.
+ */
+static void calcola_disponibili(occupazione_campo_t *occ, guint inizio, guint fine)
+{
+	const orari_t *orari = get_orari_campo(occ->campo);
+	guint aperti[ORE_GIORNO] = {0};
+
+	distribuisci(aperti, orari->apertura, orari->chiusura - orari->apertura, 1);
+
+	for (int g = 0; g < GIORNI_SETTIMANA; g++){
+		//giorni del periodo che cadono nel giorno della settimana g
+		guint primo = inizio + (g - giorno_settimana(inizio) + GIORNI_SETTIMANA) % GIORNI_SETTIMANA;
+		guint volte = (primo <= fine) ? (fine - primo) / GIORNI_SETTIMANA + 1 : 0;
+
+		for (int h = 0; h < ORE_GIORNO; h++)
+			occ->disponibili[g][h] = aperti[h] * volte;
+	}
+}
+
+/** Somma i minuti prenotati del campo nel periodo.
+ */
+static void calcola_prenotati(stato_occupazione_t *stato, occupazione_campo_t *occ, guint inizio, guint fine)
+{
+	GArray *giorni = (GArray *) g_hash_table_lookup(stato->campi, occ->campo);
+
+	for (guint i = (giorni != 0) ? cerca_giorno(giorni, inizio) : 0; giorni != 0 && i < giorni->len; i++){
+		const giorno_occupato_t &occupato = g_array_index(giorni, giorno_occupato_t, i);
+		if (occupato.giorno > fine)
+			break;
+
+		guint *prenotati = occ->prenotati[giorno_settimana(occupato.giorno)];
+		for (int h = 0; h < ORE_GIORNO; h++)
+			prenotati[h] += occupato.minuti[h];
+	}
+
+	//ogni occorrenza di una regola occupa le stesse fasce del suo giorno della settimana
+	for (GList *tmp = occ->campo->regole; tmp != NULL; tmp = g_list_next(tmp)){
+		const regola_t *regola = (const regola_t *) tmp->data;
+		guint volte[GIORNI_SETTIMANA] = {0};
+
+		for (guint g = prossima_occorrenza(regola, inizio); g != 0 && g <= fine; g = prossima_occorrenza(regola, g + 1))
+			volte[giorno_settimana(g)]++;
+
+		guint fasce[ORE_GIORNO] = {0};
+		distribuisci(fasce, regola->orario, regola->durata, 1);
+
+		for (int g = 0; g < GIORNI_SETTIMANA; g++)
+			for (int h = 0; volte[g] != 0 && h < ORE_GIORNO; h++)
+				occ->prenotati[g][h] += fasce[h] * volte[g];
+	}
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+occupazione_t *calcola_occupazione(circolo_t *circolo, guint inizio, guint fine)
+{
+	TEMPO("occupazione: calcola_occupazione")
+
+	if (circolo == 0 || inizio == 0 || inizio > fine) return 0;
+
+	stato_occupazione_t *stato = (stato_occupazione_t *) circolo->occupazione;
+	if (stato == 0)
+		stato = attiva_occupazione(circolo);
+
+	occupazione_t *occupazione = g_new0(occupazione_t, 1);
+	occupazione->inizio = inizio;
+	occupazione->fine = fine;
+	occupazione->n_campi = circolo->campi->len;
+	occupazione->campi = g_new0(occupazione_campo_t, occupazione->n_campi);
+
+	for (int c = 0; c < occupazione->n_campi; c++){
+		occupazione_campo_t *occ = &occupazione->campi[c];
+		occ->campo = (campo_t *) g_ptr_array_index(circolo->campi, c);
+
+		calcola_disponibili(occ, inizio, fine);
+		calcola_prenotati(stato, occ, inizio, fine);
+
+		for (int g = 0; g < GIORNI_SETTIMANA; g++)
+			for (int h = 0; h < ORE_GIORNO; h++){
+				occ->totale_prenotati += occ->prenotati[g][h];
+				occ->totale_disponibili += occ->disponibili[g][h];
+			}
+
+		occupazione->prenotati_terreno[occ->campo->terreno] += occ->totale_prenotati;
+		occupazione->disponibili_terreno[occ->campo->terreno] += occ->totale_disponibili;
+		occupazione->prenotati_copertura[occ->campo->copertura] += occ->totale_prenotati;
+		occupazione->disponibili_copertura[occ->campo->copertura] += occ->totale_disponibili;
+	}
+
+	return occupazione;
+}
+
+int percentuale_occupazione(guint prenotati, guint disponibili)
+{
+	if (disponibili == 0)
+		return -1;
+
+	return (int) ((100.0 * prenotati) / disponibili + 0.5);
+}
+
+void elimina_occupazione(occupazione_t *occupazione)
+{
+	if (occupazione == 0) return;
+
+	g_free(occupazione->campi);
+	g_free(occupazione);
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,72 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo occupazione.cc
+ */
+
+#ifndef OCCUPAZIONE
+#define OCCUPAZIONE
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo occupazione */
+
+const int ORE_GIORNO = 24;		/**< Fasce orarie in cui viene suddivisa l'occupazione di un giorno */
+const int GIORNI_SETTIMANA = 7;		/**< Giorni della settimana, il primo è il lunedì */
+
+/** Occupazione di un campo in un periodo.
+ * prenotati e disponibili contengono per ogni giorno della settimana e ogni fascia oraria
+ * i minuti prenotati e i minuti in cui il campo è aperto, sommati su tutti i giorni del periodo;
+ * prenotati comprende le occorrenze delle prenotazioni ricorrenti
+ */
+struct occupazione_campo_t {
+	campo_t *campo;
+	guint prenotati[GIORNI_SETTIMANA][ORE_GIORNO];
+	guint disponibili[GIORNI_SETTIMANA][ORE_GIORNO];
+	guint totale_prenotati;
+	guint totale_disponibili;
+};
+
+/** Occupazione dei campi di un circolo tra i giorni giuliani inizio e fine compresi.
+ * campi contiene un elemento per ogni campo nell'ordine del circolo;
+ * i totali per terreno e copertura sommano i campi con quel terreno o quella copertura
+ */
+struct occupazione_t {
+	guint inizio;
+	guint fine;
+	int n_campi;
+	occupazione_campo_t *campi;
+	guint prenotati_terreno[CEMENTO + 1];
+	guint disponibili_terreno[CEMENTO + 1];
+	guint prenotati_copertura[OUTDOOR + 1];
+	guint disponibili_copertura[OUTDOOR + 1];
+};
+
+/** Calcola l'occupazione dei campi in un periodo.
+ * Alla prima chiamata costruisce gli aggregati giornalieri del circolo, che vengono poi
+ * mantenuti allineati tramite gli osservatori di accesso_dati; le chiamate successive
+ * scorrono solo i giorni con prenotazioni del periodo e le regole dei campi,
+ * senza leggere le singole ore
+ * @param[in,out] circolo Circolo
+ * @param[in] inizio Primo giorno giuliano del periodo
+ * @param[in] fine Ultimo giorno giuliano del periodo
+ * @return Occupazione, da deallocare con elimina_occupazione(), 0 se il periodo non è valido
+ */
+occupazione_t *calcola_occupazione(circolo_t *circolo, guint inizio, guint fine);
+
+/** Ritorna la percentuale di occupazione.
+ * @param[in] prenotati Minuti prenotati
+ * @param[in] disponibili Minuti di apertura
+ * @return Percentuale tra 0 e 100, -1 se non ci sono minuti di apertura
+ */
+int percentuale_occupazione(guint prenotati, guint disponibili);
+
+/** Dealloca l'occupazione calcolata.
+ * @param[in] occupazione Occupazione da deallocare
+ */
+void elimina_occupazione(occupazione_t *occupazione);
+
+/* Fine interfaccia del modulo occupazione */
+
+#endif
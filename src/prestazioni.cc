@@ -0,0 +1,328 @@
+/**
+ * @file
+ * File contenente il modulo prestazioni.
+ * Raccoglie i tempi, i contatori e gli istogrammi registrati dalle macro
+ * TEMPO, CONTA e ISTOGRAMMA di debug.h; senza PRESTAZIONI le macro sono vuote
+ * e il modulo non riceve nessuna statistica.
+ * Con la variabile d'ambiente ACE_TRACCIA raccoglie anche gli eventi della macro
+ * TRACCIA e li scrive all'uscita in formato trace-event JSON
+ */
+
+#include <glib.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+using namespace std;
+
+#include "prestazioni.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const char FILE_PRESTAZIONI[] = "ACE_PRESTAZIONI";	/**< Variabile d'ambiente con il file in cui scrivere all'uscita */
+const char FILE_TRACCIA[] = "ACE_TRACCIA";		/**< Variabile d'ambiente con il file della traccia */
+const char *TIPI[] = {"contatore", "tempo (us)", "istogramma"};
+
+static GMutex mutex_registro;		/**< Protegge registro */
+static GPtrArray *registro = 0;		/**< Statistiche registrate */
+
+/** Evento completo della traccia.
+ */
+struct evento_t {
+	const char *nome;
+	const char *categoria;
+	char *file;
+	const char *nome_n;
+	gint64 n;
+	gint64 inizio;
+	gint64 durata;
+	guint thread;
+};
+
+static GMutex mutex_traccia;		/**< Protegge eventi e thread */
+static GArray *eventi = 0;		/**< Eventi registrati, 0 se la traccia non è attiva */
+static GPtrArray *thread = 0;		/**< Nome di ogni thread che ha registrato eventi */
+static GPrivate id_thread;		/**< Identificativo del thread corrente più uno */
+
+/** Ritorna l'identificativo del thread corrente nella traccia.
+ * Va chiamata con mutex_traccia acquisito
+ */
+static guint thread_corrente()
+{
+	guint id = GPOINTER_TO_UINT( g_private_get(&id_thread) );
+
+	if (id == 0){
+		//il thread che possiede il main loop è quello dell'interfaccia
+		bool principale = g_main_context_is_owner( g_main_context_default() );
+		g_ptr_array_add(thread, principale ? g_strdup("principale")
+						: g_strdup_printf("lavoro %u", thread->len));
+		id = thread->len;
+		g_private_set( &id_thread, GUINT_TO_POINTER(id) );
+	}
+
+	return id;
+}
+
+/** Scrive una stringa JSON con gli escape necessari.
+ */
+static void scrivi_json(ostream &os, const char testo[])
+{
+	os<<'"';
+	for (const char *c = testo; *c != '\0'; c++){
+		if (*c == '"' || *c == '\\')
+			os<<'\\'<<*c;
+		else if ( (unsigned char) *c < 0x20 ){
+			char codice[8];
+			g_snprintf(codice, sizeof(codice), "\\u%04x", *c);
+			os<<codice;
+		}
+		else
+			os<<*c;
+	}
+	os<<'"';
+}
+
+/** Scrive la traccia all'uscita del programma.
+ */
+static void scrivi_traccia()
+{
+	ofstream f( g_getenv(FILE_TRACCIA) );
+	if (!f){
+		D1(cout<<"Impossibile scrivere la traccia"<<endl)
+		return;
+	}
+
+	g_mutex_lock(&mutex_traccia);
+
+	f<<"{\"traceEvents\": ["<<endl;
+
+	for (guint i = 0; i < thread->len; i++){
+		f<<"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "<<i + 1<<", \"args\": {\"name\": ";
+		scrivi_json(f, (const char *) g_ptr_array_index(thread, i));
+		f<<"}},"<<endl;
+	}
+
+	for (guint i = 0; i < eventi->len; i++){
+		evento_t *e = &g_array_index(eventi, evento_t, i);
+
+		f<<"{\"name\": \""<<e->nome<<"\", \"cat\": \""<<e->categoria<<"\", \"ph\": \"X\", \"pid\": 1, \"tid\": "<<e->thread
+		 <<", \"ts\": "<<e->inizio<<", \"dur\": "<<e->durata<<", \"args\": {";
+		if (e->file != 0){
+			f<<"\"file\": ";
+			scrivi_json(f, e->file);
+		}
+		if (e->nome_n != 0)
+			f<<(e->file != 0 ? ", " : "")<<"\""<<e->nome_n<<"\": "<<e->n;
+		f<<"}},"<<endl;
+	}
+
+	//evento vuoto finale, evita la virgola dopo l'ultimo elemento
+	f<<"{}"<<endl<<"], \"displayTimeUnit\": \"ms\"}"<<endl;
+
+	g_mutex_unlock(&mutex_traccia);
+}
+
+/** Ritorna la classe dell'istogramma di un valore.
+ */
+static int classe(gint64 valore)
+{
+	if (valore <= 0)
+		return 0;
+
+	return MIN( (int) g_bit_storage(valore), N_CLASSI - 1 );
+}
+
+static gint confronta_nome(gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0( (*(statistica_t **) a)->nome, (*(statistica_t **) b)->nome );
+}
+
+static void azzera(statistica_t *stat, gpointer dati)
+{
+	g_mutex_lock(&stat->mutex);
+
+	stat->conteggio = 0;
+	stat->somma = 0;
+	stat->minimo = G_MAXINT64;
+	stat->massimo = G_MININT64;
+	for (int i = 0; i < N_CLASSI; i++)
+		stat->classi[i] = 0;
+
+	g_mutex_unlock(&stat->mutex);
+}
+
+static void scrivi_statistica(statistica_t *stat, gpointer os_)
+{
+	ostream &os = *(ostream *) os_;
+
+	g_mutex_lock(&stat->mutex);
+
+	os<<left<<setw(36)<<stat->nome<<setw(14)<<TIPI[stat->tipo]<<right<<setw(10)<<stat->conteggio;
+	if (stat->tipo != STAT_CONTATORE && stat->conteggio > 0)
+		os<<setw(14)<<stat->somma<<setw(12)<<stat->somma / (gint64) stat->conteggio
+		  <<setw(10)<<stat->minimo<<setw(10)<<percentile_statistica(stat, 0.5)
+		  <<setw(10)<<percentile_statistica(stat, 0.99)<<setw(12)<<stat->massimo;
+	os<<endl;
+
+	g_mutex_unlock(&stat->mutex);
+}
+
+/** Scrive le statistiche all'uscita del programma.
+ * Sullo standard error o nel file indicato dalla variabile d'ambiente ACE_PRESTAZIONI
+ */
+static void scrivi_uscita()
+{
+	const char *file = g_getenv(FILE_PRESTAZIONI);
+
+	if (file == 0){
+		scrivi_statistiche(cerr);
+		return;
+	}
+
+	ofstream f(file);
+	if (!f){
+		D1(cout<<"Impossibile scrivere le prestazioni"<<endl)
+		return;
+	}
+	scrivi_statistiche(f);
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+statistica_t *registra_statistica(const char nome[], tipo_statistica_t tipo)
+{
+	statistica_t *stat = g_new(statistica_t, 1);
+	stat->nome = nome;
+	stat->tipo = tipo;
+	g_mutex_init(&stat->mutex);
+	azzera(stat, 0);
+
+	g_mutex_lock(&mutex_registro);
+	if (registro == 0){
+		registro = g_ptr_array_new();
+		atexit(scrivi_uscita);
+	}
+	g_ptr_array_add(registro, stat);
+	g_mutex_unlock(&mutex_registro);
+
+	return stat;
+}
+
+void aggiungi_valore(statistica_t *stat, gint64 valore)
+{
+	g_mutex_lock(&stat->mutex);
+
+	stat->conteggio++;
+	stat->somma += valore;
+	stat->minimo = MIN(stat->minimo, valore);
+	stat->massimo = MAX(stat->massimo, valore);
+	stat->classi[ classe(valore) ]++;
+
+	g_mutex_unlock(&stat->mutex);
+}
+
+gint64 percentile_statistica(statistica_t *stat, double p)
+{
+	if (stat->conteggio == 0)
+		return 0;
+
+	guint64 soglia = (guint64) (p * stat->conteggio);
+	guint64 cumulato = 0;
+
+	for (int i = 0; i < N_CLASSI; i++){
+		cumulato += stat->classi[i];
+		if (cumulato > soglia || cumulato == stat->conteggio){
+			//la classe i contiene i valori fino a 2^i - 1
+			gint64 limite = (i == 0) ? 0 : ( ((gint64) 1 << i) - 1 );
+			return CLAMP(limite, stat->minimo, stat->massimo);
+		}
+	}
+
+	return stat->massimo;
+}
+
+void foreach_statistica(func_statistica_t funzione, gpointer dati)
+{
+	g_mutex_lock(&mutex_registro);
+
+	if (registro != 0){
+		g_ptr_array_sort(registro, confronta_nome);
+		for (guint i = 0; i < registro->len; i++)
+			funzione( (statistica_t *) g_ptr_array_index(registro, i), dati );
+	}
+
+	g_mutex_unlock(&mutex_registro);
+}
+
+void azzera_statistiche()
+{
+	foreach_statistica(azzera, 0);
+}
+
+void scrivi_statistiche(ostream &os)
+{
+	os<<left<<setw(36)<<"statistica"<<setw(14)<<"tipo"<<right<<setw(10)<<"n"
+	  <<setw(14)<<"totale"<<setw(12)<<"media"<<setw(10)<<"min"<<setw(10)<<"p50"
+	  <<setw(10)<<"p99"<<setw(12)<<"max"<<endl;
+
+	foreach_statistica(scrivi_statistica, &os);
+}
+
+bool traccia_attiva()
+{
+#ifdef PRESTAZIONI
+	static gsize attiva = 0;
+
+	if ( g_once_init_enter(&attiva) ){
+		bool stato = g_getenv(FILE_TRACCIA) != 0;
+		if (stato){
+			eventi = g_array_new(FALSE, FALSE, sizeof(evento_t));
+			thread = g_ptr_array_new();
+			atexit(scrivi_traccia);
+		}
+		g_once_init_leave(&attiva, stato ? 2 : 1);
+	}
+
+	return attiva == 2;
+#else
+	return false;
+#endif
+}
+
+traccia_blocco_t::traccia_blocco_t(const char *nome_, const char *categoria_, const char *file_)
+	: nome(nome_), categoria(categoria_), file(0), nome_n(0), n(0), inizio(0)
+{
+	if ( !traccia_attiva() )
+		return;
+
+	file = g_strdup(file_);
+	inizio = g_get_monotonic_time();
+}
+
+traccia_blocco_t::~traccia_blocco_t()
+{
+	if ( !traccia_attiva() )
+		return;
+
+	evento_t e = { nome, categoria, file, nome_n, n, inizio, g_get_monotonic_time() - inizio, 0 };
+
+	g_mutex_lock(&mutex_traccia);
+	e.thread = thread_corrente();
+	g_array_append_val(eventi, e);
+	g_mutex_unlock(&mutex_traccia);
+}
+
+bool prestazioni_attive()
+{
+#ifdef PRESTAZIONI
+	return true;
+#else
+	return false;
+#endif
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,137 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo prestazioni.cc
+ */
+
+#ifndef PRESTAZIONI_H
+#define PRESTAZIONI_H
+
+#include <glib.h>
+
+#include <ostream>
+
+/* Inizio interfaccia del modulo prestazioni */
+
+/** Tipo di statistica raccolta.
+ * I tempi sono in microsecondi
+ */
+enum tipo_statistica_t {STAT_CONTATORE = 0, STAT_TEMPO, STAT_ISTOGRAMMA};
+
+const int N_CLASSI = 40;	/**< Classi dell'istogramma, la classe i contiene i valori con i bit significativi */
+
+/** Statistica di un punto del programma.
+ * Ogni valore viene sommato e contato nella classe dell'istogramma
+ * corrispondente alla sua potenza di due; il mutex permette di aggiornarla
+ * anche dai thread dell'esecutore
+ */
+struct statistica_t {
+	const char *nome;
+	tipo_statistica_t tipo;
+	GMutex mutex;
+	guint64 conteggio;
+	gint64 somma;
+	gint64 minimo;
+	gint64 massimo;
+	guint64 classi[N_CLASSI];
+};
+
+/** Registra una statistica.
+ * Viene chiamata una sola volta per punto di misura dalle macro di debug.h;
+ * alla prima registrazione viene programmata la stampa delle statistiche all'uscita
+ * @param[in] nome Nome della statistica, deve restare valido per tutto il programma
+ * @param[in] tipo Tipo della statistica
+ * @return Statistica registrata
+ */
+statistica_t *registra_statistica(const char nome[], tipo_statistica_t tipo);
+
+/** Aggiunge un valore alla statistica.
+ * @param[in,out] stat Statistica
+ * @param[in] valore Valore da aggiungere
+ */
+void aggiungi_valore(statistica_t *stat, gint64 valore);
+
+/** Stima un percentile della statistica dal suo istogramma.
+ * @param[in] stat Statistica
+ * @param[in] p Percentile tra 0 e 1
+ * @return Limite superiore della classe che contiene il percentile
+ */
+gint64 percentile_statistica(statistica_t *stat, double p);
+
+/** Funzione chiamata per ogni statistica.
+ * @param[in] stat Statistica, da leggere sotto il suo mutex
+ * @param[in] dati Dati passati a foreach_statistica()
+ */
+typedef void (*func_statistica_t)(statistica_t *stat, gpointer dati);
+
+/** Chiama la funzione per ogni statistica registrata, in ordine di nome.
+ * @param[in] funzione Funzione da chiamare
+ * @param[in] dati Dati passati alla funzione
+ */
+void foreach_statistica(func_statistica_t funzione, gpointer dati);
+
+/** Azzera tutte le statistiche registrate.
+ */
+void azzera_statistiche();
+
+/** Scrive una tabella con tutte le statistiche.
+ * @param[out] os Stream su cui scrivere
+ */
+void scrivi_statistiche(std::ostream &os);
+
+/** Indica se il programma è compilato con la strumentazione.
+ * @return TRUE se è definito PRESTAZIONI
+ */
+bool prestazioni_attive();
+
+/** Timer che misura la durata di un blocco.
+ * Registra nella statistica il tempo passato tra costruzione e distruzione
+ */
+class tempo_blocco_t {
+	statistica_t *stat;
+	gint64 inizio;
+public:
+	tempo_blocco_t(statistica_t *stat_) : stat(stat_), inizio(g_get_monotonic_time()) {}
+	~tempo_blocco_t() { aggiungi_valore(stat, g_get_monotonic_time() - inizio); }
+};
+
+/** Indica se la traccia degli eventi è attiva.
+ * La traccia si attiva impostando la variabile d'ambiente ACE_TRACCIA
+ * con il nome del file JSON da scrivere all'uscita, nel formato trace-event
+ * apribile con chrome://tracing o Perfetto
+ * @return TRUE se il programma è compilato con PRESTAZIONI e ACE_TRACCIA è impostata
+ */
+bool traccia_attiva();
+
+/** Evento della traccia che dura quanto un blocco.
+ * Registra inizio, durata, thread, file trattato e un eventuale conteggio;
+ * se la traccia non è attiva non fa nulla
+ */
+class traccia_blocco_t {
+	const char *nome;
+	const char *categoria;
+	char *file;
+	const char *nome_n;
+	gint64 n;
+	gint64 inizio;
+public:
+	/** Apre l'evento.
+	 * @param[in] nome_ Nome dell'evento, deve restare valido per tutto il programma
+	 * @param[in] categoria_ Categoria dell'evento, come sopra
+	 * @param[in] file_ File o circolo trattato, può essere 0
+	 */
+	traccia_blocco_t(const char *nome_, const char *categoria_, const char *file_ = 0);
+
+	/** Aggiunge all'evento un conteggio.
+	 * @param[in] nome_n_ Nome del conteggio, deve restare valido per tutto il programma
+	 * @param[in] n_ Valore
+	 */
+	void argomento(const char *nome_n_, gint64 n_) { nome_n = nome_n_; n = n_; }
+
+	/** Chiude l'evento e lo aggiunge alla traccia.
+	 */
+	~traccia_blocco_t();
+};
+
+/* Fine interfaccia del modulo prestazioni */
+
+#endif
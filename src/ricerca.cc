@@ -0,0 +1,363 @@
+/**
+ * @file
+ * File contenente il modulo ricerca.
+ * Fornisce la ricerca dei giocatori per nome, cognome, tessera ed email.
+ * I dati di ogni giocatore sono normalizzati (senza accenti e in minuscolo)
+ * e indicizzati per trigrammi: una parola di almeno tre byte viene cercata solo
+ * tra i giocatori del trigramma meno frequente, le parole più corte
+ * vengono confrontate con tutti i giocatori
+ */
+
+#include <glib.h>
+#include <cstring>
+
+#include "ricerca.h"
+#include "accesso_dati.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const char SEPARATORE = '\n';		/**< Separatore dei dati nel testo di un giocatore */
+
+/** Giocatore indicizzato.
+ * Il testo contiene nome, cognome, tessera ed email normalizzati e separati da SEPARATORE,
+ * ordine contiene cognome e nome normalizzati ed è usato per ordinare i risultati
+ */
+struct voce_t {
+	giocatore_t *giocatore;
+	char *testo;
+	char *ordine;
+};
+
+/** Indice di ricerca di un circolo.
+ * voci associa a ogni giocatore la sua voce,
+ * trigrammi associa a ogni trigramma l'array delle voci che lo contengono
+ */
+struct stato_ricerca_t {
+	GHashTable *voci;
+	GHashTable *trigrammi;
+};
+
+/** Risultato di una ricerca.
+ */
+struct risultato_t {
+	voce_t *voce;
+	bool prefisso;
+};
+
+/** Ritorna la chiave del trigramma che inizia in testo.
+ * @return Chiave, 0 se il trigramma attraversa più dati o parole
+ */
+static guint chiave_trigramma(const char *testo)
+{
+	guint chiave = 0;
+
+	for (int i = 0; i < 3; i++){
+		if (testo[i] == '\0' || testo[i] == SEPARATORE || testo[i] == ' ')
+			return 0;
+		chiave = (chiave << 8) | (guchar) testo[i];
+	}
+
+	return chiave;
+}
+
+/** Chiama la funzione una volta per ogni trigramma distinto del testo.
+ */
+static void foreach_trigramma(const char *testo, void (*funzione)(guint chiave, gpointer dati), gpointer dati)
+{
+	GHashTable *visti = g_hash_table_new(g_direct_hash, g_direct_equal);
+	size_t len = strlen(testo);
+
+	for (size_t i = 0; i + 3 <= len; i++){
+		guint chiave = chiave_trigramma(testo + i);
+
+		if (chiave == 0 || g_hash_table_contains(visti, GUINT_TO_POINTER(chiave)) )
+			continue;
+
+		g_hash_table_add(visti, GUINT_TO_POINTER(chiave));
+		funzione(chiave, dati);
+	}
+
+	g_hash_table_destroy(visti);
+}
+
+/** Dati per l'aggiornamento dei trigrammi di una voce. */
+struct aggiornamento_t {
+	stato_ricerca_t *stato;
+	voce_t *voce;
+};
+
+static void aggiungi_trigramma(guint chiave, gpointer dati)
+{
+	aggiornamento_t *agg = (aggiornamento_t *) dati;
+	GPtrArray *voci = (GPtrArray *) g_hash_table_lookup(agg->stato->trigrammi, GUINT_TO_POINTER(chiave));
+
+	if (voci == 0){
+		voci = g_ptr_array_new();
+		g_hash_table_insert(agg->stato->trigrammi, GUINT_TO_POINTER(chiave), voci);
+	}
+
+	g_ptr_array_add(voci, agg->voce);
+}
+
+static void togli_trigramma(guint chiave, gpointer dati)
+{
+	aggiornamento_t *agg = (aggiornamento_t *) dati;
+	GPtrArray *voci = (GPtrArray *) g_hash_table_lookup(agg->stato->trigrammi, GUINT_TO_POINTER(chiave));
+
+	if (voci == 0)
+		return;
+
+	g_ptr_array_remove_fast(voci, agg->voce);
+
+	if (voci->len == 0)
+		g_hash_table_remove(agg->stato->trigrammi, GUINT_TO_POINTER(chiave));
+}
+
+static void libera_voce(gpointer voce_)
+{
+	voce_t *voce = (voce_t *) voce_;
+
+	g_free(voce->testo);
+	g_free(voce->ordine);
+	g_free(voce);
+}
+
+static void libera_voci(gpointer voci)
+{
+	g_ptr_array_free( (GPtrArray *) voci, TRUE );
+}
+
+/** Aggiunge il giocatore all'indice.
+ */
+static void indicizza_giocatore(stato_ricerca_t *stato, giocatore_t *giocatore)
+{
+	char *dati[] = { normalizza_testo(dato_giocatore(giocatore, DATO_NOME)), normalizza_testo(dato_giocatore(giocatore, DATO_COGNOME)),
+			normalizza_testo(dato_giocatore(giocatore, DATO_TESSERA)), normalizza_testo(dato_giocatore(giocatore, DATO_EMAIL)), 0 };
+	char separatore[] = { SEPARATORE, '\0' };
+
+	voce_t *voce = g_new(voce_t, 1);
+	voce->giocatore = giocatore;
+	voce->testo = g_strjoinv(separatore, dati);
+	voce->ordine = g_strconcat(dati[1], separatore, dati[0], NULL);
+
+	for (int i = 0; dati[i] != 0; i++)
+		g_free(dati[i]);
+
+	aggiornamento_t agg = { stato, voce };
+	foreach_trigramma(voce->testo, aggiungi_trigramma, &agg);
+
+	g_hash_table_insert(stato->voci, giocatore, voce);
+}
+
+/** Toglie il giocatore dall'indice.
+ */
+static void rimuovi_giocatore(stato_ricerca_t *stato, giocatore_t *giocatore)
+{
+	voce_t *voce = (voce_t *) g_hash_table_lookup(stato->voci, giocatore);
+
+	if (voce == 0)
+		return;
+
+	aggiornamento_t agg = { stato, voce };
+	foreach_trigramma(voce->testo, togli_trigramma, &agg);
+
+	g_hash_table_remove(stato->voci, giocatore);
+}
+
+static void libera_stato(stato_ricerca_t *stato)
+{
+	g_hash_table_destroy(stato->trigrammi);
+	g_hash_table_destroy(stato->voci);
+	g_free(stato);
+}
+
+/** Osservatore che mantiene l'indice allineato ai giocatori del circolo.
+ */
+static void osserva_circolo(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati)
+{
+	stato_ricerca_t *stato = (stato_ricerca_t *) dati;
+
+	switch (tipo){
+		case ELEM_CIRCOLO:
+			if (modifica == RIMOZIONE){
+				((circolo_t *) elemento)->ricerca = 0;
+				libera_stato(stato);
+			}
+			break;
+
+		case ELEM_GIOCATORE:
+			rimuovi_giocatore(stato, (giocatore_t *) elemento);
+			if (modifica != RIMOZIONE)
+				indicizza_giocatore(stato, (giocatore_t *) elemento);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** Costruisce l'indice del circolo e registra l'osservatore.
+ */
+static stato_ricerca_t *attiva_ricerca(circolo_t *circolo)
+{
+	D1(cout<<"Attivazione indice di ricerca"<<endl)
+
+	stato_ricerca_t *stato = g_new(stato_ricerca_t, 1);
+	stato->voci = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_voce);
+	stato->trigrammi = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, libera_voci);
+
+	for (guint i = 0; i < circolo->giocatori->len; i++)
+		indicizza_giocatore(stato, (giocatore_t *) g_ptr_array_index(circolo->giocatori, i));
+
+	circolo->ricerca = stato;
+	aggiungi_osservatore(circolo, osserva_circolo, stato);
+
+	return stato;
+}
+
+/** Controlla se la parola compare all'inizio di uno dei dati del testo.
+ */
+static bool inizio_dato(const char *testo, const char *parola)
+{
+	for (const char *pos = strstr(testo, parola); pos != 0; pos = strstr(pos + 1, parola))
+		if (pos == testo || pos[-1] == SEPARATORE)
+			return true;
+
+	return false;
+}
+
+/** Controlla la voce e se contiene tutte le parole la aggiunge ai risultati.
+ */
+static void controlla_voce(voce_t *voce, char **parole, bool solo_soci, GArray *risultati)
+{
+	if (solo_soci && !voce->giocatore->socio)
+		return;
+
+	risultato_t risultato = { voce, parole[0] == 0 };
+
+	for (int i = 0; parole[i] != 0; i++){
+		if ( strstr(voce->testo, parole[i]) == 0 )
+			return;
+		if ( !risultato.prefisso && inizio_dato(voce->testo, parole[i]) )
+			risultato.prefisso = true;
+	}
+
+	g_array_append_val(risultati, risultato);
+}
+
+/** Ordina i risultati mettendo prima quelli con una parola all'inizio di un dato.
+ */
+static int confronta_risultati(gconstpointer a_, gconstpointer b_)
+{
+	const risultato_t *a = (const risultato_t *) a_;
+	const risultato_t *b = (const risultato_t *) b_;
+
+	if (a->prefisso != b->prefisso)
+		return a->prefisso ? -1 : 1;
+
+	return strcmp(a->voce->ordine, b->voce->ordine);
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+char *normalizza_testo(const char testo[])
+{
+	char *scomposto = g_utf8_normalize(testo, -1, G_NORMALIZE_NFD);
+
+	//testo non valido in UTF-8
+	if (scomposto == 0)
+		return g_strdup("");
+
+	GString *senza_accenti = g_string_sized_new( strlen(scomposto) );
+	for (const char *c = scomposto; *c != '\0'; c = g_utf8_next_char(c)){
+		gunichar carattere = g_utf8_get_char(c);
+		if ( !g_unichar_ismark(carattere) )
+			g_string_append_unichar(senza_accenti, carattere);
+	}
+
+	char *normalizzato = g_utf8_casefold(senza_accenti->str, senza_accenti->len);
+
+	g_string_free(senza_accenti, TRUE);
+	g_free(scomposto);
+
+	return normalizzato;
+}
+
+GList *cerca_giocatori(circolo_t *circolo, const char testo[], bool solo_soci, unsigned int max)
+{
+	if (circolo == 0) return 0;
+
+	stato_ricerca_t *stato = (stato_ricerca_t *) circolo->ricerca;
+	if (stato == 0)
+		stato = attiva_ricerca(circolo);
+
+	char *normalizzato = normalizza_testo(testo);
+	char **parole = g_strsplit_set(normalizzato, " \t\n", 0);
+	g_free(normalizzato);
+
+	//tolte le parole vuote dovute a spazi consecutivi
+	int n = 0;
+	for (int i = 0; parole[i] != 0; i++){
+		if (parole[i][0] == '\0')
+			g_free(parole[i]);
+		else
+			parole[n++] = parole[i];
+	}
+	parole[n] = 0;
+
+	//i candidati sono le voci del trigramma meno frequente
+	GPtrArray *candidati = 0;
+	bool vuoto = false;
+	for (int i = 0; parole[i] != 0 && !vuoto; i++){
+		for (size_t j = 0; j + 3 <= strlen(parole[i]); j++){
+			GPtrArray *voci = (GPtrArray *)
+				g_hash_table_lookup(stato->trigrammi, GUINT_TO_POINTER( chiave_trigramma(parole[i] + j) ));
+
+			if (voci == 0){
+				vuoto = true;
+				break;
+			}
+
+			if (candidati == 0 || voci->len < candidati->len)
+				candidati = voci;
+		}
+	}
+
+	GArray *risultati = g_array_new(FALSE, FALSE, sizeof(risultato_t));
+
+	if (vuoto)
+		;
+	else if (candidati != 0)
+		for (guint i = 0; i < candidati->len; i++)
+			controlla_voce( (voce_t *) g_ptr_array_index(candidati, i), parole, solo_soci, risultati);
+	else {
+		GHashTableIter iter;
+		gpointer voce;
+		g_hash_table_iter_init(&iter, stato->voci);
+		while ( g_hash_table_iter_next(&iter, NULL, &voce) )
+			controlla_voce( (voce_t *) voce, parole, solo_soci, risultati);
+	}
+
+	g_array_sort(risultati, confronta_risultati);
+
+	guint n_risultati = risultati->len;
+	if (max != 0 && max < n_risultati)
+		n_risultati = max;
+
+	GList *lista = 0;
+	for (guint i = n_risultati; i > 0; i--)
+		lista = g_list_prepend(lista, g_array_index(risultati, risultato_t, i - 1).voce->giocatore);
+
+	D2(cout<<"Giocatori trovati: "<<risultati->len<<endl)
+
+	g_array_free(risultati, TRUE);
+	g_strfreev(parole);
+
+	return lista;
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,37 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo ricerca.cc
+ */
+
+#ifndef RICERCA
+#define RICERCA
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo ricerca */
+
+/** Cerca i giocatori del circolo.
+ * Il testo viene confrontato con nome, cognome, tessera ed email ignorando
+ * maiuscole e accenti; se contiene più parole ognuna deve comparire in uno dei dati.
+ * La prima ricerca costruisce l'indice del circolo, che poi viene aggiornato
+ * a ogni aggiunta, modifica o eliminazione di un giocatore.
+ * I giocatori in cui una parola compare all'inizio di un dato vengono prima degli altri,
+ * a parità sono ordinati per cognome e nome
+ * @param[in,out] circolo Circolo in cui cercare
+ * @param[in] testo Testo da cercare
+ * @param[in] solo_soci TRUE per cercare solo tra i soci
+ * @param[in] max Numero massimo di risultati, 0 per non avere limiti
+ * @return Lista dei giocatori trovati, da deallocare con g_list_free()
+ */
+GList *cerca_giocatori(circolo_t *circolo, const char testo[], bool solo_soci, unsigned int max);
+
+/** Normalizza il testo per la ricerca.
+ * Toglie gli accenti e converte in minuscolo
+ * @param[in] testo Testo in UTF-8
+ * @return Testo normalizzato, da deallocare con g_free()
+ */
+char *normalizza_testo(const char testo[]);
+
+/* Fine interfaccia del modulo ricerca */
+
+#endif
@@ -0,0 +1,270 @@
+/**
+ * @file
+ * File contenente il modulo selezione.
+ * Cerca giocatori, campi e ore che soddisfano condizioni componibili
+ * scorrendo direttamente i vettori del circolo: il primo elemento, il conteggio
+ * e la verifica di esistenza non creano liste né allocano memoria
+ */
+
+#include <glib.h>
+#include <cstring>
+
+#include "selezione.h"
+#include "accesso_dati.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+/** Crea una condizione semplice.
+ */
+static condizione_t condizione(elemento_t tipo, verifica_t verifica, int valore, gconstpointer riferimento)
+{
+	condizione_t c = { tipo, verifica, valore, riferimento, 0, 0 };
+	return c;
+}
+
+static bool verifica_id(gconstpointer elemento, const condizione_t *c)
+{
+	return ((const giocatore_t *) elemento)->ID == c->valore;
+}
+
+static bool verifica_socio(gconstpointer elemento, const condizione_t *c)
+{
+	return ((const giocatore_t *) elemento)->socio == (c->valore != 0);
+}
+
+static bool verifica_numero(gconstpointer elemento, const condizione_t *c)
+{
+	return ((const campo_t *) elemento)->numero == c->valore;
+}
+
+static bool verifica_terreno(gconstpointer elemento, const condizione_t *c)
+{
+	return ((const campo_t *) elemento)->terreno == c->valore;
+}
+
+static bool verifica_copertura(gconstpointer elemento, const condizione_t *c)
+{
+	return ((const campo_t *) elemento)->copertura == c->valore;
+}
+
+static bool verifica_prenotante(gconstpointer elemento, const condizione_t *c)
+{
+	return ((const ora_t *) elemento)->prenotante == c->riferimento;
+}
+
+static bool verifica_data(gconstpointer elemento, const condizione_t *c)
+{
+	return strcmp( ((const ora_t *) elemento)->data->str, (const char *) c->riferimento ) == 0;
+}
+
+static bool verifica_qualsiasi(gconstpointer elemento, const condizione_t *c)
+{
+	return true;
+}
+
+static bool verifica_nessuno(gconstpointer elemento, const condizione_t *c)
+{
+	return false;
+}
+
+static bool verifica_entrambe(gconstpointer elemento, const condizione_t *c)
+{
+	return c->prima->verifica(elemento, c->prima) && c->seconda->verifica(elemento, c->seconda);
+}
+
+static bool verifica_almeno_una(gconstpointer elemento, const condizione_t *c)
+{
+	return c->prima->verifica(elemento, c->prima) || c->seconda->verifica(elemento, c->seconda);
+}
+
+static bool verifica_negata(gconstpointer elemento, const condizione_t *c)
+{
+	return !c->prima->verifica(elemento, c->prima);
+}
+
+/** Combina due condizioni dello stesso tipo.
+ */
+static condizione_t composta(verifica_t verifica, const condizione_t &prima, const condizione_t &seconda)
+{
+	if (prima.tipo != seconda.tipo){
+		D2(cout<<"Condizioni di tipo diverso"<<endl)
+		return condizione(prima.tipo, verifica_nessuno, 0, 0);
+	}
+
+	condizione_t c = { prima.tipo, verifica, 0, 0, &prima, &seconda };
+	return c;
+}
+
+/** Crea un cursore sul vettore se la condizione è del tipo atteso.
+ */
+static cursore_t cursore(const GPtrArray *vettore, elemento_t tipo, const condizione_t &condizione)
+{
+	cursore_t c = { vettore, 0, 0, &condizione };
+
+	if (condizione.tipo != tipo){
+		D2(cout<<"Condizione di tipo errato"<<endl)
+		c.vettore = 0;
+	}
+
+	return c;
+}
+
+/** Ritorna il prossimo elemento del cursore, 0 se non ce ne sono altri.
+ * Se l'ultimo elemento ritornato è stato tolto dal vettore i successivi
+ * sono scalati di una posizione, quindi la ricerca riparte da dove si trovava
+ */
+static gpointer avanza(cursore_t &cursore)
+{
+	if (cursore.vettore == 0)
+		return 0;
+
+	const GPtrArray *vettore = cursore.vettore;
+
+	if (cursore.prossimo > 0 && (cursore.prossimo > vettore->len ||
+			g_ptr_array_index(vettore, cursore.prossimo - 1) != cursore.ultimo) )
+		cursore.prossimo--;
+
+	while (cursore.prossimo < vettore->len){
+		gpointer elemento = g_ptr_array_index(vettore, cursore.prossimo++);
+
+		if ( cursore.condizione->verifica(elemento, cursore.condizione) ){
+			cursore.ultimo = elemento;
+			return elemento;
+		}
+	}
+
+	return 0;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+condizione_t giocatore_con_id(int ID)
+{
+	return condizione(ELEM_GIOCATORE, verifica_id, ID, 0);
+}
+
+condizione_t giocatore_socio(bool socio)
+{
+	return condizione(ELEM_GIOCATORE, verifica_socio, socio, 0);
+}
+
+condizione_t campo_con_numero(int numero)
+{
+	return condizione(ELEM_CAMPO, verifica_numero, numero, 0);
+}
+
+condizione_t campo_con_terreno(terreno_t terreno)
+{
+	return condizione(ELEM_CAMPO, verifica_terreno, terreno, 0);
+}
+
+condizione_t campo_con_copertura(copertura_t copertura)
+{
+	return condizione(ELEM_CAMPO, verifica_copertura, copertura, 0);
+}
+
+condizione_t ora_di_prenotante(const giocatore_t *prenotante)
+{
+	return condizione(ELEM_ORA, verifica_prenotante, 0, prenotante);
+}
+
+condizione_t ora_con_data(const char data[])
+{
+	return condizione(ELEM_ORA, (data != 0) ? verifica_data : verifica_nessuno, 0, data);
+}
+
+condizione_t qualsiasi(elemento_t tipo)
+{
+	return condizione(tipo, verifica_qualsiasi, 0, 0);
+}
+
+condizione_t entrambe(const condizione_t &prima, const condizione_t &seconda)
+{
+	return composta(verifica_entrambe, prima, seconda);
+}
+
+condizione_t almeno_una(const condizione_t &prima, const condizione_t &seconda)
+{
+	return composta(verifica_almeno_una, prima, seconda);
+}
+
+condizione_t negata(const condizione_t &condizione)
+{
+	condizione_t c = { condizione.tipo, verifica_negata, 0, 0, &condizione, 0 };
+	return c;
+}
+
+cursore_t scorri_giocatori(const circolo_t *circolo, const condizione_t &condizione)
+{
+	return cursore( (circolo != 0) ? circolo->giocatori : 0, ELEM_GIOCATORE, condizione );
+}
+
+cursore_t scorri_campi(const circolo_t *circolo, const condizione_t &condizione)
+{
+	return cursore( (circolo != 0) ? circolo->campi : 0, ELEM_CAMPO, condizione );
+}
+
+cursore_t scorri_ore(const campo_t *campo, const condizione_t &condizione)
+{
+	return cursore( (campo != 0) ? campo->ore : 0, ELEM_ORA, condizione );
+}
+
+giocatore_t *prossimo_giocatore(cursore_t &cursore)
+{
+	if (cursore.condizione->tipo != ELEM_GIOCATORE) return 0;
+
+	return (giocatore_t *) avanza(cursore);
+}
+
+campo_t *prossimo_campo(cursore_t &cursore)
+{
+	if (cursore.condizione->tipo != ELEM_CAMPO) return 0;
+
+	return (campo_t *) avanza(cursore);
+}
+
+ora_t *prossima_ora(cursore_t &cursore)
+{
+	if (cursore.condizione->tipo != ELEM_ORA) return 0;
+
+	return (ora_t *) avanza(cursore);
+}
+
+giocatore_t *primo_giocatore(const circolo_t *circolo, const condizione_t &condizione)
+{
+	cursore_t c = scorri_giocatori(circolo, condizione);
+	return prossimo_giocatore(c);
+}
+
+campo_t *primo_campo(const circolo_t *circolo, const condizione_t &condizione)
+{
+	cursore_t c = scorri_campi(circolo, condizione);
+	return prossimo_campo(c);
+}
+
+ora_t *prima_ora(const campo_t *campo, const condizione_t &condizione)
+{
+	cursore_t c = scorri_ore(campo, condizione);
+	return prossima_ora(c);
+}
+
+int conta(cursore_t cursore)
+{
+	int n = 0;
+
+	while (avanza(cursore) != 0)
+		n++;
+
+	return n;
+}
+
+bool esiste(cursore_t cursore)
+{
+	return avanza(cursore) != 0;
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo selezione.cc
+ */
+
+#ifndef SELEZIONE
+#define SELEZIONE
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+#include "accesso_dati.h"
+
+/* Inizio interfaccia del modulo selezione */
+
+struct condizione_t;
+
+/** Funzione che verifica una condizione su un elemento.
+ * @param[in] elemento Elemento del tipo della condizione
+ * @param[in] condizione Condizione da verificare
+ * @return TRUE se l'elemento soddisfa la condizione
+ */
+typedef bool (*verifica_t)(gconstpointer elemento, const condizione_t *condizione);
+
+/** Condizione su giocatori, campi oppure ore.
+ * Le condizioni si creano con le funzioni di questo modulo, non allocano memoria
+ * e si possono copiare; tipo è il tipo degli elementi a cui si applicano.
+ * Le condizioni composte puntano alle condizioni che combinano, che devono restare
+ * valide finché la condizione composta viene usata: passate direttamente come argomenti
+ * durano fino alla fine dell'istruzione
+ */
+struct condizione_t {
+	elemento_t tipo;
+	verifica_t verifica;
+	int valore;
+	gconstpointer riferimento;
+	const condizione_t *prima;
+	const condizione_t *seconda;
+};
+
+/** Cursore che scorre gli elementi di un vettore che soddisfano una condizione.
+ * Gli elementi vengono cercati uno alla volta a ogni richiesta a partire dalla posizione prossimo;
+ * l'elemento appena ritornato, ricordato in ultimo, può essere eliminato prima di chiedere il successivo.
+ * Il cursore punta alla condizione, che deve restare valida finché il cursore viene usato
+ */
+struct cursore_t {
+	const GPtrArray *vettore;
+	guint prossimo;
+	gconstpointer ultimo;
+	const condizione_t *condizione;
+};
+
+//@{
+/** Condizioni sui giocatori.
+ */
+condizione_t giocatore_con_id(int ID);
+condizione_t giocatore_socio(bool socio);	//@}
+
+//@{
+/** Condizioni sui campi.
+ */
+condizione_t campo_con_numero(int numero);
+condizione_t campo_con_terreno(terreno_t terreno);
+condizione_t campo_con_copertura(copertura_t copertura);	//@}
+
+//@{
+/** Condizioni sulle ore.
+ * La data è nel formato gg-mm-aaaa e viene puntata, non copiata
+ */
+condizione_t ora_di_prenotante(const giocatore_t *prenotante);
+condizione_t ora_con_data(const char data[]);		//@}
+
+/** Condizione soddisfatta da tutti gli elementi di un tipo.
+ * @param[in] tipo Tipo degli elementi
+ * @return Condizione
+ */
+condizione_t qualsiasi(elemento_t tipo);
+
+//@{
+/** Condizioni composte.
+ * Le condizioni combinate devono essere dello stesso tipo, altrimenti la condizione
+ * composta non è soddisfatta da nessun elemento
+ */
+condizione_t entrambe(const condizione_t &prima, const condizione_t &seconda);
+condizione_t almeno_una(const condizione_t &prima, const condizione_t &seconda);
+condizione_t negata(const condizione_t &condizione);	//@}
+
+//@{
+/** Creano un cursore sui giocatori del circolo, sui campi del circolo o sulle ore del campo.
+ * Se la condizione non è del tipo giusto il cursore non trova nessun elemento
+ */
+cursore_t scorri_giocatori(const circolo_t *circolo, const condizione_t &condizione);
+cursore_t scorri_campi(const circolo_t *circolo, const condizione_t &condizione);
+cursore_t scorri_ore(const campo_t *campo, const condizione_t &condizione);	//@}
+
+//@{
+/** Ritornano il prossimo elemento del cursore, 0 se non ce ne sono altri.
+ */
+giocatore_t *prossimo_giocatore(cursore_t &cursore);
+campo_t *prossimo_campo(cursore_t &cursore);
+ora_t *prossima_ora(cursore_t &cursore);	//@}
+
+//@{
+/** Ritornano il primo elemento che soddisfa la condizione, 0 se non ce ne sono.
+ */
+giocatore_t *primo_giocatore(const circolo_t *circolo, const condizione_t &condizione);
+campo_t *primo_campo(const circolo_t *circolo, const condizione_t &condizione);
+ora_t *prima_ora(const campo_t *campo, const condizione_t &condizione);	//@}
+
+/** Conta gli elementi rimasti nel cursore.
+ * @param[in] cursore Cursore, viene consumato
+ * @return Numero di elementi che soddisfano la condizione
+ */
+int conta(cursore_t cursore);
+
+/** Controlla se nel cursore resta almeno un elemento.
+ * @param[in] cursore Cursore
+ * @return TRUE se almeno un elemento soddisfa la condizione
+ */
+bool esiste(cursore_t cursore);
+
+/* Fine interfaccia del modulo selezione */
+
+#endif
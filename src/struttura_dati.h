@@ -14,17 +14,42 @@
 /** Definizione dei tipi di lista.
  * Le liste del programma si appoggiano alle liste di libreria
  */
-typedef GList *lista_ore, *lista_giocatori, *lista_campi;	//@}
+typedef GList *lista_giocatori, *lista_regole, *lista_corsi;	//@}
+
+//@{
+/** Definizione dei tipi di vettore.
+ * I giocatori e i campi del circolo e le ore dei campi vengono scorsi molto più spesso
+ * di quanto vengano inseriti o tolti, quindi i loro puntatori sono tenuti contigui
+ * nei vettori di libreria, senza un nodo allocato per ogni elemento.
+ * Gli elementi restano allocati singolarmente, i loro puntatori restano validi
+ * finché non vengono eliminati
+ */
+typedef GPtrArray *vettore_giocatori, *vettore_campi, *vettore_ore;	//@}
 
 /** Definizione del tipo stringa.
  * Le stringhe del programma si appoggiano alle stringhe di libreria
  */
 typedef GString *stringa;
 
+/** Struttura rappresentante gli orari di prenotazione.
+ * Apertura e chiusura sono in minuti dalla mezzanotte, passo è la durata in minuti di uno slot:
+ * le ore iniziano e durano un numero intero di slot contati dall'apertura.
+ * Un passo uguale a 0 indica orari non impostati, per un campo significa usare quelli del circolo
+ */
+struct orari_t {
+	int apertura;
+	int chiusura;
+	int passo;
+};
+
 /** Struttura reppresentante il Circolo.
  * Il Circolo è caratterizzato dai dati (nome, inidirizzo, email, telefono) e
- * da due liste contenenti i campi e i soci;
- * ha anche due contatori per il numero di campi e di soci
+ * dai vettori dei campi, in ordine decrescente di numero, e dei giocatori e dalla lista dei corsi;
+ * ha anche due contatori per il numero di campi e di soci.
+ * La lista osservatori contiene le funzioni da avvisare a ogni modifica dei dati,
+ * istantanee, ricerca, giorni e occupazione puntano agli stati usati dai moduli istantanea, ricerca,
+ * indice_giorni e occupazione;
+ * orari contiene gli orari di prenotazione dei campi che non ne hanno di propri
  */
 struct circolo_t {
 	stringa nome;
@@ -34,40 +59,90 @@ struct circolo_t {
 	int n_campi;
 	int n_soci;
 	int pros_id;
-	lista_giocatori giocatori;
-	lista_campi campi;
+	vettore_giocatori giocatori;
+	vettore_campi campi;
+	lista_corsi corsi;
+	GList *osservatori;
+	void *istantanee;
+	void *ricerca;
+	void *giorni;
+	void *occupazione;
+	orari_t orari;
 };
 
+/** Dati di testo di un giocatore, nell'ordine in cui sono memorizzati.
+ */
+enum dato_giocatore_t {DATO_NOME, DATO_COGNOME, DATO_NASCITA, DATO_TESSERA,
+			DATO_TELEFONO, DATO_EMAIL, DATO_CLASSIFICA, DATO_CIRCOLO};
+
+const int N_DATI_GIOCATORE = DATO_CIRCOLO + 1;	/**< Numero dei dati di testo di un giocatore */
+
 /** Struttura rappresentante i giocatori.
- * Contiene i dati del giocatore se è socio il campo socio è a true, il campo retta è utilizzato solo dai soci
+ * Contiene i dati del giocatore se è socio il campo socio è a true, il campo retta è utilizzato solo dai soci.
+ * I dati di testo sono copiati uno dopo l'altro, ciascuno col suo terminatore, nell'unico blocco testi
+ * e inizio contiene la posizione di ciascuno nel blocco; si leggono con dato_giocatore()
  */
 struct giocatore_t {
 	int ID;
-	stringa nome;
-	stringa cognome;
-	stringa nascita;
-	stringa tessera;
-	stringa telefono;
-	stringa email;
-	stringa classifica;
-	stringa circolo;
+	guint16 inizio[N_DATI_GIOCATORE];
+	char *testi;
 	bool socio;
 	bool retta;
 };
 
+struct regola_t;
+
+/** Struttura rappresentante un corso.
+ * Il corso ha un nome, un istruttore e la lista dei giocatori iscritti;
+ * le sue lezioni sono prenotazioni ricorrenti dei campi che puntano al corso
+ * e hanno come prenotante l'istruttore. L'ID identifica il corso all'interno del circolo
+ */
+struct corso_t {
+	int ID;
+	stringa nome;
+	giocatore_t *istruttore;
+	lista_giocatori iscritti;
+};
+
 /** Struttura rappresentante le ore prenotate.
  * Ogni ora è caratterizzata dall'orario, la data, durata in minuti, il tipo di prenotante e un puntatore generico;
  * Il puntatore generico punterà a un dato diverso a seconda del tipo di prenotante :
  * se è SOCIO punta ai dati del socio,
  * se è GIOCATORE punta ai dati del giocatore non socio,
  * se è CORSO punta ai dati del gruppo del corso,
- * se è TORNEO punta ai dati del turno del torneo
+ * gli incontri dei tornei sono ore intestate all'organizzatore e create dal modulo torneo.
+ * regola è 0 per le ore prenotate singolarmente; le occorrenze delle prenotazioni ricorrenti
+ * sono ore generate dall'indice dei giorni che puntano alla regola da cui derivano.
+ * corso punta al corso di cui l'ora è una lezione, 0 per le ore dei giocatori
  */
 struct ora_t {
 	int orario;
 	stringa data;
 	int durata;
 	giocatore_t *prenotante;
+	regola_t *regola;
+	corso_t *corso;
+};
+
+/** Struttura rappresentante una prenotazione ricorrente.
+ * La regola viene memorizzata una sola volta e si ripete all'orario indicato
+ * nei giorni della settimana di giorni (bit 0 il lunedì, bit 6 la domenica),
+ * una settimana ogni settimane a partire da quella di inizio, tra i giorni giuliani inizio e fine compresi;
+ * eccezioni contiene in ordine crescente i giorni giuliani in cui la regola è annullata.
+ * L'ID identifica la regola all'interno del suo campo; le regole dei corsi puntano al corso
+ * e vengono salvate insieme a lui, corso è 0 per le altre
+ */
+struct regola_t {
+	int ID;
+	int orario;
+	int durata;
+	guint inizio;
+	guint fine;
+	int giorni;
+	int settimane;
+	GArray *eccezioni;
+	giocatore_t *prenotante;
+	corso_t *corso;
 };
 
 /** Tipo che rappresenta il tipo di copertura del campo.
@@ -83,14 +158,19 @@ enum terreno_t {ERBA = 0, ERBA_SINTETICA, TERRA, SINTETICO, CEMENTO};
 
 /** Struttura rappresentate i campi.
  * Ogni campo è identificato da un numero ed è caratterizzato dal tipo di terreno e se è coperto o scoperto,
- * inoltre contiene un puntatore alla lista delle ore prenotate e delle note per eventuali informazioni aggiuntive
+ * inoltre contiene il vettore delle ore prenotate in ordine cronologico, la lista delle prenotazioni ricorrenti
+ * e delle note per eventuali informazioni aggiuntive;
+ * mantiene anche un puntatore al circolo di appartenenza e gli eventuali orari propri
  */
 struct campo_t {
 	int numero;
 	copertura_t copertura;
 	terreno_t terreno;
 	stringa note;
-	lista_ore ore;
+	vettore_ore ore;
+	lista_regole regole;
+	circolo_t *circolo;
+	orari_t orari;
 };
 
 /* Fine header del modulo struttura dati */
@@ -0,0 +1,512 @@
+/**
+ * @file
+ * File contenente il modulo tabella_ore.
+ * Disegna con Cairo la tabella delle ore di uno o più giorni consecutivi: una riga per campo,
+ * i giorni uno dopo l'altro in orizzontale. Vengono disegnati solo i giorni e i minuti visibili
+ * e le righe che cadono nell'area da ridisegnare; le ore di ogni giorno visibile
+ * sono lette dall'indice di indice_giorni
+ */
+
+#include <gtk/gtk.h>
+#include <glib.h>
+#include <cmath>
+
+#include "tabella_ore.h"
+#include "indice_giorni.h"
+#include "accesso_dati.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const int ALTEZZA_RIGA = 32;			/**< Altezza in pixel della riga di un campo */
+const int ALTEZZA_GIORNI = 20;			/**< Altezza in pixel della riga dei giorni */
+const int ALTEZZA_INTESTAZIONE = 44;		/**< Altezza in pixel delle righe dei giorni e degli orari */
+const int LARGHEZZA_CAMPI = 64;			/**< Larghezza in pixel della colonna dei campi */
+const int DISTANZA_ETICHETTE = 48;		/**< Distanza minima in pixel tra due etichette degli orari */
+const int DISTANZA_SLOT = 6;			/**< Distanza minima in pixel tra due linee degli slot */
+const int GIORNI_VISIBILI = 7;			/**< Giorni mostrati al massimo con l'ingrandimento minimo */
+const double SCALA_MASSIMA = 16;		/**< Ingrandimento massimo in pixel per minuto */
+const double PASSO_ZOOM = 1.25;			/**< Fattore di ingrandimento di uno scatto della rotella */
+const double PASSO_SCORRIMENTO = 30;		/**< Pixel di scorrimento di uno scatto della rotella */
+
+/** Stato della tabella, agganciato al widget.
+ * La posizione orizzontale è misurata in minuti di apertura dall'apertura del primo giorno:
+ * il giorno d occupa l'intervallo [d * (chiusura - apertura), (d + 1) * (chiusura - apertura)).
+ * Apertura e chiusura comprendono gli orari di tutti i campi, ogni riga mostra chiuso
+ * il tempo fuori dagli orari del suo campo.
+ * scorrimento ha come valore la posizione del primo minuto visibile,
+ * scala è l'ingrandimento in pixel per minuto, 0 per quello minimo.
+ * campi contiene i campi delle righe, le ore non vengono copiate
+ */
+struct stato_tabella_t {
+	GtkWidget *area;
+	GtkAdjustment *scorrimento;
+	int apertura;
+	int chiusura;
+	double scala;
+	circolo_t *circolo;
+	guint primo;
+	int n_giorni;
+	GPtrArray *campi;
+	clic_ora_t clic;
+	gpointer dati;
+};
+
+static stato_tabella_t *get_stato(GtkWidget *tabella)
+{
+	return (stato_tabella_t *) g_object_get_data( G_OBJECT(tabella), "tabella" );
+}
+
+static void libera_stato(gpointer stato_)
+{
+	stato_tabella_t *stato = (stato_tabella_t *) stato_;
+
+	g_ptr_array_free(stato->campi, TRUE);
+	g_free(stato);
+}
+
+/** Ritorna i minuti di apertura di un giorno.
+ */
+static int durata_giorno(stato_tabella_t *stato)
+{
+	return stato->chiusura - stato->apertura;
+}
+
+/** Ritorna i pixel disponibili per le ore.
+ */
+static int larghezza_ore(stato_tabella_t *stato)
+{
+	return MAX(gtk_widget_get_allocated_width(stato->area) - LARGHEZZA_CAMPI, 1);
+}
+
+/** Ritorna l'ingrandimento effettivo.
+ * Non scende sotto quello che mostra GIORNI_VISIBILI giorni
+ */
+static double scala_effettiva(stato_tabella_t *stato)
+{
+	double minima = (double) larghezza_ore(stato) / (MIN(stato->n_giorni, GIORNI_VISIBILI) * durata_giorno(stato));
+
+	return MAX(stato->scala, minima);
+}
+
+/** Aggiorna la barra di scorrimento dopo un cambio di dimensione, di ingrandimento o di giorni.
+ */
+static void aggiorna_scorrimento(stato_tabella_t *stato)
+{
+	double totale = stato->n_giorni * durata_giorno(stato);
+	double pagina = MIN(totale, larghezza_ore(stato) / scala_effettiva(stato));
+	double valore = CLAMP(gtk_adjustment_get_value(stato->scorrimento), 0, totale - pagina);
+
+	gtk_adjustment_configure(stato->scorrimento, valore, 0, totale, 15, pagina * 0.9, pagina);
+	gtk_widget_queue_draw(stato->area);
+}
+
+/** Converte una coordinata orizzontale in posizione nella tabella.
+ */
+static double posizione_in(stato_tabella_t *stato, double x)
+{
+	return gtk_adjustment_get_value(stato->scorrimento) + (x - LARGHEZZA_CAMPI) / scala_effettiva(stato);
+}
+
+static void scorrimento_cambiato(GtkAdjustment *scorrimento, gpointer area)
+{
+	gtk_widget_queue_draw( GTK_WIDGET(area) );
+}
+
+static void dimensione_cambiata(GtkWidget *area, GdkRectangle *allocazione, gpointer stato)
+{
+	aggiorna_scorrimento( (stato_tabella_t *) stato );
+}
+
+/** Disegna le ore di una riga in un giorno.
+ * @param[in] base Posizione della mezzanotte del giorno
+ * @param[in] inizio Posizione del primo minuto visibile
+ * @param[in] fine Posizione dell'ultimo minuto visibile
+ */
+static void disegna_ore(cairo_t *cr, PangoLayout *layout, const GPtrArray *ore, double y,
+			double base, double inizio, double fine, double scala)
+{
+	for (guint j = 0; ore != 0 && j < ore->len; j++){
+		ora_t *ora = (ora_t *) g_ptr_array_index(ore, j);
+		double da = base + ora->orario;
+		double a = da + ora->durata;
+
+		if (da >= fine)
+			break;
+		if (a <= inizio)
+			continue;
+
+		da = LARGHEZZA_CAMPI + (MAX(da, inizio) - inizio) * scala;
+		a = LARGHEZZA_CAMPI + (MIN(a, fine) - inizio) * scala;
+
+		//le occorrenze delle prenotazioni ricorrenti hanno un colore proprio
+		if (ora->regola != 0)
+			cairo_set_source_rgb(cr, 0.65, 0.85, 0.65);
+		else
+			cairo_set_source_rgb(cr, 0.55, 0.70, 0.90);
+		cairo_rectangle(cr, da + 1, y + 2, a - da - 2, ALTEZZA_RIGA - 4);
+		cairo_fill_preserve(cr);
+		cairo_set_source_rgb(cr, 0.25, 0.40, 0.65);
+		cairo_set_line_width(cr, 1);
+		cairo_stroke(cr);
+
+		if (a - da > 8){
+			int h;
+			pango_layout_set_text(layout, get_nome_ora(ora), -1);
+			pango_layout_set_width(layout, (int) (a - da - 6) * PANGO_SCALE);
+			pango_layout_get_pixel_size(layout, NULL, &h);
+			cairo_set_source_rgb(cr, 0, 0, 0);
+			cairo_move_to(cr, da + 3, y + (ALTEZZA_RIGA - h) / 2);
+			pango_cairo_show_layout(cr, layout);
+		}
+	}
+}
+
+/** Disegna gli slot liberi di una riga in un giorno.
+ * Le linee tra gli slot vengono disegnate solo se abbastanza distanti
+ * @param[in] base Posizione della mezzanotte del giorno
+ * @param[in] inizio Posizione del primo minuto visibile
+ * @param[in] fine Posizione dell'ultimo minuto visibile
+ */
+static void disegna_slot(cairo_t *cr, const orari_t *orari, double y, double base, double inizio, double fine, double scala)
+{
+	double da = MAX(base + orari->apertura, inizio);
+	double a = MIN(base + orari->chiusura, fine);
+
+	if (da >= a)
+		return;
+
+	cairo_set_source_rgb(cr, 0.92, 0.95, 0.92);
+	cairo_rectangle(cr, LARGHEZZA_CAMPI + (da - inizio) * scala, y + 1, (a - da) * scala, ALTEZZA_RIGA - 2);
+	cairo_fill(cr);
+
+	if (orari->passo * scala < DISTANZA_SLOT)
+		return;
+
+	//solo gli slot che iniziano nell'intervallo visibile
+	int primo = (int) ceil( (da - base - orari->apertura) / orari->passo );
+	cairo_set_source_rgb(cr, 0.82, 0.88, 0.82);
+	cairo_set_line_width(cr, 1);
+	for (double m = base + orari->apertura + primo * orari->passo; m < a; m += orari->passo){
+		double x = floor(LARGHEZZA_CAMPI + (m - inizio) * scala) + 0.5;
+		cairo_move_to(cr, x, y + 1);
+		cairo_line_to(cr, x, y + ALTEZZA_RIGA - 1);
+	}
+	cairo_stroke(cr);
+}
+
+/** Disegna la parte visibile della tabella.
+ */
+static gboolean disegna(GtkWidget *area, cairo_t *cr, gpointer stato_)
+{
+	TEMPO("tabella_ore: disegno")
+	TRACCIA("disegna", "tabella", 0)
+
+	stato_tabella_t *stato = (stato_tabella_t *) stato_;
+	int durata = durata_giorno(stato);
+	double scala = scala_effettiva(stato);
+	double inizio = posizione_in(stato, LARGHEZZA_CAMPI);
+	double fine = MIN(stato->n_giorni * durata, inizio + larghezza_ore(stato) / scala);
+	int larghezza = gtk_widget_get_allocated_width(area);
+	int altezza = gtk_widget_get_allocated_height(area);
+
+	//giorni visibili
+	int primo = (int) (inizio / durata);
+	int ultimo = MIN(stato->n_giorni - 1, (int) ceil(fine / durata) - 1);
+
+	//righe che cadono nell'area da ridisegnare
+	double x1, y1, x2, y2;
+	cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+	int prima = MAX(0, (int) (y1 - ALTEZZA_INTESTAZIONE) / ALTEZZA_RIGA);
+	int ultima = MIN( (int) stato->campi->len - 1, (int) (y2 - ALTEZZA_INTESTAZIONE) / ALTEZZA_RIGA );
+	ISTOGRAMMA("tabella_ore: celle disegnate", (ultima - prima + 1) * (ultimo - primo + 1))
+	TRACCIA_ARG("celle", (ultima - prima + 1) * (ultimo - primo + 1))
+
+	PangoLayout *layout = gtk_widget_create_pango_layout(area, NULL);
+	pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+
+	cairo_set_source_rgb(cr, 1, 1, 1);
+	cairo_paint(cr);
+
+	for (int i = prima; i <= ultima; i++){
+		campo_t *campo = (campo_t *) g_ptr_array_index(stato->campi, i);
+		double y = ALTEZZA_INTESTAZIONE + i * ALTEZZA_RIGA;
+
+		const orari_t *orari = get_orari_campo(campo);
+
+		//tempo chiuso
+		cairo_set_source_rgb(cr, 0.85, 0.85, 0.85);
+		cairo_rectangle(cr, LARGHEZZA_CAMPI, y + 1, (fine - inizio) * scala, ALTEZZA_RIGA - 2);
+		cairo_fill(cr);
+
+		for (int d = primo; d <= ultimo; d++){
+			double base = (double) d * durata - stato->apertura;
+			disegna_slot(cr, orari, y, base, inizio, fine, scala);
+			disegna_ore(cr, layout, ore_del_giorno(stato->circolo, campo, stato->primo + d), y,
+					base, inizio, fine, scala);
+		}
+	}
+
+	cairo_set_source_rgb(cr, 0.95, 0.95, 0.95);
+	cairo_rectangle(cr, 0, 0, larghezza, ALTEZZA_INTESTAZIONE);
+	cairo_fill(cr);
+
+	//linee e etichette degli orari, distanziate in base all'ingrandimento
+	int passo = 15;
+	while (passo * scala < DISTANZA_ETICHETTE)
+		passo *= 2;
+
+	pango_layout_set_width(layout, -1);
+	for (int d = primo; d <= ultimo; d++){
+		double base = (double) d * durata - stato->apertura;
+
+		for (int m = (stato->apertura + passo - 1) / passo * passo; m < stato->chiusura; m += passo){
+			if (base + m < inizio || base + m > fine)
+				continue;
+
+			double x = LARGHEZZA_CAMPI + (base + m - inizio) * scala;
+
+			cairo_set_source_rgb(cr, 0.75, 0.75, 0.75);
+			cairo_move_to(cr, floor(x) + 0.5, ALTEZZA_GIORNI);
+			cairo_line_to(cr, floor(x) + 0.5, altezza);
+			cairo_stroke(cr);
+
+			char *orario = g_strdup_printf("%02d:%02d", m / 60, m % 60);
+			pango_layout_set_text(layout, orario, -1);
+			cairo_set_source_rgb(cr, 0, 0, 0);
+			cairo_move_to(cr, x + 2, ALTEZZA_GIORNI + 4);
+			pango_cairo_show_layout(cr, layout);
+			g_free(orario);
+		}
+
+		//inizio del giorno ed etichetta, tenuta visibile finché il giorno lo è
+		double x = LARGHEZZA_CAMPI + (MAX(base + stato->apertura, inizio) - inizio) * scala;
+		char *data = data_da_giorno(stato->primo + d);
+
+		cairo_set_source_rgb(cr, 0.3, 0.3, 0.3);
+		cairo_move_to(cr, floor(x) + 0.5, 0);
+		cairo_line_to(cr, floor(x) + 0.5, altezza);
+		cairo_stroke(cr);
+
+		pango_layout_set_text(layout, data, -1);
+		cairo_set_source_rgb(cr, 0, 0, 0);
+		cairo_move_to(cr, x + 4, 2);
+		pango_cairo_show_layout(cr, layout);
+		g_free(data);
+	}
+
+	//colonna dei campi, sopra le ore che scorrono
+	cairo_set_source_rgb(cr, 0.95, 0.95, 0.95);
+	cairo_rectangle(cr, 0, 0, LARGHEZZA_CAMPI, altezza);
+	cairo_fill(cr);
+
+	for (int i = prima; i <= ultima; i++){
+		int h;
+		char *numero = g_strdup_printf("%d", ((campo_t *) g_ptr_array_index(stato->campi, i))->numero);
+		pango_layout_set_text(layout, numero, -1);
+		pango_layout_get_pixel_size(layout, NULL, &h);
+		cairo_set_source_rgb(cr, 0, 0, 0);
+		cairo_move_to(cr, 8, ALTEZZA_INTESTAZIONE + i * ALTEZZA_RIGA + (ALTEZZA_RIGA - h) / 2);
+		pango_cairo_show_layout(cr, layout);
+		g_free(numero);
+	}
+
+	g_object_unref(layout);
+
+	return TRUE;
+}
+
+/** Individua la cella cliccata e chiama la funzione della tabella.
+ * Su una cella libera l'orario proposto è l'inizio dello slot cliccato;
+ * i clic fuori dagli orari del campo vengono ignorati
+ */
+static gboolean clic(GtkWidget *area, GdkEventButton *evento, gpointer stato_)
+{
+	stato_tabella_t *stato = (stato_tabella_t *) stato_;
+
+	if (evento->type != GDK_BUTTON_PRESS || evento->button != 1)
+		return FALSE;
+
+	if (evento->x < LARGHEZZA_CAMPI || evento->y < ALTEZZA_INTESTAZIONE)
+		return FALSE;
+
+	guint n_riga = (guint) (evento->y - ALTEZZA_INTESTAZIONE) / ALTEZZA_RIGA;
+	int posizione = (int) floor( posizione_in(stato, evento->x) );
+	int d = posizione / durata_giorno(stato);
+
+	if (n_riga >= stato->campi->len || d >= stato->n_giorni)
+		return FALSE;
+
+	campo_t *campo = (campo_t *) g_ptr_array_index(stato->campi, n_riga);
+	const GPtrArray *ore = ore_del_giorno(stato->circolo, campo, stato->primo + d);
+	const orari_t *orari = get_orari_campo(campo);
+	int minuto = stato->apertura + posizione % durata_giorno(stato);
+	int inizio = minuto - (minuto - orari->apertura) % orari->passo;
+	ora_t *cliccata = 0;
+
+	for (guint j = 0; ore != 0 && j < ore->len; j++){
+		ora_t *ora = (ora_t *) g_ptr_array_index(ore, j);
+
+		if (ora->orario > minuto)
+			break;
+
+		if (minuto < ora->orario + ora->durata){
+			cliccata = ora;
+			inizio = ora->orario;
+			break;
+		}
+	}
+
+	if (cliccata == 0 && (minuto < orari->apertura || minuto >= orari->chiusura) )
+		return FALSE;
+
+	char *giorno = data_da_giorno(stato->primo + d);
+	stato->clic(campo, giorno, inizio, cliccata, stato->dati);
+	g_free(giorno);
+
+	return TRUE;
+}
+
+/** Scorre la tabella con la rotella, con Ctrl premuto la ingrandisce.
+ * Lo scorrimento verticale è lasciato alla finestra che contiene la tabella
+ */
+static gboolean rotella(GtkWidget *area, GdkEventScroll *evento, gpointer stato_)
+{
+	stato_tabella_t *stato = (stato_tabella_t *) stato_;
+	double delta_x = 0, delta_y = 0;
+
+	switch (evento->direction){
+		case GDK_SCROLL_UP:
+			delta_y = -1;
+			break;
+		case GDK_SCROLL_DOWN:
+			delta_y = 1;
+			break;
+		case GDK_SCROLL_LEFT:
+			delta_x = -1;
+			break;
+		case GDK_SCROLL_RIGHT:
+			delta_x = 1;
+			break;
+		case GDK_SCROLL_SMOOTH:
+			delta_x = evento->delta_x;
+			delta_y = evento->delta_y;
+			break;
+	}
+
+	if (evento->state & GDK_CONTROL_MASK){
+		if (delta_y == 0)
+			return TRUE;
+
+		//la posizione sotto il puntatore resta ferma
+		double posizione = posizione_in(stato, evento->x);
+		zoom_tabella( gtk_widget_get_parent(area), pow(PASSO_ZOOM, -delta_y) );
+		gtk_adjustment_set_value(stato->scorrimento, posizione - (evento->x - LARGHEZZA_CAMPI) / scala_effettiva(stato) );
+		return TRUE;
+	}
+
+	//con Shift la rotella verticale scorre i giorni
+	if (evento->state & GDK_SHIFT_MASK && delta_x == 0)
+		delta_x = delta_y;
+
+	if (delta_x == 0)
+		return FALSE;
+
+	gtk_adjustment_set_value(stato->scorrimento, gtk_adjustment_get_value(stato->scorrimento) +
+				delta_x * PASSO_SCORRIMENTO / scala_effettiva(stato) );
+
+	return TRUE;
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+GtkWidget *crea_tabella_ore(clic_ora_t clic_ora, gpointer dati)
+{
+	stato_tabella_t *stato = g_new0(stato_tabella_t, 1);
+	stato->apertura = 0;
+	stato->chiusura = 24*60;
+	stato->n_giorni = 1;
+	stato->campi = g_ptr_array_new();
+	stato->clic = clic_ora;
+	stato->dati = dati;
+
+	GtkWidget *tabella = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	stato->area = gtk_drawing_area_new();
+	stato->scorrimento = gtk_adjustment_new(0, 0, 24*60, 15, 60, 24*60);
+	GtkWidget *barra = gtk_scrollbar_new(GTK_ORIENTATION_HORIZONTAL, stato->scorrimento);
+
+	gtk_widget_set_size_request(stato->area, LARGHEZZA_CAMPI + 100, ALTEZZA_INTESTAZIONE);
+	gtk_widget_add_events(stato->area, GDK_BUTTON_PRESS_MASK | GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
+	gtk_box_pack_start( GTK_BOX(tabella), stato->area, TRUE, TRUE, 0 );
+	gtk_box_pack_start( GTK_BOX(tabella), barra, FALSE, FALSE, 0 );
+
+	g_object_set_data_full( G_OBJECT(tabella), "tabella", stato, libera_stato );
+
+	g_signal_connect(stato->area, "draw", G_CALLBACK(disegna), stato);
+	g_signal_connect(stato->area, "button-press-event", G_CALLBACK(clic), stato);
+	g_signal_connect(stato->area, "scroll-event", G_CALLBACK(rotella), stato);
+	g_signal_connect(stato->area, "size-allocate", G_CALLBACK(dimensione_cambiata), stato);
+	g_signal_connect(stato->scorrimento, "value-changed", G_CALLBACK(scorrimento_cambiato), stato->area);
+
+	return tabella;
+}
+
+void imposta_giorno_tabella(GtkWidget *tabella, circolo_t *circolo, const char giorno[])
+{
+	TRACCIA("imposta_giorno_tabella", "tabella", giorno)
+
+	stato_tabella_t *stato = get_stato(tabella);
+
+	g_ptr_array_set_size(stato->campi, 0);
+	stato->circolo = circolo;
+
+	if (circolo != 0){
+		stato->apertura = circolo->orari.apertura;
+		stato->chiusura = circolo->orari.chiusura;
+
+		//i campi del circolo sono in ordine decrescente, le righe in ordine crescente
+		for (guint i = circolo->campi->len; i > 0; i--){
+			campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i - 1);
+			const orari_t *orari = get_orari_campo(campo);
+			stato->apertura = MIN(stato->apertura, orari->apertura);
+			stato->chiusura = MAX(stato->chiusura, orari->chiusura);
+			g_ptr_array_add(stato->campi, campo);
+		}
+
+		guint primo = giorno_da_data(giorno);
+		if (primo != 0 && primo != stato->primo){
+			stato->primo = primo;
+			gtk_adjustment_set_value(stato->scorrimento, 0);
+		}
+	}
+
+	gtk_widget_set_size_request(stato->area, LARGHEZZA_CAMPI + 100,
+				ALTEZZA_INTESTAZIONE + stato->campi->len * ALTEZZA_RIGA);
+	aggiorna_scorrimento(stato);
+
+	TRACCIA_ARG("campi", stato->campi->len)
+}
+
+void imposta_giorni_tabella(GtkWidget *tabella, int n_giorni)
+{
+	stato_tabella_t *stato = get_stato(tabella);
+
+	stato->n_giorni = MAX(n_giorni, 1);
+	aggiorna_scorrimento(stato);
+}
+
+void zoom_tabella(GtkWidget *tabella, double fattore)
+{
+	stato_tabella_t *stato = get_stato(tabella);
+
+	stato->scala = scala_effettiva(stato) * fattore;
+	if (stato->scala > SCALA_MASSIMA)
+		stato->scala = SCALA_MASSIMA;
+
+	aggiorna_scorrimento(stato);
+}
+
+/* Fine definizioni pubbliche */
@@ -0,0 +1,59 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo tabella_ore.cc
+ */
+
+#ifndef TABELLA_ORE
+#define TABELLA_ORE
+
+#include <gtk/gtk.h>
+
+#include "struttura_dati.h"
+
+/* Inizio interfaccia del modulo tabella_ore */
+
+/** Funzione chiamata al click su una cella della tabella.
+ * @param[in] campo Campo della riga cliccata
+ * @param[in] giorno Giorno della cella nel formato gg-mm-aaaa
+ * @param[in] orario Minuti dalla mezzanotte dell'inizio della cella
+ * @param[in] ora Ora prenotata cliccata, 0 se la cella è libera
+ * @param[in] dati Dati passati a crea_tabella_ore()
+ */
+typedef void (*clic_ora_t)(campo_t *campo, const char giorno[], int orario, ora_t *ora, gpointer dati);
+
+/** Crea la tabella delle ore.
+ * La tabella è un unico widget che disegna con Cairo una riga per campo e
+ * uno o più giorni in orizzontale; disegna solo l'intervallo visibile, si scorre con
+ * la barra o la rotella orizzontale (o Shift+rotella) e si ingrandisce con Ctrl+rotella.
+ * Gli orari mostrati e gli slot di ogni riga seguono gli orari del circolo e dei campi
+ * @param[in] clic Funzione chiamata al click su una cella
+ * @param[in] dati Dati passati a clic
+ * @return Widget della tabella
+ */
+GtkWidget *crea_tabella_ore(clic_ora_t clic, gpointer dati);
+
+/** Mostra nella tabella le ore a partire dal giorno.
+ * Va richiamata a ogni modifica dei campi e degli orari perché la tabella tiene
+ * i puntatori ai campi; le ore vengono lette dall'indice a ogni disegno
+ * @param[in,out] tabella Tabella creata con crea_tabella_ore()
+ * @param[in,out] circolo Circolo da mostrare, 0 per svuotare la tabella
+ * @param[in] giorno Primo giorno mostrato nel formato gg-mm-aaaa
+ */
+void imposta_giorno_tabella(GtkWidget *tabella, circolo_t *circolo, const char giorno[]);
+
+/** Cambia il numero di giorni mostrati dalla tabella.
+ * @param[in,out] tabella Tabella creata con crea_tabella_ore()
+ * @param[in] n_giorni Numero di giorni consecutivi
+ */
+void imposta_giorni_tabella(GtkWidget *tabella, int n_giorni);
+
+/** Cambia l'ingrandimento della tabella.
+ * L'ingrandimento minimo mostra al più una settimana
+ * @param[in,out] tabella Tabella creata con crea_tabella_ore()
+ * @param[in] fattore Fattore di ingrandimento rispetto al valore attuale
+ */
+void zoom_tabella(GtkWidget *tabella, double fattore);
+
+/* Fine interfaccia del modulo tabella_ore */
+
+#endif
@@ -0,0 +1,586 @@
+/**
+ * @file
+ * File contenente il modulo torneo.
+ * Crea il tabellone di un torneo e assegna a ogni incontro un campo e un orario:
+ * gli incontri vengono presi in ordine di turno e messi nel primo posto libero
+ * che rispetta gli orari dei campi, le prenotazioni e i vincoli dei giocatori.
+ * La pianificazione lavora su intervalli in minuti assoluti ordinati per campo,
+ * quindi non crea prenotazioni finché il risultato non viene scritto con prenota_torneo()
+ */
+
+#include <glib.h>
+
+#include "torneo.h"
+#include "accesso_dati.h"
+#include "indice_giorni.h"
+#include "file_IO.h"
+#include "struttura_dati.h"
+#include "debug.h"
+
+/* Inizio definizioni delle entità private del modulo */
+
+const int MINUTI_GIORNO = 24 * 60;	/**< Minuti in un giorno */
+
+/** Intervallo occupato in minuti assoluti, dalla mezzanotte del giorno giuliano 0.
+ */
+struct intervallo_t {
+	gint64 inizio;
+	gint64 fine;
+};
+
+/** Campo usato dalla pianificazione.
+ * occupato contiene in ordine di inizio gli intervalli delle prenotazioni
+ * e degli incontri già pianificati
+ */
+struct campo_torneo_t {
+	campo_t *campo;
+	const orari_t *orari;
+	GArray *occupato;
+};
+
+/** Ritorna l'istante in minuti assoluti di un orario di un giorno.
+ */
+static gint64 istante(guint giorno, int orario)
+{
+	return (gint64) giorno * MINUTI_GIORNO + orario;
+}
+
+/** Ritorna la posizione del primo intervallo che inizia da t in poi.
+ */
+static guint cerca_intervallo(GArray *occupato, gint64 t)
+{
+	guint a = 0, b = occupato->len;
+
+	while (a < b){
+		guint m = (a + b) / 2;
+		if (g_array_index(occupato, intervallo_t, m).inizio < t)
+			a = m + 1;
+		else
+			b = m;
+	}
+
+	return a;
+}
+
+/** Aggiunge un intervallo mantenendo l'ordine.
+ */
+static void occupa(GArray *occupato, gint64 inizio, gint64 fine)
+{
+	intervallo_t intervallo = { inizio, fine };
+	g_array_insert_val(occupato, cerca_intervallo(occupato, inizio), intervallo);
+}
+
+static void libera_campo_torneo(gpointer data)
+{
+	campo_torneo_t *c = (campo_torneo_t *) data;
+	g_array_free(c->occupato, TRUE);
+	g_free(c);
+}
+
+/** Cerca il primo orario libero di un campo da t in poi.
+ * L'orario rispetta l'apertura, la chiusura e il passo del campo
+ * @return Istante dell'inizio, -1 se non ce n'è uno entro l'ultimo giorno
+ */
+static gint64 primo_libero(const campo_torneo_t *c, gint64 t, int durata, guint ultimo)
+{
+	const orari_t *orari = c->orari;
+
+	for (;;){
+		guint giorno = t / MINUTI_GIORNO;
+		int minuto = t % MINUTI_GIORNO;
+
+		if (giorno > ultimo)
+			return -1;
+
+		if (minuto < orari->apertura)
+			minuto = orari->apertura;
+		else
+			minuto = orari->apertura + (minuto - orari->apertura + orari->passo - 1) / orari->passo * orari->passo;
+
+		if (minuto + durata > orari->chiusura){
+			t = istante(giorno + 1, 0);
+			continue;
+		}
+
+		gint64 inizio = istante(giorno, minuto);
+		guint i = cerca_intervallo(c->occupato, inizio);
+
+		if (i > 0 && g_array_index(c->occupato, intervallo_t, i - 1).fine > inizio){
+			t = g_array_index(c->occupato, intervallo_t, i - 1).fine;
+			continue;
+		}
+		if (i < c->occupato->len && g_array_index(c->occupato, intervallo_t, i).inizio < inizio + durata){
+			t = g_array_index(c->occupato, intervallo_t, i).fine;
+			continue;
+		}
+
+		return inizio;
+	}
+}
+
+/** Ritorna la fine dell'ultima indisponibilità dei partecipanti che si sovrappone all'intervallo.
+ * @param[in] indisponibile Indisponibilità di ogni giocatore del torneo, 0 se non ne ha
+ * @return Istante della fine, 0 se tutti i partecipanti sono disponibili
+ */
+static gint64 fine_indisponibile(const torneo_t *torneo, const incontro_t *incontro, GArray **indisponibile,
+				gint64 inizio, gint64 fine)
+{
+	gint64 ultima = 0;
+
+	for (int i = 0; i < incontro->n_partecipanti; i++){
+		GArray *periodi = indisponibile[ g_array_index(torneo->partecipanti, int, incontro->primo + i) ];
+		if (periodi == 0)
+			continue;
+
+		for (guint j = 0; j < periodi->len; j++){
+			const intervallo_t &p = g_array_index(periodi, intervallo_t, j);
+			if (p.inizio < fine && inizio < p.fine)
+				ultima = MAX(ultima, p.fine);
+		}
+	}
+
+	return ultima;
+}
+
+/** Ritorna l'istante di inizio della prenotazione di un incontro.
+ */
+static gint64 inizio_prenotato(const incontro_t *incontro)
+{
+	return istante( giorno_da_data(incontro->ora->data->str), incontro->ora->orario );
+}
+
+/** Controlla se un incontro è prenotato prima di un istante, quindi già giocato o in corso.
+ */
+static bool giocato(const incontro_t *incontro, gint64 taglio)
+{
+	return incontro->ora != 0 && inizio_prenotato(incontro) < taglio;
+}
+
+/** Prepara i campi ammessi dai vincoli con le loro prenotazioni.
+ * I campi preferiti vengono messi per primi, così a parità di orario vengono scelti loro;
+ * le prenotazioni degli incontri da ripianificare non occupano i campi
+ * @return Array di campo_torneo_t
+ */
+static GPtrArray *prepara_campi(circolo_t *circolo, const vincoli_torneo_t *vincoli, GHashTable *proprie)
+{
+	GPtrArray *campi = g_ptr_array_new_with_free_func(libera_campo_torneo);
+
+	for (int preferito = 1; preferito >= 0; preferito--)
+		for (guint i = 0; i < circolo->campi->len; i++){
+			campo_t *campo = (campo_t *) g_ptr_array_index(circolo->campi, i);
+			int bit = 1 << campo->terreno;
+
+			if (vincoli->terreni != 0 && (vincoli->terreni & bit) == 0)
+				continue;
+			if ( ((vincoli->preferiti & bit) != 0) != (preferito == 1) )
+				continue;
+
+			const orari_t *orari = get_orari_campo(campo);
+			if (vincoli->durata % orari->passo != 0 || vincoli->durata > orari->chiusura - orari->apertura)
+				continue;
+
+			campo_torneo_t *c = g_new(campo_torneo_t, 1);
+			c->campo = campo;
+			c->orari = orari;
+			c->occupato = g_array_new(FALSE, FALSE, sizeof(intervallo_t));
+
+			//le ore del giorno sono in ordine di orario, quindi gli intervalli arrivano già ordinati
+			for (guint g = vincoli->inizio; g <= vincoli->fine; g++){
+				const GPtrArray *ore = ore_del_giorno(circolo, campo, g);
+
+				for (guint i = 0; ore != 0 && i < ore->len; i++){
+					ora_t *ora = (ora_t *) g_ptr_array_index(ore, i);
+					if ( g_hash_table_contains(proprie, ora) )
+						continue;
+
+					intervallo_t intervallo = { istante(g, ora->orario), istante(g, ora->orario + ora->durata) };
+					g_array_append_val(c->occupato, intervallo);
+				}
+			}
+
+			g_ptr_array_add(campi, c);
+		}
+
+	return campi;
+}
+
+/** Raccoglie le indisponibilità per giocatore del torneo.
+ * @return Array con un elemento per ogni giocatore, 0 per chi non ne ha;
+ * da deallocare con libera_indisponibilita()
+ */
+static GArray **prepara_indisponibilita(const torneo_t *torneo, const vincoli_torneo_t *vincoli)
+{
+	GArray **indisponibile = g_new0(GArray *, torneo->giocatori->len);
+	GHashTable *indici = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	for (guint i = 0; i < torneo->giocatori->len; i++)
+		if (g_ptr_array_index(torneo->giocatori, i) != 0)
+			g_hash_table_insert(indici, g_ptr_array_index(torneo->giocatori, i), GUINT_TO_POINTER(i + 1));
+
+	for (int i = 0; i < vincoli->n_indisponibilita; i++){
+		const indisponibilita_t &p = vincoli->indisponibilita[i];
+		guint indice = GPOINTER_TO_UINT( g_hash_table_lookup(indici, p.giocatore) );
+		if (indice == 0 || p.fine <= p.inizio)
+			continue;
+
+		GArray *&periodi = indisponibile[indice - 1];
+		if (periodi == 0)
+			periodi = g_array_new(FALSE, FALSE, sizeof(intervallo_t));
+
+		intervallo_t intervallo = { istante(p.giorno, p.inizio), istante(p.giorno, p.fine) };
+		g_array_append_val(periodi, intervallo);
+	}
+
+	g_hash_table_destroy(indici);
+
+	return indisponibile;
+}
+
+static void libera_indisponibilita(GArray **indisponibile, guint n)
+{
+	for (guint i = 0; i < n; i++)
+		if (indisponibile[i] != 0)
+			g_array_free(indisponibile[i], TRUE);
+	g_free(indisponibile);
+}
+
+/** Aggiunge un incontro al tabellone.
+ * @param[in] partecipanti Indici dei giocatori che possono arrivare all'incontro
+ */
+static void aggiungi_incontro(torneo_t *torneo, int turno, const int partecipanti[], int n, bool da_giocare)
+{
+	incontro_t incontro = { turno, (int) torneo->partecipanti->len, n, da_giocare, 0, 0, 0, 0, 0, 0 };
+
+	g_array_append_vals(torneo->partecipanti, partecipanti, n);
+	g_array_append_val(torneo->incontri, incontro);
+}
+
+/** Crea il tabellone a eliminazione diretta.
+ * I posti sono una potenza di due; le teste di serie vengono distribuite in modo
+ * che la prima e la seconda possano incontrarsi solo in finale, i posti vuoti toccano alle prime
+ */
+static void crea_eliminazione(torneo_t *torneo, giocatore_t *giocatori[], int n)
+{
+	int posti = 1;
+	torneo->turni = 0;
+	while (posti < n){
+		posti *= 2;
+		torneo->turni++;
+	}
+
+	//ordine delle teste di serie nel tabellone: a ogni raddoppio la testa s incontra la 2*dim-1-s
+	int *ordine = g_new(int, posti);
+	ordine[0] = 0;
+	for (int dim = 1; dim < posti; dim *= 2)
+		for (int i = dim - 1; i >= 0; i--){
+			ordine[2 * i + 1] = 2 * dim - 1 - ordine[i];
+			ordine[2 * i] = ordine[i];
+		}
+
+	for (int i = 0; i < posti; i++)
+		g_ptr_array_add(torneo->giocatori, ordine[i] < n ? giocatori[ ordine[i] ] : 0);
+	g_free(ordine);
+
+	int *partecipanti = g_new(int, posti);
+
+	for (int t = 0; t < torneo->turni; t++){
+		int ampiezza = 2 << t;
+
+		for (int primo = 0; primo < posti; primo += ampiezza){
+			int k = 0;
+			bool sinistra = false, destra = false;
+
+			for (int i = primo; i < primo + ampiezza; i++){
+				if (g_ptr_array_index(torneo->giocatori, i) == 0)
+					continue;
+				partecipanti[k++] = i;
+				if (i < primo + ampiezza / 2)
+					sinistra = true;
+				else
+					destra = true;
+			}
+
+			aggiungi_incontro(torneo, t, partecipanti, k, sinistra && destra);
+		}
+	}
+
+	g_free(partecipanti);
+}
+
+/** Crea il girone all'italiana con il metodo del cerchio.
+ * Il primo giocatore resta fermo e gli altri ruotano di un posto a ogni turno;
+ * con un numero dispari di giocatori chi incontra il posto vuoto riposa
+ */
+static void crea_girone(torneo_t *torneo, giocatore_t *giocatori[], int n)
+{
+	int m = n + n % 2;
+	torneo->turni = m - 1;
+
+	for (int i = 0; i < n; i++)
+		g_ptr_array_add(torneo->giocatori, giocatori[i]);
+
+	int *giro = g_new(int, m);
+	for (int i = 0; i < m; i++)
+		giro[i] = i;
+
+	for (int t = 0; t < torneo->turni; t++){
+		for (int i = 0; i < m / 2; i++){
+			int coppia[2] = { giro[i], giro[m - 1 - i] };
+			if (coppia[0] < n && coppia[1] < n)
+				aggiungi_incontro(torneo, t, coppia, 2, true);
+		}
+
+		int ultimo = giro[m - 1];
+		for (int i = m - 1; i > 1; i--)
+			giro[i] = giro[i - 1];
+		giro[1] = ultimo;
+	}
+
+	g_free(giro);
+}
+
+/** Osservatore che toglie dal torneo i riferimenti agli elementi eliminati.
+ */
+static void osserva_circolo(modifica_t modifica, elemento_t tipo, gpointer elemento, gpointer contenitore, gpointer dati)
+{
+	torneo_t *torneo = (torneo_t *) dati;
+
+	if (modifica != RIMOZIONE)
+		return;
+
+	for (guint i = 0; tipo == ELEM_GIOCATORE && i < torneo->giocatori->len; i++)
+		if (g_ptr_array_index(torneo->giocatori, i) == elemento)
+			g_ptr_array_index(torneo->giocatori, i) = 0;
+
+	if (tipo == ELEM_GIOCATORE && torneo->organizzatore == elemento)
+		torneo->organizzatore = 0;
+
+	for (guint i = 0; i < torneo->incontri->len; i++){
+		incontro_t *incontro = &g_array_index(torneo->incontri, incontro_t, i);
+
+		switch (tipo){
+			case ELEM_CIRCOLO:
+				incontro->campo = 0;
+				incontro->ora = 0;
+				incontro->campo_ora = 0;
+				break;
+			case ELEM_CAMPO:
+				if (incontro->campo == elemento)
+					incontro->campo = 0;
+				if (incontro->campo_ora == elemento){
+					incontro->ora = 0;
+					incontro->campo_ora = 0;
+				}
+				break;
+			case ELEM_ORA:
+				if (incontro->ora == elemento){
+					incontro->ora = 0;
+					incontro->campo_ora = 0;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	//la registrazione viene deallocata insieme al circolo
+	if (tipo == ELEM_CIRCOLO){
+		torneo->circolo = 0;
+		torneo->organizzatore = 0;
+	}
+}
+
+/* Fine definizioni private */
+
+/* Inizio definizioni delle funzioni pubbliche */
+
+torneo_t *crea_torneo(formula_t formula, giocatore_t *giocatori[], int n, giocatore_t *organizzatore, circolo_t *circolo)
+{
+	if (circolo == 0 || organizzatore == 0 || giocatori == 0 || n < 2) return 0;
+
+	torneo_t *torneo = g_try_new(torneo_t, 1);
+	if (torneo == 0) return 0;
+
+	torneo->formula = formula;
+	torneo->giocatori = g_ptr_array_new();
+	torneo->incontri = g_array_new(FALSE, FALSE, sizeof(incontro_t));
+	torneo->partecipanti = g_array_new(FALSE, FALSE, sizeof(int));
+	torneo->organizzatore = organizzatore;
+	torneo->circolo = circolo;
+
+	if (formula == ELIMINAZIONE)
+		crea_eliminazione(torneo, giocatori, n);
+	else
+		crea_girone(torneo, giocatori, n);
+
+	aggiungi_osservatore(circolo, osserva_circolo, torneo);
+
+	D1(cout<<"Torneo creato con "<<torneo->incontri->len<<" incontri"<<endl)
+
+	return torneo;
+}
+
+bool pianifica_torneo(torneo_t *torneo, const vincoli_torneo_t *vincoli, guint giorno, int orario, int &non_pianificato)
+{
+	TEMPO("torneo: pianifica_torneo")
+
+	non_pianificato = -1;
+
+	if (torneo == 0 || vincoli == 0 || torneo->circolo == 0) return false;
+	if (vincoli->inizio == 0 || vincoli->inizio > vincoli->fine) return false;
+	if (vincoli->durata <= 0 || vincoli->riposo < 0) return false;
+
+	gint64 taglio = MAX( istante(giorno, orario), istante(vincoli->inizio, 0) );
+
+	//le prenotazioni degli incontri da ripianificare non occupano i campi
+	GHashTable *proprie = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (guint i = 0; i < torneo->incontri->len; i++){
+		incontro_t *incontro = &g_array_index(torneo->incontri, incontro_t, i);
+		if (incontro->ora != 0 && !giocato(incontro, taglio))
+			g_hash_table_add(proprie, incontro->ora);
+	}
+
+	GPtrArray *campi = prepara_campi(torneo->circolo, vincoli, proprie);
+	GArray **indisponibile = prepara_indisponibilita(torneo, vincoli);
+	gint64 *libero = g_new0(gint64, torneo->giocatori->len);
+
+	//il nuovo piano sostituisce il vecchio solo se tutti gli incontri trovano posto
+	GArray *piano = g_array_sized_new(FALSE, FALSE, sizeof(incontro_t), torneo->incontri->len);
+	g_array_append_vals(piano, torneo->incontri->data, torneo->incontri->len);
+
+	for (guint i = 0; i < piano->len; i++){
+		incontro_t *incontro = &g_array_index(piano, incontro_t, i);
+		gint64 inizio = -1;
+
+		if (!incontro->da_giocare)
+			continue;
+
+		//un incontro già giocato resta dove è stato prenotato
+		if ( giocato(incontro, taglio) ){
+			inizio = inizio_prenotato(incontro);
+			incontro->campo = incontro->campo_ora;
+			incontro->giorno = inizio / MINUTI_GIORNO;
+			incontro->orario = inizio % MINUTI_GIORNO;
+			incontro->durata = incontro->ora->durata;
+		}
+		else {
+			gint64 minimo = taglio;
+			for (int p = 0; p < incontro->n_partecipanti; p++)
+				minimo = MAX(minimo, libero[ g_array_index(torneo->partecipanti, int, incontro->primo + p) ]);
+
+			//il primo campo che trova l'orario più presto vince, a parità resta il preferito
+			campo_torneo_t *scelto = 0;
+			for (guint c = 0; c < campi->len; c++){
+				campo_torneo_t *campo = (campo_torneo_t *) g_ptr_array_index(campi, c);
+				gint64 t = minimo;
+
+				for (;;){
+					t = primo_libero(campo, t, vincoli->durata, vincoli->fine);
+					if (t < 0 || (scelto != 0 && t >= inizio)){
+						t = -1;
+						break;
+					}
+
+					gint64 u = fine_indisponibile(torneo, incontro, indisponibile, t, t + vincoli->durata);
+					if (u == 0)
+						break;
+					t = u;
+				}
+
+				if (t >= 0){
+					inizio = t;
+					scelto = campo;
+				}
+			}
+
+			if (scelto == 0){
+				non_pianificato = i;
+				break;
+			}
+
+			occupa(scelto->occupato, inizio, inizio + vincoli->durata);
+			incontro->campo = scelto->campo;
+			incontro->giorno = inizio / MINUTI_GIORNO;
+			incontro->orario = inizio % MINUTI_GIORNO;
+			incontro->durata = vincoli->durata;
+		}
+
+		for (int p = 0; p < incontro->n_partecipanti; p++)
+			libero[ g_array_index(torneo->partecipanti, int, incontro->primo + p) ] =
+					inizio + incontro->durata + vincoli->riposo;
+	}
+
+	bool stato = non_pianificato < 0;
+
+	if (stato){
+		g_array_free(torneo->incontri, TRUE);
+		torneo->incontri = piano;
+	}
+	else
+		g_array_free(piano, TRUE);
+
+	g_free(libero);
+	libera_indisponibilita(indisponibile, torneo->giocatori->len);
+	g_ptr_array_free(campi, TRUE);
+	g_hash_table_destroy(proprie);
+
+	D1(cout<<"Pianificazione del torneo "<<(stato ? "riuscita" : "non riuscita")<<endl)
+
+	return stato;
+}
+
+int prenota_torneo(torneo_t *torneo, completamento_t completamento, gpointer dati)
+{
+	TEMPO("torneo: prenota_torneo")
+
+	if (torneo == 0 || torneo->circolo == 0 || torneo->organizzatore == 0) return -1;
+
+	int scritte = 0;
+
+	for (guint i = 0; i < torneo->incontri->len; i++){
+		incontro_t *incontro = &g_array_index(torneo->incontri, incontro_t, i);
+		ora_t *vecchia = incontro->ora;
+
+		if (vecchia != 0 && incontro->campo == incontro->campo_ora && vecchia->orario == incontro->orario &&
+				vecchia->durata == incontro->durata && giorno_da_data(vecchia->data->str) == incontro->giorno)
+			continue;
+
+		//l'osservatore azzera ora quando la prenotazione viene eliminata
+		if (vecchia != 0){
+			elimina_file_ora_async(vecchia, incontro->campo_ora, torneo->circolo, completamento, dati);
+			elimina_ora(vecchia, incontro->campo_ora);
+		}
+
+		if (!incontro->da_giocare || incontro->campo == 0)
+			continue;
+
+		char *data = data_da_giorno(incontro->giorno);
+		ora_t *ora = aggiungi_ora(incontro->orario, data, incontro->durata, torneo->organizzatore, incontro->campo);
+		g_free(data);
+
+		if (ora == 0)
+			continue;
+
+		incontro->ora = ora;
+		incontro->campo_ora = incontro->campo;
+		salva_ora_async(ora, incontro->campo, torneo->circolo, completamento, dati);
+		scritte++;
+	}
+
+	return scritte;
+}
+
+void elimina_torneo(torneo_t *torneo)
+{
+	if (torneo == 0) return;
+
+	if (torneo->circolo != 0)
+		rimuovi_osservatore(torneo->circolo, osserva_circolo, torneo);
+
+	g_ptr_array_free(torneo->giocatori, TRUE);
+	g_array_free(torneo->incontri, TRUE);
+	g_array_free(torneo->partecipanti, TRUE);
+	g_free(torneo);
+}
+
+/* Fine definizioni pubbliche */
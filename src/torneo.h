@@ -0,0 +1,132 @@
+/**
+ * @file
+ * File contenente l'interfaccia del modulo torneo.cc
+ */
+
+#ifndef TORNEO
+#define TORNEO
+
+#include <glib.h>
+
+#include "struttura_dati.h"
+#include "esecutore.h"
+
+/* Inizio interfaccia del modulo torneo */
+
+/** Formula del torneo.
+ * Eliminazione diretta con i posti vuoti del tabellone assegnati alle prime teste di serie,
+ * oppure girone all'italiana in cui tutti incontrano tutti
+ */
+enum formula_t {ELIMINAZIONE = 0, GIRONE};
+
+/** Incontro del tabellone.
+ * I giocatori che possono arrivare all'incontro sono gli n_partecipanti indici di giocatori
+ * contenuti in partecipanti a partire da primo: i due avversari nel girone e nel primo turno,
+ * tutto il ramo del tabellone nei turni successivi dell'eliminazione diretta.
+ * Gli incontri con un posto vuoto non vanno giocati; campo, giorno, orario e durata sono quelli
+ * pianificati, campo è 0 se l'incontro non è pianificato; ora è la prenotazione che lo blocca
+ * sul campo campo_ora, 0 se l'incontro non è prenotato
+ */
+struct incontro_t {
+	int turno;
+	int primo;
+	int n_partecipanti;
+	bool da_giocare;
+	campo_t *campo;
+	guint giorno;
+	int orario;
+	int durata;
+	ora_t *ora;
+	campo_t *campo_ora;
+};
+
+/** Struttura rappresentante un torneo.
+ * giocatori contiene i giocatori in ordine di tabellone, 0 per i posti vuoti;
+ * incontri è un array di incontro_t in ordine di turno.
+ * Le prenotazioni degli incontri hanno come prenotante l'organizzatore;
+ * il torneo resta in memoria e osserva il circolo per sapere quali prenotazioni vengono eliminate
+ */
+struct torneo_t {
+	formula_t formula;
+	int turni;
+	GPtrArray *giocatori;
+	GArray *incontri;
+	GArray *partecipanti;
+	giocatore_t *organizzatore;
+	circolo_t *circolo;
+};
+
+/** Periodo in cui un giocatore non può giocare.
+ * inizio e fine sono in minuti dalla mezzanotte del giorno giuliano giorno
+ */
+struct indisponibilita_t {
+	giocatore_t *giocatore;
+	guint giorno;
+	int inizio;
+	int fine;
+};
+
+/** Vincoli della pianificazione.
+ * Gli incontri si giocano tra i giorni giuliani inizio e fine compresi e durano durata minuti;
+ * tra due incontri dello stesso giocatore passano almeno riposo minuti.
+ * terreni e preferiti sono maschere con un bit per ogni terreno_t: i campi con un terreno
+ * non ammesso non vengono usati, 0 li ammette tutti; a parità di orario si sceglie un campo preferito
+ */
+struct vincoli_torneo_t {
+	guint inizio;
+	guint fine;
+	int durata;
+	int riposo;
+	int terreni;
+	int preferiti;
+	const indisponibilita_t *indisponibilita;
+	int n_indisponibilita;
+};
+
+/** Crea il tabellone di un torneo.
+ * @param[in] formula Formula del torneo
+ * @param[in] giocatori Giocatori in ordine di testa di serie
+ * @param[in] n Numero di giocatori, almeno due
+ * @param[in] organizzatore Giocatore a cui vengono intestate le prenotazioni degli incontri
+ * @param[in,out] circolo Circolo del torneo
+ * @return Torneo creato, da deallocare con elimina_torneo(), 0 in caso di errore
+ */
+torneo_t *crea_torneo(formula_t formula, giocatore_t *giocatori[], int n, giocatore_t *organizzatore, circolo_t *circolo);
+
+/** Pianifica gli incontri del torneo.
+ * Gli incontri prenotati prima del giorno e dell'orario indicati restano dove sono,
+ * tutti gli altri vengono pianificati di nuovo, ognuno nel primo campo e orario liberi
+ * in ordine di turno: serve anche a ripianificare il resto del torneo dopo un ritardo.
+ * Vengono rispettati gli orari dei campi, le prenotazioni già presenti, i terreni,
+ * le indisponibilità dei giocatori e il riposo minimo; negli incontri dell'eliminazione diretta
+ * vengono rispettati i vincoli di tutti i giocatori che possono arrivarci.
+ * Le prenotazioni non vengono toccate, vanno scritte con prenota_torneo();
+ * se un incontro non trova posto la pianificazione precedente resta invariata
+ * @param[in,out] torneo Torneo
+ * @param[in] vincoli Vincoli della pianificazione
+ * @param[in] giorno Giorno giuliano da cui ripianificare
+ * @param[in] orario Orario in minuti da cui ripianificare
+ * @param[out] non_pianificato Indice del primo incontro che non ha trovato posto, -1 se ce l'hanno tutti
+ * @return successo (TRUE) o fallimento (FALSE)
+ */
+bool pianifica_torneo(torneo_t *torneo, const vincoli_torneo_t *vincoli, guint giorno, int orario, int &non_pianificato);
+
+/** Scrive le prenotazioni degli incontri pianificati.
+ * Le prenotazioni degli incontri spostati vengono eliminate e sostituite,
+ * quelle degli incontri rimasti dove erano non vengono riscritte
+ * @param[in,out] torneo Torneo pianificato
+ * @param[in] completamento Funzione chiamata al termine di ogni scrittura, può essere 0
+ * @param[in] dati Dati passati a completamento
+ * @return Numero di prenotazioni scritte, -1 se il torneo non ha più circolo o organizzatore
+ */
+int prenota_torneo(torneo_t *torneo, completamento_t completamento, gpointer dati);
+
+/** Dealloca il torneo.
+ * Le prenotazioni già scritte restano nel circolo
+ * @param[in] torneo Torneo da deallocare
+ */
+void elimina_torneo(torneo_t *torneo);
+
+/* Fine interfaccia del modulo torneo */
+
+#endif